@@ -0,0 +1,270 @@
+/*
+ * Animations the driver keeps up to date by itself: spinners,
+ * progress bars and clocks.  Erlang registers them once; after that
+ * the driver timer redraws them on the virtual screen and refreshes,
+ * without a message from Erlang per frame.
+ *
+ * A frame that is due within ANIM_SLACK ms when Erlang asks for a
+ * refresh is drawn right away and goes out with that refresh, so
+ * animations mostly ride along with the normal screen updates.  A
+ * timer refresh is only done when some animation actually changed
+ * cells on the screen, and never while Erlang is in the middle of a
+ * batch of drawing commands: the frame then waits for the refresh
+ * that ends the batch.  Cells are only rewritten when they differ from
+ * the virtual screen, so an animation that was drawn over comes back
+ * with its next frame.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slang_drv.h"
+
+
+#define ANIM_MAX        64
+#define ANIM_WIDTH      256
+#define ANIM_SLACK      20                   /* ms */
+
+typedef struct {
+    int used;
+    int id;
+    int kind;
+    int row, col, width;
+    int color, color2;
+    uint64_t period, due;                   /* ns */
+    unsigned int frame;
+    int value;
+    char text[ANIM_WIDTH];                  /* glyphs or strftime format */
+} Anim;
+
+static Anim Anims[ANIM_MAX];
+
+
+
+static Anim *anim_find(int id, int create)
+{
+    int i;
+    Anim *free_slot = NULL;
+
+    for (i = 0; i < ANIM_MAX; i++) {
+	if (Anims[i].used && (Anims[i].id == id))
+	    return &Anims[i];
+	if (!Anims[i].used && (free_slot == NULL))
+	    free_slot = &Anims[i];
+    }
+    if (!create || (free_slot == NULL))
+	return NULL;
+    memset(free_slot, 0, sizeof(Anim));
+    free_slot->used = 1;
+    free_slot->id = id;
+    return free_slot;
+}
+
+
+int anim_add(int kind, int id, int row, int col, int width,
+	     int color, int color2, int period_ms, int value, char *text)
+{
+    Anim *a;
+
+    if ((width < 1) || (width > ANIM_WIDTH) || (period_ms < 1)
+	|| ((kind == ANIM_SPINNER) && (text[0] == 0)))
+	return -1;
+    if ((a = anim_find(id, 1)) == NULL)
+	return -1;
+    a->kind = kind;
+    a->row = row;
+    a->col = col;
+    a->width = width;
+    a->color = color;
+    a->color2 = color2;
+    a->period = (uint64_t) period_ms * 1000000;
+    a->due = 0;
+    a->frame = 0;
+    a->value = value;
+    strncpy(a->text, text, ANIM_WIDTH - 1);
+    a->text[ANIM_WIDTH - 1] = 0;
+    return 0;
+}
+
+
+int anim_set(int id, int value)
+{
+    Anim *a;
+
+    if ((a = anim_find(id, 0)) == NULL)
+	return -1;
+    a->value = value;
+    a->due = 0;
+    return 0;
+}
+
+
+/* id -1 removes them all */
+void anim_delete(int id)
+{
+    int i;
+
+    for (i = 0; i < ANIM_MAX; i++)
+	if ((id == -1) || (Anims[i].id == id))
+	    Anims[i].used = 0;
+}
+
+
+
+static int anim_put(int row, int col, SLsmg_Char_Type *cells, int n)
+{
+    SLsmg_Char_Type old[ANIM_WIDTH];
+    int r = SLsmg_get_row(), c = SLsmg_get_column();
+    int changed = 0, offset = snap_color_offset(), i;
+
+    /* the colors as SLsmg_set_color would have put them on the screen */
+    if (offset)
+	for (i = 0; i < n; i++)
+	    cells[i] = SLSMG_BUILD_CHAR(SLSMG_EXTRACT_CHAR(cells[i]),
+					SLSMG_EXTRACT_COLOR(cells[i]) + offset);
+    SLsmg_gotorc(row, col);
+    if ((SLsmg_read_raw(old, n) != (unsigned int) n)
+	|| (memcmp(old, cells, n * sizeof(SLsmg_Char_Type)) != 0)) {
+	SLsmg_write_raw(cells, n);
+	changed = 1;
+    }
+    SLsmg_gotorc(r, c);
+    return changed;
+}
+
+
+static void cells_text(SLsmg_Char_Type *cells, int n, char *s, int color)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	cells[i] = SLSMG_BUILD_CHAR(*s ? *s : ' ', color);
+	if (*s)
+	    s++;
+    }
+}
+
+
+static int anim_draw(Anim *a)
+{
+    SLsmg_Char_Type cells[ANIM_WIDTH];
+    char s[ANIM_WIDTH + 1];
+    int i, fill, len, start;
+    time_t t;
+
+    switch (a->kind) {
+    case ANIM_SPINNER:
+	cells[0] = SLSMG_BUILD_CHAR(a->text[a->frame % strlen(a->text)],
+				    a->color);
+	return anim_put(a->row, a->col, cells, 1);
+
+    case ANIM_PROGRESS:
+	if (a->value < 0) {
+	    /* unknown amount, a block going back and forth */
+	    len = (a->width + 4) / 5;
+	    fill = a->width - len;
+	    start = fill ? (int) (a->frame % (2 * fill)) : 0;
+	    if (start > fill)
+		start = 2 * fill - start;
+	    for (i = 0; i < a->width; i++)
+		cells[i] = SLSMG_BUILD_CHAR(' ', ((i >= start) && (i < start + len))
+					    ? a->color2 : a->color);
+	    return anim_put(a->row, a->col, cells, a->width);
+	}
+	fill = (a->value > 100 ? 100 : a->value) * a->width / 100;
+	len = sprintf(s, "%d%%", a->value > 100 ? 100 : a->value);
+	start = (a->width - len) / 2;
+	for (i = 0; i < a->width; i++)
+	    cells[i] = SLSMG_BUILD_CHAR(((i >= start) && (i < start + len))
+					? s[i - start] : ' ',
+					(i < fill) ? a->color2 : a->color);
+	return anim_put(a->row, a->col, cells, a->width);
+
+    case ANIM_CLOCK:
+	t = time(NULL);
+	if (strftime(s, sizeof(s), a->text, localtime(&t)) == 0)
+	    s[0] = 0;
+	cells_text(cells, a->width, s, a->color);
+	return anim_put(a->row, a->col, cells, a->width);
+    }
+    return 0;
+}
+
+
+/*
+ * Draw every animation due within slack ms.  Returns the number of
+ * ms until the next one is due, -1 if there are none, and sets
+ * *dirty if anything on the screen changed.
+ */
+static int anim_run(int slack, int *dirty)
+{
+    uint64_t now = stats_now(), next = 0;
+    int i;
+    Anim *a;
+
+    for (i = 0; i < ANIM_MAX; i++) {
+	a = &Anims[i];
+	if (!a->used)
+	    continue;
+	if (a->due <= now + (uint64_t) slack * 1000000) {
+	    if (anim_draw(a))
+		*dirty = 1;
+	    a->frame++;
+	    /* frames missed while we were busy are skipped */
+	    a->due = (a->due + a->period > now) ? a->due + a->period
+						: now + a->period;
+	}
+	if ((next == 0) || (a->due < next))
+	    next = a->due;
+    }
+    if (next == 0)
+	return -1;
+    return (next > now) ? (int) ((next - now + 999999) / 1000000) : 0;
+}
+
+
+/* ms until the next animation is due, -1 if there are none */
+static int anim_next(void)
+{
+    uint64_t now = stats_now(), next = 0;
+    int i, any = 0;
+
+    for (i = 0; i < ANIM_MAX; i++)
+	if (Anims[i].used && (!any || (Anims[i].due < next))) {
+	    next = Anims[i].due;
+	    any = 1;
+	}
+    if (!any)
+	return -1;
+    return (next > now) ? (int) ((next - now + 999999) / 1000000) : 0;
+}
+
+
+/* from the driver timer */
+int anim_tick(void)
+{
+    int dirty = 0, next;
+
+    if (Smg_Batch) {
+	/* look again later, the refresh that ends the batch may take
+	   the frames along before that */
+	next = anim_next();
+	return ((next >= 0) && (next < ANIM_SLACK)) ? ANIM_SLACK : next;
+    }
+    next = anim_run(0, &dirty);
+    if (dirty) {
+	SLsmg_refresh();
+	cast_refreshed();
+    }
+    return next;
+}
+
+
+/* just before an SLsmg_refresh asked for by Erlang */
+void anim_before_refresh(void)
+{
+    int dirty = 0;
+
+    anim_run(ANIM_SLACK, &dirty);
+}
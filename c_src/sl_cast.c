@@ -0,0 +1,368 @@
+/*
+ * Session recording in asciicast v2 format.
+ *
+ * Everything libslang writes to the terminal passes SLtt_Output_Hook
+ * on its way out of SLtt_flush_output.  The hook only time stamps the
+ * chunk and appends it to a buffer; a writer thread swaps the buffer
+ * out, escapes the output as JSON and writes the events to the file.
+ * The terminal never waits for the disk: if the writer falls behind
+ * by more than CAST_BUF_MAX bytes, chunks are dropped and counted.
+ *
+ * Keyframes are full redraws of the screen built from the SLsmg
+ * virtual screen, written as an ordinary output event.  One goes out
+ * when the recording starts and, if asked for, one every interval
+ * after a refresh, so players can seek.  They are never dropped for
+ * want of room: the buffer grows to take one, however large the
+ * screen, and only a keyframe that cannot be allocated is lost.  Output bytes above 0x7f are
+ * recorded as Latin-1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slang_drv.h"
+
+
+#define CAST_BUF_MAX   (256 * 1024)
+#define CAST_HDR       13                  /* Ns:64 Type:8 Len:32 */
+
+static int Cast_On = 0;
+static FILE *Cast_Fp;
+static ErlDrvTid Cast_Thread;
+static ErlDrvMutex *Cast_Lock;
+static ErlDrvCond *Cast_Wake;
+static int Cast_Stopping;
+
+static char *Fill, *Drain;                 /* CAST_BUF_MAX at least */
+static int Fill_Size, Drain_Size;
+static int Fill_Len;
+static unsigned long Dropped;
+
+static uint64_t Cast_Start;
+static uint64_t Keyframe_Interval, Last_Keyframe;   /* ns, 0 no periodic */
+static int Cast_Rows, Cast_Cols;
+
+
+
+/* returns -1 if the event was dropped, which output is when the writer
+   is CAST_BUF_MAX behind, while a keyframe grows the buffer instead */
+static int cast_put(int type, char *buf, unsigned int n, int keyframe)
+{
+    uint64_t t = stats_now() - Cast_Start;
+    int need;
+    char *p;
+
+    erl_drv_mutex_lock(Cast_Lock);
+    need = Fill_Len + CAST_HDR + n;
+    if ((need > CAST_BUF_MAX) && !keyframe) {
+	Dropped++;
+	erl_drv_mutex_unlock(Cast_Lock);
+	return -1;
+    }
+    if (need > Fill_Size) {
+	if ((p = driver_realloc(Fill, need)) == NULL) {
+	    Dropped++;
+	    erl_drv_mutex_unlock(Cast_Lock);
+	    return -1;
+	}
+	Fill = p;
+	Fill_Size = need;
+    }
+    p = Fill + Fill_Len;
+    put_int32(t >> 32, p);
+    put_int32(t & 0xffffffff, p+4);
+    p[8] = type;
+    put_int32(n, p+9);
+    memcpy(p + CAST_HDR, buf, n);
+    if (Fill_Len == 0)
+	erl_drv_cond_signal(Cast_Wake);
+    Fill_Len += CAST_HDR + n;
+    erl_drv_mutex_unlock(Cast_Lock);
+    return 0;
+}
+
+
+static void cast_output_hook(char *buf, unsigned int n)
+{
+    char size[32];
+
+    if ((SLtt_Screen_Rows != Cast_Rows) || (SLtt_Screen_Cols != Cast_Cols)) {
+	Cast_Rows = SLtt_Screen_Rows;
+	Cast_Cols = SLtt_Screen_Cols;
+	sprintf(size, "%dx%d", Cast_Cols, Cast_Rows);
+	(void) cast_put('r', size, strlen(size), 0);
+    }
+    (void) cast_put('o', buf, n, 0);
+}
+
+
+
+/* writer thread */
+
+static void write_event(FILE *fp, uint64_t t, int type, unsigned char *s, int n)
+{
+    int i;
+
+    fprintf(fp, "[%llu.%06llu, \"%c\", \"",
+	    (unsigned long long) (t / 1000000000),
+	    (unsigned long long) (t % 1000000000 / 1000), type);
+    for (i = 0; i < n; i++) {
+	switch (s[i]) {
+	case '"':  fputs("\\\"", fp); break;
+	case '\\': fputs("\\\\", fp); break;
+	case '\n': fputs("\\n", fp); break;
+	case '\r': fputs("\\r", fp); break;
+	case '\t': fputs("\\t", fp); break;
+	case '\b': fputs("\\b", fp); break;
+	default:
+	    if ((s[i] < 0x20) || (s[i] >= 0x7f))
+		fprintf(fp, "\\u%04x", s[i]);
+	    else
+		putc(s[i], fp);
+	}
+    }
+    fputs("\"]\n", fp);
+}
+
+
+static void *cast_writer(void *arg)
+{
+    char *tmp, *p, *end;
+    int len, size, stopping;
+    uint64_t t;
+
+    for (;;) {
+	erl_drv_mutex_lock(Cast_Lock);
+	while ((Fill_Len == 0) && !Cast_Stopping)
+	    erl_drv_cond_wait(Cast_Wake, Cast_Lock);
+	tmp = Drain; Drain = Fill; Fill = tmp;
+	size = Drain_Size; Drain_Size = Fill_Size; Fill_Size = size;
+	len = Fill_Len;
+	Fill_Len = 0;
+	stopping = Cast_Stopping;
+	erl_drv_mutex_unlock(Cast_Lock);
+
+	for (p = Drain, end = Drain + len; p < end; ) {
+	    t = ((uint64_t) get_int32(p) << 32) | (uint32_t) get_int32(p+4);
+	    len = get_int32(p+9);
+	    write_event(Cast_Fp, t, p[8], (unsigned char *) p + CAST_HDR, len);
+	    p += CAST_HDR + len;
+	}
+	fflush(Cast_Fp);
+	if (stopping)
+	    return NULL;
+    }
+}
+
+
+
+/* keyframe */
+
+typedef struct {
+    char *buf;
+    int len, size;
+    int failed;                             /* something did not fit */
+} Kbuf;
+
+static void kput(Kbuf *k, char *s, int n)
+{
+    char *b;
+
+    if (k->failed)
+	return;
+    if (k->len + n > k->size) {
+	if ((b = driver_realloc(k->buf, 2 * k->size + n)) == NULL) {
+	    k->failed = 1;
+	    return;
+	}
+	k->buf = b;
+	k->size = 2 * k->size + n;
+    }
+    memcpy(k->buf + k->len, s, n);
+    k->len += n;
+}
+
+static int sgr_color(char *p, int base, int c)
+{
+    if (c == 0xff)                          /* default */
+	return sprintf(p, ";%d", base + 9);
+    if (c >= 8)
+	return sprintf(p, ";%d", base + 60 + (c & 7));
+    return sprintf(p, ";%d", base + c);
+}
+
+/* SGR for an SLsmg color, ANSI as asciicast players understand it */
+static void ksgr(Kbuf *k, int color)
+{
+    SLtt_Char_Type fgbg = SLtt_get_color_object(color);
+    char s[64], *p = s;
+
+    p += sprintf(p, "\033[0");
+    if (fgbg & SLTT_BOLD_MASK) p += sprintf(p, ";1");
+    if (fgbg & SLTT_ULINE_MASK) p += sprintf(p, ";4");
+    if (fgbg & SLTT_BLINK_MASK) p += sprintf(p, ";5");
+    if (fgbg & SLTT_REV_MASK) p += sprintf(p, ";7");
+    if (SLtt_Use_Ansi_Colors) {
+	p += sgr_color(p, 30, (fgbg >> 8) & 0xff);
+	p += sgr_color(p, 40, (fgbg >> 16) & 0xff);
+    }
+    *p++ = 'm';
+    kput(k, s, p - s);
+}
+
+/* returns -1 if the keyframe could not be recorded */
+int cast_keyframe(void)
+{
+    int rows = SLtt_Screen_Rows, cols = SLtt_Screen_Cols;
+    int r, c, color, alt, cur_color = -1, cur_alt = 0, ret;
+    SLsmg_Char_Type *screen, cell;
+    Kbuf k;
+    char s[32], ch;
+
+    if (!Cast_On || (rows <= 0) || (cols <= 0))
+	return 0;
+    if ((screen = driver_alloc(rows * cols * sizeof(SLsmg_Char_Type))) == NULL)
+	return -1;
+    if ((k.buf = driver_alloc(k.size = rows * cols * 2 + 256)) == NULL) {
+	driver_free(screen);
+	return -1;
+    }
+    k.len = 0;
+    k.failed = 0;
+
+    /* have the terminal in the state we leave the recording in */
+    SLtt_normal_video();
+    SLtt_flush_output();
+
+    snap_read_screen(screen, rows, cols);
+    kput(&k, "\033(B\033[0m\033[H\033[2J", 14);
+    for (r = 0; r < rows; r++) {
+	kput(&k, s, sprintf(s, "\033[%d;1H", r + 1));
+	for (c = 0; c < cols; c++) {
+	    cell = screen[r * cols + c];
+	    color = (cell >> 8) & 0x7f;
+	    alt = (cell & 0x8000) != 0;
+	    if (color != cur_color) {
+		ksgr(&k, color);
+		cur_color = color;
+	    }
+	    if (alt != cur_alt) {
+		kput(&k, alt ? "\033(0" : "\033(B", 3);
+		cur_alt = alt;
+	    }
+	    ch = cell & 0xff;
+	    kput(&k, ((unsigned char) ch < 0x20) ? " " : &ch, 1);
+	}
+    }
+    if (cur_alt)
+	kput(&k, "\033(B", 3);
+    ksgr(&k, 0);
+    kput(&k, s, sprintf(s, "\033[%d;%dH",
+			SLsmg_get_row() + 1, SLsmg_get_column() + 1));
+    /* half a keyframe would leave players with a garbled screen */
+    if (k.failed) {
+	erl_drv_mutex_lock(Cast_Lock);
+	Dropped++;
+	erl_drv_mutex_unlock(Cast_Lock);
+	ret = -1;
+    }
+    else
+	ret = cast_put('o', k.buf, k.len, 1);
+    driver_free(k.buf);
+    driver_free(screen);
+    Last_Keyframe = stats_now();
+    return ret;
+}
+
+
+/* after a refresh, when it is time for the next keyframe */
+void cast_refreshed(void)
+{
+    if (Cast_On && Keyframe_Interval
+	&& (stats_now() - Last_Keyframe >= Keyframe_Interval))
+	(void) cast_keyframe();
+}
+
+
+
+static void cast_free(void)
+{
+    if (Cast_Wake != NULL)
+	erl_drv_cond_destroy(Cast_Wake);
+    if (Cast_Lock != NULL)
+	erl_drv_mutex_destroy(Cast_Lock);
+    if (Fill != NULL)
+	driver_free(Fill);
+    if (Drain != NULL)
+	driver_free(Drain);
+    Cast_Wake = NULL;
+    Cast_Lock = NULL;
+    Fill = Drain = NULL;
+    Fill_Size = Drain_Size = 0;
+}
+
+
+/* interval_ms < 0: no keyframes, 0: only the first one */
+int cast_start(char *file, int interval_ms)
+{
+    char *term = getenv("TERM");
+
+    cast_stop();
+    if (((Fill = driver_alloc(CAST_BUF_MAX)) == NULL)
+	|| ((Drain = driver_alloc(CAST_BUF_MAX)) == NULL)
+	|| ((Cast_Lock = erl_drv_mutex_create("sl_cast")) == NULL)
+	|| ((Cast_Wake = erl_drv_cond_create("sl_cast")) == NULL)) {
+	cast_free();
+	return -1;
+    }
+    Fill_Size = Drain_Size = CAST_BUF_MAX;
+    if ((Cast_Fp = fopen(file, "w")) == NULL) {
+	cast_free();
+	return -1;
+    }
+    Cast_Rows = SLtt_Screen_Rows;
+    Cast_Cols = SLtt_Screen_Cols;
+    fprintf(Cast_Fp, "{\"version\": 2, \"width\": %d, \"height\": %d, "
+	    "\"timestamp\": %ld, \"env\": {\"TERM\": \"%s\"}}\n",
+	    Cast_Cols, Cast_Rows, (long) time(NULL),
+	    (term && !strchr(term, '"') && !strchr(term, '\\')) ? term : "");
+    Fill_Len = 0;
+    Dropped = 0;
+    Cast_Stopping = 0;
+    if (erl_drv_thread_create("sl_cast", &Cast_Thread, cast_writer, NULL, NULL) != 0) {
+	fclose(Cast_Fp);
+	cast_free();
+	return -1;
+    }
+    Cast_Start = stats_now();
+    Keyframe_Interval = (interval_ms > 0) ? (uint64_t) interval_ms * 1000000 : 0;
+    Cast_On = 1;
+    SLtt_flush_output();                   /* nothing from before */
+    SLtt_Output_Hook = cast_output_hook;
+    if ((interval_ms >= 0) && (cast_keyframe() == -1)) {
+	(void) cast_stop();
+	return -1;
+    }
+    return 0;
+}
+
+
+/* returns the number of chunks that had to be dropped */
+unsigned long cast_stop(void)
+{
+    if (!Cast_On)
+	return 0;
+    SLtt_flush_output();
+    SLtt_Output_Hook = NULL;
+    Cast_On = 0;
+    erl_drv_mutex_lock(Cast_Lock);
+    Cast_Stopping = 1;
+    erl_drv_cond_signal(Cast_Wake);
+    erl_drv_mutex_unlock(Cast_Lock);
+    erl_drv_thread_join(Cast_Thread, NULL);
+    fclose(Cast_Fp);
+    cast_free();
+    return Dropped;
+}
@@ -0,0 +1,69 @@
+/*
+ * Recording of the command stream that reaches the driver, to be
+ * played back later with slang_replay.
+ *
+ * File format, all integers big endian:
+ *
+ *   "SLREC" 1               magic and version
+ *   Rows:16 Cols:16         screen size when the recording started
+ *   { Delta Len Bytes }*    Delta is ns since the previous command,
+ *                           Delta and Len are unsigned LEB128 varints
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slang_drv.h"
+
+
+static FILE *Cmdlog = NULL;
+static uint64_t Cmdlog_Last;
+
+
+static void put_varint(uint64_t v, FILE *fp)
+{
+    while (v >= 0x80) {
+	putc((int)(v & 0x7f) | 0x80, fp);
+	v >>= 7;
+    }
+    putc((int) v, fp);
+}
+
+
+int cmdlog_start(char *file)
+{
+    char hdr[10];
+
+    cmdlog_stop();
+    if ((Cmdlog = fopen(file, "wb")) == NULL)
+	return -1;
+    memcpy(hdr, "SLREC\001", 6);
+    put_int16(SLtt_Screen_Rows, hdr+6);
+    put_int16(SLtt_Screen_Cols, hdr+8);
+    fwrite(hdr, 1, 10, Cmdlog);
+    Cmdlog_Last = stats_now();
+    return 0;
+}
+
+
+void cmdlog_stop(void)
+{
+    if (Cmdlog != NULL)
+	fclose(Cmdlog);
+    Cmdlog = NULL;
+}
+
+
+void cmdlog_write(char *buf, int len)
+{
+    uint64_t now;
+
+    if (Cmdlog == NULL)
+	return;
+    now = stats_now();
+    put_varint(now - Cmdlog_Last, Cmdlog);
+    put_varint(len, Cmdlog);
+    fwrite(buf, 1, len, Cmdlog);
+    Cmdlog_Last = now;
+}
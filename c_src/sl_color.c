@@ -0,0 +1,250 @@
+/*
+ * Color objects allocated on demand.
+ *
+ * slang:color/3 and slang:smg_set_color/3 name a color by its
+ * foreground, background and attributes; the driver hands out color
+ * objects COLOR_FIRST..COLOR_LAST for them from a hash table and sets
+ * them up with SLtt_set_color_fgbg, so no color name is ever parsed.
+ * When all objects are taken, the least recently used one that is not
+ * on the screen is reused.  Objects below COLOR_FIRST are left alone
+ * for the tt_set_color family.  On a terminal without bce the cells
+ * hold every object one up, so COLOR_LAST is not handed out there: it
+ * would become 128, the alternate character set flag.
+ *
+ * Colors are -1 for the terminal default, 0..255 for palette entries
+ * and COLOR_RGB | 0xRRGGBB for 24 bit colors.  libslang can only send
+ * palette colors, so RGB colors are mapped to the nearest entry of the
+ * xterm 256 color palette, or of the 16 ANSI colors when the terminal
+ * has fewer than 256 colors.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "slang_drv.h"
+
+
+#define COLOR_FIRST   64
+#define COLOR_LAST    127
+#define COLOR_HASH    256                   /* power of 2, > 2 * objects */
+
+#define COLOR_RGB     0x1000000
+#define COLOR_DEFAULT 0x2000000
+
+static uint64_t Color_Key[COLOR_LAST + 1];
+static int Color_Valid[COLOR_LAST + 1];
+static unsigned long Color_Use[COLOR_LAST + 1];
+static unsigned long Color_Clock = 0;
+static unsigned char Color_Table[COLOR_HASH];   /* object, 0 is empty */
+static int Colors = 0;                          /* terminal's, 0 unknown */
+
+/* xterm's values for the 16 ANSI colors */
+static const unsigned char Ansi_Rgb[16][3] = {
+    {0, 0, 0}, {205, 0, 0}, {0, 205, 0}, {205, 205, 0},
+    {0, 0, 238}, {205, 0, 205}, {0, 205, 205}, {229, 229, 229},
+    {127, 127, 127}, {255, 0, 0}, {0, 255, 0}, {255, 255, 0},
+    {92, 92, 255}, {255, 0, 255}, {0, 255, 255}, {255, 255, 255}
+};
+
+static const unsigned char Cube[6] = {0, 95, 135, 175, 215, 255};
+
+
+
+static int dist(int r1, int g1, int b1, int r2, int g2, int b2)
+{
+    return (r1-r2)*(r1-r2) + (g1-g2)*(g1-g2) + (b1-b2)*(b1-b2);
+}
+
+static int nearest_ansi(int r, int g, int b)
+{
+    int i, d, best = 0, best_d = 1 << 30;
+
+    for (i = 0; i < 16; i++) {
+	d = dist(r, g, b, Ansi_Rgb[i][0], Ansi_Rgb[i][1], Ansi_Rgb[i][2]);
+	if (d < best_d) {
+	    best_d = d;
+	    best = i;
+	}
+    }
+    return best;
+}
+
+static int cube_level(int v)
+{
+    return (v < 48) ? 0 : (v < 115) ? 1 : (v - 35) / 40;
+}
+
+static int nearest_256(int r, int g, int b)
+{
+    int cr = cube_level(r), cg = cube_level(g), cb = cube_level(b);
+    int gray, gi, cube_d, gray_d;
+
+    cube_d = dist(r, g, b, Cube[cr], Cube[cg], Cube[cb]);
+    gi = ((r + g + b) / 3 - 3) / 10;
+    gi = (gi < 0) ? 0 : (gi > 23) ? 23 : gi;
+    gray = 8 + 10 * gi;
+    gray_d = dist(r, g, b, gray, gray, gray);
+    if (gray_d < cube_d)
+	return 232 + gi;
+    return 16 + 36 * cr + 6 * cg + cb;
+}
+
+/* palette entry i as RGB */
+static void palette_rgb(int i, int *r, int *g, int *b)
+{
+    if (i < 16) {
+	*r = Ansi_Rgb[i][0]; *g = Ansi_Rgb[i][1]; *b = Ansi_Rgb[i][2];
+    }
+    else if (i < 232) {
+	i -= 16;
+	*r = Cube[i / 36]; *g = Cube[(i / 6) % 6]; *b = Cube[i % 6];
+    }
+    else
+	*r = *g = *b = 8 + 10 * (i - 232);
+}
+
+
+/* to what SLtt_set_color_fgbg takes */
+static SLtt_Char_Type resolve(int c)
+{
+    int r, g, b;
+
+    if (Colors == 0)
+	if ((Colors = SLtt_tgetnum("Co")) < 8)
+	    Colors = 8;
+
+    if (c & COLOR_DEFAULT)
+	return 0xff;
+    if (c & COLOR_RGB) {
+	r = (c >> 16) & 0xff; g = (c >> 8) & 0xff; b = c & 0xff;
+	return (Colors >= 256) ? nearest_256(r, g, b) : nearest_ansi(r, g, b);
+    }
+    c &= 0xff;
+    if ((c >= 16) && (Colors < 256)) {
+	palette_rgb(c, &r, &g, &b);
+	return nearest_ansi(r, g, b);
+    }
+    return c;
+}
+
+
+static uint32_t norm(int c)
+{
+    if (c < 0)
+	return COLOR_DEFAULT;
+    if (c & COLOR_RGB)
+	return COLOR_RGB | (c & 0xffffff);
+    return c & 0xff;
+}
+
+static unsigned int hash(uint64_t key)
+{
+    key ^= key >> 29;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 32;
+    return (unsigned int) key & (COLOR_HASH - 1);
+}
+
+static void table_insert(int obj)
+{
+    unsigned int h = hash(Color_Key[obj]);
+
+    while (Color_Table[h] != 0)
+	h = (h + 1) & (COLOR_HASH - 1);
+    Color_Table[h] = obj;
+}
+
+static int table_find(uint64_t key)
+{
+    unsigned int h = hash(key);
+
+    while (Color_Table[h] != 0) {
+	if (Color_Key[Color_Table[h]] == key)
+	    return Color_Table[h];
+	h = (h + 1) & (COLOR_HASH - 1);
+    }
+    return -1;
+}
+
+
+/* a free object up to last, or the least recently used one not on the
+   screen */
+static int color_victim(int last, int offset)
+{
+    int obj, best = -1, rows = SLtt_Screen_Rows, cols = SLtt_Screen_Cols, i, c;
+    char on_screen[COLOR_LAST + 1];
+    SLsmg_Char_Type *screen;
+
+    for (obj = COLOR_FIRST; obj <= last; obj++)
+	if (!Color_Valid[obj])
+	    return obj;
+
+    memset(on_screen, 0, sizeof(on_screen));
+    if ((rows > 0) && (cols > 0)
+	&& ((screen = driver_alloc(rows * cols * sizeof(SLsmg_Char_Type))) != NULL)) {
+	snap_read_screen(screen, rows, cols);
+	for (i = 0; i < rows * cols; i++)
+	    if ((c = ((screen[i] >> 8) & 0x7f) - offset) >= 0)
+		on_screen[c] = 1;
+	driver_free(screen);
+    }
+    for (obj = COLOR_FIRST; obj <= last; obj++) {
+	if (on_screen[obj])
+	    continue;
+	if ((best == -1) || (Color_Use[obj] < Color_Use[best]))
+	    best = obj;
+    }
+    if (best != -1)
+	return best;
+    /* everything is on the screen, some of it will change color */
+    for (obj = best = COLOR_FIRST; obj <= last; obj++)
+	if (Color_Use[obj] < Color_Use[best])
+	    best = obj;
+    return best;
+}
+
+
+int color_get(int fg, int bg, int attrs)
+{
+    uint64_t key;
+    int obj, i, offset = snap_color_offset(), last = COLOR_LAST - offset;
+    SLtt_Char_Type a = 0;
+
+    key = (uint64_t) norm(fg) | ((uint64_t) norm(bg) << 26)
+	| ((uint64_t) (attrs & 0xf) << 52);
+    if (((obj = table_find(key)) != -1) && (obj <= last)) {
+	Color_Use[obj] = ++Color_Clock;
+	return obj;
+    }
+
+    /* a miss: take an object and rebuild the table around it, without
+       the objects above last if the terminal has lost bce */
+    obj = color_victim(last, offset);
+    Color_Key[obj] = key;
+    Color_Valid[obj] = 1;
+    Color_Use[obj] = ++Color_Clock;
+    memset(Color_Table, 0, sizeof(Color_Table));
+    for (i = COLOR_FIRST; i <= COLOR_LAST; i++) {
+	if (i > last)
+	    Color_Valid[i] = 0;
+	if (Color_Valid[i])
+	    table_insert(i);
+    }
+
+    if (attrs & COLOR_BOLD) a |= SLTT_BOLD_MASK;
+    if (attrs & COLOR_ULINE) a |= SLTT_ULINE_MASK;
+    if (attrs & COLOR_BLINK) a |= SLTT_BLINK_MASK;
+    if (attrs & COLOR_REV) a |= SLTT_REV_MASK;
+    SLtt_set_color_fgbg(obj, resolve(norm(fg)), resolve(norm(bg)));
+    if (a)
+	SLtt_add_color_attribute(obj, a);
+    return obj;
+}
+
+
+void color_reset(void)
+{
+    memset(Color_Valid, 0, sizeof(Color_Valid));
+    memset(Color_Table, 0, sizeof(Color_Table));
+    Colors = 0;
+}
@@ -0,0 +1,333 @@
+/*
+ * Tab completion for the driver's line editor.
+ *
+ * Erlang loads the words to complete from in bulk, into one of a few
+ * sources: source 0 is for the first word of the line (commands), the
+ * others for the words after it (host names, node names).  Each source
+ * is a trie whose nodes know how many words are below them, so finding
+ * the words with a prefix, how many there are and how far they agree
+ * takes time in the length of the prefix, not the number of words.
+ *
+ * When no loaded word fits and completion_callback(true) was done,
+ * sl_rline.c asks Erlang instead with {slang_complete, Gen, Source,
+ * Prefix}, and compl_from_list() turns the answer into the same kind
+ * of candidate list.
+ *
+ * More than one candidate and nothing more in common shows a menu of
+ * them under (or above) the edit line, drawn on the SLsmg screen and
+ * taken away again on the next key.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "slang_drv.h"
+
+
+#define COMPL_WORD       256                /* longest word */
+#define COMPL_MENU_ROWS  6
+
+typedef struct {
+    int child, next;                        /* -1 if none */
+    int words;                              /* words at or below */
+    unsigned char ch, end;
+} Tnode;
+
+typedef struct {
+    Tnode *node;                            /* [0] is the root */
+    int used, size;
+} Trie;
+
+static Trie Tries[COMPL_SOURCES];
+
+static SLsmg_Char_Type *Menu_Saved = NULL;
+static int Menu_Row, Menu_Col, Menu_Rows, Menu_Width;
+
+
+
+static int trie_node(Trie *t, unsigned char ch)
+{
+    Tnode *n;
+    int size;
+
+    if (t->used == t->size) {
+	size = t->size ? 2 * t->size : 1024;
+	n = t->node ? driver_realloc(t->node, size * sizeof(Tnode))
+	    : driver_alloc(size * sizeof(Tnode));
+	if (n == NULL)
+	    return -1;
+	t->node = n;
+	t->size = size;
+    }
+    n = &t->node[t->used];
+    n->child = n->next = -1;
+    n->words = 0;
+    n->ch = ch;
+    n->end = 0;
+    return t->used++;
+}
+
+static int str_cmp(const void *a, const void *b)
+{
+    return strcmp(*(char **) a, *(char **) b);
+}
+
+
+/* the child of node for ch, -1 if none */
+static int trie_child(Trie *t, int node, unsigned char ch)
+{
+    int i;
+
+    for (i = t->node[node].child; i != -1; i = t->node[i].next)
+	if (t->node[i].ch == ch)
+	    return i;
+    return -1;
+}
+
+
+static void trie_insert(Trie *t, char *w)
+{
+    int node = 0, c, last, path[COMPL_WORD + 1], depth = 0, i;
+
+    path[depth++] = 0;
+    for (; *w && (depth <= COMPL_WORD); w++) {
+	if ((c = trie_child(t, node, *w)) == -1) {
+	    if ((c = trie_node(t, *w)) == -1)
+		return;
+	    /* words come sorted, so a new child goes last */
+	    if ((last = t->node[node].child) == -1)
+		t->node[node].child = c;
+	    else {
+		while (t->node[last].next != -1)
+		    last = t->node[last].next;
+		t->node[last].next = c;
+	    }
+	}
+	node = c;
+	path[depth++] = node;
+    }
+    if (t->node[node].end)
+	return;                             /* a duplicate */
+    t->node[node].end = 1;
+    for (i = 0; i < depth; i++)
+	t->node[path[i]].words++;
+}
+
+
+/* words separated by NULs, replacing what the source had */
+int compl_load(int source, char *buf, int len)
+{
+    Trie *t;
+    char **words, *p, *end = buf + len;
+    int n = 0, i;
+
+    if ((source < 0) || (source >= COMPL_SOURCES))
+	return -1;
+    t = &Tries[source];
+    if (t->node != NULL)
+	driver_free(t->node);
+    t->node = NULL;
+    t->used = t->size = 0;
+    if (trie_node(t, 0) == -1)
+	return -1;
+
+    for (p = buf; p < end; p += strlen(p) + 1)
+	n++;
+    if ((words = driver_alloc((n + 1) * sizeof(char *))) == NULL)
+	return -1;
+    for (p = buf, i = 0; p < end; p += strlen(p) + 1)
+	if (*p)
+	    words[i++] = p;
+    n = i;
+    qsort(words, n, sizeof(char *), str_cmp);
+    for (i = 0; i < n; i++)
+	trie_insert(t, words[i]);
+    driver_free(words);
+    return t->node[0].words;
+}
+
+
+void compl_reset(void)
+{
+    int i;
+
+    for (i = 0; i < COMPL_SOURCES; i++) {
+	if (Tries[i].node != NULL)
+	    driver_free(Tries[i].node);
+	Tries[i].node = NULL;
+	Tries[i].used = Tries[i].size = 0;
+    }
+}
+
+
+
+static void cands_add(Compl_Cands *c, char *w, int len)
+{
+    if ((c->n == COMPL_MENU_MAX) || (c->used + len + 1 > COMPL_BUF))
+	return;
+    c->w[c->n++] = c->buf + c->used;
+    memcpy(c->buf + c->used, w, len);
+    c->used += len;
+    c->buf[c->used++] = 0;
+}
+
+
+/* the first words below node in order, word[0..depth) leads to it */
+static void trie_collect(Trie *t, int node, char *word, int depth,
+			 Compl_Cands *c)
+{
+    int i;
+
+    if (t->node[node].end)
+	cands_add(c, word, depth);
+    if (depth == COMPL_WORD)
+	return;
+    for (i = t->node[node].child; (i != -1) && (c->n < COMPL_MENU_MAX);
+	 i = t->node[i].next) {
+	word[depth] = t->node[i].ch;
+	trie_collect(t, i, word, depth + 1, c);
+    }
+}
+
+
+/* the words of source starting with prefix */
+void compl_find(int source, char *prefix, int plen, Compl_Cands *c)
+{
+    Trie *t;
+    char word[COMPL_WORD + 1];
+    int node = 0, i;
+
+    c->n = c->total = c->used = c->lcp = 0;
+    if ((source < 0) || (source >= COMPL_SOURCES) || (plen > COMPL_WORD))
+	return;
+    t = &Tries[source];
+    if (t->node == NULL)
+	return;
+    for (i = 0; (i < plen) && (node != -1); i++)
+	node = trie_child(t, node, prefix[i]);
+    if ((node == -1) || (t->node[node].words == 0))
+	return;
+    c->total = t->node[node].words;
+
+    memcpy(word, prefix, plen);
+    trie_collect(t, node, word, plen, c);
+
+    /* as far as there is only one way on */
+    for (c->lcp = plen; !t->node[node].end && (t->node[node].child != -1)
+	     && (t->node[t->node[node].child].next == -1); c->lcp++)
+	node = t->node[node].child;
+}
+
+
+/* candidates from a list of NUL separated words, as Erlang sends them */
+void compl_from_list(char *buf, int len, Compl_Cands *c)
+{
+    char *p, *end = buf + len;
+    int i, l;
+
+    c->n = c->total = c->used = c->lcp = 0;
+    for (p = buf; p < end; p += strlen(p) + 1) {
+	if (*p == 0)
+	    continue;
+	l = strlen(p);
+	if (c->total == 0)
+	    c->lcp = l;
+	else {
+	    for (i = 0; (i < c->lcp) && (i < l) && (c->w[0][i] == p[i]); i++)
+		;
+	    c->lcp = i;
+	}
+	cands_add(c, p, l);
+	c->total++;
+    }
+}
+
+
+
+/* menu */
+
+void compl_menu_hide(void)
+{
+    int r, cur_r = SLsmg_get_row(), cur_c = SLsmg_get_column();
+
+    if (Menu_Saved == NULL)
+	return;
+    for (r = 0; r < Menu_Rows; r++) {
+	SLsmg_gotorc(Menu_Row + r, Menu_Col);
+	SLsmg_write_raw(Menu_Saved + r * Menu_Width, Menu_Width);
+    }
+    SLsmg_gotorc(cur_r, cur_c);
+    driver_free(Menu_Saved);
+    Menu_Saved = NULL;
+}
+
+int compl_menu_shown(void)
+{
+    return Menu_Saved != NULL;
+}
+
+
+/* the candidates in columns, next to the edit line at row */
+void compl_menu_show(Compl_Cands *c, int row, int col, int width, int color)
+{
+    SLsmg_Char_Type cells[SLRL_DISPLAY_BUFFER_SIZE];
+    int colw = 0, ncols, rows, below, shown, r, i, k, n, len, cur_r, cur_c;
+    char more[32];
+
+    compl_menu_hide();
+    for (i = 0; i < c->n; i++)
+	if ((len = strlen(c->w[i])) > colw)
+	    colw = len;
+    colw += 2;
+    ncols = (colw > width) ? 1 : width / colw;
+    rows = (c->n + ncols - 1) / ncols;
+    if (rows > COMPL_MENU_ROWS)
+	rows = COMPL_MENU_ROWS;
+    /* below the line if it fits, else wherever there is more room */
+    below = SLtt_Screen_Rows - row - 1;
+    if ((rows > below) && (row > below))
+	Menu_Row = row - ((rows > row) ? (rows = row) : rows);
+    else {
+	if (rows > below)
+	    rows = below;
+	Menu_Row = row + 1;
+    }
+    if (rows <= 0)
+	return;
+    shown = (c->n < rows * ncols) ? c->n : rows * ncols;
+    if ((Menu_Saved = driver_alloc(rows * width * sizeof(SLsmg_Char_Type))) == NULL)
+	return;
+    Menu_Col = col;
+    Menu_Rows = rows;
+    Menu_Width = width;
+
+    cur_r = SLsmg_get_row();
+    cur_c = SLsmg_get_column();
+    for (r = 0; r < rows; r++) {
+	SLsmg_gotorc(Menu_Row + r, col);
+	if (SLsmg_read_raw(Menu_Saved + r * width, width) != (unsigned int) width)
+	    memset(Menu_Saved + r * width, 0, width * sizeof(SLsmg_Char_Type));
+	for (i = 0; i < width; i++)
+	    cells[i] = SLSMG_BUILD_CHAR(' ', color);
+	for (k = 0; k < ncols; k++) {
+	    /* column major, as ls does it */
+	    i = k * rows + r;
+	    if (i >= shown)
+		break;
+	    len = strlen(c->w[i]);
+	    if (len > width - k * colw)
+		len = width - k * colw;
+	    for (n = 0; n < len; n++)
+		cells[k * colw + n] = SLSMG_BUILD_CHAR((unsigned char) c->w[i][n], color);
+	}
+	if ((r == rows - 1) && (c->total > shown)) {
+	    len = sprintf(more, " +%d ", c->total - shown);
+	    if (len <= width)
+		for (n = 0; n < len; n++)
+		    cells[width - len + n] = SLSMG_BUILD_CHAR(more[n], color);
+	}
+	SLsmg_gotorc(Menu_Row + r, col);
+	SLsmg_write_raw(cells, width);
+    }
+    SLsmg_gotorc(cur_r, cur_c);
+}
@@ -0,0 +1,525 @@
+/*
+ * History of the driver's line editor.
+ *
+ * At most Max lines, each one only once: entering a line again moves
+ * it to the end.  The lines are kept three ways:
+ *
+ *   Chron    in the order they were entered, for walking back and
+ *            forth and for the substring search of Ctrl-R.  Removed
+ *            lines stay in it marked dead until they are as many as
+ *            the live ones, then it is packed.
+ *   Sorted   sorted by text, a prefix is a range of it found by
+ *            binary search
+ *   Hash     by text, for finding the line to remove on a repeat
+ *
+ * and every line has a sequence number that only grows, which is what
+ * positions in the history are.
+ *
+ * With a file open, lines are appended to it as they are entered, one
+ * per line with \ and newline escaped.  On open the file is mmap'ed
+ * and replayed.  Whenever it has grown to well over Max lines, on open
+ * or while adding, it is rewritten without the lines that no longer
+ * count.
+ */
+
+#define _GNU_SOURCE                         /* memmem */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "slang_drv.h"
+
+
+#define HIST_DEFAULT_MAX  1000
+#define HIST_TOMB         ((Hent *) 1)
+
+typedef struct {
+    unsigned long seq;
+    int dead;
+    int len;
+    char s[1];
+} Hent;
+
+static Hent **Chron = NULL;
+static int Chron_N = 0, Chron_Size = 0;
+static int Chron_Start = 0;                     /* no live line before */
+static Hent **Sorted = NULL;
+static Hent **Hash = NULL;
+static int Hash_Size = 0, Hash_Used = 0;       /* used counts tombs */
+static int Live = 0;
+static int Loading = 0;                         /* Sorted is rebuilt after */
+static int Max = HIST_DEFAULT_MAX;
+static unsigned long Seq = 0;
+
+static int Fd = -1;
+static char *Path = NULL;
+static int File_Lines = 0;
+static int Compact_At = 0;                      /* File_Lines to compact at */
+
+static void file_compact(void);
+
+
+
+static unsigned int hist_hash(char *s, int len)
+{
+    unsigned int h = 2166136261U;
+
+    while (len--)
+	h = (h ^ (unsigned char) *s++) * 16777619U;
+    return h;
+}
+
+static int hent_cmp(char *s, int len, Hent *e)
+{
+    int r = memcmp(s, e->s, (len < e->len) ? len : e->len);
+
+    return r ? r : len - e->len;
+}
+
+
+/* the slot of s, or of the empty slot where it would go */
+static int hash_slot(char *s, int len)
+{
+    unsigned int i = hist_hash(s, len) & (Hash_Size - 1);
+    int tomb = -1;
+
+    while (Hash[i] != NULL) {
+	if (Hash[i] == HIST_TOMB) {
+	    if (tomb == -1)
+		tomb = i;
+	}
+	else if ((Hash[i]->len == len) && !memcmp(Hash[i]->s, s, len))
+	    return i;
+	i = (i + 1) & (Hash_Size - 1);
+    }
+    return (tomb != -1) ? tomb : (int) i;
+}
+
+static int hash_grow(void)
+{
+    Hent **old = Hash;
+    int i, n = Hash_Size, size = 64;
+
+    while (size < 4 * (Live + 1))
+	size *= 2;
+    if ((Hash = driver_alloc(size * sizeof(Hent *))) == NULL) {
+	Hash = old;
+	return -1;
+    }
+    memset(Hash, 0, size * sizeof(Hent *));
+    Hash_Size = size;
+    Hash_Used = 0;
+    for (i = 0; i < n; i++)
+	if ((old[i] != NULL) && (old[i] != HIST_TOMB)) {
+	    Hash[hash_slot(old[i]->s, old[i]->len)] = old[i];
+	    Hash_Used++;
+	}
+    if (old != NULL)
+	driver_free(old);
+    return 0;
+}
+
+
+/* first index in Sorted not less than s */
+static int sorted_lower(char *s, int len)
+{
+    int lo = 0, hi = Live, mid;
+
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (hent_cmp(s, len, Sorted[mid]) > 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+/* first index in Chron with a seq not less than seq */
+static int chron_lower(unsigned long seq)
+{
+    int lo = Chron_Start, hi = Chron_N, mid;
+
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (Chron[mid]->seq < seq)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+static void chron_pack(void)
+{
+    int i, j;
+
+    for (i = j = 0; i < Chron_N; i++) {
+	if (Chron[i]->dead)
+	    driver_free(Chron[i]);
+	else
+	    Chron[j++] = Chron[i];
+    }
+    Chron_N = j;
+    Chron_Start = 0;
+}
+
+
+static int chron_room(void)
+{
+    Hent **c;
+    int size;
+
+    if (Chron_N < Chron_Size)
+	return 0;
+    if (Live < Chron_Size / 2) {
+	chron_pack();
+	return 0;
+    }
+    size = Chron_Size ? 2 * Chron_Size : 256;
+    c = Chron ? driver_realloc(Chron, size * sizeof(Hent *))
+	: driver_alloc(size * sizeof(Hent *));
+    if (c == NULL)
+	return -1;
+    Chron = c;
+    c = Sorted ? driver_realloc(Sorted, size * sizeof(Hent *))
+	: driver_alloc(size * sizeof(Hent *));
+    if (c == NULL)
+	return -1;
+    Sorted = c;
+    Chron_Size = size;
+    return 0;
+}
+
+
+static void hist_remove(Hent *e)
+{
+    int i;
+
+    Hash[hash_slot(e->s, e->len)] = HIST_TOMB;
+    if (!Loading) {
+	i = sorted_lower(e->s, e->len);
+	memmove(Sorted + i, Sorted + i + 1, (Live - i - 1) * sizeof(Hent *));
+    }
+    e->dead = 1;
+    Live--;
+    if (Chron_N - Live > Live + 64)
+	chron_pack();
+}
+
+
+static void file_append(char *s, int len)
+{
+    char *buf, *p;
+    int i;
+
+    if ((Fd == -1) || ((buf = driver_alloc(2 * len + 1)) == NULL))
+	return;
+    for (i = 0, p = buf; i < len; i++) {
+	if (s[i] == '\\') {
+	    *p++ = '\\'; *p++ = '\\';
+	}
+	else if (s[i] == '\n') {
+	    *p++ = '\\'; *p++ = 'n';
+	}
+	else
+	    *p++ = s[i];
+    }
+    *p++ = '\n';
+    if (write(Fd, buf, p - buf) == p - buf)
+	File_Lines++;
+    driver_free(buf);
+}
+
+
+static int hist_put(char *s, int len, int append)
+{
+    Hent *e;
+    int i, slot;
+
+    if (len == 0)
+	return 0;
+    if (Hash_Size == 0)
+	if (hash_grow() == -1)
+	    return -1;
+    slot = hash_slot(s, len);
+    if ((Hash[slot] != NULL) && (Hash[slot] != HIST_TOMB)) {
+	if (Hash[slot]->seq == Seq)
+	    return 0;                           /* the newest one already */
+	hist_remove(Hash[slot]);
+    }
+    if (chron_room() == -1)
+	return -1;
+    if ((e = driver_alloc(sizeof(Hent) + len)) == NULL)
+	return -1;
+    e->seq = ++Seq;
+    e->dead = 0;
+    e->len = len;
+    memcpy(e->s, s, len);
+    e->s[len] = 0;
+
+    Chron[Chron_N++] = e;
+    if (!Loading) {
+	i = sorted_lower(s, len);
+	memmove(Sorted + i + 1, Sorted + i, (Live - i) * sizeof(Hent *));
+	Sorted[i] = e;
+    }
+    Live++;
+    if (4 * (Hash_Used + 1) > 3 * Hash_Size)
+	hash_grow();
+    slot = hash_slot(s, len);
+    if (Hash[slot] == NULL)
+	Hash_Used++;
+    Hash[slot] = e;
+
+    while (Live > Max) {
+	while (Chron[Chron_Start]->dead)
+	    Chron_Start++;
+	hist_remove(Chron[Chron_Start]);
+    }
+    if (append) {
+	file_append(s, len);
+	if ((Fd != -1) && (File_Lines > Compact_At))
+	    file_compact();
+    }
+    return 0;
+}
+
+
+int hist_add(char *s, int len)
+{
+    return hist_put(s, len, 1);
+}
+
+
+void hist_clear(void)
+{
+    int i;
+
+    for (i = 0; i < Chron_N; i++)
+	driver_free(Chron[i]);
+    if (Chron != NULL)
+	driver_free(Chron);
+    if (Sorted != NULL)
+	driver_free(Sorted);
+    if (Hash != NULL)
+	driver_free(Hash);
+    Chron = Sorted = Hash = NULL;
+    Chron_N = Chron_Size = Chron_Start = Hash_Size = Hash_Used = Live = 0;
+}
+
+
+
+/*
+ * Navigation.  Positions are sequence numbers, 0 is before the oldest
+ * line and HIST_END after the newest.  Each of these returns the
+ * position of the line found with its text in *text and *len, or 0 if
+ * there is none.
+ */
+
+static unsigned long found(Hent *e, char **text, int *len)
+{
+    if (e == NULL)
+	return 0;
+    *text = e->s;
+    *len = e->len;
+    return e->seq;
+}
+
+/* the newest line before seq that starts with prefix */
+unsigned long hist_prev(char *prefix, int plen, unsigned long seq,
+			char **text, int *len)
+{
+    Hent *best = NULL;
+    int i;
+
+    if (plen == 0) {
+	for (i = chron_lower(seq) - 1; (i >= Chron_Start) && (best == NULL); i--)
+	    if (!Chron[i]->dead)
+		best = Chron[i];
+	return found(best, text, len);
+    }
+    for (i = sorted_lower(prefix, plen); (i < Live) && (Sorted[i]->len >= plen)
+	     && !memcmp(Sorted[i]->s, prefix, plen); i++)
+	if ((Sorted[i]->seq < seq) && ((best == NULL) || (Sorted[i]->seq > best->seq)))
+	    best = Sorted[i];
+    return found(best, text, len);
+}
+
+/* the oldest line after seq that starts with prefix */
+unsigned long hist_next(char *prefix, int plen, unsigned long seq,
+			char **text, int *len)
+{
+    Hent *best = NULL;
+    int i;
+
+    if (seq == HIST_END)
+	return 0;
+    if (plen == 0) {
+	for (i = chron_lower(seq + 1); (i < Chron_N) && (best == NULL); i++)
+	    if (!Chron[i]->dead)
+		best = Chron[i];
+	return found(best, text, len);
+    }
+    for (i = sorted_lower(prefix, plen); (i < Live) && (Sorted[i]->len >= plen)
+	     && !memcmp(Sorted[i]->s, prefix, plen); i++)
+	if ((Sorted[i]->seq > seq) && ((best == NULL) || (Sorted[i]->seq < best->seq)))
+	    best = Sorted[i];
+    return found(best, text, len);
+}
+
+/* the newest line before seq that contains str, which is at *at in it */
+unsigned long hist_search(char *str, int slen, unsigned long seq,
+			  char **text, int *len, int *at)
+{
+    char *p;
+    int i;
+
+    for (i = chron_lower(seq) - 1; i >= Chron_Start; i--) {
+	if (Chron[i]->dead)
+	    continue;
+	if ((p = memmem(Chron[i]->s, Chron[i]->len, str, slen)) != NULL) {
+	    *at = p - Chron[i]->s;
+	    return found(Chron[i], text, len);
+	}
+    }
+    return 0;
+}
+
+
+
+/* persistence */
+
+static int sorted_cmp(const void *a, const void *b)
+{
+    Hent *e = *(Hent **) b;
+
+    return hent_cmp((*(Hent **) a)->s, (*(Hent **) a)->len, e);
+}
+
+static int file_load(char *map, size_t size)
+{
+    char *p = map, *end = map + size, *line, *q;
+    int i, n = 0, len;
+
+    if ((line = driver_alloc(size + 1)) == NULL)
+	return -1;
+    Loading = 1;
+    while (p < end) {
+	for (q = line; (p < end) && (*p != '\n'); p++) {
+	    if ((*p == '\\') && (p + 1 < end)) {
+		p++;
+		*q++ = (*p == 'n') ? '\n' : *p;
+	    }
+	    else
+		*q++ = *p;
+	}
+	p++;
+	len = q - line;
+	if (len > 0) {
+	    hist_put(line, len, 0);
+	    n++;
+	}
+    }
+    driver_free(line);
+    Loading = 0;
+    for (i = Chron_Start, len = 0; i < Chron_N; i++)
+	if (!Chron[i]->dead)
+	    Sorted[len++] = Chron[i];
+    qsort(Sorted, len, sizeof(Hent *), sorted_cmp);
+    return n;
+}
+
+
+/*
+ * Write just the lines that count and switch to the new file.  It is
+ * opened for appending and renamed over the old one, so its descriptor
+ * goes on as Fd without opening the file again.  If anything fails the
+ * old file stays as it was, and compacting is not tried again until
+ * another Max + 100 lines have been added.
+ */
+static void file_compact(void)
+{
+    char *tmp;
+    int i, n, fd, fd_old = Fd, lines_old = File_Lines;
+
+    Compact_At = File_Lines + Max + 100;
+    if ((tmp = driver_alloc(strlen(Path) + 8)) == NULL)
+	return;
+    sprintf(tmp, "%s.new", Path);
+    if ((fd = open(tmp, O_WRONLY|O_CREAT|O_TRUNC|O_APPEND, 0600)) == -1) {
+	driver_free(tmp);
+	return;
+    }
+    Fd = fd;
+    File_Lines = 0;
+    for (i = Chron_Start, n = 0; i < Chron_N; i++)
+	if (!Chron[i]->dead) {
+	    file_append(Chron[i]->s, Chron[i]->len);
+	    n++;
+	}
+    if ((File_Lines == n) && (rename(tmp, Path) == 0)) {
+	close(fd_old);
+	Compact_At = 2 * Max + 100;
+    }
+    else {
+	close(fd);
+	unlink(tmp);
+	Fd = fd_old;
+	File_Lines = lines_old;
+    }
+    driver_free(tmp);
+}
+
+
+/* returns the number of lines kept, max <= 0 keeps the default */
+int hist_open(char *file, int max)
+{
+    struct stat st;
+    char *map;
+    int fd;
+
+    hist_close();
+    hist_clear();
+    Max = (max > 0) ? max : HIST_DEFAULT_MAX;
+
+    if ((fd = open(file, O_RDWR|O_CREAT|O_APPEND, 0600)) == -1)
+	return -1;
+    if ((fstat(fd, &st) == -1)
+	|| ((Path = driver_alloc(strlen(file) + 1)) == NULL)) {
+	close(fd);
+	return -1;
+    }
+    strcpy(Path, file);
+    if (st.st_size > 0) {
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+	    close(fd);
+	    hist_close();
+	    return -1;
+	}
+	File_Lines = file_load(map, st.st_size);
+	munmap(map, st.st_size);
+    }
+    Fd = fd;
+    Compact_At = 2 * Max + 100;
+    if (File_Lines > Compact_At)
+	file_compact();
+    return Live;
+}
+
+
+void hist_close(void)
+{
+    if (Fd != -1)
+	close(Fd);
+    if (Path != NULL)
+	driver_free(Path);
+    Fd = -1;
+    Path = NULL;
+    File_Lines = 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * Damage records for mirroring the screen to other nodes.
+ *
+ * SLsmg_refresh hands us every row it may have to redraw through
+ * SLsmg_Refresh_Hook.  Each one is compared with what was sent last
+ * time and the changed span of the row goes into the record for this
+ * refresh, run length encoded.  At the end of the refresh the record
+ * is sent as {slang_damage, Binary} to the process that turned
+ * mirroring on, if anything changed.
+ *
+ * A span that does not fit for want of memory is left out of Sent
+ * too, and the next refresh sends every row again, a keyframe, since
+ * SLsmg will not hand us the rows it thinks are up to date.  Cells go
+ * out with the color object, see snap_cell.
+ *
+ * Record, all integers big endian:
+ *
+ *   Seq:32 Rows:16 Cols:16 CurRow:16 CurCol:16 NSpans:16
+ *   NSpans * (Row:16 Col:16 Len:16 Runs)
+ *
+ * where Runs covers Len cells with
+ *
+ *   N:16 N * Cell:16            N < 0x8000, N literal cells
+ *   (0x8000 | N):16 Cell:16     Cell repeated N times
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "slang_drv.h"
+
+
+#define MIRROR_MIN_RUN  3
+#define MIRROR_MAX_RUN  0x7fff
+
+static int Mirror_On = 0;
+static ErlDrvPort Mirror_Port;
+static ErlDrvTermData Mirror_To;
+
+static SLsmg_Char_Type *Sent = NULL;    /* what the mirrors show */
+static int Sent_Rows = 0, Sent_Cols = 0;
+static int Sent_Cur_Row = -1, Sent_Cur_Col = -1;
+static unsigned int Seq = 0;
+static int Resync = 0;                  /* next record has everything */
+
+static char *Rec = NULL;                /* record being built */
+static int Rec_Size = 0, Rec_Len = 0, Rec_Spans = 0;
+static int Rec_Offset = 0;              /* bce color offset of the cells */
+
+
+
+static int rec_room(int n)
+{
+    char *r;
+    int size = Rec_Size ? Rec_Size : 1024;
+
+    if (Rec_Len + n <= Rec_Size)
+	return 0;
+    while (size < Rec_Len + n)
+	size *= 2;
+    if (Rec == NULL)
+	r = driver_alloc(size);
+    else
+	r = driver_realloc(Rec, size);
+    if (r == NULL)
+	return -1;
+    Rec = r;
+    Rec_Size = size;
+    return 0;
+}
+
+
+static char *rec_literals(char *p, SLsmg_Char_Type *cells, int from, int to)
+{
+    int k;
+
+    while (from < to) {
+	k = (to - from > MIRROR_MAX_RUN) ? MIRROR_MAX_RUN : to - from;
+	put_int16(k, p); p+= 2;
+	for (; k > 0; k--, from++) {
+	    put_int16(snap_cell(cells[from], Rec_Offset), p); p+= 2;
+	}
+    }
+    return p;
+}
+
+
+/* row span [c0, c1) of cells, at worst 2 + 2 * n bytes of runs */
+static int rec_span(int row, int c0, int c1, SLsmg_Char_Type *cells)
+{
+    char *p;
+    int i, j, lit, n = c1 - c0;
+
+    if (rec_room(6 + 2 * n + 2 * (n / MIRROR_MAX_RUN + 1)) == -1) {
+	Resync = 1;
+	return -1;
+    }
+    p = Rec + Rec_Len;
+    put_int16(row, p); p+= 2;
+    put_int16(c0, p); p+= 2;
+    put_int16(n, p); p+= 2;
+
+    for (i = lit = c0; i < c1; i = j) {
+	for (j = i + 1; (j < c1) && (cells[j] == cells[i])
+		 && (j - i < MIRROR_MAX_RUN); j++)
+	    ;
+	if (j - i >= MIRROR_MIN_RUN) {
+	    p = rec_literals(p, cells, lit, i);
+	    put_int16(0x8000 | (j - i), p); p+= 2;
+	    put_int16(snap_cell(cells[i], Rec_Offset), p); p+= 2;
+	    lit = j;
+	}
+    }
+    p = rec_literals(p, cells, lit, c1);
+    Rec_Len = p - Rec;
+    Rec_Spans++;
+    return 0;
+}
+
+
+static int sent_resize(int rows, int cols)
+{
+    SLsmg_Char_Type *s;
+
+    if ((rows != Sent_Rows) || (cols != Sent_Cols)) {
+	if ((s = driver_alloc(rows * cols * sizeof(SLsmg_Char_Type) + 1)) == NULL)
+	    return -1;
+	if (Sent != NULL)
+	    driver_free(Sent);
+	Sent = s;
+	Sent_Rows = rows;
+	Sent_Cols = cols;
+    }
+    snap_read_screen(Sent, rows, cols);
+    return 0;
+}
+
+
+static void rec_row(int row, SLsmg_Char_Type *cells)
+{
+    SLsmg_Char_Type *old = Sent + row * Sent_Cols;
+    int c0, c1;
+
+    for (c0 = 0; (c0 < Sent_Cols) && (old[c0] == cells[c0]); c0++)
+	;
+    if (c0 == Sent_Cols)
+	return;
+    for (c1 = Sent_Cols; old[c1 - 1] == cells[c1 - 1]; c1--)
+	;
+    if (rec_span(row, c0, c1, cells) == 0)
+	memcpy(old + c0, cells + c0, (c1 - c0) * sizeof(SLsmg_Char_Type));
+}
+
+
+static void rec_send(void)
+{
+    char *p = Rec;
+    int cur_r = SLsmg_get_row(), cur_c = SLsmg_get_column();
+
+    if ((Rec_Spans == 0) && (cur_r == Sent_Cur_Row) && (cur_c == Sent_Cur_Col))
+	return;
+    put_int32(++Seq, p); p+= 4;
+    put_int16(Sent_Rows, p); p+= 2;
+    put_int16(Sent_Cols, p); p+= 2;
+    put_int16(cur_r, p); p+= 2;
+    put_int16(cur_c, p); p+= 2;
+    put_int16(Rec_Spans, p); p+= 2;
+    {
+	ErlDrvTermData spec[] = {
+	    ERL_DRV_ATOM, driver_mk_atom("slang_damage"),
+	    ERL_DRV_BUF2BINARY, (ErlDrvTermData) Rec, (ErlDrvTermData) Rec_Len,
+	    ERL_DRV_TUPLE, 2
+	};
+	driver_send_term(Mirror_Port, Mirror_To, spec,
+			 sizeof(spec) / sizeof(spec[0]));
+    }
+    Sent_Cur_Row = cur_r;
+    Sent_Cur_Col = cur_c;
+}
+
+
+static void mirror_hook(int row, SLsmg_Char_Type *cells, unsigned int ncols)
+{
+    int r, rows = SLtt_Screen_Rows, cols = SLtt_Screen_Cols;
+
+    if (Rec_Len == 0) {
+	/* first call for this refresh */
+	if (rec_room(14) == -1) {
+	    /* the rows of this refresh are lost */
+	    Resync = 1;
+	    return;
+	}
+	Rec_Len = 14;
+	Rec_Spans = 0;
+	Rec_Offset = snap_color_offset();
+	if (Resync || (rows != Sent_Rows) || (cols != Sent_Cols)) {
+	    /* the mirrors have to redraw it all */
+	    if (sent_resize(rows, cols) == -1) {
+		Resync = 1;
+		Rec_Len = 0;
+		return;
+	    }
+	    Resync = 0;
+	    for (r = 0; r < rows; r++)
+		rec_span(r, 0, cols, Sent + r * cols);
+	}
+    }
+    if (row >= 0) {
+	if ((row < Sent_Rows) && ((int) ncols == Sent_Cols))
+	    rec_row(row, cells);
+	return;
+    }
+    rec_send();
+    Rec_Len = 0;
+}
+
+
+int mirror_start(ErlDrvPort port)
+{
+    Mirror_Port = port;
+    Mirror_To = driver_caller(port);
+    if (!Mirror_On) {
+	Sent_Rows = Sent_Cols = 0;      /* first record has everything */
+	Sent_Cur_Row = Sent_Cur_Col = -1;
+	Resync = 0;
+	Rec_Len = 0;
+	SLsmg_Refresh_Hook = mirror_hook;
+	Mirror_On = 1;
+    }
+    return 0;
+}
+
+
+void mirror_stop(void)
+{
+    SLsmg_Refresh_Hook = NULL;
+    Mirror_On = 0;
+    if (Sent != NULL)
+	driver_free(Sent);
+    if (Rec != NULL)
+	driver_free(Rec);
+    Sent = NULL;
+    Rec = NULL;
+    Rec_Size = Rec_Len = 0;
+    Sent_Rows = Sent_Cols = 0;
+}
@@ -0,0 +1,469 @@
+/*
+ * A pager engine that lives in the driver.
+ *
+ * The file is mmap'ed and never copied, the line structure is
+ * discovered lazily: a sparse index remembers the offset of every
+ * PAGER_INDEX_STEP'th line and is extended in slices from the driver
+ * timer, or synchronously when a line number beyond the index is
+ * asked for.  Only the visible window is ever looked at when
+ * rendering into the SLsmg screen, so opening a huge file is instant.
+ *
+ * Reading a page of a shared mapping that lies past the end of the file
+ * raises SIGBUS, which would take the whole emulator down.  A log that
+ * is truncated in place (copytruncate, `> file') does exactly that, so
+ * every entry point that touches the map fstat()s the file first and
+ * remaps it if the size has changed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "slang_drv.h"
+
+
+#define PAGER_INDEX_STEP      1024
+#define PAGER_INDEX_SLICE     (8 << 20)   /* bytes indexed per tick */
+#define PAGER_FOLLOW_INTERVAL 250         /* ms between stat()s in follow mode */
+#define PAGER_MAX_COLS        1024
+
+static struct {
+    int fd;
+    char *map;
+    size_t size;
+
+    size_t *index;             /* index[i] is the offset of line i*STEP */
+    unsigned long nindex, index_max;
+    size_t indexed_to;         /* [0, indexed_to) has been scanned */
+    unsigned long newlines;    /* number of '\n' in [0, indexed_to) */
+
+    size_t top;                /* offset of the first visible line */
+    int hshift;
+    int follow;
+    int follow_due;            /* the file grew during a batch */
+    int row, col, nrows, ncols;
+} Pager = { -1 };
+
+
+
+static void index_reset(void)
+{
+    Pager.nindex = 1;
+    Pager.index[0] = 0;
+    Pager.indexed_to = 0;
+    Pager.newlines = 0;
+}
+
+
+static int index_add(size_t off)
+{
+    if (Pager.nindex == Pager.index_max) {
+	size_t *n = driver_realloc(Pager.index,
+				   2 * Pager.index_max * sizeof(size_t));
+	if (n == NULL)
+	    return -1;
+	Pager.index = n;
+	Pager.index_max *= 2;
+    }
+    Pager.index[Pager.nindex++] = off;
+    return 0;
+}
+
+
+/* scan forward until `end' or until `want' newlines have been seen */
+static void index_scan(size_t end, unsigned long want)
+{
+    char *p = Pager.map + Pager.indexed_to;
+    char *pend = Pager.map + end;
+    char *nl;
+
+    while ((p < pend) && (Pager.newlines < want)) {
+	if ((nl = memchr(p, '\n', pend - p)) == NULL) {
+	    p = pend;
+	    break;
+	}
+	p = nl + 1;
+	if ((++Pager.newlines % PAGER_INDEX_STEP) == 0)
+	    if (index_add(p - Pager.map) == -1)
+		break;
+    }
+    Pager.indexed_to = p - Pager.map;
+}
+
+
+/* (re)map the file if its size has changed, returns 1 if it did.  Must
+   be called before the map is looked at, see above. */
+static int remap(void)
+{
+    struct stat st;
+    char *map;
+
+    if (fstat(Pager.fd, &st) == -1)
+	return 0;
+    if ((size_t)st.st_size == Pager.size)
+	return 0;
+
+    map = NULL;
+    if (st.st_size > 0) {
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, Pager.fd, 0);
+	if (map == MAP_FAILED) {
+	    if ((size_t)st.st_size > Pager.size)
+		return 0;      /* keep showing what we have */
+	    map = NULL;        /* the old map reaches past EOF, drop it */
+	    st.st_size = 0;
+	}
+    }
+    if (Pager.map != NULL)
+	munmap(Pager.map, Pager.size);
+
+    if ((size_t)st.st_size < Pager.size) {   /* truncated, start over */
+	index_reset();
+	Pager.top = 0;
+    }
+    Pager.map = map;
+    Pager.size = st.st_size;
+    return 1;
+}
+
+
+/* offset of the line following the one at `off', or `off' at the last line */
+static size_t next_line(size_t off)
+{
+    char *nl = memchr(Pager.map + off, '\n', Pager.size - off);
+
+    if ((nl == NULL) || (nl + 1 >= Pager.map + Pager.size))
+	return off;
+    return nl + 1 - Pager.map;
+}
+
+
+static size_t prev_line(size_t off)
+{
+    char *p;
+
+    if (off == 0)
+	return 0;
+    p = Pager.map + off - 1;          /* the '\n' ending the previous line */
+    while ((p > Pager.map) && (p[-1] != '\n'))
+	p--;
+    return p - Pager.map;
+}
+
+
+static size_t last_line(void)
+{
+    if (Pager.size == 0)
+	return 0;
+    return prev_line(Pager.map[Pager.size - 1] == '\n' ?
+		     Pager.size : Pager.size + 1);
+}
+
+
+static size_t line_offset(unsigned long n)
+{
+    unsigned long i;
+    size_t off, next;
+
+    if (Pager.newlines < n)
+	index_scan(Pager.size, n);
+
+    if (n > Pager.newlines)
+	n = Pager.newlines;
+    i = n / PAGER_INDEX_STEP;
+    if (i >= Pager.nindex)
+	i = Pager.nindex - 1;
+    off = Pager.index[i];
+    n -= i * PAGER_INDEX_STEP;
+    while (n--) {
+	if ((next = next_line(off)) == off)
+	    break;
+	off = next;
+    }
+    return off;
+}
+
+
+/* line number of the line starting at `off', -1 if not indexed yet */
+static long line_number(size_t off)
+{
+    unsigned long lo, hi, mid;
+    long n;
+    char *p, *pend, *nl;
+
+    if (off > Pager.indexed_to)
+	return -1;
+
+    lo = 0;
+    hi = Pager.nindex;
+    while (hi - lo > 1) {
+	mid = (lo + hi) / 2;
+	if (Pager.index[mid] <= off)
+	    lo = mid;
+	else
+	    hi = mid;
+    }
+    n = lo * PAGER_INDEX_STEP;
+    p = Pager.map + Pager.index[lo];
+    pend = Pager.map + off;
+    while ((p < pend) && ((nl = memchr(p, '\n', pend - p)) != NULL)) {
+	n++;
+	p = nl + 1;
+    }
+    return n;
+}
+
+
+static size_t move_lines(size_t off, int n)
+{
+    size_t next;
+
+    while ((n > 0) && ((next = next_line(off)) != off)) {
+	off = next;
+	n--;
+    }
+    while ((n < 0) && (off > 0)) {
+	off = prev_line(off);
+	n++;
+    }
+    return off;
+}
+
+
+
+int pager_open(char *file)
+{
+    int fd;
+    struct stat st;
+
+    if ((fd = open(file, O_RDONLY)) == -1)
+	return -1;
+    if ((fstat(fd, &st) == -1) || !S_ISREG(st.st_mode)) {
+	close(fd);
+	return -1;
+    }
+
+    pager_close();
+    if ((Pager.index = driver_alloc(64 * sizeof(size_t))) == NULL) {
+	close(fd);
+	return -1;
+    }
+    Pager.index_max = 64;
+    index_reset();
+    Pager.fd = fd;
+    Pager.size = 0;
+    Pager.top = 0;
+    Pager.hshift = 0;
+    Pager.follow = 0;
+    Pager.follow_due = 0;
+    remap();
+
+    if (Pager.nrows == 0)
+	pager_window(0, 0, SLtt_Screen_Rows - 1, SLtt_Screen_Cols);
+    return 0;
+}
+
+
+void pager_close(void)
+{
+    if (Pager.map != NULL)
+	munmap(Pager.map, Pager.size);
+    if (Pager.fd != -1)
+	close(Pager.fd);
+    if (Pager.index != NULL)
+	driver_free(Pager.index);
+    Pager.map = NULL;
+    Pager.index = NULL;
+    Pager.size = 0;
+    Pager.fd = -1;
+}
+
+
+void pager_window(int r, int c, int nr, int nc)
+{
+    if (nc > PAGER_MAX_COLS)
+	nc = PAGER_MAX_COLS;
+    Pager.row = r;
+    Pager.col = c;
+    Pager.nrows = nr < 0 ? 0 : nr;
+    Pager.ncols = nc < 0 ? 0 : nc;
+}
+
+
+/* don't scroll the last line further up than the bottom of the window */
+static void clamp_top(void)
+{
+    size_t bottom = move_lines(last_line(), 1 - Pager.nrows);
+
+    if (Pager.top > bottom)
+	Pager.top = bottom;
+}
+
+
+void pager_move(int how, int n)
+{
+    if (Pager.fd == -1)
+	return;
+    remap();
+
+    switch (how) {
+    case PAGER_LINES:
+	Pager.top = move_lines(Pager.top, n);
+	if (n > 0)
+	    clamp_top();
+	return;
+    case PAGER_PAGES:
+	Pager.top = move_lines(Pager.top, n * Pager.nrows);
+	if (n > 0)
+	    clamp_top();
+	return;
+    case PAGER_GOTO:
+	Pager.top = line_offset(n < 0 ? 0 : n);
+	clamp_top();
+	return;
+    case PAGER_TOP:
+	Pager.top = 0;
+	return;
+    case PAGER_BOTTOM:
+	Pager.top = move_lines(last_line(), 1 - Pager.nrows);
+	return;
+    case PAGER_COLUMNS:
+	Pager.hshift += n;
+	if (Pager.hshift < 0)
+	    Pager.hshift = 0;
+	return;
+    }
+}
+
+
+void pager_follow(int on)
+{
+    Pager.follow = on;
+    if (on && (Pager.fd != -1)) {
+	remap();
+	pager_move(PAGER_BOTTOM, 0);
+    }
+}
+
+
+/* expand one line into exactly ncols display cells */
+static void render_line(char *s, char *smax, char *out)
+{
+    int col = 0, hs = Pager.hshift, end = Pager.hshift + Pager.ncols;
+    int i, w;
+    unsigned char ch;
+    char cell[2];
+
+    if ((smax > s) && (smax[-1] == '\r'))
+	smax--;
+    memset(out, ' ', Pager.ncols);
+
+    while ((s < smax) && (col < end)) {
+	ch = (unsigned char) *s++;
+	if (ch == '\t') {
+	    w = SLsmg_Tab_Width - (col % SLsmg_Tab_Width);
+	    cell[0] = cell[1] = ' ';
+	}
+	else if ((ch < 32) || (ch == 127)) {
+	    w = 2;
+	    cell[0] = '^';
+	    cell[1] = ch ^ 0x40;
+	}
+	else {
+	    w = 1;
+	    cell[0] = ch;
+	}
+	for (i = 0; i < w; i++, col++)
+	    if ((col >= hs) && (col < end))
+		out[col - hs] = cell[i > 1 ? 1 : i];
+    }
+}
+
+
+void pager_render(void)
+{
+    static char buf[PAGER_MAX_COLS];
+    size_t off = Pager.top;
+    char *nl, *eol;
+    int i;
+
+    if (Pager.fd == -1)
+	return;
+    remap();
+
+    for (i = 0; i < Pager.nrows; i++) {
+	if (off < Pager.size) {
+	    nl = memchr(Pager.map + off, '\n', Pager.size - off);
+	    eol = nl ? nl : Pager.map + Pager.size;
+	    render_line(Pager.map + off, eol, buf);
+	    off = eol - Pager.map + 1;
+	}
+	else
+	    memset(buf, ' ', Pager.ncols);
+	SLsmg_gotorc(Pager.row + i, Pager.col);
+	SLsmg_write_nchars(buf, Pager.ncols);
+    }
+}
+
+
+/* [1, TopLine, Lines, SizeHi, SizeLo, Follow],
+   line numbers are -1 until the index has got that far */
+void pager_info(ErlDrvPort port)
+{
+    char buf[21];
+    long lines = -1;
+    unsigned long long size;
+
+    if (Pager.fd != -1)
+	remap();
+    size = Pager.size;
+    if ((Pager.fd != -1) && (Pager.indexed_to == Pager.size)) {
+	lines = Pager.newlines;
+	if ((Pager.size > 0) && (Pager.map[Pager.size - 1] != '\n'))
+	    lines++;
+    }
+    buf[0] = 1;
+    put_int32(Pager.fd == -1 ? -1 : line_number(Pager.top), buf+1);
+    put_int32(lines, buf+5);
+    put_int32(size >> 32, buf+9);
+    put_int32(size & 0xffffffff, buf+13);
+    put_int32(Pager.follow, buf+17);
+    driver_output(port, buf, 21);
+}
+
+
+/* called from the driver timer, returns ms until the next call or -1 */
+int pager_tick(void)
+{
+    size_t end;
+    int next = -1;
+
+    if (Pager.fd == -1)
+	return -1;
+
+    if (remap() && Pager.follow)
+	Pager.follow_due = 1;
+    /* not into the middle of Erlang's drawing, the next tick after its
+       refresh will do */
+    if (Pager.follow_due && Pager.follow && !Smg_Batch) {
+	Pager.follow_due = 0;
+	pager_move(PAGER_BOTTOM, 0);
+	pager_render();
+	SLsmg_refresh();
+	cast_refreshed();
+    }
+
+    if (Pager.indexed_to < Pager.size) {
+	end = Pager.indexed_to + PAGER_INDEX_SLICE;
+	index_scan(end < Pager.size ? end : Pager.size, (unsigned long) -1);
+	if (Pager.indexed_to < Pager.size)
+	    next = 0;
+    }
+    if ((next < 0) && Pager.follow)
+	next = PAGER_FOLLOW_INTERVAL;
+    return next;
+}
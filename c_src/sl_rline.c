@@ -0,0 +1,492 @@
+/*
+ * Line editor in the driver.
+ *
+ * slang:read_line/5 starts SLang_read_line's editor on one row of the
+ * screen and returns at once.  Keys are then read and acted on in the
+ * driver as they arrive, one SLang_rline_key per key, and only the
+ * finished line goes to Erlang as {slang_line, Line}, or as
+ * {slang_line, eof} or {slang_line, abort}.
+ *
+ * The editor's update hook gets the new image of the edit field; the
+ * span between the first and the last cell that differ from what is
+ * on the virtual screen is rewritten and the screen refreshed, so an
+ * ordinary keystroke sends the changed suffix of the line and no more.
+ *
+ * Up and down walk the history in sl_hist.c, through the lines that
+ * start with what is left of the cursor.  Ctrl-R searches it backwards
+ * for what is typed next, as in bash.  Tab completes the word left of
+ * the cursor from sl_compl.c, or by asking Erlang.
+ *
+ * rline_key runs in the emulator thread and must not block, so the
+ * editor only gets keys whose bytes have all been typed.  They are
+ * read into Key_Buf as they come, and a sequence that is not all
+ * there yet, ESC [ without the final letter say, waits there for the
+ * next call instead of SLang_do_key waiting on the tty for the rest.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "slang_drv.h"
+
+
+#define RLINE_BUF   1024
+
+static int Rline_On = 0;
+static int Rline_Init = 0;
+static int Rline_Keys = 0;
+static SLang_RLine_Info_Type Rline;
+static unsigned char Rline_Buf[RLINE_BUF];
+static char Rline_Prompt[SLRL_DISPLAY_BUFFER_SIZE];
+static int Rline_Row, Rline_Col, Rline_Color;
+static ErlDrvPort Rline_Port;
+static ErlDrvTermData Rline_To;
+
+static unsigned long Nav_Seq;                   /* HIST_END at the bottom */
+static char Nav_Prefix[RLINE_BUF];
+static int Nav_Plen;
+static char Nav_Saved[RLINE_BUF];               /* the line before */
+
+static int Search_On = 0;
+static char Search_Str[128];
+static int Search_Len;
+static unsigned long Search_Seq;
+static char Search_Prompt[SLRL_DISPLAY_BUFFER_SIZE];
+
+static Compl_Cands Cands;
+static int Compl_Callback = 0;
+static ErlDrvTermData Compl_To;
+static int Compl_Gen = 0;               /* one more for every key */
+static int Compl_Word;                  /* where the word being completed starts */
+
+static unsigned char Key_Buf[64];       /* typed, not yet acted on */
+static int Key_Len, Key_Pos;
+static int Key_Short;                   /* a key wanted more than Key_Buf */
+
+
+
+/* the next byte typed, SLANG_GETKEY_ERROR if there is none yet */
+static unsigned int rline_getkey(void)
+{
+    if (Key_Pos == Key_Len) {
+	if ((Key_Len == sizeof(Key_Buf)) || (SLang_input_pending(0) <= 0)) {
+	    Key_Short = 1;
+	    return SLANG_GETKEY_ERROR;
+	}
+	Key_Buf[Key_Len++] = SLang_getkey();
+    }
+    return Key_Buf[Key_Pos++];
+}
+
+/* whether Key_Buf starts with a whole key of the editor, reading what
+   has been typed so far to find out */
+static int key_whole(void)
+{
+    SLang_Key_Type *key;
+
+    Key_Pos = 0;
+    Key_Short = 0;
+    key = SLang_do_key(Rline.keymap, (int (*)(void)) rline_getkey);
+    /* quoted_insert reads one more */
+    if (!Key_Short && (key != NULL) && (key->type == SLKEY_F_INTRINSIC)
+	&& (key->f.f == SLang_find_key_function("quoted_insert", Rline.keymap)))
+	(void) rline_getkey();
+    Key_Pos = 0;
+    /* no key is that long, let the editor throw it away */
+    return !Key_Short || (Key_Len == sizeof(Key_Buf));
+}
+
+/* forget the bytes of the key acted on */
+static void key_done(void)
+{
+    memmove(Key_Buf, Key_Buf + Key_Pos, Key_Len - Key_Pos);
+    Key_Len -= Key_Pos;
+    Key_Pos = 0;
+}
+
+/* what is left goes back to SLang_getkey */
+static void key_giveback(void)
+{
+    if (Key_Len > 0)
+	(void) SLang_ungetkey_string(Key_Buf, Key_Len);
+    Key_Len = Key_Pos = 0;
+}
+
+
+static void rline_update(unsigned char *img, int width, int cursor)
+{
+    SLsmg_Char_Type old[SLRL_DISPLAY_BUFFER_SIZE], cells[SLRL_DISPLAY_BUFFER_SIZE];
+    int i, c0, c1;
+
+    for (i = 0; i < width; i++)
+	cells[i] = SLSMG_BUILD_CHAR(img[i], Rline_Color);
+    SLsmg_gotorc(Rline_Row, Rline_Col);
+    if (SLsmg_read_raw(old, width) != (unsigned int) width)
+	memset(old, 0, sizeof(old));
+
+    for (c0 = 0; (c0 < width) && (old[c0] == cells[c0]); c0++)
+	;
+    if (c0 < width) {
+	for (c1 = width; old[c1 - 1] == cells[c1 - 1]; c1--)
+	    ;
+	SLsmg_gotorc(Rline_Row, Rline_Col + c0);
+	SLsmg_write_raw(cells + c0, c1 - c0);
+    }
+    SLsmg_gotorc(Rline_Row, Rline_Col + cursor);
+    SLsmg_refresh();
+    cast_refreshed();
+}
+
+
+static void rline_send(int len)
+{
+    if ((len == 0) && (SLang_Last_Key_Char == SLang_RL_EOF_Char))
+	len = -2;
+    if (len < 0) {
+	ErlDrvTermData spec[] = {
+	    ERL_DRV_ATOM, driver_mk_atom("slang_line"),
+	    ERL_DRV_ATOM, driver_mk_atom(len == -2 ? "eof" : "abort"),
+	    ERL_DRV_TUPLE, 2
+	};
+	driver_send_term(Rline_Port, Rline_To, spec, sizeof(spec) / sizeof(spec[0]));
+    }
+    else {
+	ErlDrvTermData spec[] = {
+	    ERL_DRV_ATOM, driver_mk_atom("slang_line"),
+	    ERL_DRV_BUF2BINARY, (ErlDrvTermData) Rline_Buf, (ErlDrvTermData) len,
+	    ERL_DRV_TUPLE, 2
+	};
+	driver_send_term(Rline_Port, Rline_To, spec, sizeof(spec) / sizeof(spec[0]));
+    }
+}
+
+
+/* history */
+
+static void rline_set(char *text, int len, int point)
+{
+    if (len > RLINE_BUF - 1)
+	len = RLINE_BUF - 1;
+    memcpy(Rline_Buf, text, len);
+    Rline_Buf[len] = 0;
+    Rline.len = len;
+    Rline.point = (point > len) ? len : point;
+}
+
+static int rline_up(void);
+static int rline_down(void);
+
+static int rline_walking(void)
+{
+    return (Rline.last_fun == (FVOID_STAR) rline_up)
+	|| (Rline.last_fun == (FVOID_STAR) rline_down);
+}
+
+static int rline_up(void)
+{
+    unsigned long seq;
+    char *text;
+    int len;
+
+    if (!rline_walking()) {
+	Nav_Seq = HIST_END;
+	Nav_Plen = Rline.point;
+	memcpy(Nav_Prefix, Rline_Buf, Nav_Plen);
+	strcpy(Nav_Saved, (char *) Rline_Buf);
+    }
+    if ((seq = hist_prev(Nav_Prefix, Nav_Plen, Nav_Seq, &text, &len)) == 0)
+	return 0;
+    Nav_Seq = seq;
+    rline_set(text, len, Nav_Plen ? Nav_Plen : len);
+    return 1;
+}
+
+static int rline_down(void)
+{
+    unsigned long seq;
+    char *text;
+    int len;
+
+    if (!rline_walking() || (Nav_Seq == HIST_END))
+	return 0;
+    if ((seq = hist_next(Nav_Prefix, Nav_Plen, Nav_Seq, &text, &len)) == 0) {
+	/* back to what was being typed */
+	Nav_Seq = HIST_END;
+	len = strlen(Nav_Saved);
+	rline_set(Nav_Saved, len, Nav_Plen ? Nav_Plen : len);
+	return 1;
+    }
+    Nav_Seq = seq;
+    rline_set(text, len, Nav_Plen ? Nav_Plen : len);
+    return 1;
+}
+
+
+static void search_show(void)
+{
+    snprintf(Search_Prompt, sizeof(Search_Prompt), "(reverse-i-search)`%.*s': ",
+	     Search_Len, Search_Str);
+    Rline.prompt = Search_Prompt;
+    SLrline_update(&Rline);
+}
+
+/* the newest match before seq, the line stays if there is none */
+static void search_find(unsigned long before)
+{
+    unsigned long seq;
+    char *text;
+    int len, at;
+
+    if (Search_Len == 0)
+	return;
+    seq = hist_search(Search_Str, Search_Len, before, &text, &len, &at);
+    if (seq != 0) {
+	Search_Seq = seq;
+	rline_set(text, len, at);
+    }
+}
+
+static void search_end(void)
+{
+    Search_On = 0;
+    Rline.prompt = Rline_Prompt;
+    SLrline_update(&Rline);
+}
+
+static int rline_search(void)
+{
+    Search_On = 1;
+    Search_Len = 0;
+    Search_Seq = HIST_END;
+    strcpy(Nav_Saved, (char *) Rline_Buf);
+    search_show();
+    return 0;
+}
+
+/* returns 0 if the key is for the editor, which then gets it again */
+static int search_key(void)
+{
+    unsigned int ch = rline_getkey();
+
+    if (ch == SLANG_GETKEY_ERROR)
+	return 1;
+
+    switch (ch) {
+    case 'R' - '@':                         /* the next older match */
+	search_find(Search_Seq);
+	break;
+    case 'G' - '@':                         /* give up */
+	rline_set(Nav_Saved, strlen(Nav_Saved), strlen(Nav_Saved));
+	search_end();
+	return 1;
+    case 27:
+	search_end();
+	return 1;
+    case 'H' - '@':
+    case 127:
+	if (Search_Len > 0)
+	    Search_Len--;
+	Search_Seq = HIST_END;
+	search_find(HIST_END);
+	break;
+    default:
+	if ((ch < ' ') || (ch > 255) || (Search_Len == sizeof(Search_Str))) {
+	    search_end();
+	    Key_Pos--;
+	    return 0;
+	}
+	Search_Str[Search_Len++] = ch;
+	/* the current match may still do */
+	search_find((Search_Seq == HIST_END) ? HIST_END : Search_Seq + 1);
+    }
+    search_show();
+    return 1;
+}
+
+
+
+/* completion */
+
+static int rline_insert(char *s, int len)
+{
+    char buf[COMPL_BUF + 1];
+
+    memcpy(buf, s, len);
+    buf[len] = 0;
+    return SLang_rline_insert(buf);
+}
+
+/* Cands against the word from Compl_Word to the cursor */
+static int compl_apply(void)
+{
+    int plen = Rline.point - Compl_Word;
+
+    if (Cands.total == 0) {
+	SLtt_beep();
+	return 0;
+    }
+    if (Cands.lcp > plen)
+	rline_insert(Cands.w[0] + plen, Cands.lcp - plen);
+    if (Cands.total == 1)
+	rline_insert(" ", 1);
+    else if (Cands.lcp == plen)
+	compl_menu_show(&Cands, Rline_Row, Rline_Col, Rline.edit_width, Rline_Color);
+    return 1;
+}
+
+static void compl_ask(int source, char *prefix, int plen)
+{
+    ErlDrvTermData spec[] = {
+	ERL_DRV_ATOM, driver_mk_atom("slang_complete"),
+	ERL_DRV_INT, (ErlDrvTermData) Compl_Gen,
+	ERL_DRV_INT, (ErlDrvTermData) source,
+	ERL_DRV_BUF2BINARY, (ErlDrvTermData) prefix, (ErlDrvTermData) plen,
+	ERL_DRV_TUPLE, 4
+    };
+    driver_send_term(Rline_Port, Compl_To, spec, sizeof(spec) / sizeof(spec[0]));
+}
+
+static int rline_complete(void)
+{
+    int source;
+    char *word;
+
+    for (Compl_Word = Rline.point;
+	 (Compl_Word > 0) && (Rline_Buf[Compl_Word - 1] != ' '); Compl_Word--)
+	;
+    for (source = 0; (source < Compl_Word) && (Rline_Buf[source] == ' '); source++)
+	;
+    source = (source < Compl_Word) ? 1 : 0;
+    word = (char *) Rline_Buf + Compl_Word;
+
+    compl_find(source, word, Rline.point - Compl_Word, &Cands);
+    if ((Cands.total == 0) && Compl_Callback) {
+	compl_ask(source, word, Rline.point - Compl_Word);
+	return 0;
+    }
+    return compl_apply();
+}
+
+/* Erlang's answer to {slang_complete, Gen, ...}, if no key came since */
+void rline_compl_reply(int gen, char *buf, int len)
+{
+    if (!Rline_On || (gen != Compl_Gen))
+	return;
+    compl_from_list(buf, len, &Cands);
+    if (compl_apply())
+	SLrline_update(&Rline);
+}
+
+void rline_callback(ErlDrvPort port, int on)
+{
+    Compl_Callback = on;
+    Compl_To = driver_caller(port);
+}
+
+
+
+/* edit on row, from col on, width cells wide */
+int rline_start(ErlDrvPort port, int row, int col, int width, int color,
+		char *prompt)
+{
+    if ((width < 2) || (width > SLRL_DISPLAY_BUFFER_SIZE)
+	|| (row < 0) || (row >= SLtt_Screen_Rows)
+	|| (col < 0) || (col + width > SLtt_Screen_Cols))
+	return -1;
+
+    if (!Rline_Init) {
+	memset(&Rline, 0, sizeof(Rline));
+	Rline.buf = Rline_Buf;
+	Rline.buf_len = RLINE_BUF - 1;
+	Rline.tab = 8;
+	Rline.getkey = rline_getkey;
+	Rline.update_hook = rline_update;
+	Rline_Init = 1;
+    }
+    strncpy(Rline_Prompt, prompt, sizeof(Rline_Prompt) - 1);
+    Rline.prompt = Rline_Prompt;
+    Rline.edit_width = width;
+    Rline.dhscroll = width / 3;
+    Rline.last = NULL;
+    if (SLang_init_readline(&Rline) == -1)
+	return -1;
+    if (!Rline_Keys) {
+	SLkm_define_key("^P", (FVOID_STAR) rline_up, Rline.keymap);
+	SLkm_define_key("^N", (FVOID_STAR) rline_down, Rline.keymap);
+	SLkm_define_key("^[[A", (FVOID_STAR) rline_up, Rline.keymap);
+	SLkm_define_key("^[[B", (FVOID_STAR) rline_down, Rline.keymap);
+	SLkm_define_key("^[OA", (FVOID_STAR) rline_up, Rline.keymap);
+	SLkm_define_key("^[OB", (FVOID_STAR) rline_down, Rline.keymap);
+	SLkm_define_key("^R", (FVOID_STAR) rline_search, Rline.keymap);
+	SLkm_define_key("^I", (FVOID_STAR) rline_complete, Rline.keymap);
+	Rline_Keys = 1;
+    }
+    Search_On = 0;
+    Key_Len = Key_Pos = 0;
+
+    Rline_Row = row;
+    Rline_Col = col;
+    Rline_Color = color;
+    Rline_Port = port;
+    Rline_To = driver_caller(port);
+    Rline_On = 1;
+    SLang_rline_start(&Rline);
+    return 0;
+}
+
+
+/*
+ * Act on the key that is pending, if all of it has been typed.
+ * Returns 1 when that finished the line, which has then been sent to
+ * Erlang.  Never waits for input.
+ */
+int rline_key(void)
+{
+    int len;
+
+    if (!Rline_On)
+	return 1;
+    if (!Search_On && !key_whole())
+	return 0;
+    Compl_Gen++;
+    if (compl_menu_shown()) {
+	compl_menu_hide();
+	SLsmg_refresh();
+    }
+    if (Search_On) {
+	if (search_key()) {
+	    key_done();
+	    return 0;
+	}
+	/* the key that ended the search is the editor's */
+	if (!key_whole())
+	    return 0;
+    }
+    len = SLang_rline_key(&Rline);
+    key_done();
+    if (len == -2)
+	return 0;
+    Rline_On = 0;
+    key_giveback();
+    if (len > 0)
+	hist_add((char *) Rline_Buf, len);
+    rline_send(len);
+    return 1;
+}
+
+
+int rline_active(void)
+{
+    return Rline_On;
+}
+
+
+/* stop editing without telling anyone */
+void rline_stop(void)
+{
+    Rline_On = 0;
+    Search_On = 0;
+    Rline.prompt = Rline_Prompt;
+    key_giveback();
+    compl_menu_hide();
+}
@@ -0,0 +1,173 @@
+/*
+ * Whole screen snapshots of the SLsmg virtual screen.
+ *
+ * Every snapshot is compared row by row against a shadow copy of the
+ * previous one.  Rows that differ get the new generation number, so
+ * a reader that remembers the generation of its last snapshot can ask
+ * for only the rows changed since then.  Any number of readers can
+ * do that independently, the shadow copy is shared.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "slang_drv.h"
+
+
+static SLsmg_Char_Type *Shadow = NULL;   /* Snap_Rows * Snap_Cols */
+static unsigned int *Row_Gen = NULL;
+static int Snap_Rows = 0, Snap_Cols = 0;
+static unsigned int Snap_Gen = 0;
+
+
+static int snap_resize(int rows, int cols)
+{
+    SLsmg_Char_Type *s;
+    unsigned int *g;
+    int i;
+
+    s = driver_alloc(rows * cols * sizeof(SLsmg_Char_Type));
+    g = driver_alloc(rows * sizeof(unsigned int));
+    if ((s == NULL) || (g == NULL)) {
+	if (s != NULL)
+	    driver_free(s);
+	if (g != NULL)
+	    driver_free(g);
+	return -1;
+    }
+    snap_reset();
+    memset(s, 0, rows * cols * sizeof(SLsmg_Char_Type));
+    /* everything is new to everybody */
+    for (i = 0; i < rows; i++)
+	g[i] = Snap_Gen + 1;
+    Shadow = s;
+    Row_Gen = g;
+    Snap_Rows = rows;
+    Snap_Cols = cols;
+    return 0;
+}
+
+
+void snap_reset(void)
+{
+    if (Shadow != NULL)
+	driver_free(Shadow);
+    if (Row_Gen != NULL)
+	driver_free(Row_Gen);
+    Shadow = NULL;
+    Row_Gen = NULL;
+    Snap_Rows = Snap_Cols = 0;
+}
+
+
+/* copy the virtual screen into dst, rows * cols cells, whatever the
+   screen start and without moving the cursor */
+void snap_read_screen(SLsmg_Char_Type *dst, int rows, int cols)
+{
+    int cur_r, cur_c, start_r = 0, start_c = 0;
+    int r;
+    unsigned int len;
+
+    cur_r = SLsmg_get_row();
+    cur_c = SLsmg_get_column();
+    SLsmg_set_screen_start(&start_r, &start_c);
+    for (r = 0; r < rows; r++, dst += cols) {
+	SLsmg_gotorc(r, 0);
+	len = SLsmg_read_raw(dst, cols);
+	if (len < (unsigned int) cols)
+	    memset(dst + len, 0, (cols - len) * sizeof(SLsmg_Char_Type));
+    }
+    SLsmg_set_screen_start(&start_r, &start_c);
+    SLsmg_gotorc(cur_r, cur_c);
+}
+
+
+/* on terminals that cannot erase with the background color of object
+   0, slsmg stores every color object one up in the cells, see
+   SLTT_HAS_NON_BCE_SUPPORT */
+extern int _SLtt_get_bce_color_offset(void);
+
+int snap_color_offset(void)
+{
+    return _SLtt_get_bce_color_offset();
+}
+
+/* a cell as it goes out to Erlang: with the color object, whatever
+   the offset, so that the side painting it adds its own offset once */
+SLsmg_Char_Type snap_cell(SLsmg_Char_Type cell, int offset)
+{
+    int color = SLSMG_EXTRACT_COLOR(cell);
+
+    if (offset == 0)
+	return cell;
+    color = (((color & 0x7f) - offset) & 0x7f) | (color & 0x80);
+    return SLSMG_BUILD_CHAR(SLSMG_EXTRACT_CHAR(cell), color);
+}
+
+
+/*
+ * [1, Gen:32, Rows:16, Cols:16, CurRow:16, CurCol:16, N:16,
+ *  N * (Row:16, Cols * Cell:16)]
+ * with the rows changed after generation Since, all of them if
+ * Since < 0.  A cell is an SLsmg_Char_Type, character in the low
+ * byte and color object in the high byte, see snap_cell.
+ */
+void snap_get(ErlDrvPort port, int since)
+{
+    int rows = SLtt_Screen_Rows, cols = SLtt_Screen_Cols;
+    int r, c, n, offset = snap_color_offset();
+    SLsmg_Char_Type *row, *screen;
+    char *buf, *p, *np;
+
+    if ((rows <= 0) || (cols <= 0)) {
+	rows = 0;
+	cols = 0;
+    }
+    else if (((rows != Snap_Rows) || (cols != Snap_Cols))
+	     && (snap_resize(rows, cols) == -1)) {
+	rows = 0;
+	cols = 0;
+    }
+    if ((screen = driver_alloc(rows * cols * sizeof(SLsmg_Char_Type) + 1)) == NULL)
+	return;
+
+    /* pick up the changes since the last snapshot */
+    Snap_Gen++;
+    snap_read_screen(screen, rows, cols);
+    for (r = 0; r < rows; r++) {
+	row = Shadow + r * cols;
+	if (memcmp(row, screen + r * cols, cols * sizeof(SLsmg_Char_Type)) != 0) {
+	    memcpy(row, screen + r * cols, cols * sizeof(SLsmg_Char_Type));
+	    Row_Gen[r] = Snap_Gen;
+	}
+    }
+    driver_free(screen);
+
+    for (r = 0, n = 0; r < rows; r++)
+	if ((since < 0) || (Row_Gen[r] > (unsigned int) since))
+	    n++;
+
+    if ((buf = driver_alloc(15 + n * (2 + 2 * cols))) == NULL)
+	return;
+    p = buf;
+    *p++ = 1;
+    put_int32(Snap_Gen, p); p+= 4;
+    put_int16(rows, p); p+= 2;
+    put_int16(cols, p); p+= 2;
+    put_int16(SLsmg_get_row(), p); p+= 2;
+    put_int16(SLsmg_get_column(), p); p+= 2;
+    np = p; p+= 2;
+    for (r = 0, n = 0; r < rows; r++) {
+	if ((since >= 0) && (Row_Gen[r] <= (unsigned int) since))
+	    continue;
+	put_int16(r, p); p+= 2;
+	row = Shadow + r * cols;
+	for (c = 0; c < cols; c++) {
+	    put_int16(snap_cell(row[c], offset), p); p+= 2;
+	}
+	n++;
+    }
+    put_int16(n, np);
+    driver_output(port, buf, p - buf);
+    driver_free(buf);
+}
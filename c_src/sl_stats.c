@@ -0,0 +1,181 @@
+/*
+ * Per opcode latency statistics for the driver.
+ *
+ * Every command that goes through sl_output is timed with the
+ * monotonic clock and accounted to its opcode: call count, total,
+ * min and max, and a log-linear (HDR style) histogram with
+ * 2^STATS_SUB_BITS buckets per power of two, i.e. values are kept
+ * with a relative error of at most 1/16.  Histograms are allocated
+ * the first time an opcode is seen.
+ *
+ * With tracing on, every call is also sent as a
+ * {slang_trace, Op, Nanoseconds} message to the process that turned
+ * tracing on.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slang_drv.h"
+
+
+#define STATS_SUB_BITS   4
+#define STATS_SUB        (1 << STATS_SUB_BITS)
+#define STATS_MAX_EXP    40                 /* ~18 minutes in ns */
+#define STATS_BUCKETS    ((STATS_MAX_EXP - STATS_SUB_BITS + 2) << STATS_SUB_BITS)
+
+typedef struct {
+    uint64_t count;
+    uint64_t total;
+    uint64_t min, max;
+    uint32_t *hist;
+} Op_Stats;
+
+static Op_Stats Stats[256];
+
+static int Trace = 0;
+static ErlDrvTermData Trace_To;
+
+
+
+uint64_t stats_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static int msb(uint64_t v)
+{
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(v);
+#else
+    int n = 0;
+    while (v >>= 1)
+	n++;
+    return n;
+#endif
+}
+
+
+static int bucket_of(uint64_t v)
+{
+    int e;
+
+    if (v < STATS_SUB)
+	return (int) v;
+    e = msb(v);
+    if (e > STATS_MAX_EXP) {
+	e = STATS_MAX_EXP;
+	v = ~(uint64_t)0 >> (63 - STATS_MAX_EXP);
+    }
+    return ((e - STATS_SUB_BITS + 1) << STATS_SUB_BITS)
+	+ (int) ((v >> (e - STATS_SUB_BITS)) & (STATS_SUB - 1));
+}
+
+
+void stats_record(ErlDrvPort port, int op, uint64_t ns)
+{
+    Op_Stats *s = &Stats[op & 0xff];
+
+    if (s->hist == NULL) {
+	if ((s->hist = driver_alloc(STATS_BUCKETS * sizeof(uint32_t))) == NULL)
+	    return;
+	memset(s->hist, 0, STATS_BUCKETS * sizeof(uint32_t));
+	s->min = ns;
+    }
+    s->count++;
+    s->total += ns;
+    if (ns < s->min)
+	s->min = ns;
+    if (ns > s->max)
+	s->max = ns;
+    s->hist[bucket_of(ns)]++;
+
+    if (Trace) {
+	ErlDrvTermData spec[] = {
+	    ERL_DRV_ATOM, driver_mk_atom("slang_trace"),
+	    ERL_DRV_INT, (ErlDrvTermData) (op & 0xff),
+	    ERL_DRV_INT, (ErlDrvTermData) ns,
+	    ERL_DRV_TUPLE, 3
+	};
+	driver_send_term(port, Trace_To, spec, sizeof(spec) / sizeof(spec[0]));
+    }
+}
+
+
+void stats_reset(void)
+{
+    int i;
+
+    for (i = 0; i < 256; i++) {
+	if (Stats[i].hist != NULL)
+	    driver_free(Stats[i].hist);
+	memset(&Stats[i], 0, sizeof(Op_Stats));
+    }
+}
+
+
+void stats_trace(ErlDrvPort port, int on)
+{
+    Trace = on;
+    Trace_To = driver_caller(port);
+}
+
+
+#define put_int64(i, s) do {				\
+	put_int32((uint64_t)(i) >> 32, (s));		\
+	put_int32((uint64_t)(i) & 0xffffffff, (s)+4);	\
+} while (0)
+
+/*
+ * [1 | per used opcode:
+ *      Op:8 Count:64 Total:64 Min:64 Max:64 NBuckets:16
+ *      NBuckets * (Bucket:16 Count:32)]
+ * only non empty buckets are sent, or the int -1 when there is no
+ * memory for the reply
+ */
+void stats_get(ErlDrvPort port)
+{
+    int i, b, n, size = 1;
+    char *buf, *p, *np;
+
+    for (i = 0; i < 256; i++) {
+	if (Stats[i].count == 0)
+	    continue;
+	size += 35;
+	for (b = 0; b < STATS_BUCKETS; b++)
+	    if (Stats[i].hist[b])
+		size += 6;
+    }
+
+    if ((buf = driver_alloc(size)) == NULL) {
+	ret_int(port, -1);
+	return;
+    }
+    p = buf;
+    *p++ = 1;
+    for (i = 0; i < 256; i++) {
+	if (Stats[i].count == 0)
+	    continue;
+	put_int8(i, p); p+= 1;
+	put_int64(Stats[i].count, p); p+= 8;
+	put_int64(Stats[i].total, p); p+= 8;
+	put_int64(Stats[i].min, p); p+= 8;
+	put_int64(Stats[i].max, p); p+= 8;
+	np = p; p+= 2;
+	for (b = 0, n = 0; b < STATS_BUCKETS; b++) {
+	    if (Stats[i].hist[b] == 0)
+		continue;
+	    put_int16(b, p); p+= 2;
+	    put_int32(Stats[i].hist[b], p); p+= 4;
+	    n++;
+	}
+	put_int16(n, np);
+    }
+    driver_output(port, buf, size);
+    driver_free(buf);
+}
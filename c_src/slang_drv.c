@@ -1,12 +1,12 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
-#include <arpa/inet.h>
-#include <stdint.h>
+#include <sys/ioctl.h>
+#include <termios.h>
 
-#include <slang.h>
-#include <erl_driver.h>
+#include "slang_drv.h"
 
 #if (SLANG_VERSION < 10400 )
 #define SLsmg_Char_Type unsigned short
@@ -14,144 +14,6 @@
 
 
 
-/* Standard set of integer macros  .. */
-
-#define get_int32(s) ntohl(*(uint32_t *)(s))
-
-#define put_int32(i, s) do {				\
-	*(uint32_t *)(s) = htonl((uint32_t)(i));	\
-} while (0)
-
-#define get_int16(s) ntohs(*(uint16_t *)(s))
-
-#define put_int16(i, s) do {				\
-	*(uint16_t *)(s) = htons((uint16_t)(i));	\
-} while (0)
-
-#define get_int8(s) (*(uint8_t *)(s))
-
-#define put_int8(i, s) do {				\
-	*(uint8_t *)(s) = (uint8_t)(i);			\
-} while (0)
-
-
-
-#define INIT_TTY           1
-#define SET_ABORT_FUNCTION 2
-#define GETKEY             3
-#define RESET_TTY          4
-#define KP_GETKEY          5
-#define UNGETKEY           6
-#define SETVAR             7
-#define GETVAR             8
-#define KP_INIT            9
-
-/* screen mgmt  */
-
-#define SMG_FILL_REGION       10
-#define SMG_SET_CHAR_SET      11
-#define SMG_SUSPEND_SMG       12
-#define SMG_RESUME_SMG        13
-#define SMG_ERASE_EOL         14
-#define SMG_GOTORC            15
-#define SMG_ERASE_EOS         16
-#define SMG_REVERSE_VIDEO     17
-#define SMG_SET_COLOR         18
-#define SMG_NORMAL_VIDEO      19
-#define SMG_PRINTF            20
-#define SMG_VPRINTF           21
-#define SMG_WRITE_STRING      22
-#define SMG_WRITE_NSTRING     23
-#define SMG_WRITE_CHAR        24
-#define SMG_WRITE_NCHARS      25
-#define SMG_WRITE_WRAPPED_STRING 26
-#define SMG_CLS               27
-#define SMG_REFRESH           28
-#define SMG_TOUCH_LINES       29
-#define SMG_TOUCH_SCREEN      30
-#define SMG_INIT_SMG          31
-#define SMG_REINIT_SMG        32
-#define SMG_RESET_SMG         33
-#define SMG_CHAR_AT            34
-#define SMG_SET_SCREEN_START  35
-#define SMG_DRAW_HLINE        36
-#define SMG_DRAW_VLINE        37
-#define SMG_DRAW_OBJECT       38
-#define SMG_DRAW_BOX          39
-#define SMG_GET_COLUMN        40
-#define SMG_GET_ROW           41
-#define SMG_FORWARD           42
-#define SMG_WRITE_COLOR_CHARS 43
-#define SMG_READ_RAW          44
-#define SMG_WRITE_RAW         45
-#define SMG_SET_COLOR_IN_REGION 46
-
-
-
-
-/* ops for all the tt_ functions */
-
-#define TT_FLUSH_OUTPUT        50
-#define TT_SET_SCROLL_REGION   51
-#define TT_RESET_SCROLL_REGION 52
-#define TT_REVERSE_VIDEO       53
-#define TT_BOLD_VIDEO          54
-#define TT_BEGIN_INSERT        55
-#define TT_END_INSERT          56
-#define TT_DEL_EOL             57
-#define TT_GOTO_RC             58
-#define TT_DELETE_NLINES       59
-#define TT_DELETE_CHAR         60
-#define TT_ERASE_LINE          61
-#define TT_NORMAL_VIDEO        62
-#define TT_CLS                 63
-#define TT_BEEP                64
-#define TT_REVERSE_INDEX       65
-#define TT_SMART_PUTS          66
-#define TT_WRITE_STRING        67
-#define TT_PUTCHAR             68
-#define TT_INIT_VIDEO          69
-#define TT_RESET_VIDEO         70
-#define TT_GET_TERMINFO        71
-#define TT_GET_SCREEN_SIZE     72
-#define TT_SET_CURSOR_VISIBILITY 73
-#define TT_SET_MOUSE_MODE      74
-
-#define TT_INITIALIZE          75
-#define TT_ENABLE_CURSOR_KEYS  76
-#define TT_SET_TERM_VTXXX      77
-#define TT_SET_COLOR_ESC       78
-#define TT_WIDE_WIDTH          79
-#define TT_NARROW_WIDTH        80
-#define TT_SET_ALT_CHAR_SET    81
-#define TT_WRITE_TO_STATUS_LINE 82
-#define TT_DISABLE_STATUS_LINE  83
-
-
-#define TT_TGETSTR             84
-#define TT_TGETNUM             85
-#define TT_TGETFLAG            86
-#define TT_TIGETENT            87
-#define TT_TIGETSTR            88
-#define TT_TIGETNUM            89
-
-#define SLTT_GET_COLOR_OBJECT  90
-#define TT_SET_COLOR_OBJECT    91
-#define TT_SET_COLOR           92
-#define TT_SET_MONO            93
-#define TT_ADD_COLOR_ATTRIBUTE 94
-#define TT_SET_COLOR_FGBG      95
-
-
-/* aux tty functions */
-#define ISATTY                 100
-#define EFORMAT                101
-#define SIGNAL                 102
-#define SIGNAL_CHECK           103
-
-
-
-
 /*  read/write global variables */
 #define esl_baud_rate         1
 #define esl_read_fd           2
@@ -189,6 +51,15 @@ static ErlDrvEntry sl_erl_drv_entry;
 static int wait_for = 0;
 static int signal_cought = 0;
 
+/* with key events on, keys go to Key_To as {slang_key, Key} */
+static int key_events = 0;
+static ErlDrvTermData Key_To;
+
+/* set from the first command that draws on the virtual screen until
+   the SMG_REFRESH that ends the batch: the screen holds half a frame
+   then, and the timer must not send it out */
+int Smg_Batch = 0;
+
 
 
 static int sig_to_x(int x)
@@ -230,9 +101,11 @@ SLsmg_Char_Type *decode_smg_char_type(char **buf)
 {
     static SLsmg_Char_Type mbuf[256];
     int i;
-    int len = get_int32(*buf); *buf+=4;
+    int len = get_int32(*buf) / 2; *buf+=4;   /* length is in bytes */
     for(i=0; i<len; i++) {
-	mbuf[i++] =  get_int16(*buf); *buf+=2;
+	if (i < 256)
+	    mbuf[i] = get_int16(*buf);
+	*buf+=2;
     }
     return mbuf;
 }
@@ -246,10 +119,24 @@ static ErlDrvData sl_start(ErlDrvPort port, char *buf)
 
 static void sl_stop(ErlDrvData port)
 {
+    pager_close();
+    stats_reset();
+    cmdlog_stop();
+    snap_reset();
+    mirror_stop();
+    cast_stop();
+    anim_delete(-1);
+    color_reset();
+    rline_stop();
+    hist_close();
+    hist_clear();
+    compl_reset();
+    key_events = 0;
+    wait_for = 0;
     return;
 }
 
-static int ret_int_int(ErlDrvPort port, int i, int j)
+int ret_int_int(ErlDrvPort port, int i, int j)
 {
     char buf[9];
     buf[0] = 1;
@@ -260,7 +147,7 @@ static int ret_int_int(ErlDrvPort port, int i, int j)
 }
 
 
-static int ret_int(ErlDrvPort port, int ret)
+int ret_int(ErlDrvPort port, int ret)
 {
     char buf[5];
     buf[0] = 1;
@@ -278,9 +165,8 @@ static int ret_string(ErlDrvPort port, char *str)
 }
 
 
-static void sl_output(ErlDrvData drv_data, char *buf, int len)
+static void sl_dispatch(ErlDrvPort port, char *buf, int len)
 {
-    ErlDrvPort port = (ErlDrvPort)drv_data;
     int x,y,z,v,w;
     char *str, *t1, *t2, *t3;
     int ret;
@@ -298,7 +184,7 @@ static void sl_output(ErlDrvData drv_data, char *buf, int len)
 	signal_cought = 0;
     }
 
-    switch (*buf++) {
+    switch (*(unsigned char *)buf++) {
     case INIT_TTY: {
 	int abort_char, flow_ctl, opost;
 	abort_char = get_int32(buf); buf+=4;
@@ -529,7 +415,10 @@ static void sl_output(ErlDrvData drv_data, char *buf, int len)
 	return;
     }
     case SMG_REFRESH: {
+	anim_before_refresh();
 	SLsmg_refresh();
+	cast_refreshed();
+	Smg_Batch = 0;
 	return;
     }
     case SMG_TOUCH_LINES: {
@@ -562,6 +451,7 @@ static void sl_output(ErlDrvData drv_data, char *buf, int len)
     }
     case SMG_RESET_SMG: {
 	SLsmg_reset_smg();
+	Smg_Batch = 0;
 	return;
     }
     case SMG_CHAR_AT: {
@@ -624,12 +514,31 @@ static void sl_output(ErlDrvData drv_data, char *buf, int len)
 	return;
     }
     case SMG_READ_RAW: {
+	SLsmg_Char_Type *sl;
 	x = get_int32(buf); buf+= 4;
-	t1 = malloc((2*x) + 2 + 1);
-	y = SLsmg_read_raw((unsigned short*)t1 +1, x);
-	t1[1] = 1;
-	driver_output(port, t1, y+1);
-	free(t1);
+	if (x < 0)
+	    x = 0;
+	sl = driver_alloc(x * sizeof(SLsmg_Char_Type) + 1);
+	t1 = driver_alloc(2*x + 1);
+	if ((sl == NULL) || (t1 == NULL)) {
+	    if (sl != NULL)
+		driver_free(sl);
+	    if (t1 != NULL)
+		driver_free(t1);
+	    return;
+	}
+	y = SLsmg_read_raw(sl, x);
+	t1[0] = 1;
+	for (z = 0; z < y; z++)
+	    put_int16(sl[z], t1 + 1 + 2*z);
+	driver_output(port, t1, 2*y + 1);
+	driver_free(t1);
+	driver_free(sl);
+	return;
+    }
+    case SMG_SNAPSHOT: {
+	x = get_int32(buf); buf+= 4;
+	snap_get(port, x);
 	return;
     }
     case SMG_WRITE_RAW: {
@@ -649,6 +558,39 @@ static void sl_output(ErlDrvData drv_data, char *buf, int len)
 	SLsmg_set_color_in_region(x, y,z,v,w);
 	return;
     }
+    case SMG_SCROLL_REGION: {
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	z = get_int32(buf); buf+= 4;
+	v = get_int32(buf); buf+= 4;
+	w = get_int32(buf); buf+= 4;
+	SLsmg_scroll_region(x, y,z,v,w);
+	return;
+    }
+    case SMG_PAINT_REGION: {
+	SLsmg_Char_Type *pat;
+	int i, pw, ph;
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	z = get_int32(buf); buf+= 4;
+	v = get_int32(buf); buf+= 4;
+	pw = get_int32(buf); buf+= 4;
+	ph = get_int32(buf); buf+= 4;
+	/* a tile larger than the screen is never needed, and keeping
+	   pw*ph small means the length check cannot overflow */
+	if ((pw <= 0) || (ph <= 0)
+	    || (pw > SLtt_Screen_Cols) || (ph > SLtt_Screen_Rows)
+	    || (len < 25) || ((size_t) len < 25 + 2 * (size_t) pw * (size_t) ph))
+	    return;
+	if ((pat = driver_alloc(pw * ph * sizeof(SLsmg_Char_Type))) == NULL)
+	    return;
+	for (i = 0; i < pw * ph; i++) {
+	    pat[i] = get_int16(buf); buf+= 2;
+	}
+	SLsmg_paint_region(x, y, z, v, pat, pw, ph);
+	driver_free(pat);
+	return;
+    }
 
 
 
@@ -903,9 +845,265 @@ static void sl_output(ErlDrvData drv_data, char *buf, int len)
 	signal_cought = 0;
 	return;
     }
+
+
+    case PAGER_OPEN: {
+	ret = pager_open(buf);
+	if (ret == 0)
+	    driver_set_timer(port, 0);
+	ret_int(port, ret);
+	return;
+    }
+    case PAGER_CLOSE: {
+	pager_close();
+	return;
+    }
+    case PAGER_WINDOW: {
+	x = get_int32(buf); buf+=4;
+	y = get_int32(buf); buf+=4;
+	z = get_int32(buf); buf+=4;
+	v = get_int32(buf); buf+=4;
+	pager_window(x, y, z, v);
+	return;
+    }
+    case PAGER_MOVE: {
+	x = get_int32(buf); buf+=4;
+	y = get_int32(buf); buf+=4;
+	pager_move(x, y);
+	return;
+    }
+    case PAGER_FOLLOW: {
+	x = get_int32(buf); buf+=4;
+	pager_follow(x);
+	if (x)
+	    driver_set_timer(port, 0);
+	return;
+    }
+    case PAGER_RENDER: {
+	pager_render();
+	return;
+    }
+    case PAGER_INFO: {
+	pager_info(port);
+	return;
+    }
+
+    case STATS_GET: {
+	stats_get(port);
+	return;
+    }
+    case STATS_RESET: {
+	stats_reset();
+	return;
+    }
+    case STATS_TRACE: {
+	stats_trace(port, get_int32(buf));
+	return;
+    }
+
+    case CMDLOG_START: {
+	ret_int(port, cmdlog_start(buf));
+	return;
+    }
+    case CMDLOG_STOP: {
+	cmdlog_stop();
+	return;
+    }
+
+    case KEY_EVENTS: {
+	/* 0 off, 1 SLang_getkey, 2 SLkp_getkey */
+	x = get_int32(buf); buf+= 4;
+	if ((x != 0) && (SLang_TT_Read_FD == -1)) {
+	    ret_int(port, -1);
+	    return;
+	}
+	key_events = x;
+	Key_To = driver_caller(port);
+	wait_for = x ? KEY_EVENTS : 0;
+	driver_select(port, 0, DO_READ, x != 0);
+	ret_int(port, 0);
+	return;
+    }
+    case MIRROR: {
+	x = get_int32(buf); buf+= 4;
+	if (x)
+	    ret_int(port, mirror_start(port));
+	else {
+	    mirror_stop();
+	    ret_int(port, 0);
+	}
+	return;
+    }
+    case ANIM_ADD: {
+	int kind, id, width, color2, period, value;
+	kind = get_int32(buf); buf+= 4;
+	id = get_int32(buf); buf+= 4;
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	width = get_int32(buf); buf+= 4;
+	z = get_int32(buf); buf+= 4;
+	color2 = get_int32(buf); buf+= 4;
+	period = get_int32(buf); buf+= 4;
+	value = get_int32(buf); buf+= 4;
+	ret = anim_add(kind, id, x, y, width, z, color2, period, value, buf);
+	if (ret == 0)
+	    driver_set_timer(port, 0);
+	ret_int(port, ret);
+	return;
+    }
+    case ANIM_SET: {
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	ret = anim_set(x, y);
+	if (ret == 0)
+	    driver_set_timer(port, 0);
+	ret_int(port, ret);
+	return;
+    }
+    case ANIM_DELETE: {
+	x = get_int32(buf); buf+= 4;
+	anim_delete(x);
+	return;
+    }
+    case COLOR_GET: {
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	z = get_int32(buf); buf+= 4;
+	ret_int(port, color_get(x, y, z));
+	return;
+    }
+    case COLOR_SET: {
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	z = get_int32(buf); buf+= 4;
+	SLsmg_set_color(color_get(x, y, z));
+	return;
+    }
+    case RLINE_START: {
+	int width, color;
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	width = get_int32(buf); buf+= 4;
+	color = get_int32(buf); buf+= 4;
+	if (SLang_TT_Read_FD == -1) {
+	    ret_int(port, -1);
+	    return;
+	}
+	ret = rline_start(port, x, y, width, color, buf);
+	if (ret == 0) {
+	    wait_for = RLINE_START;
+	    driver_select(port, 0, DO_READ, 1);
+	}
+	ret_int(port, ret);
+	return;
+    }
+    case RLINE_STOP: {
+	rline_stop();
+	if (wait_for == RLINE_START) {
+	    wait_for = key_events ? KEY_EVENTS : 0;
+	    driver_select(port, 0, DO_READ, key_events != 0);
+	}
+	return;
+    }
+    case HIST_OPEN: {
+	x = get_int32(buf); buf+= 4;
+	ret_int(port, hist_open(buf, x));
+	return;
+    }
+    case HIST_CLOSE: {
+	hist_close();
+	return;
+    }
+    case HIST_ADD: {
+	hist_add(buf, strlen(buf));
+	return;
+    }
+    case COMPL_LOAD: {
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	ret_int(port, compl_load(x, buf, y));
+	return;
+    }
+    case COMPL_CALLBACK: {
+	x = get_int32(buf); buf+= 4;
+	rline_callback(port, x);
+	return;
+    }
+    case COMPL_REPLY: {
+	x = get_int32(buf); buf+= 4;
+	y = get_int32(buf); buf+= 4;
+	rline_compl_reply(x, buf, y);
+	return;
+    }
+    case CAST_START: {
+	x = get_int32(buf); buf+= 4;
+	ret_int(port, cast_start(buf, x));
+	return;
+    }
+    case CAST_STOP: {
+	ret_int(port, (int) cast_stop());
+	return;
+    }
+    case TT_OUTQ: {
+	/* bytes written to the tty that it has not sent yet */
+	x = 0;
+#ifdef TIOCOUTQ
+	if ((SLang_TT_Write_FD == -1)
+	    || (ioctl(SLang_TT_Write_FD, TIOCOUTQ, &x) == -1))
+	    x = 0;
+#endif
+	ret_int(port, x);
+	return;
+    }
+    }
+}
+
+
+
+
+/* the commands that change the virtual screen, see Smg_Batch */
+static int smg_draws(int op)
+{
+    switch (op) {
+    case SMG_SUSPEND_SMG:
+    case SMG_RESUME_SMG:
+    case SMG_REFRESH:
+    case SMG_RESET_SMG:
+    case SMG_CHAR_AT:
+    case SMG_GET_COLUMN:
+    case SMG_GET_ROW:
+    case SMG_READ_RAW:
+	return 0;
+    case PAGER_RENDER:
+	return 1;
+    default:
+	return (op >= SMG_FILL_REGION) && (op <= SMG_PAINT_REGION);
     }
 }
 
+static void sl_output(ErlDrvData drv_data, char *buf, int len)
+{
+    ErlDrvPort port = (ErlDrvPort)drv_data;
+    uint64_t t0;
+
+    if (len < 1)
+	return;
+    cmdlog_write(buf, len);
+    if (smg_draws(*(unsigned char *)buf))
+	Smg_Batch = 1;
+    t0 = stats_now();
+    sl_dispatch(port, buf, len);
+    stats_record(port, *(unsigned char *)buf, stats_now() - t0);
+}
+
+
+
+/* slang_replay feeds recorded commands through here, there is no
+   emulator and no port behind it */
+void sl_replay_output(char *buf, int len)
+{
+    sl_output((ErlDrvData)NULL, buf, len);
+}
 
 
 
@@ -914,6 +1112,31 @@ void sl_ready_input(ErlDrvData drv_data, ErlDrvEvent fd)
 {
     ErlDrvPort port = (ErlDrvPort)drv_data;
     unsigned int key;
+
+    if (wait_for == RLINE_START) {
+	while (SLang_input_pending (0) > 0)
+	    if (rline_key()) {
+		/* keys typed after the line are key events, if on */
+		wait_for = key_events ? KEY_EVENTS : 0;
+		driver_select(port, 0, DO_READ, key_events != 0);
+		break;
+	    }
+	if (wait_for != KEY_EVENTS)
+	    return;
+    }
+    if (wait_for == KEY_EVENTS) {
+	while (SLang_input_pending (0) > 0) {
+	    ErlDrvTermData spec[] = {
+		ERL_DRV_ATOM, driver_mk_atom("slang_key"),
+		ERL_DRV_INT, 0,
+		ERL_DRV_TUPLE, 2
+	    };
+	    key = (key_events == 2) ? SLkp_getkey () : SLang_getkey ();
+	    spec[3] = (ErlDrvTermData) key;
+	    driver_send_term(port, Key_To, spec, sizeof(spec) / sizeof(spec[0]));
+	}
+	return;
+    }
     driver_select(port, 0, DO_READ, 0);
     switch (wait_for) {
     case GETKEY: {
@@ -929,6 +1152,20 @@ void sl_ready_input(ErlDrvData drv_data, ErlDrvEvent fd)
     }
 }
 
+/* background work: pager indexing and follow mode */
+static void sl_timeout(ErlDrvData drv_data)
+{
+    ErlDrvPort port = (ErlDrvPort)drv_data;
+    int next, a;
+
+    a = anim_tick();
+    next = pager_tick();
+    if ((a >= 0) && ((next < 0) || (a < next)))
+	next = a;
+    if (next >= 0)
+	driver_set_timer(port, next);
+}
+
 /*
  * Initialize and return a driver entry struct
  */
@@ -941,6 +1178,7 @@ DRIVER_INIT(slang_drv)
     sl_erl_drv_entry.stop = sl_stop;
     sl_erl_drv_entry.output = sl_output;
     sl_erl_drv_entry.ready_input = sl_ready_input;
+    sl_erl_drv_entry.timeout = sl_timeout;
     sl_erl_drv_entry.driver_name = "slang_drv";
 
     return &sl_erl_drv_entry;
@@ -0,0 +1,322 @@
+/*
+ * Internal declarations shared by the parts of slang_drv
+ */
+
+#ifndef SLANG_DRV_H
+#define SLANG_DRV_H
+
+#include <arpa/inet.h>
+#include <stdint.h>
+
+#include <slang.h>
+
+
+/* Standard set of integer macros  .. */
+
+#define get_int32(s) ntohl(*(uint32_t *)(s))
+
+#define put_int32(i, s) do {				\
+	*(uint32_t *)(s) = htonl((uint32_t)(i));	\
+} while (0)
+
+#define get_int16(s) ntohs(*(uint16_t *)(s))
+
+#define put_int16(i, s) do {				\
+	*(uint16_t *)(s) = htons((uint16_t)(i));	\
+} while (0)
+
+#define get_int8(s) (*(uint8_t *)(s))
+
+#define put_int8(i, s) do {				\
+	*(uint8_t *)(s) = (uint8_t)(i);			\
+} while (0)
+
+
+
+/* ops of the port protocol, the first byte of every command */
+
+#define INIT_TTY           1
+#define SET_ABORT_FUNCTION 2
+#define GETKEY             3
+#define RESET_TTY          4
+#define KP_GETKEY          5
+#define UNGETKEY           6
+#define SETVAR             7
+#define GETVAR             8
+#define KP_INIT            9
+
+/* screen mgmt  */
+
+#define SMG_FILL_REGION       10
+#define SMG_SET_CHAR_SET      11
+#define SMG_SUSPEND_SMG       12
+#define SMG_RESUME_SMG        13
+#define SMG_ERASE_EOL         14
+#define SMG_GOTORC            15
+#define SMG_ERASE_EOS         16
+#define SMG_REVERSE_VIDEO     17
+#define SMG_SET_COLOR         18
+#define SMG_NORMAL_VIDEO      19
+#define SMG_PRINTF            20
+#define SMG_VPRINTF           21
+#define SMG_WRITE_STRING      22
+#define SMG_WRITE_NSTRING     23
+#define SMG_WRITE_CHAR        24
+#define SMG_WRITE_NCHARS      25
+#define SMG_WRITE_WRAPPED_STRING 26
+#define SMG_CLS               27
+#define SMG_REFRESH           28
+#define SMG_TOUCH_LINES       29
+#define SMG_TOUCH_SCREEN      30
+#define SMG_INIT_SMG          31
+#define SMG_REINIT_SMG        32
+#define SMG_RESET_SMG         33
+#define SMG_CHAR_AT            34
+#define SMG_SET_SCREEN_START  35
+#define SMG_DRAW_HLINE        36
+#define SMG_DRAW_VLINE        37
+#define SMG_DRAW_OBJECT       38
+#define SMG_DRAW_BOX          39
+#define SMG_GET_COLUMN        40
+#define SMG_GET_ROW           41
+#define SMG_FORWARD           42
+#define SMG_WRITE_COLOR_CHARS 43
+#define SMG_READ_RAW          44
+#define SMG_WRITE_RAW         45
+#define SMG_SET_COLOR_IN_REGION 46
+#define SMG_SCROLL_REGION     47
+#define SMG_PAINT_REGION      48
+#define SMG_SNAPSHOT          49
+
+
+
+
+/* ops for all the tt_ functions */
+
+#define TT_FLUSH_OUTPUT        50
+#define TT_SET_SCROLL_REGION   51
+#define TT_RESET_SCROLL_REGION 52
+#define TT_REVERSE_VIDEO       53
+#define TT_BOLD_VIDEO          54
+#define TT_BEGIN_INSERT        55
+#define TT_END_INSERT          56
+#define TT_DEL_EOL             57
+#define TT_GOTO_RC             58
+#define TT_DELETE_NLINES       59
+#define TT_DELETE_CHAR         60
+#define TT_ERASE_LINE          61
+#define TT_NORMAL_VIDEO        62
+#define TT_CLS                 63
+#define TT_BEEP                64
+#define TT_REVERSE_INDEX       65
+#define TT_SMART_PUTS          66
+#define TT_WRITE_STRING        67
+#define TT_PUTCHAR             68
+#define TT_INIT_VIDEO          69
+#define TT_RESET_VIDEO         70
+#define TT_GET_TERMINFO        71
+#define TT_GET_SCREEN_SIZE     72
+#define TT_SET_CURSOR_VISIBILITY 73
+#define TT_SET_MOUSE_MODE      74
+
+#define TT_INITIALIZE          75
+#define TT_ENABLE_CURSOR_KEYS  76
+#define TT_SET_TERM_VTXXX      77
+#define TT_SET_COLOR_ESC       78
+#define TT_WIDE_WIDTH          79
+#define TT_NARROW_WIDTH        80
+#define TT_SET_ALT_CHAR_SET    81
+#define TT_WRITE_TO_STATUS_LINE 82
+#define TT_DISABLE_STATUS_LINE  83
+
+
+#define TT_TGETSTR             84
+#define TT_TGETNUM             85
+#define TT_TGETFLAG            86
+#define TT_TIGETENT            87
+#define TT_TIGETSTR            88
+#define TT_TIGETNUM            89
+
+#define SLTT_GET_COLOR_OBJECT  90
+#define TT_SET_COLOR_OBJECT    91
+#define TT_SET_COLOR           92
+#define TT_SET_MONO            93
+#define TT_ADD_COLOR_ATTRIBUTE 94
+#define TT_SET_COLOR_FGBG      95
+
+
+/* aux tty functions */
+#define ISATTY                 100
+#define EFORMAT                101
+#define SIGNAL                 102
+#define SIGNAL_CHECK           103
+#define KEY_EVENTS             104
+#define TT_OUTQ                105
+#define MIRROR                 106
+#define CAST_START             107
+#define CAST_STOP              108
+
+/* the driver side pager */
+#define PAGER_OPEN             110
+#define PAGER_CLOSE            111
+#define PAGER_WINDOW           112
+#define PAGER_MOVE             113
+#define PAGER_FOLLOW           114
+#define PAGER_RENDER           115
+#define PAGER_INFO             116
+
+/* per opcode latency statistics */
+#define STATS_GET              120
+#define STATS_RESET            121
+#define STATS_TRACE            122
+
+/* command stream recording */
+#define CMDLOG_START           125
+#define CMDLOG_STOP            126
+
+/* animations the driver redraws by itself */
+#define ANIM_ADD               130
+#define ANIM_SET               131
+#define ANIM_DELETE            132
+
+/* color objects allocated on demand */
+#define COLOR_GET              133
+#define COLOR_SET              134
+
+/* line editor in the driver */
+#define RLINE_START            135
+#define RLINE_STOP             136
+#define HIST_OPEN              137
+#define HIST_CLOSE             138
+#define HIST_ADD               139
+#define COMPL_LOAD             140
+#define COMPL_CALLBACK         141
+#define COMPL_REPLY            142
+
+/* slang.erl pokes the driver while it waits for a reply */
+#define TICK                   255
+
+
+
+/* slang_replay stands in for the emulator and only wants the ops */
+#ifndef SLANG_DRV_OPS_ONLY
+
+#include <erl_driver.h>
+
+/* slang_drv.c */
+extern int Smg_Batch;
+extern int ret_int(ErlDrvPort port, int ret);
+extern int ret_int_int(ErlDrvPort port, int i, int j);
+
+/* sl_pager.c */
+extern int pager_open(char *file);
+extern void pager_close(void);
+extern void pager_window(int r, int c, int nr, int nc);
+extern void pager_move(int how, int n);
+extern void pager_follow(int on);
+extern void pager_render(void);
+extern void pager_info(ErlDrvPort port);
+extern int pager_tick(void);
+
+/* sl_stats.c */
+extern uint64_t stats_now(void);
+extern void stats_record(ErlDrvPort port, int op, uint64_t ns);
+extern void stats_reset(void);
+extern void stats_trace(ErlDrvPort port, int on);
+extern void stats_get(ErlDrvPort port);
+
+/* sl_snap.c */
+extern void snap_get(ErlDrvPort port, int since);
+extern void snap_reset(void);
+extern void snap_read_screen(SLsmg_Char_Type *dst, int rows, int cols);
+extern int snap_color_offset(void);
+extern SLsmg_Char_Type snap_cell(SLsmg_Char_Type cell, int offset);
+
+/* sl_mirror.c */
+extern int mirror_start(ErlDrvPort port);
+extern void mirror_stop(void);
+
+/* sl_cast.c */
+extern int cast_start(char *file, int interval_ms);
+extern unsigned long cast_stop(void);
+extern int cast_keyframe(void);
+extern void cast_refreshed(void);
+
+/* sl_anim.c */
+#define ANIM_SPINNER   1
+#define ANIM_PROGRESS  2
+#define ANIM_CLOCK     3
+extern int anim_add(int kind, int id, int row, int col, int width,
+		    int color, int color2, int period_ms, int value, char *text);
+extern int anim_set(int id, int value);
+extern void anim_delete(int id);
+extern int anim_tick(void);
+extern void anim_before_refresh(void);
+
+/* sl_color.c, color_get() attrs */
+#define COLOR_BOLD     1
+#define COLOR_ULINE    2
+#define COLOR_BLINK    4
+#define COLOR_REV      8
+extern int color_get(int fg, int bg, int attrs);
+extern void color_reset(void);
+
+/* sl_rline.c */
+extern int rline_start(ErlDrvPort port, int row, int col, int width, int color,
+		       char *prompt);
+extern int rline_key(void);
+extern int rline_active(void);
+extern void rline_stop(void);
+extern void rline_callback(ErlDrvPort port, int on);
+extern void rline_compl_reply(int gen, char *buf, int len);
+
+/* sl_hist.c */
+#define HIST_END ((unsigned long) -1)
+extern int hist_open(char *file, int max);
+extern void hist_close(void);
+extern void hist_clear(void);
+extern int hist_add(char *s, int len);
+extern unsigned long hist_prev(char *prefix, int plen, unsigned long seq,
+			       char **text, int *len);
+extern unsigned long hist_next(char *prefix, int plen, unsigned long seq,
+			       char **text, int *len);
+extern unsigned long hist_search(char *str, int slen, unsigned long seq,
+				 char **text, int *len, int *at);
+
+/* sl_compl.c */
+#define COMPL_SOURCES   4
+#define COMPL_MENU_MAX  200
+#define COMPL_BUF       8192
+
+typedef struct {
+    int total;                  /* words that fit */
+    int lcp;                    /* length they all have in common */
+    int n, used;                /* the first n of them in w */
+    char *w[COMPL_MENU_MAX];
+    char buf[COMPL_BUF];
+} Compl_Cands;
+
+extern int compl_load(int source, char *buf, int len);
+extern void compl_reset(void);
+extern void compl_find(int source, char *prefix, int plen, Compl_Cands *c);
+extern void compl_from_list(char *buf, int len, Compl_Cands *c);
+extern void compl_menu_show(Compl_Cands *c, int row, int col, int width, int color);
+extern void compl_menu_hide(void);
+extern int compl_menu_shown(void);
+
+/* sl_cmdlog.c */
+extern int cmdlog_start(char *file);
+extern void cmdlog_stop(void);
+extern void cmdlog_write(char *buf, int len);
+
+/* pager_move() kinds */
+#define PAGER_LINES   1
+#define PAGER_PAGES   2
+#define PAGER_GOTO    3
+#define PAGER_TOP     4
+#define PAGER_BOTTOM  5
+#define PAGER_COLUMNS 6
+
+#endif /* SLANG_DRV_OPS_ONLY */
+
+#endif
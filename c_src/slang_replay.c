@@ -0,0 +1,505 @@
+/*
+ * slang_replay - play back a command stream recorded with
+ * slang:cmdlog_start/1 through the driver's own decode path,
+ * without an Erlang node and without a user.
+ *
+ * By default the screen management runs against a null terminal, so
+ * only the SLsmg side is measured.  With -t the output is encoded for
+ * the terminal in $TERM, as it would be live, and thrown away into
+ * /dev/null.  Commands that need a tty or a user (keyboard, signals)
+ * are skipped.  At the end the driver's per opcode statistics are
+ * printed to stderr and, with -s, the screen as an SMG_SNAPSHOT
+ * reply has it to a file, which is what the tests compare.
+ *
+ * The driver objects are linked in as they are, the few emulator
+ * functions they call are stubbed out here.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <slang.h>
+
+#define SLANG_DRV_OPS_ONLY
+#include "slang_drv.h"
+
+
+extern void sl_replay_output(char *buf, int len);
+
+
+/* ops not to replay, see slang_drv.h */
+static int skip_op(int op)
+{
+    switch (op) {
+    case INIT_TTY:
+    case SET_ABORT_FUNCTION:
+    case GETKEY:
+    case RESET_TTY:
+    case KP_GETKEY:
+    case UNGETKEY:
+    case KP_INIT:
+    case TT_GET_TERMINFO:
+    case TT_GET_SCREEN_SIZE:
+    case ISATTY:
+    case EFORMAT:
+    case SIGNAL:
+    case SIGNAL_CHECK:
+    case KEY_EVENTS:
+    case MIRROR:
+    case CAST_START:
+    case CAST_STOP:
+    case ANIM_ADD:       /* nothing would run the timer */
+    case ANIM_SET:
+    case ANIM_DELETE:
+    case RLINE_START:    /* needs a tty */
+    case RLINE_STOP:
+    case HIST_OPEN:
+    case HIST_CLOSE:
+    case HIST_ADD:
+    case COMPL_LOAD:
+    case COMPL_CALLBACK:
+    case COMPL_REPLY:
+    case STATS_GET:
+    case STATS_RESET:
+    case STATS_TRACE:
+    case CMDLOG_START:
+    case CMDLOG_STOP:
+    case TICK:
+	return 1;
+    default:
+	return 0;
+    }
+}
+
+
+
+/* the emulator as far as the driver is concerned */
+
+static char *Reply;
+static int Reply_Len;
+
+int driver_output(void *port, char *buf, long len)
+{
+    if (Reply != NULL)
+	free(Reply);
+    if ((Reply = malloc(len)) != NULL) {
+	memcpy(Reply, buf, len);
+	Reply_Len = len;
+    }
+    return 0;
+}
+
+int driver_select(void *port, void *event, int mode, int on)
+{
+    return 0;
+}
+
+int driver_set_timer(void *port, unsigned long t)
+{
+    return 0;
+}
+
+int driver_cancel_timer(void *port)
+{
+    return 0;
+}
+
+void *driver_alloc(size_t size)
+{
+    return malloc(size);
+}
+
+void *driver_realloc(void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void driver_free(void *ptr)
+{
+    free(ptr);
+}
+
+unsigned long driver_mk_atom(char *name)
+{
+    return 0;
+}
+
+unsigned long driver_caller(void *port)
+{
+    return 0;
+}
+
+int driver_send_term(void *port, unsigned long to, unsigned long *data, int len)
+{
+    return 0;
+}
+
+/* threads, for the cast recorder */
+
+void *erl_drv_mutex_create(char *name)
+{
+    pthread_mutex_t *m = malloc(sizeof(pthread_mutex_t));
+
+    if ((m != NULL) && (pthread_mutex_init(m, NULL) != 0)) {
+	free(m);
+	return NULL;
+    }
+    return m;
+}
+
+void erl_drv_mutex_destroy(void *m)
+{
+    pthread_mutex_destroy(m);
+    free(m);
+}
+
+void erl_drv_mutex_lock(void *m)
+{
+    pthread_mutex_lock(m);
+}
+
+void erl_drv_mutex_unlock(void *m)
+{
+    pthread_mutex_unlock(m);
+}
+
+void *erl_drv_cond_create(char *name)
+{
+    pthread_cond_t *c = malloc(sizeof(pthread_cond_t));
+
+    if ((c != NULL) && (pthread_cond_init(c, NULL) != 0)) {
+	free(c);
+	return NULL;
+    }
+    return c;
+}
+
+void erl_drv_cond_destroy(void *c)
+{
+    pthread_cond_destroy(c);
+    free(c);
+}
+
+void erl_drv_cond_signal(void *c)
+{
+    pthread_cond_signal(c);
+}
+
+void erl_drv_cond_wait(void *c, void *m)
+{
+    pthread_cond_wait(c, m);
+}
+
+int erl_drv_thread_create(char *name, void **tid, void *(*func)(void *),
+			  void *arg, void *opts)
+{
+    pthread_t *t = malloc(sizeof(pthread_t));
+
+    if (t == NULL)
+	return -1;
+    if (pthread_create(t, NULL, func, arg) != 0) {
+	free(t);
+	return -1;
+    }
+    *tid = t;
+    return 0;
+}
+
+int erl_drv_thread_join(void *tid, void **respp)
+{
+    int ret = pthread_join(*(pthread_t *) tid, respp);
+
+    free(tid);
+    return ret;
+}
+
+
+
+/* a terminal that does nothing */
+
+static int Rows = 24, Cols = 80, Zero = 0;
+static char *No_Pairs = NULL;
+
+static void null_void(void) {}
+static int null_int(void) { return 0; }
+static void null_int_int(int a, int b) {}
+static void null_int1(int a) {}
+static void null_puts(SLsmg_Char_Type *a, SLsmg_Char_Type *b, int n, int r) {}
+
+static SLsmg_Term_Type Null_Term = {
+    null_void,          /* tt_normal_video */
+    null_int_int,       /* tt_set_scroll_region */
+    null_int_int,       /* tt_goto_rc */
+    null_int1,          /* tt_reverse_index */
+    null_void,          /* tt_reset_scroll_region */
+    null_int1,          /* tt_delete_nlines */
+    null_void,          /* tt_cls */
+    null_void,          /* tt_del_eol */
+    null_puts,          /* tt_smart_puts */
+    null_int,           /* tt_flush_output */
+    null_int,           /* tt_reset_video */
+    null_int,           /* tt_init_video */
+    &Rows, &Cols,
+    &Zero, &Zero, &Zero,
+    &No_Pairs
+};
+
+
+
+static uint64_t now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static int get_varint(unsigned char **p, unsigned char *end, uint64_t *v)
+{
+    int shift = 0;
+
+    *v = 0;
+    while (*p < end) {
+	*v |= (uint64_t)(**p & 0x7f) << shift;
+	if ((*(*p)++ & 0x80) == 0)
+	    return 0;
+	shift += 7;
+    }
+    return -1;
+}
+
+
+static uint64_t get64(unsigned char *p)
+{
+    uint64_t v = 0;
+    int i;
+
+    for (i = 0; i < 8; i++)
+	v = (v << 8) | p[i];
+    return v;
+}
+
+
+static uint64_t bucket_low(int b)
+{
+    if (b < 16)
+	return b;
+    return (uint64_t)(16 + (b & 15)) << ((b >> 4) - 1);
+}
+
+
+/* ask the driver for its STATS_GET reply and print it */
+static void print_stats(void)
+{
+    char op = STATS_GET;
+    unsigned char *p, *end;
+    uint64_t count, total, max, rank, p50, p99, t50, t99, c;
+    int i, n, b, o;
+
+    sl_replay_output(&op, 1);
+    if ((Reply == NULL) || (Reply_Len < 1) || (Reply[0] != 1))
+	return;
+
+    fprintf(stderr, "%4s %10s %12s %10s %10s %10s %10s\n",
+	    "op", "calls", "total(us)", "mean(ns)", "p50(ns)", "p99(ns)", "max(ns)");
+    p = (unsigned char *) Reply + 1;
+    end = (unsigned char *) Reply + Reply_Len;
+    while (p + 35 <= end) {
+	o = p[0];
+	count = get64(p+1);
+	total = get64(p+9);
+	max = get64(p+25);
+	n = (p[33] << 8) | p[34];
+	p += 35;
+
+	p50 = p99 = 0;
+	t50 = (count + 1) / 2;
+	t99 = (count * 99 + 99) / 100;
+	for (i = 0, rank = 0; (i < n) && (p + 6 <= end); i++, p += 6) {
+	    b = (p[0] << 8) | p[1];
+	    c = ((uint64_t)p[2] << 24) | (p[3] << 16) | (p[4] << 8) | p[5];
+	    if ((rank < t50) && (rank + c >= t50))
+		p50 = bucket_low(b);
+	    if ((rank < t99) && (rank + c >= t99))
+		p99 = bucket_low(b);
+	    rank += c;
+	}
+	fprintf(stderr, "%4d %10llu %12llu %10llu %10llu %10llu %10llu\n",
+		o, (unsigned long long) count,
+		(unsigned long long) (total / 1000),
+		(unsigned long long) (total / count),
+		(unsigned long long) p50, (unsigned long long) p99,
+		(unsigned long long) max);
+    }
+}
+
+
+/*
+ * Write the screen from an SMG_SNAPSHOT reply: the size and cursor,
+ * the text of every row without trailing blanks and, for the rows
+ * that have any, the runs of cells not in color 0 as
+ * Row: First-Last:Color ..., with a + for the alternate character set.
+ */
+static int write_screen(char *file)
+{
+    char op[5];
+    unsigned char *p, *end, *cells;
+    int rows, cols, n, r, c, last, ch, color;
+    FILE *fp;
+
+    op[0] = SMG_SNAPSHOT;
+    put_int32(-1, op+1);
+    sl_replay_output(op, 5);
+    if ((Reply == NULL) || (Reply_Len < 15) || (Reply[0] != 1))
+	return -1;
+    p = (unsigned char *) Reply;
+    end = p + Reply_Len;
+    rows = (p[5] << 8) | p[6];
+    cols = (p[7] << 8) | p[8];
+    n = (p[13] << 8) | p[14];
+    if ((n != rows) || (end - (p + 15) != rows * (2 + 2 * cols)))
+	return -1;
+    if ((fp = fopen(file, "w")) == NULL)
+	return -1;
+
+    fprintf(fp, "%dx%d at %d,%d\n", rows, cols,
+	    (p[9] << 8) | p[10], (p[11] << 8) | p[12]);
+    p += 15;
+    for (r = 0; r < rows; r++) {
+	cells = p + r * (2 + 2 * cols) + 2;
+	for (last = cols; last > 0; last--)
+	    if ((cells[2 * last - 1] != ' ') && (cells[2 * last - 1] != 0))
+		break;
+	for (c = 0; c < last; c++) {
+	    ch = cells[2 * c + 1];
+	    putc(((ch < 0x20) || (ch >= 0x7f)) ? '?' : ch, fp);
+	}
+	putc('\n', fp);
+    }
+    for (r = 0; r < rows; r++) {
+	cells = p + r * (2 + 2 * cols) + 2;
+	for (c = 0, n = 0; c < cols; c = last) {
+	    color = cells[2 * c];
+	    for (last = c + 1; (last < cols) && (cells[2 * last] == color); last++)
+		;
+	    if (color == 0)
+		continue;
+	    if (n++ == 0)
+		fprintf(fp, "%d:", r);
+	    fprintf(fp, " %d-%d:%d%s", c, last - 1, color & 0x7f,
+		    (color & 0x80) ? "+" : "");
+	}
+	if (n)
+	    putc('\n', fp);
+    }
+    fclose(fp);
+    return 0;
+}
+
+
+static void usage(char *prog)
+{
+    fprintf(stderr, "usage: %s [-t] [-p] [-n count] [-s file] recording\n"
+	    "  -t  encode for $TERM, output goes to /dev/null\n"
+	    "  -p  keep the recorded pacing\n"
+	    "  -n  play the recording count times\n"
+	    "  -s  write the final screen to file\n", prog);
+    exit(1);
+}
+
+
+int main(int argc, char **argv)
+{
+    int c, tty = 0, pace = 0, count = 1, pass, fd, ret = 0;
+    char *screen = NULL;
+    FILE *fp;
+    long size;
+    unsigned char *data, *p, *end;
+    uint64_t delta, len, ncmds = 0, nbytes = 0, t0, elapsed;
+    struct timespec ts;
+
+    while ((c = getopt(argc, argv, "tpn:s:")) != -1) {
+	switch (c) {
+	case 't': tty = 1; break;
+	case 'p': pace = 1; break;
+	case 'n': count = atoi(optarg); break;
+	case 's': screen = optarg; break;
+	default: usage(argv[0]);
+	}
+    }
+    if (optind != argc - 1)
+	usage(argv[0]);
+
+    if ((fp = fopen(argv[optind], "rb")) == NULL) {
+	perror(argv[optind]);
+	return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    rewind(fp);
+    if ((size < 10) || ((data = malloc(size)) == NULL)
+	|| (fread(data, 1, size, fp) != (size_t) size)
+	|| (memcmp(data, "SLREC\001", 6) != 0)) {
+	fprintf(stderr, "%s: not a slang recording\n", argv[optind]);
+	return 1;
+    }
+    fclose(fp);
+    Rows = (data[6] << 8) | data[7];
+    Cols = (data[8] << 8) | data[9];
+
+    if (tty) {
+	SLtt_get_terminfo();
+	if ((fd = open("/dev/null", O_WRONLY)) != -1)
+	    dup2(fd, 1);
+    }
+    else
+	SLsmg_set_terminal_info(&Null_Term);
+    SLtt_Screen_Rows = Rows;
+    SLtt_Screen_Cols = Cols;
+    SLsmg_init_smg();
+
+    t0 = now();
+    for (pass = 0; pass < count; pass++) {
+	p = data + 10;
+	end = data + size;
+	while (p < end) {
+	    if ((get_varint(&p, end, &delta) == -1)
+		|| (get_varint(&p, end, &len) == -1)
+		|| (len > (uint64_t)(end - p))) {
+		fprintf(stderr, "truncated recording\n");
+		break;
+	    }
+	    if (pace && delta) {
+		ts.tv_sec = delta / 1000000000;
+		ts.tv_nsec = delta % 1000000000;
+		nanosleep(&ts, NULL);
+	    }
+	    if ((len > 0) && !skip_op(p[0])) {
+		sl_replay_output((char *) p, (int) len);
+		ncmds++;
+		nbytes += len;
+	    }
+	    p += len;
+	}
+    }
+    elapsed = now() - t0;
+
+    if ((screen != NULL) && (write_screen(screen) == -1)) {
+	fprintf(stderr, "%s: cannot write the screen\n", screen);
+	ret = 1;
+    }
+    SLsmg_reset_smg();
+
+    fprintf(stderr, "%llu commands, %llu bytes in %.3f s, %.0f commands/s\n",
+	    (unsigned long long) ncmds, (unsigned long long) nbytes,
+	    elapsed / 1e9, elapsed ? ncmds * 1e9 / elapsed : 0.0);
+    print_stats();
+    return ret;
+}
@@ -1,7 +1,7 @@
 %%%----------------------------------------------------------------------
 %%% File    : pager.erl
 %%% Author  : Claes Wikstrom <klacke@kaja.hemma.net>
-%%% Purpose :
+%%% Purpose : a less(1) lookalike on top of the driver side pager
 %%% Created :  1 Dec 2000 by Claes Wikstrom <klacke@kaja.hemma.net>
 %%%----------------------------------------------------------------------
 
@@ -12,18 +12,20 @@
 
 -include ("slang.hrl").
 
--record(file_line, {next,
-		    prev,
-		    data}).
-
 
+%% the file is mmap'ed by the driver and rendered from there, we
+%% only send navigation commands, so this works just as well on
+%% a multi GB log file as on a small one
 
+-define(APP_KEY_EOB, 16#1001).
+-define(APP_KEY_BOB, 16#1002).
 
 
 demolib_exit (Signal) ->
 
-    slang:reset_tty (),
+    slang:pager_close (),
     slang:smg_reset_smg (),
+    slang:reset_tty (),
 
     if
 	Signal ==  0 ->
@@ -34,43 +36,8 @@ demolib_exit (Signal) ->
     end.
 
 
-sigint_handler (Signal) ->
-    demolib_exit (Signal).
-
-
-
-% static void init_signals (void)
-% {
-% #ifdef SIGTSTP
-%    SLsignal (SIGTSTP, sigtstp_handler);
-% #endif
-% #ifdef SIGINT
-%    SLsignal (SIGINT, sigint_handler);
-% #endif
-% }
-
-exit_error_hook (Fmt, Args) ->
-
-    slang:reset_tty (),
-    slang:reset_smg (),
-
-    io:format(Fmt, Args),
-    io:nl(),
-    halt().
-
-
-
-
 demolib_init_terminal () ->
 
-    %% SLang_Exit_Error_Hook = exit_error_hook
-						% It is wise to block the occurance of display  related
-    %signals while we are
-    %initializing.
-
-
-						%SLsig_block_signals (),
-
     slang:tt_get_terminfo (),
 
     %% SLkp_init assumes that SLtt_get_terminfo has been called.
@@ -78,10 +45,8 @@ demolib_init_terminal () ->
     case slang:kp_init() of
 	-1 ->
 	    -1;
-	Ret ->
-
+	_ ->
 	    slang:init_tty (-1, 0, 1),
-	    %slang:tty_set_suspend_state (1),
 
 	    case slang:smg_init_smg () of
 		-1 ->
@@ -92,260 +57,80 @@ demolib_init_terminal () ->
     end.
 
 
-main() ->
-    File="tmp/test",
-
-
-
-
-int main (int argc, char **argv)
-{
-   if (argc == 2)
-     {
-	File_Name = argv[1];
-     }
-   else if ((argc != 1) || (1 == isatty (fileno(stdin))))
-     usage (argv[0]);
-
-
-   if (-1 == read_file (File_Name))
-     {
-	fprintf (stderr, "Unable to read %s\n", File_Name);
-	return 1;
-     }
-
-   /* This sets up the terminal, signals, screen management routines, etc... */
-   if (-1 == demolib_init_terminal (1, 1))
-     {
-	fprintf (stderr, "Unable to initialize terminal.");
-	return 1;
-     }
-
-#define APP_KEY_EOB  0x1001
-#define APP_KEY_BOB  0x1002
-
-   /* Add a few application defined keysyms.  0x1000 and above are for
-    * applications.
-    */
-   (void) SLkp_define_keysym ("\033>", APP_KEY_EOB);
-   (void) SLkp_define_keysym ("\033<", APP_KEY_BOB);
-
-   main_loop ();		       /* should not return */
-   return 1;
-}
-
-
-/* The SLscroll routines will be used for pageup/down commands.  They assume
- * a linked list of lines.  The first element of the structure MUST point to
- * the NEXT line, the second MUST point to the PREVIOUS line.
- */
-typedef struct _File_Line_Type
-{
-   struct _File_Line_Type *next;
-   struct _File_Line_Type *prev;
-   char *data;			       /* pointer to line data */
-}
-File_Line_Type;
-
-static File_Line_Type *File_Lines;
-
-/* The SLscroll routines will use this structure. */
-static SLscroll_Window_Type Line_Window;
-
-static void free_lines (void)
-{
-   File_Line_Type *line, *next;
-
-   line = File_Lines;
-   while (line != NULL)
-     {
-	next = line->next;
-	if (line->data != NULL) free (line->data);
-	free (line);
-	line = next;
-     }
-   File_Lines = NULL;
-}
-
-static File_Line_Type *create_line (char *buf)
-{
-   File_Line_Type *line;
-
-   line = (File_Line_Type *) malloc (sizeof (File_Line_Type));
-   if (line == NULL) return NULL;
-
-   memset ((char *) line, sizeof (File_Line_Type), 0);
-
-   line->data = SLmake_string (buf);   /* use a slang routine */
-   if (line->data == NULL)
-     {
-	free (line);
-	return NULL;
-     }
-
-   return line;
-}
-
-
-static int read_file (char *file)
-{
-   FILE *fp;
-   char buf [1024];
-   File_Line_Type *line, *last_line;
-   unsigned int num_lines;
-
-   if (file == NULL)
-     fp = stdin;
-   else fp = fopen (file, "r");
-
-   if (fp == NULL) return -1;
-
-   last_line = NULL;
-   num_lines = 0;
-
-   while (NULL != fgets (buf, sizeof(buf), fp))
-     {
-	num_lines++;
-
-	if (NULL == (line = create_line (buf)))
-	  {
-	     fprintf (stderr, "Out of memory.");
-	     free_lines ();
-	     return -1;
-	  }
-
-	if (last_line == NULL)
-	  File_Lines = line;
-	else
-	  last_line->next = line;
-
-	line->prev = last_line;
-	line->next = NULL;
-
-	last_line = line;
-     }
-
-   memset ((char *)&Line_Window, 0, sizeof (SLscroll_Window_Type));
-
-   Line_Window.current_line = (SLscroll_Type *) File_Lines;
-   Line_Window.lines = (SLscroll_Type *) File_Lines;
-   Line_Window.line_num = 1;
-   Line_Window.num_lines = num_lines;
-
-   return 0;
-}
-
-
-static void update_display (void)
-{
-   unsigned int row, nrows;
-   File_Line_Type *line;
-
-   /* All well behaved applications should block signals that may affect
-    * the display while performing screen update.
-    */
-   SLsig_block_signals ();
-
-   Line_Window.nrows = nrows = SLtt_Screen_Rows - 1;
-
-   /* Always make the current line equal to the top window line. */
-   if (Line_Window.top_window_line != NULL)
-     Line_Window.current_line = Line_Window.top_window_line;
-
-   SLscroll_find_top (&Line_Window);
-
-   row = 0;
-   line = (File_Line_Type *) Line_Window.top_window_line;
-
-   SLsmg_normal_video ();
-
-   while (row < Line_Window.nrows)
-     {
-	SLsmg_gotorc (row, 0);
-
-	if (line != NULL)
-	  {
-	     SLsmg_write_string (line->data);
-	     line = line->next;
-	  }
-	SLsmg_erase_eol ();
-	row++;
-     }
-
-   SLsmg_gotorc (row, 0);
-   SLsmg_reverse_video ();
-   SLsmg_printf ("%s", (File_Name == NULL) ? "<stdin>" : File_Name);
-   SLsmg_erase_eol ();
-   SLsmg_refresh ();
-
-   SLsig_unblock_signals ();
-}
-
-static int Screen_Start;
-
-static void main_loop (void)
-{
-   int screen_start;
-
-   while (1)
-     {
-	update_display ();
-	switch (SLkp_getkey ())
-	  {
-	   case SL_KEY_ERR:
-	   case 'q':
-	   case 'Q':
-	     demolib_exit (0);
-	     break;
-
-	   case SL_KEY_RIGHT:
-	     Screen_Start += 1;
-	     screen_start = Screen_Start;
-	     SLsmg_set_screen_start (NULL, &screen_start);
-	     break;
-
-	   case SL_KEY_LEFT:
-	     Screen_Start -= 1;
-	     if (Screen_Start < 0) Screen_Start = 0;
-	     screen_start = Screen_Start;
-	     SLsmg_set_screen_start (NULL, &screen_start);
-	     break;
-
-	   case SL_KEY_UP:
-	     SLscroll_prev_n (&Line_Window, 1);
-	     Line_Window.top_window_line = Line_Window.current_line;
-	     break;
-
-	   case '\r':
-	   case SL_KEY_DOWN:
-	     SLscroll_next_n (&Line_Window, 1);
-	     Line_Window.top_window_line = Line_Window.current_line;
-	     break;
-
-	   case SL_KEY_NPAGE:
-	   case ' ': case 4:
-	     SLscroll_pagedown (&Line_Window);
-	     break;
-
-	   case SL_KEY_PPAGE:
-	   case 127: case 21:
-	     SLscroll_pageup (&Line_Window);
-	     break;
-
-	   case APP_KEY_BOB:
-	     while (-1 != SLscroll_pageup (&Line_Window))
-	       ;
-	     break;
+main([File]) when is_atom(File) ->
+    main(atom_to_list(File));
+main(File) ->
+    case demolib_init_terminal () of
+	0 ->
+	    case slang:pager_open(File) of
+		0 ->
+		    Rows = slang:getvar(screen_rows),
+		    Cols = slang:getvar(screen_cols),
+		    slang:pager_window(0, 0, Rows - 1, Cols),
+		    main_loop(File, Rows);
+		_ ->
+		    slang:smg_reset_smg (),
+		    slang:reset_tty (),
+		    io:format("Unable to read ~s~n", [File]),
+		    halt()
+	    end;
+	_ ->
+	    io:format("Unable to initialize terminal.~n", []),
+	    halt()
+    end.
 
-	   case APP_KEY_EOB:
-	     while (-1 != SLscroll_pagedown (&Line_Window))
-	       ;
-	     break;
 
-	   default:
-	     SLtt_beep ();
-	  }
-     }
-}
+update_display (File, Rows) ->
+    slang:smg_normal_video (),
+    slang:pager_render (),
+    Info = slang:pager_info(),
+    slang:smg_gotorc (Rows - 1, 0),
+    slang:smg_reverse_video (),
+    slang:smg_printf("~s  ~s", [File, position(Info)]),
+    slang:smg_erase_eol (),
+    slang:smg_normal_video (),
+    slang:smg_refresh ().
+
+
+position(Info) ->
+    Follow = case proplists:get_value(follow, Info) of
+		 true -> "  (following)";
+		 false -> ""
+	     end,
+    case {proplists:get_value(top_line, Info),
+	  proplists:get_value(lines, Info)} of
+	{_, -1} ->
+	    "indexing ..." ++ Follow;
+	{Top, Lines} ->
+	    io_lib:format("line ~w of ~w", [Top + 1, Lines]) ++ Follow
+    end.
 
 
+main_loop (File, Rows) ->
+    update_display (File, Rows),
+    case slang:kp_getkey () of
+	K when K == ?SL_KEY_ERR; K == $q; K == $Q ->
+	    demolib_exit (0);
+	?SL_KEY_RIGHT ->
+	    slang:pager_hscroll(1);
+	?SL_KEY_LEFT ->
+	    slang:pager_hscroll(-1);
+	?SL_KEY_UP ->
+	    slang:pager_scroll(-1);
+	K when K == $\r; K == ?SL_KEY_DOWN ->
+	    slang:pager_scroll(1);
+	K when K == ?SL_KEY_NPAGE; K == $\s; K == 4 ->
+	    slang:pager_page(1);
+	K when K == ?SL_KEY_PPAGE; K == 127; K == 21 ->
+	    slang:pager_page(-1);
+	K when K == ?APP_KEY_BOB; K == $g ->
+	    slang:pager_top();
+	K when K == ?APP_KEY_EOB; K == $G ->
+	    slang:pager_bottom();
+	$F ->
+	    Info = slang:pager_info(),
+	    slang:pager_follow(not proplists:get_value(follow, Info));
+	_ ->
+	    slang:tt_beep ()
+    end,
+    main_loop (File, Rows).
@@ -1090,18 +1090,75 @@
 \done
 
 
+\function{SLang_create_context}
+\synopsis{Create a new interpreter context}
+\usage{SLang_Context_Type *SLang_create_context (void)}
+\description
+   This function creates a context with its own run-time, function
+   call and local variable stacks, its own value of
+   \var{SLang_Error}, its own string table and its own namespaces,
+   including the \var{Global} namespace.  It returns \var{NULL} upon
+   failure.  The context is not used until it is passed to
+   \var{SLang_switch_context}.
+\notes
+   The intrinsics of the default context may be used in every
+   context, but they may not be redefined in the \var{Global}
+   namespace of another one.  Intrinsics added while a context is in
+   use belong to that context.
+
+   All contexts share the data types and the compiler.  Hence contexts
+   used by different threads must not run at the same time; the
+   application must serialize the calls.
+\seealso{SLang_switch_context, SLang_free_context}
+\done
+
+
+\function{SLang_switch_context}
+\synopsis{Run the interpreter in another context}
+\usage{SLang_Context_Type *SLang_switch_context (SLang_Context_Type *c)}
+\description
+   This function makes \var{c} the context in which the interpreter
+   runs, and returns the context that was in use.  If \var{c} is
+   \var{NULL}, the default context, which is the one the interpreter
+   starts in, is used.  Objects left on the stack of a context stay
+   there until that context is used again.
+   
+   Contexts may only be switched at top level, i.e., not from an
+   intrinsic function.  Upon error, \var{NULL} is returned.
+\seealso{SLang_create_context, SLang_free_context}
+\done
+
+
+\function{SLang_free_context}
+\synopsis{Free an interpreter context}
+\usage{void SLang_free_context (SLang_Context_Type *c)}
+\description
+   This function frees a context created by
+   \var{SLang_create_context}, along with any objects left on its
+   stack, and the variables and functions defined in it.  The context
+   in use may not be freed, and contexts may only be freed at top
+   level.
+\seealso{SLang_create_context, SLang_switch_context}
+\done
+
+
 \function{SLang_byte_compile_file}
 \synopsis{Byte-compile a file for faster loading}
-\usage{int SLang_byte_compile_file(char *fn, int reserved)}
+\usage{int SLang_byte_compile_file(char *fn, int method)}
 \description
   The \var{SLang_byte_compile_file} function ``byte-compiles'' the
   file \var{fn} for faster loading by the interpreter.  This produces
   a new file whose filename is equivalent to the one specified by
   \var{fn}, except that a \var{'c'} is appended to the name.  For
   example, if \var{fn} is set to \exmp{init.sl}, then the new file
-  will have the name exmp{init.slc}.  The meaning of the second
-  parameter, \var{reserved}, is reserved for future use.  For now, set
-  it to \var{0}.
+  will have the name exmp{init.slc}.  If \var{method} is \var{0}, the
+  new file is a binary image that is read without tokenizing it again.
+  The image records a hash of the contents of \var{fn}, and if the
+  source has changed when the image is loaded, the source is loaded
+  instead.  A source that still has the length and modification time
+  it had when the image was written is not read again.  An image is only read by the version of the library that
+  wrote it.  If \var{method} is \var{1}, the older text form is
+  written.
   
   The function returns zero upon success, or \exmp{-1} upon error and
   sets SLang_Error accordingly.
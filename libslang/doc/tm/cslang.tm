@@ -198,9 +198,11 @@
   extension, then the path is searched with \exstr{.sl} and
   \exstr{.slc} appended to the filename.  If two such files are found
   (one ending with \exstr{.sl} and the other with \exstr{.slc}), then
-  the more recent of the two will be used.  If no matching file has
-  been found by this process, then the search will cease and an error
-  generated.
+  the more recent of the two will be used.  A \exstr{.slc} file that
+  is a binary image made from a \exstr{.sl} file that has since been
+  edited is not used; the \exstr{.sl} file is loaded in its place.
+  If no matching file has been found by this process, then the search
+  will cease and an error generated.
 
   The search path is a delimiter separated list of directories that
   specify where the interpreter looks for files.  By default, the
@@ -242,6 +244,30 @@
   keyboard and map those key sequences to interpreter functions via
   the \slang keymap interface.
 
+\sect1{Interpreter Contexts}
+  An application that runs several independent scripts, e.g., one per
+  worker thread, may give each of them a context of its own via
+  \cfun{SLang_create_context}.  A context has its own stacks, error
+  state, string table and namespaces, so that the variables and
+  functions that one script defines, what it leaves on the stack, or
+  an error that it causes, do not affect the others:
+#v+
+     SLang_Context_Type *c, *old;
+
+     c = SLang_create_context ();
+     old = SLang_switch_context (c);
+     (void) SLang_load_file ("worker.sl");
+     (void) SLang_switch_context (old);
+     .
+     .
+     SLang_free_context (c);
+#v-
+  The intrinsic functions and variables of the default context are
+  seen by all of them.  The data types and the compiler are shared.
+  Only one context may run at a time, so an application that uses them
+  from several threads must hold a lock around each call into the
+  interpreter.
+
 #%}}}
 
 \sect{Intrinsic Functions} #%{{{
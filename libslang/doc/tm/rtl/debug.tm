@@ -1,3 +1,25 @@
+\function{_bytecode_stats}
+\synopsis{Count which byte-code sequences run}
+\usage{Integer_Type _bytecode_stats (Integer_Type on)}
+\description
+  If \var{on} is non-zero, the interpreter counts how often each pair
+  and triple of byte-codes is executed, until \var{_bytecode_stats} is
+  called again with \var{on} equal to zero.  Functions compiled while
+  the counting is on are not fused into superinstructions, so the
+  counts show the plain byte-code sequences.  The previous setting is
+  returned.
+\example
+#v+
+    () = _bytecode_stats (1);
+    () = evalfile ("workload.sl");
+    () = _write_bytecode_stats ("stats.txt");
+#v-
+\notes
+  Counting slows the interpreter down.  A function that is running
+  when the counting is turned on is only counted from its next call.
+\seealso{_write_bytecode_stats}
+\done
+
 \function{_clear_error}
 \synopsis{Clear an error condition}
 \usage{_clear_error ()}
@@ -52,6 +74,53 @@
 \seealso{_traceback, _slangtrace}
 \done
 
+\function{_profile}
+\synopsis{Turn the profiler on or off}
+\usage{Integer_Type _profile (Integer_Type flags)}
+\description
+  This function sets how \slang functions are profiled.  If bit 0 of
+  \var{flags} is set, every call is counted and timed.  If bit 1 is
+  set, the call stack is looked at every \var{_profile_interval}
+  microseconds of CPU time, which costs much less than timing every
+  call.  Both bits may be set, and \var{_profile(0)} turns profiling
+  off.  The figures add up until \var{_profile_reset} is called.  The
+  previous flags are returned, or \var{-1} upon failure.
+\example
+#v+
+    () = _profile (2);
+    () = evalfile ("workload.sl");
+    () = _profile (0);
+    () = _write_profile_stacks ("workload.stacks");
+#v-
+\notes
+  Sampling is only supported on Unix systems, where it uses the
+  \var{SIGPROF} signal and the \var{ITIMER_PROF} timer.  Calls that
+  are running when the profiler is turned on are not timed.  A call in
+  tail position takes the place of the function that makes it, so its
+  time is not part of that function's inclusive time.
+\seealso{_profile_interval, _profile_reset, _write_profile, _write_profile_stacks}
+\done
+
+\variable{_profile_interval}
+\synopsis{The time between profiler samples}
+\usage{Integer_Type _profile_interval}
+\description
+  The number of microseconds of CPU time between two samples of the
+  call stack, 1000 by default.  A new value takes effect the next time
+  sampling is turned on by \var{_profile}.
+\seealso{_profile}
+\done
+
+\function{_profile_reset}
+\synopsis{Forget the figures taken by the profiler}
+\usage{_profile_reset ()}
+\description
+  This function throws away all the call counts, times and samples
+  that the profiler has taken so far.  It does not turn the profiler
+  on or off.
+\seealso{_profile}
+\done
+
 \variable{_slangtrace}
 \synopsis{Turn function tracing on or off.}
 \usage{Integer_Type _slangtrace}
@@ -96,3 +165,47 @@
 \seealso{_slangtrace, error}
 \done
 
+
+\function{_write_bytecode_stats}
+\synopsis{Write out byte-code statistics}
+\usage{Integer_Type _write_bytecode_stats (String_Type file)}
+\description
+  This function writes the counts gathered since \var{_bytecode_stats}
+  was first turned on to \var{file}, most frequent sequence first.
+  Each line holds a count followed by the names of the byte-codes.
+  Sequences that cannot become a superinstruction are written as
+  comments starting with \exmp{#}.  The \var{mksuper} program in the
+  \var{util} directory of the source turns the file into the
+  superinstructions that the library is built with.  It returns
+  \var{0} upon success, or \var{-1} upon failure.
+\seealso{_bytecode_stats}
+\done
+
+\function{_write_profile}
+\synopsis{Write out the profile of each function}
+\usage{Integer_Type _write_profile (String_Type file)}
+\description
+  This function writes a line per profiled function to \var{file},
+  those that took the most time first.  The columns are the number of
+  calls, the inclusive and exclusive time in milliseconds, the number
+  of samples taken in the function or in the functions it called, the
+  number of samples taken in the function itself, and the name of the
+  function.  Time spent in recursive calls is only counted once in the
+  inclusive figures.  It returns \var{0} upon success, or \var{-1} upon
+  failure.
+\seealso{_profile, _write_profile_stacks}
+\done
+
+\function{_write_profile_stacks}
+\synopsis{Write out the profile as collapsed call stacks}
+\usage{Integer_Type _write_profile_stacks (String_Type file)}
+\description
+  This function writes a line per call path to \var{file}, made of
+  the names of the functions from the outermost one, separated by
+  semicolons, followed by the number of samples taken in the last of
+  them.  If no samples were taken, its exclusive time in microseconds
+  is written instead.  This is the input that flame graph programs
+  such as \var{flamegraph.pl} expect.  It returns \var{0} upon
+  success, or \var{-1} upon failure.
+\seealso{_profile, _write_profile}
+\done
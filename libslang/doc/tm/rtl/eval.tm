@@ -25,10 +25,15 @@
   to the output file name.  For example, \var{file} is
   \exmp{"site.sl"}, then the function produces a new file named
   \exmp{site.slc}.
+
+  If \var{method} is \exmp{0}, the new file is a binary image that
+  loads without being tokenized again.  It records a hash of the
+  contents of \var{file}, and if \var{file} has changed when the image
+  is loaded, \var{file} is loaded instead.  If \var{method} is
+  \exmp{1}, the older text form is written.
 \notes
-  The \var{method} parameter is not used in the current
-  implementation.  Its use is reserved for the future.  For now, set
-  it to \exmp{0}.
+  A binary image may only be loaded by the version of \slang that
+  wrote it.
 \seealso{evalfile}
 \done
 
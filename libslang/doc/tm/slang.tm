@@ -2674,6 +2674,17 @@
        [1:-3]          ==> []
 #v-
 
+   An integer range array does not store its elements; they are
+   computed as they are needed.  Hence a loop such as
+#v+
+     foreach ([0:n-1]) { ... }
+#v-
+   does not create an array of \var{n} integers.  Adding an integer to
+   such an array, subtracting one from it, multiplying it by one,
+   changing its sign, or indexing it by another range array all
+   produce another range array.  Other operations produce an ordinary
+   array but do not need to expand the range array first.
+
 \sect1{Creating arrays via the dereference operator}
 
    Another way to create an array is apply the dereference operator
@@ -201,6 +201,30 @@
 #define _SLANG_BC_GVARIABLE_COMBINED	0xA1
 #define _SLANG_BC_LITERAL_COMBINED	0xA2
 
+/* Superinstructions: each one runs a sequence of the above in one go.
+ * The sequences come from slsuper.inc, which util/mksuper.c writes from
+ * byte-code statistics.  Only the first byte-code of a sequence is
+ * replaced; the others stay where they are.
+ */
+#define _SLANG_BC_SUPER_0	0xB0
+#define _SLANG_BC_SUPER_1	0xB1
+#define _SLANG_BC_SUPER_2	0xB2
+#define _SLANG_BC_SUPER_3	0xB3
+#define _SLANG_BC_SUPER_4	0xB4
+#define _SLANG_BC_SUPER_5	0xB5
+#define _SLANG_BC_SUPER_6	0xB6
+#define _SLANG_BC_SUPER_7	0xB7
+#define _SLANG_BC_SUPER_8	0xB8
+#define _SLANG_BC_SUPER_9	0xB9
+#define _SLANG_BC_SUPER_10	0xBA
+#define _SLANG_BC_SUPER_11	0xBB
+#define _SLANG_BC_SUPER_12	0xBC
+#define _SLANG_BC_SUPER_13	0xBD
+#define _SLANG_BC_SUPER_14	0xBE
+#define _SLANG_BC_SUPER_15	0xBF
+#define _SLANG_MAX_SUPER_BYTECODES	16
+#define _SLANG_MAX_SUPER_SEQUENCE	3
+
 /* Byte-Code Sub Types (_BCST_) */
 
 /* These are sub_types of _SLANG_BC_BLOCK */
@@ -228,6 +252,20 @@
 #define _SLANG_BCST_SWITCH	0x25
 #define _SLANG_BCST_NOTELSE	0x26
 
+/* These are sub_types of _SLANG_BC_BINARY and the combined binary
+ * byte-codes: the operand types the operation has been quickened for.
+ * A sub_type of 0 means that it has not been run yet.
+ */
+#define _SLANG_BCST_BINARY_II	0x01   /* int and int */
+#define _SLANG_BCST_BINARY_DD	0x02   /* double and double */
+#define _SLANG_BCST_BINARY_ID	0x03   /* int and double, either way round */
+#define _SLANG_BCST_BINARY_ANY	0x04   /* anything else */
+
+/* The sub_type of a _SLANG_BC_FUNCTION or _SLANG_BC_PFUNCTION in tail
+ * position.  The called function takes over the frame of the caller.
+ */
+#define _SLANG_BCST_TAIL_CALL	0x01
+
 /* assignment (_SLANG_BC_SET_*_LVALUE) subtypes.  The order MUST correspond
  * to the assignment token order with the ASSIGN_TOKEN as the first!
  */
@@ -306,6 +344,8 @@ extern int _SLstruct_init (void);
 /* extern int _SLstruct_get_field (char *); */
 extern int _SLstruct_define_struct (void);
 extern int _SLstruct_define_typedef (void);
+extern int _SLstruct_sget_cached (SLang_Class_Type *, unsigned char, char *, unsigned short *);
+extern int _SLstruct_sput_cached (SLang_Class_Type *, unsigned char, char *, unsigned short *);
 
 struct _SLang_Ref_Type
 {
@@ -324,6 +364,12 @@ extern int _SLang_push_ref (int, VOID_STAR);
 
 extern int _SL_increment_frame_pointer (void);
 extern int _SL_decrement_frame_pointer (void);
+extern char **_SLang_function_name_stack (unsigned int *);
+
+/* slprof.c */
+extern int _SLang_Profile;
+extern unsigned long _SLprof_enter (char *);
+extern void _SLprof_exit (unsigned long);
 
 extern int SLang_pop(SLang_Object_Type *);
 extern void SLang_free_object (SLang_Object_Type *);
@@ -356,6 +402,11 @@ extern int _SLstring_list_push (_SLString_List_Type *);
 
 /* This function assumes that s is an slstring. */
 extern char *_SLstring_dup_slstring (char *);
+
+typedef struct _SLstring_Table_Type _SLstring_Table_Type;
+extern _SLstring_Table_Type *_SLstring_new_table (void);
+extern _SLstring_Table_Type *_SLstring_switch_table (_SLstring_Table_Type *);
+extern void _SLstring_free_table (_SLstring_Table_Type *);
 extern int _SLang_dup_and_push_slstring (char *);
 
 
@@ -396,6 +447,7 @@ extern char *_SLang_cur_namespace_intrinsic (void);
 extern SLang_Array_Type *_SLang_apropos (char *, char *, unsigned int);
 extern void _SLang_implements_intrinsic (char *);
 extern SLang_Array_Type *_SLns_list_namespaces (void);
+extern SLang_NameSpace_Type *_SLns_switch_namespace_list (SLang_NameSpace_Type *);
 
 extern int _SLang_Trace;
 extern int _SLstack_depth(void);
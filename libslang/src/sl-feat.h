@@ -15,6 +15,12 @@
 
 #define _SLANG_USE_INLINE_CODE		1
 
+/* Dispatch byte-codes through a table of label addresses instead of a
+ * switch when the compiler supports it (gcc and clang).  Set this to 0
+ * to always use the switch.
+ */
+#define _SLANG_USE_COMPUTED_GOTO	1
+
 /* This is experimental.  It adds extra information for tracking down
  * errors.
  */
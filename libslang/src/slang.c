@@ -17,6 +17,15 @@
 #include "_slang.h"
 
 #define USE_COMBINED_BYTECODES	1
+/* The superinstructions are in slsuper.inc, which the Makefile writes
+ * with util/mksuper and defines HAVE_SLSUPER_INC for.  Builds that do
+ * not generate it go without them.
+ */
+#if defined(HAVE_SLSUPER_INC) && USE_COMBINED_BYTECODES && _SLANG_OPTIMIZE_FOR_SPEED && SLANG_HAS_FLOAT
+# define USE_SUPER_BYTECODES	1
+#else
+# define USE_SUPER_BYTECODES	0
+#endif
 
 struct _SLBlock_Type;
 
@@ -73,6 +82,11 @@ typedef struct _SLBlock_Type
 {
    unsigned char bc_main_type;
    unsigned char bc_sub_type;
+   /* Where a FIELD or SET_STRUCT_LVALUE last found its field, or how
+    * often a binary operation has been quickened again.  This uses what
+    * would otherwise be padding.
+    */
+   unsigned short bc_cache;
    union
      {
 	struct _SLBlock_Type *blk;
@@ -133,6 +147,10 @@ static SLang_Object_Type *Frame_Pointer;
 static int Next_Function_Num_Args;
 static unsigned int Frame_Pointer_Depth;
 static unsigned int *Frame_Pointer_Stack;
+/* The name of the function running at each recursion depth, or NULL.
+ * The sampling profiler reads these from its signal handler.
+ */
+static char **Function_Name_Stack;
 
 static int Lang_Break_Condition = 0;
 /* true if any one below is true.  This keeps us from testing 3 variables.
@@ -146,9 +164,40 @@ static SLang_Object_Type *_SLRun_Stack;
 static SLang_Object_Type *_SLStack_Pointer;
 static SLang_Object_Type *_SLStack_Pointer_Max;
 
-/* Might want to increase this. */
-static SLang_Object_Type Local_Variable_Stack[SLANG_MAX_LOCAL_STACK];
+/* The stacks start small and grow as needed, up to these limits. */
+unsigned int SLang_Max_Stack_Len = SLANG_MAX_STACK_LEN;
+unsigned int SLang_Max_Recursion_Depth = SLANG_MAX_RECURSIVE_DEPTH;
+unsigned int SLang_Max_Local_Stack = SLANG_MAX_LOCAL_STACK;
+
+static unsigned int Run_Stack_Len;
+static unsigned int Recursion_Stack_Len;      /* Num_Args_Stack, Function_Name_Stack */
+static unsigned int Frame_Pointer_Stack_Len;
+static int Stacks_Have_Grown;
+
+/* The local variables of a function are in one piece, but they need not
+ * be in the same chunk of memory as those of its caller: a function whose
+ * locals do not fit in the current chunk gets them from a new one.
+ * Nothing moves, so references to local variables stay good.  Element 0
+ * of a chunk is not used since a frame points at its last local.
+ */
+typedef struct
+{
+   SLang_Object_Type *objs;
+   unsigned int len;
+   SLang_Object_Type *frame;	       /* Local_Variable_Frame when the next chunk was started */
+}
+Local_Stack_Chunk_Type;
+
+#define MAX_LOCAL_STACK_CHUNKS	32
+static SLang_Object_Type Local_Variable_Stack[SLANG_INITIAL_LOCAL_STACK];
+static Local_Stack_Chunk_Type Local_Stack_Chunks[MAX_LOCAL_STACK_CHUNKS] =
+{
+   {Local_Variable_Stack, SLANG_INITIAL_LOCAL_STACK, NULL}
+};
+static unsigned int Local_Stack_Chunk;
+static unsigned int Local_Stack_Size = SLANG_INITIAL_LOCAL_STACK;
 static SLang_Object_Type *Local_Variable_Frame = Local_Variable_Stack;
+static SLang_Object_Type *Local_Variable_Max = Local_Variable_Stack + SLANG_INITIAL_LOCAL_STACK;
 
 static void free_function_header (_SLBlock_Header_Type *);
 
@@ -184,6 +233,257 @@ static void call_dump_routine (char *fmt, ...)
 static void do_traceback (char *, unsigned int, char *);
 static int init_interpreter (void);
 
+/*{{{ growing and shrinking the stacks */
+
+/* Make room for n more objects on the run-time stack.  The push
+ * functions only compare against _SLStack_Pointer_Max and come here
+ * when that fails.
+ */
+static int grow_run_stack (unsigned int n)
+{
+   SLang_Object_Type *s;
+   unsigned int used, len;
+
+   used = (unsigned int) (_SLStack_Pointer - _SLRun_Stack);
+   if (used + n > SLang_Max_Stack_Len)
+     {
+	if (SLang_Error == 0) SLang_Error = SL_STACK_OVERFLOW;
+	return -1;
+     }
+
+   len = Run_Stack_Len;
+   while (len < used + n)
+     len *= 2;
+   if (len > SLang_Max_Stack_Len)
+     len = SLang_Max_Stack_Len;
+
+   s = (SLang_Object_Type *) SLrealloc ((char *) _SLRun_Stack, len * sizeof (SLang_Object_Type));
+   if (s == NULL)
+     return -1;
+
+   Frame_Pointer = s + (Frame_Pointer - _SLRun_Stack);
+   _SLStack_Pointer = s + used;
+   _SLStack_Pointer_Max = s + len;
+   _SLRun_Stack = s;
+   Run_Stack_Len = len;
+   Stacks_Have_Grown = 1;
+   return 0;
+}
+
+static int grow_recursion_stacks (void)
+{
+   unsigned int len;
+   int *num_args;
+   char **names, **old_names;
+
+   if (Recursion_Stack_Len >= SLang_Max_Recursion_Depth)
+     {
+	SLang_verror (SL_STACK_OVERFLOW, "Num Args Stack Overflow");
+	return -1;
+     }
+   len = 2 * Recursion_Stack_Len;
+   if (len > SLang_Max_Recursion_Depth)
+     len = SLang_Max_Recursion_Depth;
+
+   num_args = (int *) SLrealloc ((char *) Num_Args_Stack, len * sizeof (int));
+   if (num_args == NULL)
+     return -1;
+   Num_Args_Stack = num_args;
+
+   /* The profiler's signal handler may look at this one at any time, so
+    * it must never point at freed memory: the old array is freed only
+    * after the new one has taken its place.
+    */
+   names = (char **) SLmalloc (len * sizeof (char *));
+   if (names == NULL)
+     return -1;
+   memcpy ((char *) names, (char *) Function_Name_Stack, Recursion_Stack_Len * sizeof (char *));
+   old_names = Function_Name_Stack;
+   Function_Name_Stack = names;
+   SLfree ((char *) old_names);
+
+   Recursion_Stack_Len = len;
+   Stacks_Have_Grown = 1;
+   return 0;
+}
+
+static int grow_frame_pointer_stack (void)
+{
+   unsigned int len, *s;
+
+   if (Frame_Pointer_Stack_Len >= SLang_Max_Recursion_Depth)
+     {
+	SLang_verror (SL_STACK_OVERFLOW, "Frame Stack Overflow");
+	return -1;
+     }
+   len = 2 * Frame_Pointer_Stack_Len;
+   if (len > SLang_Max_Recursion_Depth)
+     len = SLang_Max_Recursion_Depth;
+
+   s = (unsigned int *) SLrealloc ((char *) Frame_Pointer_Stack, len * sizeof (unsigned int));
+   if (s == NULL)
+     return -1;
+   Frame_Pointer_Stack = s;
+   Frame_Pointer_Stack_Len = len;
+   Stacks_Have_Grown = 1;
+   return 0;
+}
+
+/* Move on to a new chunk for the locals of a function, since the
+ * current one has no room for n more.  The new frame is returned, or
+ * NULL if the limit has been reached.
+ */
+static SLang_Object_Type *grow_local_stack (unsigned int n)
+{
+   Local_Stack_Chunk_Type *c;
+   unsigned int len;
+
+   if (Local_Stack_Chunk + 1 == MAX_LOCAL_STACK_CHUNKS)
+     return NULL;
+
+   c = Local_Stack_Chunks + (Local_Stack_Chunk + 1);
+   if ((c->objs != NULL) && (c->len <= n))
+     {
+	/* A spare chunk that is too small */
+	Local_Stack_Size -= c->len;
+	SLfree ((char *) c->objs);
+	c->objs = NULL;
+     }
+   if (c->objs == NULL)
+     {
+	len = 2 * Local_Stack_Chunks[Local_Stack_Chunk].len;
+	if (len <= n)
+	  len = 2 * (n + 1);
+	if (Local_Stack_Size + len > SLang_Max_Local_Stack)
+	  {
+	     if (Local_Stack_Size + n + 1 > SLang_Max_Local_Stack)
+	       return NULL;
+	     len = SLang_Max_Local_Stack - Local_Stack_Size;
+	  }
+	if (NULL == (c->objs = (SLang_Object_Type *) SLmalloc (len * sizeof (SLang_Object_Type))))
+	  return NULL;
+	c->len = len;
+	Local_Stack_Size += len;
+	Stacks_Have_Grown = 1;
+     }
+
+   Local_Stack_Chunks[Local_Stack_Chunk].frame = Local_Variable_Frame;
+   Local_Stack_Chunk++;
+   Local_Variable_Max = c->objs + c->len;
+   return c->objs;
+}
+
+/* Back to the previous chunk when the function that started this one
+ * returns.  Its frame is where it was before.
+ */
+static void pop_local_stack_chunk (void)
+{
+   Local_Stack_Chunk_Type *c;
+
+   Local_Stack_Chunk--;
+   c = Local_Stack_Chunks + Local_Stack_Chunk;
+   Local_Variable_Max = c->objs + c->len;
+   Local_Variable_Frame = c->frame;
+}
+
+/* Whether obj is a local variable of a function that has not returned */
+static int local_variable_in_scope (SLang_Object_Type *obj)
+{
+   unsigned int k;
+
+   k = Local_Stack_Chunk;
+   if ((obj > Local_Stack_Chunks[k].objs) && (obj <= Local_Variable_Frame))
+     return 1;
+   while (k-- > 0)
+     {
+	if ((obj > Local_Stack_Chunks[k].objs) && (obj <= Local_Stack_Chunks[k].frame))
+	  return 1;
+     }
+   return 0;
+}
+
+/* Give back what a spike in stack use took.  This is done when the
+ * outermost function call returns, when nothing but the stack pointers
+ * points into the stacks.
+ */
+static void shrink_stacks (void)
+{
+   unsigned int used, len, k;
+
+   Stacks_Have_Grown = 0;
+
+   used = (unsigned int) (_SLStack_Pointer - _SLRun_Stack);
+   len = Run_Stack_Len;
+   while ((len > SLANG_INITIAL_STACK_LEN) && (4 * used < len))
+     len /= 2;
+   if (len < SLANG_INITIAL_STACK_LEN)
+     len = SLANG_INITIAL_STACK_LEN;
+   if (len < Run_Stack_Len)
+     {
+	SLang_Object_Type *s;
+
+	s = (SLang_Object_Type *) SLrealloc ((char *) _SLRun_Stack, len * sizeof (SLang_Object_Type));
+	if (s != NULL)
+	  {
+	     Frame_Pointer = s + (Frame_Pointer - _SLRun_Stack);
+	     _SLStack_Pointer = s + used;
+	     _SLStack_Pointer_Max = s + len;
+	     _SLRun_Stack = s;
+	     Run_Stack_Len = len;
+	  }
+	else Stacks_Have_Grown = 1;
+     }
+
+   if (Recursion_Stack_Len > SLANG_INITIAL_RECURSIVE_DEPTH)
+     {
+	char **names, **old_names;
+	int *num_args;
+
+	names = (char **) SLmalloc (SLANG_INITIAL_RECURSIVE_DEPTH * sizeof (char *));
+	num_args = (int *) SLrealloc ((char *) Num_Args_Stack, SLANG_INITIAL_RECURSIVE_DEPTH * sizeof (int));
+	if (num_args != NULL)
+	  Num_Args_Stack = num_args;
+	if ((names != NULL) && (num_args != NULL))
+	  {
+	     /* As in grow_recursion_stacks */
+	     old_names = Function_Name_Stack;
+	     Function_Name_Stack = names;
+	     SLfree ((char *) old_names);
+	     Recursion_Stack_Len = SLANG_INITIAL_RECURSIVE_DEPTH;
+	  }
+	else
+	  {
+	     SLfree ((char *) names);
+	     Stacks_Have_Grown = 1;
+	  }
+     }
+
+   if ((Frame_Pointer_Depth <= SLANG_INITIAL_RECURSIVE_DEPTH)
+       && (Frame_Pointer_Stack_Len > SLANG_INITIAL_RECURSIVE_DEPTH))
+     {
+	unsigned int *s;
+
+	s = (unsigned int *) SLrealloc ((char *) Frame_Pointer_Stack, SLANG_INITIAL_RECURSIVE_DEPTH * sizeof (unsigned int));
+	if (s != NULL)
+	  {
+	     Frame_Pointer_Stack = s;
+	     Frame_Pointer_Stack_Len = SLANG_INITIAL_RECURSIVE_DEPTH;
+	  }
+	else Stacks_Have_Grown = 1;
+     }
+
+   for (k = Local_Stack_Chunk + 1; k < MAX_LOCAL_STACK_CHUNKS; k++)
+     {
+	if (Local_Stack_Chunks[k].objs == NULL)
+	  break;
+	Local_Stack_Size -= Local_Stack_Chunks[k].len;
+	SLfree ((char *) Local_Stack_Chunks[k].objs);
+	Local_Stack_Chunks[k].objs = NULL;
+     }
+}
+
+/*}}}*/
+
 /*{{{ push/pop/etc stack manipulation functions */
 
 /* This routine is assumed to work even in the presence of a SLang_Error. */
@@ -314,8 +614,9 @@ int SLang_push (SLang_Object_Type *x)
    /* flag it now */
    if (y >= _SLStack_Pointer_Max)
      {
-	if (!SLang_Error) SLang_Error = SL_STACK_OVERFLOW;
-	return -1;
+	if (-1 == grow_run_stack (1))
+	  return -1;
+	y = _SLStack_Pointer;
      }
 
    *y = *x;
@@ -331,8 +632,9 @@ int SLclass_push_ptr_obj (unsigned char type, VOID_STAR pval)
 
    if (y >= _SLStack_Pointer_Max)
      {
-	if (!SLang_Error) SLang_Error = SL_STACK_OVERFLOW;
-	return -1;
+	if (-1 == grow_run_stack (1))
+	  return -1;
+	y = _SLStack_Pointer;
      }
 
    y->data_type = type;
@@ -350,8 +652,9 @@ int SLclass_push_int_obj (unsigned char type, int x)
 
    if (y >= _SLStack_Pointer_Max)
      {
-	if (!SLang_Error) SLang_Error = SL_STACK_OVERFLOW;
-	return -1;
+	if (-1 == grow_run_stack (1))
+	  return -1;
+	y = _SLStack_Pointer;
      }
 
    y->data_type = type;
@@ -506,9 +809,10 @@ int SLdup_n (int n)
      }
    if (top + n > _SLStack_Pointer_Max)
      {
-	if (SLang_Error == 0)
-	  SLang_Error = SL_STACK_OVERFLOW;
-	return -1;
+	/* Grow now, since bot must not move in the loop below */
+	if (-1 == grow_run_stack ((unsigned int) n))
+	  return -1;
+	top = _SLStack_Pointer;
      }
    bot = top - n;
 
@@ -539,12 +843,11 @@ int SLdup_n (int n)
 _INLINE_
 int _SL_increment_frame_pointer (void)
 {
-   if (Recursion_Depth >= SLANG_MAX_RECURSIVE_DEPTH)
-     {
-	SLang_verror (SL_STACK_OVERFLOW, "Num Args Stack Overflow");
-	return -1;
-     }
+   if ((Recursion_Depth >= Recursion_Stack_Len)
+       && (-1 == grow_recursion_stacks ()))
+     return -1;
    Num_Args_Stack [Recursion_Depth] = SLang_Num_Function_Args;
+   Function_Name_Stack [Recursion_Depth] = NULL;
 
    SLang_Num_Function_Args = Next_Function_Num_Args;
    Next_Function_Num_Args = 0;
@@ -562,26 +865,34 @@ int _SL_decrement_frame_pointer (void)
      }
 
    Recursion_Depth--;
-   if (Recursion_Depth < SLANG_MAX_RECURSIVE_DEPTH)
-     SLang_Num_Function_Args = Num_Args_Stack [Recursion_Depth];
+   SLang_Num_Function_Args = Num_Args_Stack [Recursion_Depth];
 
+   if (Stacks_Have_Grown && (Recursion_Depth == 0))
+     shrink_stacks ();
    return 0;
 }
 
+/* The names of the functions on the call stack, the outermost first.
+ * Entries may be NULL.  This is safe to call from a signal handler.
+ */
+char **_SLang_function_name_stack (unsigned int *depth)
+{
+   *depth = Recursion_Depth;
+   return Function_Name_Stack;
+}
+
 _INLINE_
 int SLang_start_arg_list (void)
 {
-   if (Frame_Pointer_Depth < SLANG_MAX_RECURSIVE_DEPTH)
-     {
-	Frame_Pointer_Stack [Frame_Pointer_Depth] = (unsigned int) (Frame_Pointer - _SLRun_Stack);
-	Frame_Pointer = _SLStack_Pointer;
-	Frame_Pointer_Depth++;
-	Next_Function_Num_Args = 0;
-	return 0;
-     }
+   if ((Frame_Pointer_Depth >= Frame_Pointer_Stack_Len)
+       && (-1 == grow_frame_pointer_stack ()))
+     return -1;
 
-   SLang_verror (SL_STACK_OVERFLOW, "Frame Stack Overflow");
-   return -1;
+   Frame_Pointer_Stack [Frame_Pointer_Depth] = (unsigned int) (Frame_Pointer - _SLRun_Stack);
+   Frame_Pointer = _SLStack_Pointer;
+   Frame_Pointer_Depth++;
+   Next_Function_Num_Args = 0;
+   return 0;
 }
 
 _INLINE_
@@ -593,11 +904,8 @@ int SLang_end_arg_list (void)
 	return -1;
      }
    Frame_Pointer_Depth--;
-   if (Frame_Pointer_Depth < SLANG_MAX_RECURSIVE_DEPTH)
-     {
-	Next_Function_Num_Args = (int) (_SLStack_Pointer - Frame_Pointer);
-	Frame_Pointer = _SLRun_Stack + Frame_Pointer_Stack [Frame_Pointer_Depth];
-     }
+   Next_Function_Num_Args = (int) (_SLStack_Pointer - Frame_Pointer);
+   Frame_Pointer = _SLRun_Stack + Frame_Pointer_Stack [Frame_Pointer_Depth];
    return 0;
 }
 
@@ -788,6 +1096,195 @@ static void do_binary_b_inc_ref (int op, SLang_Object_Type *bp)
      SLang_free_object (&a);
 }
 
+#if _SLANG_OPTIMIZE_FOR_SPEED
+/*{{{ quickened binary operations */
+
+/* The first time a binary byte-code runs, its sub_type is set to the
+ * types of its operands if they are int or double.  From then on the
+ * common operations on those types are done right on the objects,
+ * without going through do_binary_ab and the class of the operands.
+ * If other types show up, the byte-code is quickened again for them,
+ * but only a few times: after that it sticks to the generic way.  The
+ * number of times is kept in bc_cache.
+ */
+#define MAX_BINARY_REQUICKENS	4
+
+static unsigned char binary_quick_type (unsigned char a_type, unsigned char b_type)
+{
+   if (a_type == SLANG_INT_TYPE)
+     {
+	if (b_type == SLANG_INT_TYPE)
+	  return _SLANG_BCST_BINARY_II;
+#if SLANG_HAS_FLOAT
+	if (b_type == SLANG_DOUBLE_TYPE)
+	  return _SLANG_BCST_BINARY_ID;
+#endif
+     }
+#if SLANG_HAS_FLOAT
+   else if (a_type == SLANG_DOUBLE_TYPE)
+     {
+	if (b_type == SLANG_DOUBLE_TYPE)
+	  return _SLANG_BCST_BINARY_DD;
+	if (b_type == SLANG_INT_TYPE)
+	  return _SLANG_BCST_BINARY_ID;
+     }
+#endif
+   return _SLANG_BCST_BINARY_ANY;
+}
+
+static void quicken_binary (SLBlock_Type *bc, unsigned char a_type, unsigned char b_type)
+{
+   unsigned char t;
+
+   if (bc->bc_sub_type == _SLANG_BCST_BINARY_ANY)
+     return;
+
+   t = binary_quick_type (a_type, b_type);
+   if (t == bc->bc_sub_type)
+     return;
+
+   if ((bc->bc_sub_type != 0)
+       && (++bc->bc_cache >= MAX_BINARY_REQUICKENS))
+     t = _SLANG_BCST_BINARY_ANY;
+
+   bc->bc_sub_type = t;
+}
+
+/* The operations done here give the same results as the ones in
+ * slarith.c.  The others, such as division which may fail, are left to
+ * the generic way.
+ */
+#define QUICK_BINARY_OP(x, y, type, val) \
+   switch (bc->b.i_blk) \
+     { \
+      case SLANG_PLUS: c->v.val = (x) + (y); c->data_type = type; return 1; \
+      case SLANG_MINUS: c->v.val = (x) - (y); c->data_type = type; return 1; \
+      case SLANG_TIMES: c->v.val = (x) * (y); c->data_type = type; return 1; \
+      case SLANG_EQ: c->v.char_val = (char) ((x) == (y)); break; \
+      case SLANG_NE: c->v.char_val = (char) ((x) != (y)); break; \
+      case SLANG_GT: c->v.char_val = (char) ((x) > (y)); break; \
+      case SLANG_GE: c->v.char_val = (char) ((x) >= (y)); break; \
+      case SLANG_LT: c->v.char_val = (char) ((x) < (y)); break; \
+      case SLANG_LE: c->v.char_val = (char) ((x) <= (y)); break; \
+      default: return 0; \
+     } \
+   c->data_type = SLANG_CHAR_TYPE; \
+   return 1
+
+/* Do the operation of bc on a and b if they have the types it was
+ * quickened for, with the result in c, which may be a.  Returns 0 if it
+ * did not.
+ */
+_INLINE_
+static int quick_binary_op (SLBlock_Type *bc, SLang_Object_Type *a,
+			    SLang_Object_Type *b, SLang_Object_Type *c)
+{
+   switch (bc->bc_sub_type)
+     {
+      case _SLANG_BCST_BINARY_II:
+	if ((a->data_type == SLANG_INT_TYPE) && (b->data_type == SLANG_INT_TYPE))
+	  {
+	     int x = a->v.int_val;
+	     int y = b->v.int_val;
+	     QUICK_BINARY_OP(x, y, SLANG_INT_TYPE, int_val);
+	  }
+	break;
+
+#if SLANG_HAS_FLOAT
+      case _SLANG_BCST_BINARY_DD:
+	if ((a->data_type == SLANG_DOUBLE_TYPE) && (b->data_type == SLANG_DOUBLE_TYPE))
+	  {
+	     double x = a->v.double_val;
+	     double y = b->v.double_val;
+	     QUICK_BINARY_OP(x, y, SLANG_DOUBLE_TYPE, double_val);
+	  }
+	break;
+
+      case _SLANG_BCST_BINARY_ID:
+	  {
+	     double x, y;
+
+	     if (a->data_type == SLANG_INT_TYPE)
+	       {
+		  if (b->data_type != SLANG_DOUBLE_TYPE)
+		    break;
+		  x = (double) a->v.int_val;
+		  y = b->v.double_val;
+	       }
+	     else if ((a->data_type == SLANG_DOUBLE_TYPE)
+		      && (b->data_type == SLANG_INT_TYPE))
+	       {
+		  x = a->v.double_val;
+		  y = (double) b->v.int_val;
+	       }
+	     else break;
+	     QUICK_BINARY_OP(x, y, SLANG_DOUBLE_TYPE, double_val);
+	  }
+#endif
+     }
+   return 0;
+}
+
+/* _SLANG_BC_BINARY: both operands are on the stack */
+_INLINE_
+static void do_binary_quick (SLBlock_Type *bc)
+{
+   SLang_Object_Type *top = _SLStack_Pointer;
+
+   if (top - _SLRun_Stack >= 2)
+     {
+	if (quick_binary_op (bc, top - 2, top - 1, top - 2))
+	  {
+	     _SLStack_Pointer = top - 1;
+	     return;
+	  }
+	quicken_binary (bc, (top - 2)->data_type, (top - 1)->data_type);
+     }
+   do_binary (bc->b.i_blk);
+}
+
+/* The combined byte-codes with both operands in variables or literals */
+_INLINE_
+static void do_binary_ab_quick (SLBlock_Type *bc, SLang_Object_Type *a, SLang_Object_Type *b)
+{
+   if (_SLStack_Pointer < _SLStack_Pointer_Max)
+     {
+	if (quick_binary_op (bc, a, b, _SLStack_Pointer))
+	  {
+	     _SLStack_Pointer++;
+	     return;
+	  }
+     }
+   quicken_binary (bc, a->data_type, b->data_type);
+   (void) do_binary_ab_inc_ref (bc->b.i_blk, a, b);
+}
+
+/* The combined byte-codes with the first operand on the stack */
+_INLINE_
+static void do_binary_b_quick (SLBlock_Type *bc, SLang_Object_Type *b, int inc_ref)
+{
+   SLang_Object_Type *top = _SLStack_Pointer;
+
+   if (top > _SLRun_Stack)
+     {
+	if (quick_binary_op (bc, top - 1, b, top - 1))
+	  return;
+	quicken_binary (bc, (top - 1)->data_type, b->data_type);
+     }
+   if (inc_ref)
+     do_binary_b_inc_ref (bc->b.i_blk, b);
+   else
+     do_binary_b (bc->b.i_blk, b);
+}
+
+/*}}}*/
+#else
+# define do_binary_quick(bc) do_binary ((bc)->b.i_blk)
+# define do_binary_ab_quick(bc,a,b) do_binary_ab_inc_ref ((bc)->b.i_blk, (a), (b))
+# define do_binary_b_quick(bc,b,inc_ref) \
+   ((inc_ref) ? do_binary_b_inc_ref ((bc)->b.i_blk, (b)) : do_binary_b ((bc)->b.i_blk, (b)))
+#endif				       /* _SLANG_OPTIMIZE_FOR_SPEED */
+
 static int do_unary_op (int op, SLang_Object_Type *obj, int unary_type)
 {
    int (*f) (int, unsigned char, VOID_STAR, unsigned int, VOID_STAR);
@@ -984,6 +1481,7 @@ set_struct_lvalue (SLBlock_Type *bc_blk)
    int type;
    SLang_Class_Type *cl;
    char *name;
+   unsigned short *cache;
    int op;
 
    if (-1 == (type = SLang_peek_at_stack ()))
@@ -1001,6 +1499,7 @@ set_struct_lvalue (SLBlock_Type *bc_blk)
      }
    name = bc_blk->b.s_blk;
    op = bc_blk->bc_sub_type;
+   cache = &bc_blk->bc_cache;
 
    if (op != _SLANG_BCST_ASSIGN)
      {
@@ -1014,7 +1513,7 @@ set_struct_lvalue (SLBlock_Type *bc_blk)
 	  return -1;
 
 	if ((-1 == _SLpush_slang_obj (&obj_A))
-	    || (-1 == cl->cl_sget ((unsigned char) type, name))
+	    || (-1 == _SLstruct_sget_cached (cl, (unsigned char) type, name, cache))
 	    || (-1 == SLang_pop (&obj)))
 	  {
 	     SLang_free_object (&obj_A);
@@ -1037,7 +1536,7 @@ set_struct_lvalue (SLBlock_Type *bc_blk)
 	  }
      }
 
-   return (*cl->cl_sput) ((unsigned char) type, name);
+   return _SLstruct_sput_cached (cl, (unsigned char) type, name, cache);
 }
 
 static int make_unit_object (SLang_Object_Type *a, SLang_Object_Type *u)
@@ -1222,7 +1721,7 @@ int _SLang_deref_assign (SLang_Ref_Type *ref)
    if (ref->is_global == 0)
      {
 	objp = ref->v.local_obj;
-	if (objp > Local_Variable_Frame)
+	if (0 == local_variable_in_scope (objp))
 	  {
 	     SLang_verror (SL_UNDEFINED_NAME, "Local variable reference is out of scope");
 	     return -1;
@@ -1295,7 +1794,7 @@ static void set_deref_lvalue (SLBlock_Type *bc_blk)
    SLang_free_ref (ref);
 }
 
-static int push_struct_field (char *name)
+static int push_struct_field (SLBlock_Type *bc_blk)
 {
    int type;
    SLang_Class_Type *cl;
@@ -1313,7 +1812,8 @@ static int push_struct_field (char *name)
 	return -1;
      }
 
-   return (*cl->cl_sget) ((unsigned char) type, name);
+   return _SLstruct_sget_cached (cl, (unsigned char) type, bc_blk->b.s_blk,
+				 &bc_blk->bc_cache);
 }
 
 static void trace_dump (char *format, char *name, SLang_Object_Type *objs, int n, int dir)
@@ -1447,6 +1947,7 @@ static int execute_intrinsic_fun (SLang_Intrin_Fun_Type *objf)
 
    if (-1 == _SL_increment_frame_pointer ())
      return -1;
+   Function_Name_Stack [Recursion_Depth - 1] = objf->name;
 
    stk_depth = -1;
    if (Trace_Mode && (_SLang_Trace > 0))
@@ -1959,6 +2460,18 @@ static SLBlock_Type *Global_User_Block[5];
 static SLBlock_Type **User_Block_Ptr = Global_User_Block;
 static char *Current_Function_Name = NULL;
 
+/* Set by a call in tail position for execute_slang_fun to make */
+static _SLang_Function_Type *Tail_Call_Function;
+static int Tail_Call_Num_Args;
+
+static void do_tail_call (_SLang_Function_Type *fun)
+{
+   Tail_Call_Function = fun;
+   Tail_Call_Num_Args = Next_Function_Num_Args;
+   Next_Function_Num_Args = 0;
+   Lang_Break_Condition = Lang_Return = Lang_Break = 1;
+}
+
 static int execute_slang_fun (_SLang_Function_Type *fun)
 {
    register unsigned int i;
@@ -1970,6 +2483,9 @@ static int execute_slang_fun (_SLang_Function_Type *fun)
    SLBlock_Type **user_block_save;
    SLBlock_Type *user_blocks[5];
    char *save_fname;
+   _SLang_Function_Type *tail_fun;
+   unsigned long profile_token;
+   int new_chunk;
 
    exit_block_save = Exit_Block_Ptr;
    user_block_save = User_Block_Ptr;
@@ -1983,9 +2499,24 @@ static int execute_slang_fun (_SLang_Function_Type *fun)
    Exit_Block_Ptr = NULL;
 
    save_fname = Current_Function_Name;
-   Current_Function_Name = fun->name;
 
-   _SL_increment_frame_pointer ();
+   if (-1 == _SL_increment_frame_pointer ())
+     {
+	/* Do not go on recursing once the limit has been reached */
+	Exit_Block_Ptr = exit_block_save;
+	User_Block_Ptr = user_block_save;
+	Current_Function_Name = save_fname;
+	return -1;
+     }
+
+   /* A call in tail position comes back here with the new function */
+   tail_call:
+
+   Current_Function_Name = fun->name;
+   Function_Name_Stack [Recursion_Depth - 1] = fun->name;
+   tail_fun = NULL;
+   profile_token = 0;
+   new_chunk = 0;
 
    /* need loaded?  */
    if (fun->nlocals == AUTOLOAD_NUM_LOCALS)
@@ -2010,11 +2541,15 @@ static int execute_slang_fun (_SLang_Function_Type *fun)
    /* set new stack frame */
    lvf = frame = Local_Variable_Frame;
    i = n_locals;
-   if ((lvf + i) > Local_Variable_Stack + SLANG_MAX_LOCAL_STACK)
+   if (lvf + i >= Local_Variable_Max)
      {
-	SLang_verror(SL_STACK_OVERFLOW, "%s: Local Variable Stack Overflow",
-		     Current_Function_Name);
-	goto the_return;
+	if (NULL == (lvf = frame = grow_local_stack (i)))
+	  {
+	     SLang_verror(SL_STACK_OVERFLOW, "%s: Local Variable Stack Overflow",
+			  Current_Function_Name);
+	     goto the_return;
+	  }
+	new_chunk = 1;
      }
 
    /* Make sure we do not allow this header to get destroyed by something
@@ -2039,6 +2574,8 @@ static int execute_slang_fun (_SLang_Function_Type *fun)
      }
 
    if (SLang_Enter_Function != NULL) (*SLang_Enter_Function)(Current_Function_Name);
+   if (_SLang_Profile)
+     profile_token = _SLprof_enter (fun->name);
 
    if (_SLang_Trace)
      {
@@ -2064,6 +2601,8 @@ static int execute_slang_fun (_SLang_Function_Type *fun)
 
 	inner_interp (header->body);
 	Lang_Break_Condition = Lang_Return = Lang_Break = 0;
+	tail_fun = Tail_Call_Function;
+	Tail_Call_Function = NULL;
 	if (Exit_Block_Ptr != NULL) inner_interp(Exit_Block_Ptr);
 
 	if (Trace_Mode)
@@ -2085,9 +2624,12 @@ static int execute_slang_fun (_SLang_Function_Type *fun)
      {
 	inner_interp (header->body);
 	Lang_Break_Condition = Lang_Return = Lang_Break = 0;
+	tail_fun = Tail_Call_Function;
+	Tail_Call_Function = NULL;
 	if (Exit_Block_Ptr != NULL) inner_interp(Exit_Block_Ptr);
      }
 
+   if (profile_token) _SLprof_exit (profile_token);
    if (SLang_Exit_Function != NULL) (*SLang_Exit_Function)(Current_Function_Name);
 
    if (SLang_Error)
@@ -2109,13 +2651,27 @@ static int execute_slang_fun (_SLang_Function_Type *fun)
 	  SLang_free_object (lvf);
 	lvf--;
      }
-   Local_Variable_Frame = lvf;
+   if (new_chunk)
+     pop_local_stack_chunk ();
+   else
+     Local_Variable_Frame = lvf;
 
    if (header->num_refs == 1)
      free_function_header (header);
    else
      header->num_refs--;
 
+   if ((tail_fun != NULL) && (SLang_Error == 0))
+     {
+	/* Its arguments are on the stack, where the caller left them */
+	fun = tail_fun;
+	SLang_Num_Function_Args = Tail_Call_Num_Args;
+	for (i = 0; i < 5; i++)
+	  user_blocks[i] = NULL;
+	Exit_Block_Ptr = NULL;
+	goto tail_call;
+     }
+
    the_return:
 
    Lang_Break_Condition = Lang_Return = Lang_Break = 0;
@@ -2205,6 +2761,7 @@ static int inner_interp_nametype (SLang_Name_Type *nt)
 
    bc_blks[0].b.nt_blk = nt;
    bc_blks[0].bc_main_type = nt->name_type;
+   bc_blks[0].bc_sub_type = 0;
    bc_blks[1].bc_main_type = 0;
    return inner_interp(bc_blks);
 }
@@ -2220,7 +2777,7 @@ int _SLang_dereference_ref (SLang_Ref_Type *ref)
    if (ref->is_global == 0)
      {
 	SLang_Object_Type *obj = ref->v.local_obj;
-	if (obj > Local_Variable_Frame)
+	if (0 == local_variable_in_scope (obj))
 	  {
 	     SLang_verror (SL_UNDEFINED_NAME, "Local variable deref is out of scope");
 	     return -1;
@@ -2245,7 +2802,7 @@ int _SLang_is_ref_initialized (SLang_Ref_Type *ref)
    if (ref->is_global == 0)
      {
 	SLang_Object_Type *obj = ref->v.local_obj;
-	if (obj > Local_Variable_Frame)
+	if (0 == local_variable_in_scope (obj))
 	  {
 	     SLang_verror (SL_UNDEFINED_NAME, "Local variable deref is out of scope");
 	     return -1;
@@ -2276,7 +2833,7 @@ int _SLang_uninitialize_ref (SLang_Ref_Type *ref)
    if (ref->is_global == 0)
      {
 	obj = ref->v.local_obj;
-	if (obj > Local_Variable_Frame)
+	if (0 == local_variable_in_scope (obj))
 	  {
 	     SLang_verror (SL_UNDEFINED_NAME, "Local variable deref is out of scope");
 	     return -1;
@@ -2519,49 +3076,489 @@ do_inner_interp_error (SLBlock_Type *err_block,
 }
 
 
-#define GATHER_STATISTICS 0
-#if GATHER_STATISTICS
-static unsigned int Bytecodes[0xFFFF];
-
-static void print_stats (void)
+/* Byte-code statistics.  While SLang_collect_bytecode_stats is on,
+ * inner_interp counts every byte-code it runs together with the one or
+ * two byte-codes that follow it in the block, and newly compiled blocks
+ * are not fused into superinstructions so that the counts show the
+ * plain sequences.  SLang_write_bytecode_stats writes them out for
+ * util/mksuper, which turns the hot ones into slsuper.inc.
+ */
+typedef struct
 {
-   unsigned int i;
-   unsigned long total;
-   FILE *fp = fopen ("stats.txt", "w");
-   if (fp == NULL)
-     return;
-   
-   total = 0;
-   for (i = 0; i < 0xFFFF; i++)
-     total += Bytecodes[i];
-   
-   if (total == 0)
-     total = 1;
-
-   for (i = 0; i < 0xFFFF; i++)
-     {
-	if (Bytecodes[i])
-	  fprintf (fp, "0x%04X %9u %e\n", i, Bytecodes[i], Bytecodes[i]/(double) total);
-     }
-   fclose (fp);
+   unsigned char bc;
+   unsigned char len;		       /* slots taken, with combined ones */
+   unsigned char fuse;		       /* may be part of a superinstruction */
+   char *name;
 }
+Bytecode_Info_Type;
+
+static Bytecode_Info_Type Bytecode_Info_Table [] =
+{
+   {_SLANG_BC_LVARIABLE, 1, 1, "LVARIABLE"},
+   {_SLANG_BC_GVARIABLE, 1, 1, "GVARIABLE"},
+   {_SLANG_BC_IVARIABLE, 1, 0, "IVARIABLE"},
+   {_SLANG_BC_RVARIABLE, 1, 0, "RVARIABLE"},
+   {_SLANG_BC_INTRINSIC, 1, 1, "INTRINSIC"},
+   {_SLANG_BC_FUNCTION, 1, 0, "FUNCTION"},
+   {_SLANG_BC_MATH_UNARY, 1, 0, "MATH_UNARY"},
+   {_SLANG_BC_APP_UNARY, 1, 0, "APP_UNARY"},
+   {_SLANG_BC_ICONST, 1, 0, "ICONST"},
+   {_SLANG_BC_DCONST, 1, 0, "DCONST"},
+   {_SLANG_BC_PVARIABLE, 1, 0, "PVARIABLE"},
+   {_SLANG_BC_PFUNCTION, 1, 0, "PFUNCTION"},
+   {_SLANG_BC_BINARY, 1, 1, "BINARY"},
+   {_SLANG_BC_LITERAL, 1, 0, "LITERAL"},
+   {_SLANG_BC_LITERAL_INT, 1, 1, "LITERAL_INT"},
+   {_SLANG_BC_LITERAL_STR, 1, 1, "LITERAL_STR"},
+   {_SLANG_BC_BLOCK, 1, 0, "BLOCK"},
+   {_SLANG_BC_RETURN, 1, 0, "RETURN"},
+   {_SLANG_BC_BREAK, 1, 0, "BREAK"},
+   {_SLANG_BC_CONTINUE, 1, 0, "CONTINUE"},
+   {_SLANG_BC_EXCH, 1, 1, "EXCH"},
+   {_SLANG_BC_LABEL, 1, 0, "LABEL"},
+   {_SLANG_BC_LOBJPTR, 1, 0, "LOBJPTR"},
+   {_SLANG_BC_GOBJPTR, 1, 0, "GOBJPTR"},
+   {_SLANG_BC_X_ERROR, 1, 0, "X_ERROR"},
+   {_SLANG_BC_X_USER0, 1, 0, "X_USER0"},
+   {_SLANG_BC_X_USER1, 1, 0, "X_USER1"},
+   {_SLANG_BC_X_USER2, 1, 0, "X_USER2"},
+   {_SLANG_BC_X_USER3, 1, 0, "X_USER3"},
+   {_SLANG_BC_X_USER4, 1, 0, "X_USER4"},
+   {_SLANG_BC_LITERAL_DBL, 1, 1, "LITERAL_DBL"},
+   {_SLANG_BC_CALL_DIRECT, 1, 1, "CALL_DIRECT"},
+   {_SLANG_BC_CALL_DIRECT_FRAME, 1, 1, "CALL_DIRECT_FRAME"},
+   {_SLANG_BC_UNARY, 1, 1, "UNARY"},
+   {_SLANG_BC_UNARY_FUNC, 1, 0, "UNARY_FUNC"},
+   {_SLANG_BC_DEREF_ASSIGN, 1, 0, "DEREF_ASSIGN"},
+   {_SLANG_BC_SET_LOCAL_LVALUE, 1, 1, "SET_LOCAL_LVALUE"},
+   {_SLANG_BC_SET_GLOBAL_LVALUE, 1, 1, "SET_GLOBAL_LVALUE"},
+   {_SLANG_BC_SET_INTRIN_LVALUE, 1, 0, "SET_INTRIN_LVALUE"},
+   {_SLANG_BC_SET_STRUCT_LVALUE, 1, 0, "SET_STRUCT_LVALUE"},
+   {_SLANG_BC_FIELD, 1, 1, "FIELD"},
+   {_SLANG_BC_SET_ARRAY_LVALUE, 1, 0, "SET_ARRAY_LVALUE"},
+   {_SLANG_BC_LINE_NUM, 1, 0, "LINE_NUM"},
+   {_SLANG_BC_TMP, 1, 0, "TMP"},
+   {_SLANG_BC_LVARIABLE_AGET, 1, 1, "LVARIABLE_AGET"},
+   {_SLANG_BC_LVARIABLE_APUT, 1, 1, "LVARIABLE_APUT"},
+   {_SLANG_BC_INTEGER_PLUS, 1, 1, "INTEGER_PLUS"},
+   {_SLANG_BC_INTEGER_MINUS, 1, 1, "INTEGER_MINUS"},
+   {_SLANG_BC_EARG_LVARIABLE, 1, 1, "EARG_LVARIABLE"},
+   {_SLANG_BC_CALL_DIRECT_INTRINSIC, 2, 1, "CALL_DIRECT_INTRINSIC"},
+   {_SLANG_BC_INTRINSIC_CALL_DIRECT, 2, 0, "INTRINSIC_CALL_DIRECT"},
+   {_SLANG_BC_CALL_DIRECT_LSTR, 2, 1, "CALL_DIRECT_LSTR"},
+   {_SLANG_BC_CALL_DIRECT_SLFUN, 2, 0, "CALL_DIRECT_SLFUN"},
+   {_SLANG_BC_CALL_DIRECT_INTRSTOP, 2, 0, "CALL_DIRECT_INTRSTOP"},
+   {_SLANG_BC_INTRINSIC_STOP, 1, 0, "INTRINSIC_STOP"},
+   {_SLANG_BC_CALL_DIRECT_EARG_LVAR, 2, 1, "CALL_DIRECT_EARG_LVAR"},
+   {_SLANG_BC_CALL_DIRECT_LINT, 2, 1, "CALL_DIRECT_LINT"},
+   {_SLANG_BC_CALL_DIRECT_LVAR, 2, 1, "CALL_DIRECT_LVAR"},
+   {_SLANG_BC_LLVARIABLE_BINARY, 3, 1, "LLVARIABLE_BINARY"},
+   {_SLANG_BC_LGVARIABLE_BINARY, 3, 1, "LGVARIABLE_BINARY"},
+   {_SLANG_BC_GLVARIABLE_BINARY, 3, 1, "GLVARIABLE_BINARY"},
+   {_SLANG_BC_GGVARIABLE_BINARY, 3, 1, "GGVARIABLE_BINARY"},
+   {_SLANG_BC_LIVARIABLE_BINARY, 3, 1, "LIVARIABLE_BINARY"},
+   {_SLANG_BC_LDVARIABLE_BINARY, 3, 1, "LDVARIABLE_BINARY"},
+   {_SLANG_BC_ILVARIABLE_BINARY, 3, 1, "ILVARIABLE_BINARY"},
+   {_SLANG_BC_DLVARIABLE_BINARY, 3, 1, "DLVARIABLE_BINARY"},
+   {_SLANG_BC_LVARIABLE_BINARY, 2, 1, "LVARIABLE_BINARY"},
+   {_SLANG_BC_GVARIABLE_BINARY, 2, 1, "GVARIABLE_BINARY"},
+   {_SLANG_BC_LITERAL_INT_BINARY, 2, 1, "LITERAL_INT_BINARY"},
+   {_SLANG_BC_LITERAL_DBL_BINARY, 2, 1, "LITERAL_DBL_BINARY"},
+   {_SLANG_BC_SUPER_0, 0, 0, "SUPER_0"},
+   {_SLANG_BC_SUPER_1, 0, 0, "SUPER_1"},
+   {_SLANG_BC_SUPER_2, 0, 0, "SUPER_2"},
+   {_SLANG_BC_SUPER_3, 0, 0, "SUPER_3"},
+   {_SLANG_BC_SUPER_4, 0, 0, "SUPER_4"},
+   {_SLANG_BC_SUPER_5, 0, 0, "SUPER_5"},
+   {_SLANG_BC_SUPER_6, 0, 0, "SUPER_6"},
+   {_SLANG_BC_SUPER_7, 0, 0, "SUPER_7"},
+   {_SLANG_BC_SUPER_8, 0, 0, "SUPER_8"},
+   {_SLANG_BC_SUPER_9, 0, 0, "SUPER_9"},
+   {_SLANG_BC_SUPER_10, 0, 0, "SUPER_10"},
+   {_SLANG_BC_SUPER_11, 0, 0, "SUPER_11"},
+   {_SLANG_BC_SUPER_12, 0, 0, "SUPER_12"},
+   {_SLANG_BC_SUPER_13, 0, 0, "SUPER_13"},
+   {_SLANG_BC_SUPER_14, 0, 0, "SUPER_14"},
+   {_SLANG_BC_SUPER_15, 0, 0, "SUPER_15"},
+   {0, 0, 0, NULL}
+};
 
-static void add_to_statistics (SLBlock_Type *b)
+typedef struct
 {
-   unsigned short x, y;
-   
-   x = b->bc_main_type;
-   if (x == 0)
+   unsigned int num;
+   unsigned char bc[_SLANG_MAX_SUPER_SEQUENCE];
+}
+Super_Bytecode_Type;
+
+/* Super_Bytecodes and SLSUPER_NUM */
+#if USE_SUPER_BYTECODES
+# define SLSUPER_TABLE
+# include "slsuper.inc"
+# undef SLSUPER_TABLE
+#else
+# define SLSUPER_NUM	0
+#endif
+
+static Bytecode_Info_Type *Bytecode_Info [256];
+static unsigned char Bytecode_Length [256];
+#if USE_SUPER_BYTECODES
+/* Non-zero for the byte-codes that start a superinstruction */
+static unsigned char Bytecode_Starts_Super [256];
+#endif
+
+static void init_bytecode_info (void)
+{
+   Bytecode_Info_Type *b;
+   unsigned int i, j;
+
+   if (Bytecode_Length[0] != 0)
+     return;
+
+   for (i = 0; i < 256; i++)
+     Bytecode_Length[i] = 1;
+   for (b = Bytecode_Info_Table; b->name != NULL; b++)
      {
-	Bytecodes[0] += 1;
-	return;
+	Bytecode_Info[b->bc] = b;
+	Bytecode_Length[b->bc] = b->len;
      }
-   b++;
-   y = b->bc_main_type;
+#if USE_SUPER_BYTECODES
+   for (i = 0; i < SLSUPER_NUM; i++)
+     {
+	Bytecode_Length[_SLANG_BC_SUPER_0 + i] = 0;
+	Bytecode_Starts_Super[Super_Bytecodes[i].bc[0]] = 1;
+	for (j = 0; j < Super_Bytecodes[i].num; j++)
+	  Bytecode_Length[_SLANG_BC_SUPER_0 + i] += Bytecode_Length[Super_Bytecodes[i].bc[j]];
+     }
+#else
+   (void) j;
+#endif
+}
 
-   Bytecodes[(x << 8) | y] += 1;
+#define BC_STATS_HASH_SIZE	0x4000	       /* power of 2 */
+typedef struct
+{
+   unsigned long seq;		       /* 0 if unused */
+   unsigned long count;
+}
+Bytecode_Seq_Type;
+
+static int Bytecode_Stats;
+static Bytecode_Seq_Type *Bytecode_Seqs;
+static unsigned int Num_Bytecode_Seqs;
+
+/* seq is n << 24 | bc1 << 16 | bc2 << 8 | bc3 */
+static void add_bytecode_seq (unsigned long seq)
+{
+   unsigned int h;
+   Bytecode_Seq_Type *s;
+
+   h = (unsigned int) ((seq * 2654435761UL) >> 8) & (BC_STATS_HASH_SIZE - 1);
+   while (1)
+     {
+	s = Bytecode_Seqs + h;
+	if (s->seq == seq)
+	  {
+	     s->count++;
+	     return;
+	  }
+	if (s->seq == 0)
+	  break;
+	h = (h + 1) & (BC_STATS_HASH_SIZE - 1);
+     }
+   /* When the table fills up, only the sequences already in it count */
+   if (4 * Num_Bytecode_Seqs >= 3 * BC_STATS_HASH_SIZE)
+     return;
+   s->seq = seq;
+   s->count = 1;
+   Num_Bytecode_Seqs++;
 }
 
+static void count_bytecodes (SLBlock_Type *b)
+{
+   unsigned long b1, b2, b3;
+
+   if (0 == (b1 = b->bc_main_type))
+     return;
+   b += Bytecode_Length[b1];
+   if (0 == (b2 = b->bc_main_type))
+     return;
+   add_bytecode_seq ((2UL << 24) | (b1 << 16) | (b2 << 8));
+   b += Bytecode_Length[b2];
+   if (0 == (b3 = b->bc_main_type))
+     return;
+   add_bytecode_seq ((3UL << 24) | (b1 << 16) | (b2 << 8) | b3);
+}
+
+int SLang_collect_bytecode_stats (int on)
+{
+   int was_on = Bytecode_Stats;
+
+   if (on && (Bytecode_Seqs == NULL))
+     {
+	Bytecode_Seqs = (Bytecode_Seq_Type *) SLcalloc (BC_STATS_HASH_SIZE, sizeof (Bytecode_Seq_Type));
+	if (Bytecode_Seqs == NULL)
+	  return -1;
+	init_bytecode_info ();
+     }
+   Bytecode_Stats = (on != 0);
+   return was_on;
+}
+
+static int compare_bytecode_seqs (Bytecode_Seq_Type *a, Bytecode_Seq_Type *b)
+{
+   if (a->count > b->count) return -1;
+   if (a->count < b->count) return 1;
+   return (a->seq < b->seq) ? -1 : (a->seq > b->seq);
+}
+
+static char *bytecode_name (unsigned int bc, char *buf)
+{
+   if (Bytecode_Info[bc] != NULL)
+     return Bytecode_Info[bc]->name;
+   sprintf (buf, "0x%02X", bc);
+   return buf;
+}
+
+/* One line per sequence, most frequent first: the count and the names
+ * of the byte-codes.  Sequences that cannot be made into one
+ * superinstruction are written as comments.
+ */
+int SLang_write_bytecode_stats (char *file)
+{
+   Bytecode_Seq_Type *seqs;
+   FILE *fp;
+   unsigned int i, j, n;
+   unsigned long seq;
+   char buf[3][8];
+   int fuse;
+
+   if (Bytecode_Seqs == NULL)
+     return -1;
+
+   seqs = (Bytecode_Seq_Type *) SLmalloc (Num_Bytecode_Seqs * sizeof (Bytecode_Seq_Type) + 1);
+   if (seqs == NULL)
+     return -1;
+   for (i = j = 0; i < BC_STATS_HASH_SIZE; i++)
+     if (Bytecode_Seqs[i].seq != 0)
+       seqs[j++] = Bytecode_Seqs[i];
+   n = j;
+   qsort ((char *) seqs, n, sizeof (Bytecode_Seq_Type),
+	  (int (*)(const void *, const void *)) compare_bytecode_seqs);
+
+   if (NULL == (fp = fopen (file, "w")))
+     {
+	SLang_verror (SL_OBJ_NOPEN, "Unable to open %s", file);
+	SLfree ((char *) seqs);
+	return -1;
+     }
+   fputs ("# S-Lang byte-code sequences, most frequent first\n", fp);
+   for (i = 0; i < n; i++)
+     {
+	seq = seqs[i].seq;
+	fuse = 1;
+	for (j = 0; j < (seq >> 24); j++)
+	  {
+	     Bytecode_Info_Type *b = Bytecode_Info[(seq >> (16 - 8 * j)) & 0xFF];
+	     if ((b == NULL) || (b->fuse == 0))
+	       fuse = 0;
+	  }
+	fprintf (fp, "%s%lu", fuse ? "" : "# ", seqs[i].count);
+	for (j = 0; j < (seq >> 24); j++)
+	  fprintf (fp, " %s", bytecode_name ((seq >> (16 - 8 * j)) & 0xFF, buf[j]));
+	fputc ('\n', fp);
+     }
+   SLfree ((char *) seqs);
+   if (EOF == fclose (fp))
+     return -1;
+   return 0;
+}
+
+/* What the byte-codes that may be fused into superinstructions do.
+ * inner_interp uses these both for the byte-codes themselves and for
+ * the superinstructions from slsuper.inc.
+ */
+#define BC_DO_LVARIABLE \
+   push_local_variable (addr->b.i_blk)
+#define BC_DO_GVARIABLE \
+   if (-1 == _SLpush_slang_obj (&addr->b.nt_gvar_blk->obj)) \
+     do_name_type_error (addr->b.nt_blk)
+#define BC_DO_INTRINSIC \
+   execute_intrinsic_fun (addr->b.nt_ifun_blk); \
+   if (SLang_Error) \
+     do_traceback(addr->b.nt_ifun_blk->name, 0, NULL)
+#define BC_DO_BINARY \
+   do_binary_quick (addr)
+#define BC_DO_LITERAL_INT \
+   SLclass_push_int_obj (addr->bc_sub_type, (int) addr->b.l_blk)
+#define BC_DO_LITERAL_DBL \
+   SLclass_push_double_obj (addr->bc_sub_type, *addr->b.double_blk)
+#define BC_DO_LITERAL_STR \
+   _SLang_dup_and_push_slstring (addr->b.s_blk)
+#define BC_DO_EXCH \
+   (void) SLreverse_stack (2)
+#define BC_DO_CALL_DIRECT \
+   (*addr->b.call_function) ()
+#define BC_DO_CALL_DIRECT_FRAME \
+   do_bc_call_direct_frame (addr->b.call_function)
+#define BC_DO_UNARY \
+   do_unary (addr->b.i_blk, _SLANG_BC_UNARY)
+#define BC_DO_SET_LOCAL_LVALUE \
+   set_lvalue_obj (addr->bc_sub_type, Local_Variable_Frame - addr->b.i_blk)
+#define BC_DO_SET_GLOBAL_LVALUE \
+   if (-1 == set_lvalue_obj (addr->bc_sub_type, &addr->b.nt_gvar_blk->obj)) \
+     do_name_type_error (addr->b.nt_blk)
+#define BC_DO_FIELD \
+   (void) push_struct_field (addr)
+#define BC_DO_LVARIABLE_AGET \
+   if (0 == push_local_variable (addr->b.i_blk)) \
+     do_bc_call_direct_frame (_SLarray_aget)
+#define BC_DO_LVARIABLE_APUT \
+   if (0 == push_local_variable (addr->b.i_blk)) \
+     do_bc_call_direct_frame (_SLarray_aput)
+#define BC_DO_INTEGER_PLUS \
+   if (0 == SLclass_push_int_obj (addr->bc_sub_type, (int) addr->b.l_blk)) \
+     do_binary (SLANG_PLUS)
+#define BC_DO_INTEGER_MINUS \
+   if (0 == SLclass_push_int_obj (addr->bc_sub_type, (int) addr->b.l_blk)) \
+     do_binary (SLANG_MINUS)
+#define BC_DO_EARG_LVARIABLE \
+   push_local_variable (addr->b.i_blk); \
+   (void) SLang_end_arg_list ()
+
+/* The combined byte-codes leave addr at their last slot */
+#define BC_DO_CALL_DIRECT_INTRINSIC \
+   (*addr->b.call_function) (); \
+   addr++; \
+   BC_DO_INTRINSIC
+#define BC_DO_CALL_DIRECT_LSTR \
+   (*addr->b.call_function) (); \
+   addr++; \
+   _SLang_dup_and_push_slstring (addr->b.s_blk)
+#define BC_DO_CALL_DIRECT_EARG_LVAR \
+   (*addr->b.call_function) (); \
+   addr++; \
+   BC_DO_EARG_LVARIABLE
+#define BC_DO_CALL_DIRECT_LINT \
+   (*addr->b.call_function) (); \
+   addr++; \
+   SLclass_push_int_obj (addr->bc_sub_type, (int) addr->b.l_blk)
+#define BC_DO_CALL_DIRECT_LVAR \
+   (*addr->b.call_function) (); \
+   addr++; \
+   push_local_variable (addr->b.i_blk)
+#define BC_DO_LLVARIABLE_BINARY \
+   do_binary_ab_quick (addr, \
+		       Local_Variable_Frame - (addr+1)->b.i_blk, \
+		       Local_Variable_Frame - (addr+2)->b.i_blk); \
+   addr += 2
+#define BC_DO_LGVARIABLE_BINARY \
+   do_binary_ab_quick (addr, \
+		       Local_Variable_Frame - (addr+1)->b.i_blk, \
+		       &(addr+2)->b.nt_gvar_blk->obj); \
+   addr += 2
+#define BC_DO_GLVARIABLE_BINARY \
+   do_binary_ab_quick (addr, \
+		       &(addr+1)->b.nt_gvar_blk->obj, \
+		       Local_Variable_Frame - (addr+2)->b.i_blk); \
+   addr += 2
+#define BC_DO_GGVARIABLE_BINARY \
+   do_binary_ab_quick (addr, \
+		       &(addr+1)->b.nt_gvar_blk->obj, \
+		       &(addr+2)->b.nt_gvar_blk->obj); \
+   addr += 2
+#define BC_DO_LIVARIABLE_BINARY \
+     { \
+	SLang_Object_Type o; \
+	o.data_type = SLANG_INT_TYPE; \
+	o.v.int_val = (int) (addr+2)->b.l_blk; \
+	do_binary_ab_quick (addr, \
+			    Local_Variable_Frame - (addr+1)->b.i_blk, \
+			    &o); \
+     } \
+   addr += 2
+#define BC_DO_LDVARIABLE_BINARY \
+     { \
+	SLang_Object_Type o; \
+	o.data_type = SLANG_DOUBLE_TYPE; \
+	o.v.double_val = *(addr+2)->b.double_blk; \
+	do_binary_ab_quick (addr, \
+			    Local_Variable_Frame - (addr+1)->b.i_blk, \
+			    &o); \
+     } \
+   addr += 2
+#define BC_DO_ILVARIABLE_BINARY \
+     { \
+	SLang_Object_Type o; \
+	o.data_type = SLANG_INT_TYPE; \
+	o.v.int_val = (int) (addr+1)->b.l_blk; \
+	do_binary_ab_quick (addr, \
+			    &o, \
+			    Local_Variable_Frame - (addr+2)->b.i_blk); \
+     } \
+   addr += 2
+#define BC_DO_DLVARIABLE_BINARY \
+     { \
+	SLang_Object_Type o; \
+	o.data_type = SLANG_DOUBLE_TYPE; \
+	o.v.double_val = *(addr+1)->b.double_blk; \
+	do_binary_ab_quick (addr, \
+			    &o, \
+			    Local_Variable_Frame - (addr+2)->b.i_blk); \
+     } \
+   addr += 2
+#define BC_DO_LVARIABLE_BINARY \
+   do_binary_b_quick (addr, \
+		      Local_Variable_Frame - (addr+1)->b.i_blk, 1); \
+   addr++
+#define BC_DO_GVARIABLE_BINARY \
+   do_binary_b_quick (addr, \
+		      &(addr+1)->b.nt_gvar_blk->obj, 1); \
+   addr++
+#define BC_DO_LITERAL_INT_BINARY \
+     { \
+	SLang_Object_Type o; \
+	o.data_type = SLANG_INT_TYPE; \
+	o.v.int_val = (int) (addr+1)->b.l_blk; \
+	do_binary_b_quick (addr, &o, 0); \
+     } \
+   addr++
+#define BC_DO_LITERAL_DBL_BINARY \
+     { \
+	SLang_Object_Type o; \
+	o.data_type = SLANG_DOUBLE_TYPE; \
+	o.v.double_val = *(addr+1)->b.double_blk; \
+	do_binary_b_quick (addr, &o, 0); \
+     } \
+   addr++
+
+/* Between the parts of a superinstruction */
+#define BC_FUSE \
+   if (SLang_Error) goto bc_error; \
+   addr++
+
+
+/* With gcc, each byte-code jumps straight to the code for the next one
+ * through Dispatch below, so that every handler has its own indirect
+ * branch for the CPU to predict instead of all of them sharing the one
+ * of the switch.  Byte-codes without an entry there go through the
+ * switch, which stays the only way in for other compilers.
+ */
+#if _SLANG_USE_COMPUTED_GOTO && defined(__GNUC__)
+# define BC_COMPUTED_GOTO	1
+# define BC_CASE(x)	case x: bc_##x
+# define BC_TARGET(x)	[x] = &&bc_##x
+# define BC_NEXT \
+   do \
+     { \
+	if (SLang_Error) goto bc_error; \
+	addr++; \
+	goto *dispatch[addr->bc_main_type]; \
+     } \
+   while (0)
+#else
+# define BC_COMPUTED_GOTO	0
+# define BC_CASE(x)	case x
+# define BC_NEXT	break
 #endif
 
 /* inner interpreter */
@@ -2573,14 +3570,109 @@ static void add_to_statistics (SLBlock_Type *b)
 static int inner_interp (SLBlock_Type *addr_start)
 {
    SLBlock_Type *block, *err_block, *addr;
-#if GATHER_STATISTICS
-   static int inited = 0;
-
-   if (inited == 0)
+#if BC_COMPUTED_GOTO
+   static void *const Dispatch[256] =
+     {
+	[0 ... 255] = &&bc_switch,
+	BC_TARGET(0),
+	BC_TARGET(_SLANG_BC_LVARIABLE),
+	BC_TARGET(_SLANG_BC_GVARIABLE),
+	BC_TARGET(_SLANG_BC_IVARIABLE),
+	BC_TARGET(_SLANG_BC_RVARIABLE),
+	BC_TARGET(_SLANG_BC_INTRINSIC),
+	BC_TARGET(_SLANG_BC_FUNCTION),
+	BC_TARGET(_SLANG_BC_MATH_UNARY),
+	BC_TARGET(_SLANG_BC_APP_UNARY),
+	BC_TARGET(_SLANG_BC_ICONST),
+#if SLANG_HAS_FLOAT
+	BC_TARGET(_SLANG_BC_DCONST),
+#endif
+	BC_TARGET(_SLANG_BC_PVARIABLE),
+	BC_TARGET(_SLANG_BC_PFUNCTION),
+	BC_TARGET(_SLANG_BC_BINARY),
+	BC_TARGET(_SLANG_BC_LITERAL),
+	BC_TARGET(_SLANG_BC_LITERAL_INT),
+	BC_TARGET(_SLANG_BC_LITERAL_STR),
+#if SLANG_HAS_FLOAT || !_SLANG_OPTIMIZE_FOR_SPEED
+	BC_TARGET(_SLANG_BC_LITERAL_DBL),
+#endif
+	BC_TARGET(_SLANG_BC_BLOCK),
+	BC_TARGET(_SLANG_BC_RETURN),
+	BC_TARGET(_SLANG_BC_BREAK),
+	BC_TARGET(_SLANG_BC_CONTINUE),
+	BC_TARGET(_SLANG_BC_EXCH),
+	BC_TARGET(_SLANG_BC_LABEL),
+	BC_TARGET(_SLANG_BC_LOBJPTR),
+	BC_TARGET(_SLANG_BC_GOBJPTR),
+	BC_TARGET(_SLANG_BC_X_ERROR),
+	BC_TARGET(_SLANG_BC_X_USER0),
+	BC_TARGET(_SLANG_BC_X_USER1),
+	BC_TARGET(_SLANG_BC_X_USER2),
+	BC_TARGET(_SLANG_BC_X_USER3),
+	BC_TARGET(_SLANG_BC_X_USER4),
+	BC_TARGET(_SLANG_BC_CALL_DIRECT),
+	BC_TARGET(_SLANG_BC_CALL_DIRECT_FRAME),
+	BC_TARGET(_SLANG_BC_UNARY),
+	BC_TARGET(_SLANG_BC_UNARY_FUNC),
+	BC_TARGET(_SLANG_BC_DEREF_ASSIGN),
+	BC_TARGET(_SLANG_BC_SET_LOCAL_LVALUE),
+	BC_TARGET(_SLANG_BC_SET_GLOBAL_LVALUE),
+	BC_TARGET(_SLANG_BC_SET_INTRIN_LVALUE),
+	BC_TARGET(_SLANG_BC_SET_STRUCT_LVALUE),
+	BC_TARGET(_SLANG_BC_FIELD),
+	BC_TARGET(_SLANG_BC_SET_ARRAY_LVALUE),
+#if _SLANG_HAS_DEBUG_CODE
+	BC_TARGET(_SLANG_BC_LINE_NUM),
+#endif
+	BC_TARGET(_SLANG_BC_TMP),
+#if _SLANG_OPTIMIZE_FOR_SPEED
+	BC_TARGET(_SLANG_BC_LVARIABLE_AGET),
+	BC_TARGET(_SLANG_BC_LVARIABLE_APUT),
+	BC_TARGET(_SLANG_BC_INTEGER_PLUS),
+	BC_TARGET(_SLANG_BC_INTEGER_MINUS),
+#endif
+	BC_TARGET(_SLANG_BC_EARG_LVARIABLE),
+#if USE_COMBINED_BYTECODES
+	BC_TARGET(_SLANG_BC_CALL_DIRECT_INTRINSIC),
+	BC_TARGET(_SLANG_BC_INTRINSIC_CALL_DIRECT),
+	BC_TARGET(_SLANG_BC_CALL_DIRECT_LSTR),
+	BC_TARGET(_SLANG_BC_CALL_DIRECT_SLFUN),
+	BC_TARGET(_SLANG_BC_CALL_DIRECT_INTRSTOP),
+	BC_TARGET(_SLANG_BC_INTRINSIC_STOP),
+	BC_TARGET(_SLANG_BC_CALL_DIRECT_EARG_LVAR),
+	BC_TARGET(_SLANG_BC_CALL_DIRECT_LINT),
+	BC_TARGET(_SLANG_BC_CALL_DIRECT_LVAR),
+	BC_TARGET(_SLANG_BC_LLVARIABLE_BINARY),
+	BC_TARGET(_SLANG_BC_LGVARIABLE_BINARY),
+	BC_TARGET(_SLANG_BC_GLVARIABLE_BINARY),
+	BC_TARGET(_SLANG_BC_GGVARIABLE_BINARY),
+	BC_TARGET(_SLANG_BC_LIVARIABLE_BINARY),
+# if SLANG_HAS_FLOAT
+	BC_TARGET(_SLANG_BC_LDVARIABLE_BINARY),
+# endif
+	BC_TARGET(_SLANG_BC_ILVARIABLE_BINARY),
+# if SLANG_HAS_FLOAT
+	BC_TARGET(_SLANG_BC_DLVARIABLE_BINARY),
+# endif
+	BC_TARGET(_SLANG_BC_LVARIABLE_BINARY),
+	BC_TARGET(_SLANG_BC_GVARIABLE_BINARY),
+	BC_TARGET(_SLANG_BC_LITERAL_INT_BINARY),
+# if SLANG_HAS_FLOAT
+	BC_TARGET(_SLANG_BC_LITERAL_DBL_BINARY),
+# endif
+#endif
+#if USE_SUPER_BYTECODES
+# define SLSUPER_TARGETS
+# include "slsuper.inc"
+# undef SLSUPER_TARGETS
+#endif
+     };
+   /* Every byte-code goes by bc_count first while statistics are on */
+   static void *const Count_Dispatch[256] =
      {
-	(void) SLang_add_cleanup_function (print_stats);
-	inited = 1;
-     }
+	[0 ... 255] = &&bc_count
+     };
+   void *const *dispatch = Bytecode_Stats ? Count_Dispatch : Dispatch;
 #endif
 
    /* for systems that have no real interrupt facility (e.g. go32 on dos) */
@@ -2589,41 +3681,50 @@ static int inner_interp (SLBlock_Type *addr_start)
    block = err_block = NULL;
    addr = addr_start;
 
-#if GATHER_STATISTICS
-   add_to_statistics (addr);
-#endif
    while (1)
      {
+#if BC_COMPUTED_GOTO
+	goto *dispatch[addr->bc_main_type];
+	bc_count:
+	count_bytecodes (addr);
+	goto *Dispatch[addr->bc_main_type];
+	bc_switch:
+#else
+	if (Bytecode_Stats)
+	  count_bytecodes (addr);
+#endif
 	switch (addr->bc_main_type)
 	  {
-	   case 0:
+	   BC_CASE(0):
 	     return 1;
-	   case _SLANG_BC_LVARIABLE:
-	     push_local_variable (addr->b.i_blk);
-	     break;
-	   case _SLANG_BC_GVARIABLE:
-	     if (-1 == _SLpush_slang_obj (&addr->b.nt_gvar_blk->obj))
-	       do_name_type_error (addr->b.nt_blk);
-	     break;
-
-	   case _SLANG_BC_IVARIABLE:
-	   case _SLANG_BC_RVARIABLE:
+	   BC_CASE(_SLANG_BC_LVARIABLE):
+	     BC_DO_LVARIABLE;
+	     BC_NEXT;
+	   BC_CASE(_SLANG_BC_GVARIABLE):
+	     BC_DO_GVARIABLE;
+	     BC_NEXT;
+
+	   BC_CASE(_SLANG_BC_IVARIABLE):
+	   BC_CASE(_SLANG_BC_RVARIABLE):
 	     push_intrinsic_variable (addr->b.nt_ivar_blk);
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_INTRINSIC:
-	     execute_intrinsic_fun (addr->b.nt_ifun_blk);
-	     if (SLang_Error)
-	       do_traceback(addr->b.nt_ifun_blk->name, 0, NULL);
-	     break;
+	   BC_CASE(_SLANG_BC_INTRINSIC):
+	     BC_DO_INTRINSIC;
+	     BC_NEXT;
 
-	   case _SLANG_BC_FUNCTION:
+	   BC_CASE(_SLANG_BC_FUNCTION):
+	     if (addr->bc_sub_type == _SLANG_BCST_TAIL_CALL)
+	       {
+		  do_tail_call (addr->b.nt_fun_blk);
+		  return 1;
+	       }
 	     execute_slang_fun (addr->b.nt_fun_blk);
 	     if (Lang_Break_Condition) goto handle_break_condition;
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_MATH_UNARY:
-	   case _SLANG_BC_APP_UNARY:
+	   BC_CASE(_SLANG_BC_MATH_UNARY):
+	   BC_CASE(_SLANG_BC_APP_UNARY):
 	     /* Make sure we treat these like function calls since the
 	      * parser took sin(x) to be a function call.
 	      */
@@ -2632,57 +3733,62 @@ static int inner_interp (SLBlock_Type *addr_start)
 		  do_app_unary (addr->b.nt_unary_blk);
 		  (void) _SL_decrement_frame_pointer ();
 	       }
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_ICONST:
+	   BC_CASE(_SLANG_BC_ICONST):
 	     SLclass_push_int_obj (SLANG_INT_TYPE, addr->b.iconst_blk->i);
-	     break;
+	     BC_NEXT;
 
 #if SLANG_HAS_FLOAT
-	   case _SLANG_BC_DCONST:
+	   BC_CASE(_SLANG_BC_DCONST):
 	     SLclass_push_double_obj (SLANG_DOUBLE_TYPE, addr->b.dconst_blk->d);
-	     break;
+	     BC_NEXT;
 #endif
 
-	   case _SLANG_BC_PVARIABLE:
+	   BC_CASE(_SLANG_BC_PVARIABLE):
 	     if (-1 == _SLpush_slang_obj (&addr->b.nt_gvar_blk->obj))
 	       do_name_type_error (addr->b.nt_blk);
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_PFUNCTION:
+	   BC_CASE(_SLANG_BC_PFUNCTION):
+	     if (addr->bc_sub_type == _SLANG_BCST_TAIL_CALL)
+	       {
+		  do_tail_call (addr->b.nt_fun_blk);
+		  return 1;
+	       }
 	     execute_slang_fun (addr->b.nt_fun_blk);
 	     if (Lang_Break_Condition) goto handle_break_condition;
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_BINARY:
-	     do_binary (addr->b.i_blk);
-	     break;
+	   BC_CASE(_SLANG_BC_BINARY):
+	     BC_DO_BINARY;
+	     BC_NEXT;
 	     
-	   case _SLANG_BC_LITERAL:
+	   BC_CASE(_SLANG_BC_LITERAL):
 #if !_SLANG_OPTIMIZE_FOR_SPEED
-	   case _SLANG_BC_LITERAL_INT:
-	   case _SLANG_BC_LITERAL_STR:
-	   case _SLANG_BC_LITERAL_DBL:
+	   BC_CASE(_SLANG_BC_LITERAL_INT):
+	   BC_CASE(_SLANG_BC_LITERAL_STR):
+	   BC_CASE(_SLANG_BC_LITERAL_DBL):
 #endif
 	       {
 		  SLang_Class_Type *cl = _SLclass_get_class (addr->bc_sub_type);
 		  (*cl->cl_push_literal) (addr->bc_sub_type, (VOID_STAR) &addr->b.ptr_blk);
 	       }
-	     break;
+	     BC_NEXT;
 #if _SLANG_OPTIMIZE_FOR_SPEED
-	   case _SLANG_BC_LITERAL_INT:
-	     SLclass_push_int_obj (addr->bc_sub_type, (int) addr->b.l_blk);
-	     break;
+	   BC_CASE(_SLANG_BC_LITERAL_INT):
+	     BC_DO_LITERAL_INT;
+	     BC_NEXT;
 #if SLANG_HAS_FLOAT
-	   case _SLANG_BC_LITERAL_DBL:
-	     SLclass_push_double_obj (addr->bc_sub_type, *addr->b.double_blk);
-	     break;
+	   BC_CASE(_SLANG_BC_LITERAL_DBL):
+	     BC_DO_LITERAL_DBL;
+	     BC_NEXT;
 #endif
-	   case _SLANG_BC_LITERAL_STR:
-	     _SLang_dup_and_push_slstring (addr->b.s_blk);
-	     break;
+	   BC_CASE(_SLANG_BC_LITERAL_STR):
+	     BC_DO_LITERAL_STR;
+	     BC_NEXT;
 #endif
-	   case _SLANG_BC_BLOCK:
+	   BC_CASE(_SLANG_BC_BLOCK):
 	     switch (addr->bc_sub_type)
 	       {
 		case _SLANG_BCST_ERROR_BLOCK:
@@ -2782,37 +3888,37 @@ static int inner_interp (SLBlock_Type *addr_start)
 		  break;
 	       }
 	     if (Lang_Break_Condition) goto handle_break_condition;
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_RETURN:
+	   BC_CASE(_SLANG_BC_RETURN):
 	     Lang_Break_Condition = Lang_Return = Lang_Break = 1; return 1;
-	   case _SLANG_BC_BREAK:
+	   BC_CASE(_SLANG_BC_BREAK):
 	     Lang_Break_Condition = Lang_Break = 1; return 1;
-	   case _SLANG_BC_CONTINUE:
+	   BC_CASE(_SLANG_BC_CONTINUE):
 	     Lang_Break_Condition = /* Lang_Continue = */ 1; return 1;
 
-	   case _SLANG_BC_EXCH:
-	     (void) SLreverse_stack (2);
-	     break;
+	   BC_CASE(_SLANG_BC_EXCH):
+	     BC_DO_EXCH;
+	     BC_NEXT;
 
-	   case _SLANG_BC_LABEL:
+	   BC_CASE(_SLANG_BC_LABEL):
 	       {
 		  int test;
 		  if ((0 == SLang_pop_integer (&test))
 		      && (test == 0))
 		    return 0;
 	       }
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_LOBJPTR:
+	   BC_CASE(_SLANG_BC_LOBJPTR):
 	     (void)_SLang_push_ref (0, (VOID_STAR)(Local_Variable_Frame - addr->b.i_blk));
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_GOBJPTR:
+	   BC_CASE(_SLANG_BC_GOBJPTR):
 	     (void)_SLang_push_ref (1, (VOID_STAR)addr->b.nt_blk);
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_X_ERROR:
+	   BC_CASE(_SLANG_BC_X_ERROR):
 	     if (err_block != NULL)
 	       {
 		  inner_interp(err_block->b.blk);
@@ -2820,34 +3926,34 @@ static int inner_interp (SLBlock_Type *addr_start)
 	       }
 	     else SLang_verror(SL_SYNTAX_ERROR, "No ERROR_BLOCK");
 	     if (Lang_Break_Condition) goto handle_break_condition;
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_X_USER0:
-	   case _SLANG_BC_X_USER1:
-	   case _SLANG_BC_X_USER2:
-	   case _SLANG_BC_X_USER3:
-	   case _SLANG_BC_X_USER4:
+	   BC_CASE(_SLANG_BC_X_USER0):
+	   BC_CASE(_SLANG_BC_X_USER1):
+	   BC_CASE(_SLANG_BC_X_USER2):
+	   BC_CASE(_SLANG_BC_X_USER3):
+	   BC_CASE(_SLANG_BC_X_USER4):
 	     if (User_Block_Ptr[addr->bc_main_type - _SLANG_BC_X_USER0] != NULL)
 	       {
 		  inner_interp(User_Block_Ptr[addr->bc_main_type - _SLANG_BC_X_USER0]);
 	       }
 	     else SLang_verror(SL_SYNTAX_ERROR, "No block for X_USERBLOCK");
 	     if (Lang_Break_Condition) goto handle_break_condition;
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_CALL_DIRECT:
-	     (*addr->b.call_function) ();
-	     break;
+	   BC_CASE(_SLANG_BC_CALL_DIRECT):
+	     BC_DO_CALL_DIRECT;
+	     BC_NEXT;
 
-	   case _SLANG_BC_CALL_DIRECT_FRAME:
-	     do_bc_call_direct_frame (addr->b.call_function);
-	     break;
+	   BC_CASE(_SLANG_BC_CALL_DIRECT_FRAME):
+	     BC_DO_CALL_DIRECT_FRAME;
+	     BC_NEXT;
 
-	   case _SLANG_BC_UNARY:
-	     do_unary (addr->b.i_blk, _SLANG_BC_UNARY);
-	     break;
+	   BC_CASE(_SLANG_BC_UNARY):
+	     BC_DO_UNARY;
+	     BC_NEXT;
 	     
-	   case _SLANG_BC_UNARY_FUNC:
+	   BC_CASE(_SLANG_BC_UNARY_FUNC):
 	     /* Make sure we treat these like function calls since the
 	      * parser took abs(x) to be a function call.
 	      */
@@ -2856,247 +3962,174 @@ static int inner_interp (SLBlock_Type *addr_start)
 		  do_unary (addr->b.i_blk, _SLANG_BC_UNARY);
 		  (void) _SL_decrement_frame_pointer ();
 	       }
-	     break;
+	     BC_NEXT;
 	     
-	   case _SLANG_BC_DEREF_ASSIGN:
+	   BC_CASE(_SLANG_BC_DEREF_ASSIGN):
 	     set_deref_lvalue (addr);
-	     break;
-	   case _SLANG_BC_SET_LOCAL_LVALUE:
-	     set_lvalue_obj (addr->bc_sub_type, Local_Variable_Frame - addr->b.i_blk);
-	     break;
-	   case _SLANG_BC_SET_GLOBAL_LVALUE:
-	     if (-1 == set_lvalue_obj (addr->bc_sub_type, &addr->b.nt_gvar_blk->obj))
-	       do_name_type_error (addr->b.nt_blk);
-	     break;
-	   case _SLANG_BC_SET_INTRIN_LVALUE:
+	     BC_NEXT;
+	   BC_CASE(_SLANG_BC_SET_LOCAL_LVALUE):
+	     BC_DO_SET_LOCAL_LVALUE;
+	     BC_NEXT;
+	   BC_CASE(_SLANG_BC_SET_GLOBAL_LVALUE):
+	     BC_DO_SET_GLOBAL_LVALUE;
+	     BC_NEXT;
+	   BC_CASE(_SLANG_BC_SET_INTRIN_LVALUE):
 	     set_intrin_lvalue (addr);
-	     break;
-	   case _SLANG_BC_SET_STRUCT_LVALUE:
+	     BC_NEXT;
+	   BC_CASE(_SLANG_BC_SET_STRUCT_LVALUE):
 	     set_struct_lvalue (addr);
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_FIELD:
-	     (void) push_struct_field (addr->b.s_blk);
-	     break;
+	   BC_CASE(_SLANG_BC_FIELD):
+	     BC_DO_FIELD;
+	     BC_NEXT;
 
-	   case _SLANG_BC_SET_ARRAY_LVALUE:
+	   BC_CASE(_SLANG_BC_SET_ARRAY_LVALUE):
 	     set_array_lvalue (addr->bc_sub_type);
-	     break;
+	     BC_NEXT;
 
 #if _SLANG_HAS_DEBUG_CODE
-	   case _SLANG_BC_LINE_NUM:
-	     break;
+	   BC_CASE(_SLANG_BC_LINE_NUM):
+	     BC_NEXT;
 #endif
 	     
-	   case _SLANG_BC_TMP:
+	   BC_CASE(_SLANG_BC_TMP):
 	     tmp_variable_function (addr);
-	     break;
+	     BC_NEXT;
 
 #if _SLANG_OPTIMIZE_FOR_SPEED
-	   case _SLANG_BC_LVARIABLE_AGET:
-	     if (0 == push_local_variable (addr->b.i_blk))
-	       do_bc_call_direct_frame (_SLarray_aget);
-	     break;
-
-	   case _SLANG_BC_LVARIABLE_APUT:
-	     if (0 == push_local_variable (addr->b.i_blk))
-	       do_bc_call_direct_frame (_SLarray_aput);
-	     break;
-	   case _SLANG_BC_INTEGER_PLUS:
-	     if (0 == SLclass_push_int_obj (addr->bc_sub_type, (int) addr->b.l_blk))
-	       do_binary (SLANG_PLUS);
-	     break;
-
-	   case _SLANG_BC_INTEGER_MINUS:
-	     if (0 == SLclass_push_int_obj (addr->bc_sub_type, (int) addr->b.l_blk))
-	       do_binary (SLANG_MINUS);
-	     break;
+	   BC_CASE(_SLANG_BC_LVARIABLE_AGET):
+	     BC_DO_LVARIABLE_AGET;
+	     BC_NEXT;
+
+	   BC_CASE(_SLANG_BC_LVARIABLE_APUT):
+	     BC_DO_LVARIABLE_APUT;
+	     BC_NEXT;
+	   BC_CASE(_SLANG_BC_INTEGER_PLUS):
+	     BC_DO_INTEGER_PLUS;
+	     BC_NEXT;
+
+	   BC_CASE(_SLANG_BC_INTEGER_MINUS):
+	     BC_DO_INTEGER_MINUS;
+	     BC_NEXT;
 #endif
 #if 0
-	   case _SLANG_BC_ARG_LVARIABLE:
+	   BC_CASE(_SLANG_BC_ARG_LVARIABLE):
 	     (void) SLang_start_arg_list ();
 	     push_local_variable (addr->b.i_blk);
-	     break;
+	     BC_NEXT;
 #endif
-	   case _SLANG_BC_EARG_LVARIABLE:
-	     push_local_variable (addr->b.i_blk);
-	     (void) SLang_end_arg_list ();
-	     break;
+	   BC_CASE(_SLANG_BC_EARG_LVARIABLE):
+	     BC_DO_EARG_LVARIABLE;
+	     BC_NEXT;
 
 #if USE_COMBINED_BYTECODES
-	   case _SLANG_BC_CALL_DIRECT_INTRINSIC:
-	     (*addr->b.call_function) ();
-	     addr++;
-	     execute_intrinsic_fun (addr->b.nt_ifun_blk);
-	     if (SLang_Error)
-	       do_traceback(addr->b.nt_ifun_blk->name, 0, NULL);
-	     break;
+	   BC_CASE(_SLANG_BC_CALL_DIRECT_INTRINSIC):
+	     BC_DO_CALL_DIRECT_INTRINSIC;
+	     BC_NEXT;
 
-	   case _SLANG_BC_INTRINSIC_CALL_DIRECT:
+	   BC_CASE(_SLANG_BC_INTRINSIC_CALL_DIRECT):
 	     execute_intrinsic_fun (addr->b.nt_ifun_blk);
 	     if (SLang_Error)
 	       {
 		  do_traceback(addr->b.nt_ifun_blk->name, 0, NULL);
-		  break;
+		  BC_NEXT;
 	       }
 	     addr++;
 	     (*addr->b.call_function) ();
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_CALL_DIRECT_LSTR:
-	     (*addr->b.call_function) ();
-	     addr++;
-	     _SLang_dup_and_push_slstring (addr->b.s_blk);
-	     break;
+	   BC_CASE(_SLANG_BC_CALL_DIRECT_LSTR):
+	     BC_DO_CALL_DIRECT_LSTR;
+	     BC_NEXT;
 
-	   case _SLANG_BC_CALL_DIRECT_SLFUN:
+	   BC_CASE(_SLANG_BC_CALL_DIRECT_SLFUN):
 	     (*addr->b.call_function) ();
 	     addr++;
+	     if (addr->bc_sub_type == _SLANG_BCST_TAIL_CALL)
+	       {
+		  do_tail_call (addr->b.nt_fun_blk);
+		  return 1;
+	       }
 	     execute_slang_fun (addr->b.nt_fun_blk);
 	     if (Lang_Break_Condition) goto handle_break_condition;
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_CALL_DIRECT_INTRSTOP:
+	   BC_CASE(_SLANG_BC_CALL_DIRECT_INTRSTOP):
 	     (*addr->b.call_function) ();
 	     addr++;
 	     /* drop */
-	   case _SLANG_BC_INTRINSIC_STOP:
+	   BC_CASE(_SLANG_BC_INTRINSIC_STOP):
 	     execute_intrinsic_fun (addr->b.nt_ifun_blk);
 	     if (SLang_Error == 0)
 	       return 1;
 	     do_traceback(addr->b.nt_ifun_blk->name, 0, NULL);
-	     break;
+	     BC_NEXT;
 
-	   case _SLANG_BC_CALL_DIRECT_EARG_LVAR:
-	     (*addr->b.call_function) ();
-	     addr++;
-	     push_local_variable (addr->b.i_blk);
-	     (void) SLang_end_arg_list ();
-	     break;
+	   BC_CASE(_SLANG_BC_CALL_DIRECT_EARG_LVAR):
+	     BC_DO_CALL_DIRECT_EARG_LVAR;
+	     BC_NEXT;
 
-	   case _SLANG_BC_CALL_DIRECT_LINT:
-	     (*addr->b.call_function) ();
-	     addr++;
-	     SLclass_push_int_obj (addr->bc_sub_type, (int) addr->b.l_blk);
-	     break;
+	   BC_CASE(_SLANG_BC_CALL_DIRECT_LINT):
+	     BC_DO_CALL_DIRECT_LINT;
+	     BC_NEXT;
 
-	   case _SLANG_BC_CALL_DIRECT_LVAR:
-	     (*addr->b.call_function) ();
-	     addr++;
-	     push_local_variable (addr->b.i_blk);
-	     break;
+	   BC_CASE(_SLANG_BC_CALL_DIRECT_LVAR):
+	     BC_DO_CALL_DIRECT_LVAR;
+	     BC_NEXT;
 	     
-	   case _SLANG_BC_LLVARIABLE_BINARY:
-	     do_binary_ab_inc_ref (addr->b.i_blk, 
-			   Local_Variable_Frame - (addr+1)->b.i_blk,
-			   Local_Variable_Frame - (addr+2)->b.i_blk);
-	     addr += 2;
-	     break;
-	   case _SLANG_BC_LGVARIABLE_BINARY:
-	     do_binary_ab_inc_ref (addr->b.i_blk, 
-			   Local_Variable_Frame - (addr+1)->b.i_blk,
-			   &(addr+2)->b.nt_gvar_blk->obj);
-	     addr += 2;
-	     break;
-
-	   case _SLANG_BC_GLVARIABLE_BINARY:
-	     do_binary_ab_inc_ref (addr->b.i_blk, 
-			   &(addr+1)->b.nt_gvar_blk->obj,
-			   Local_Variable_Frame - (addr+2)->b.i_blk);
-	     addr += 2;
-	     break;
-	   case _SLANG_BC_GGVARIABLE_BINARY:
-	     do_binary_ab_inc_ref (addr->b.i_blk,
-			   &(addr+1)->b.nt_gvar_blk->obj,
-			   &(addr+2)->b.nt_gvar_blk->obj);
-	     addr += 2;
-	     break;
+	   BC_CASE(_SLANG_BC_LLVARIABLE_BINARY):
+	     BC_DO_LLVARIABLE_BINARY;
+	     BC_NEXT;
+	   BC_CASE(_SLANG_BC_LGVARIABLE_BINARY):
+	     BC_DO_LGVARIABLE_BINARY;
+	     BC_NEXT;
+
+	   BC_CASE(_SLANG_BC_GLVARIABLE_BINARY):
+	     BC_DO_GLVARIABLE_BINARY;
+	     BC_NEXT;
+	   BC_CASE(_SLANG_BC_GGVARIABLE_BINARY):
+	     BC_DO_GGVARIABLE_BINARY;
+	     BC_NEXT;
 	     
-	   case _SLANG_BC_LIVARIABLE_BINARY:
-	       {
-		  SLang_Object_Type o;
-		  o.data_type = SLANG_INT_TYPE;
-		  o.v.int_val = (int) (addr+2)->b.l_blk;
-
-		  do_binary_ab_inc_ref (addr->b.i_blk, 
-				Local_Variable_Frame - (addr+1)->b.i_blk,
-				&o);
-	       }
-	     addr += 2;
-	     break;
+	   BC_CASE(_SLANG_BC_LIVARIABLE_BINARY):
+	     BC_DO_LIVARIABLE_BINARY;
+	     BC_NEXT;
 #if SLANG_HAS_FLOAT
-	   case _SLANG_BC_LDVARIABLE_BINARY:
-	       {
-		  SLang_Object_Type o;
-		  o.data_type = SLANG_DOUBLE_TYPE;
-		  o.v.double_val = *(addr+2)->b.double_blk;
-
-		  do_binary_ab_inc_ref (addr->b.i_blk, 
-				Local_Variable_Frame - (addr+1)->b.i_blk,
-				&o);
-	       }
-	     addr += 2;
-	     break;
+	   BC_CASE(_SLANG_BC_LDVARIABLE_BINARY):
+	     BC_DO_LDVARIABLE_BINARY;
+	     BC_NEXT;
 #endif
-	   case _SLANG_BC_ILVARIABLE_BINARY:
-	       {
-		  SLang_Object_Type o;
-		  o.data_type = SLANG_INT_TYPE;
-		  o.v.int_val = (int) (addr+1)->b.l_blk;
-
-		  do_binary_ab_inc_ref (addr->b.i_blk, 
-				&o,
-				Local_Variable_Frame - (addr+2)->b.i_blk);
-	       }
-	     addr += 2;
-	     break;
+	   BC_CASE(_SLANG_BC_ILVARIABLE_BINARY):
+	     BC_DO_ILVARIABLE_BINARY;
+	     BC_NEXT;
 #if SLANG_HAS_FLOAT
-	   case _SLANG_BC_DLVARIABLE_BINARY:
-	       {
-		  SLang_Object_Type o;
-		  o.data_type = SLANG_DOUBLE_TYPE;
-		  o.v.double_val = *(addr+1)->b.double_blk;
-
-		  do_binary_ab_inc_ref (addr->b.i_blk, 
-				&o,
-				Local_Variable_Frame - (addr+2)->b.i_blk);
-	       }
-	     addr += 2;
-	     break;
+	   BC_CASE(_SLANG_BC_DLVARIABLE_BINARY):
+	     BC_DO_DLVARIABLE_BINARY;
+	     BC_NEXT;
 #endif
-	   case _SLANG_BC_LVARIABLE_BINARY:
-	     do_binary_b_inc_ref (addr->b.i_blk, 
-			  Local_Variable_Frame - (addr+1)->b.i_blk);
-	     addr++;
-	     break;
+	   BC_CASE(_SLANG_BC_LVARIABLE_BINARY):
+	     BC_DO_LVARIABLE_BINARY;
+	     BC_NEXT;
 
-	   case _SLANG_BC_GVARIABLE_BINARY:
-	     do_binary_b_inc_ref (addr->b.i_blk,
-			  &(addr+1)->b.nt_gvar_blk->obj);
-	     addr++;
-	     break;
+	   BC_CASE(_SLANG_BC_GVARIABLE_BINARY):
+	     BC_DO_GVARIABLE_BINARY;
+	     BC_NEXT;
 
-	   case _SLANG_BC_LITERAL_INT_BINARY:
-	       {
-		  SLang_Object_Type o;
-		  o.data_type = SLANG_INT_TYPE;
-		  o.v.int_val = (int) (addr+1)->b.l_blk;
-		  do_binary_b (addr->b.i_blk, &o);
-	       }
-	     addr++;
-	     break;
+	   BC_CASE(_SLANG_BC_LITERAL_INT_BINARY):
+	     BC_DO_LITERAL_INT_BINARY;
+	     BC_NEXT;
 #if SLANG_HAS_FLOAT
-	   case _SLANG_BC_LITERAL_DBL_BINARY:
-	       {
-		  SLang_Object_Type o;
-		  o.data_type = SLANG_DOUBLE_TYPE;
-		  o.v.double_val = *(addr+1)->b.double_blk;
-		  do_binary_b (addr->b.i_blk, &o);
-	       }
-	     addr++;
-	     break;
+	   BC_CASE(_SLANG_BC_LITERAL_DBL_BINARY):
+	     BC_DO_LITERAL_DBL_BINARY;
+	     BC_NEXT;
 #endif
 #endif				       /* USE_COMBINED_BYTECODES */
+#if USE_SUPER_BYTECODES
+# define SLSUPER_CASES
+# include "slsuper.inc"
+# undef SLSUPER_CASES
+#endif
 	   default:
 	     SLang_verror (SL_INTERNAL_ERROR, "Byte-Code 0x%X is not valid", addr->bc_main_type);
 	  }
@@ -3117,6 +4150,9 @@ static int inner_interp (SLBlock_Type *addr_start)
 	 *      else....
 	 *   }
 	 */
+#if BC_COMPUTED_GOTO || (USE_SUPER_BYTECODES && SLSUPER_NUM)
+	bc_error:
+#endif
 	if (SLang_Error)
 	  {
 	     if (-1 == do_inner_interp_error (err_block, addr_start, addr))
@@ -3159,12 +4195,18 @@ int (*SLang_Auto_Declare_Var_Hook) (char *);
 
 static SLang_NameSpace_Type *This_Static_NameSpace;
 static SLang_NameSpace_Type *Global_NameSpace;
+/* The Global namespace of the default context.  Other contexts find the
+ * intrinsics there.
+ */
+static SLang_NameSpace_Type *Intrinsic_NameSpace;
 
 #if _SLANG_HAS_DEBUG_CODE
 static char *This_Compile_Filename;
 #endif
 
 static int Lang_Defining_Function;
+/* Non-zero if the function being defined may not make tail calls */
+static int No_Tail_Calls;
 static void (*Default_Variable_Mode) (_SLang_Token_Type *);
 static void (*Default_Define_Function) (char *, unsigned long);
 static int setup_default_compile_linkage (int);
@@ -3207,6 +4249,12 @@ static int lang_free_branch (SLBlock_Type *p)
      {
 	SLang_Class_Type *cl;
 
+#if USE_SUPER_BYTECODES
+	/* The first byte-code of the sequence may own something */
+	if ((p->bc_main_type >= _SLANG_BC_SUPER_0)
+	    && (p->bc_main_type < _SLANG_BC_SUPER_0 + SLSUPER_NUM))
+	  p->bc_main_type = Super_Bytecodes[p->bc_main_type - _SLANG_BC_SUPER_0].bc[0];
+#endif
         switch (p->bc_main_type)
 	  {
 	   case _SLANG_BC_BLOCK:
@@ -3425,6 +4473,30 @@ static SLang_Name_Type *locate_name_in_table (char *name, unsigned long hash,
    return t;
 }
 
+static SLang_Name_Type *locate_global_name (char *name, unsigned long hash)
+{
+   SLang_Name_Type *t;
+
+   t = locate_name_in_table (name, hash, Global_NameSpace->table, Global_NameSpace->table_size);
+   if ((t != NULL) || (Global_NameSpace == Intrinsic_NameSpace))
+     return t;
+
+   t = locate_name_in_table (name, hash, Intrinsic_NameSpace->table, Intrinsic_NameSpace->table_size);
+   if (t == NULL)
+     return NULL;
+
+   switch (t->name_type)
+     {
+	/* The variables and functions of the default context are its own. */
+      case SLANG_GVARIABLE:
+      case SLANG_PVARIABLE:
+      case SLANG_FUNCTION:
+      case SLANG_PFUNCTION:
+	return NULL;
+     }
+   return t;
+}
+
 static SLang_Name_Type *locate_namespace_encoded_name (char *name, int err_on_bad_ns)
 {
    char *ns, *ns1;
@@ -3447,8 +4519,7 @@ static SLang_Name_Type *locate_namespace_encoded_name (char *name, int err_on_ba
      {
 	/* Use Global Namespace */
 	SLang_free_slstring (ns);
-	return locate_name_in_table (name, _SLcompute_string_hash (name),
-				     Global_NameSpace->table, Global_NameSpace->table_size);
+	return locate_global_name (name, _SLcompute_string_hash (name));
      }
 
    if (NULL == (table = _SLns_find_namespace (ns)))
@@ -3491,7 +4562,7 @@ static SLang_Name_Type *locate_hashed_name (char *name, unsigned long hash)
        && (NULL != (t = locate_name_in_table (name, hash, This_Static_NameSpace->table, This_Static_NameSpace->table_size))))
      return t;
 
-   t = locate_name_in_table (name, hash, Global_NameSpace->table, Global_NameSpace->table_size);
+   t = locate_global_name (name, hash);
    if (NULL != t)
      return t;
 
@@ -3562,6 +4633,15 @@ add_global_name (char *name, unsigned long hash,
 	return NULL;
      }
 
+   /* Nor may the intrinsics that a context shares with the default one */
+   if ((ns == Global_NameSpace)
+       && (NULL != (nt = locate_global_name (name, hash)))
+       && (nt->name_type != name_type))
+     {
+	SLang_verror (SL_DUPLICATE_DEFINITION, "%s cannot be re-defined", name);
+	return NULL;
+     }
+
    return add_name_to_hash_table (name, hash, sizeof_obj, name_type,
 				  table, table_size, 0);
 }
@@ -3747,8 +4827,7 @@ SLang_Name_Type *_SLlocate_global_name (char *name)
    unsigned long hash;
 
    hash = _SLcompute_string_hash (name);
-   return locate_name_in_table (name, hash, Global_NameSpace->table, 
-				Global_NameSpace->table_size);
+   return locate_global_name (name, hash);
 }
 
 /*}}}*/
@@ -3887,6 +4966,7 @@ static void lang_begin_function (void)
 	return;
      }
    Lang_Defining_Function = 1;
+   No_Tail_Calls = 0;
    (void) push_block_context (COMPILE_BLOCK_TYPE_FUNCTION);
 }
 
@@ -3917,7 +4997,7 @@ static void rearrange_optimized_unary (SLBlock_Type *b, unsigned char t1, unsign
    *(b-1) = tmp;
 }
 
-static void optimize_block (SLBlock_Type *b)
+static void combine_bytecodes (SLBlock_Type *b)
 {
    SLBlock_Type *bstart, *b1, *b2;
    SLtype b2_main_type;
@@ -4076,17 +5156,153 @@ static void optimize_block (SLBlock_Type *b)
 		  break;
 #endif
 
-		case 0:
-		  (b-1)->bc_main_type = _SLANG_BC_INTRINSIC_STOP;
-		  return;
-	       }	     
+		case 0:
+		  (b-1)->bc_main_type = _SLANG_BC_INTRINSIC_STOP;
+		  return;
+	       }	     
+	     break;
+	  }
+     }
+}
+
+
+#if USE_SUPER_BYTECODES
+/* Replace the first byte-code of each sequence in slsuper.inc by its
+ * superinstruction.  Sequences are tried in the order mksuper wrote
+ * them: the longer ones first, then by how many dispatches they save.
+ */
+static void fuse_super_bytecodes (SLBlock_Type *b)
+{
+   SLBlock_Type *b1;
+   unsigned int i, j;
+
+   if (Bytecode_Stats)
+     return;
+   init_bytecode_info ();
+
+   while (b->bc_main_type != 0)
+     {
+	if (0 == Bytecode_Starts_Super[b->bc_main_type])
+	  {
+	     b += Bytecode_Length[b->bc_main_type];
+	     continue;
+	  }
+	for (i = 0; i < SLSUPER_NUM; i++)
+	  {
+	     b1 = b;
+	     for (j = 0; j < Super_Bytecodes[i].num; j++)
+	       {
+		  if (b1->bc_main_type != Super_Bytecodes[i].bc[j])
+		    break;
+		  b1 += Bytecode_Length[b1->bc_main_type];
+	       }
+	     if (j == Super_Bytecodes[i].num)
+	       break;
+	  }
+	if (i < SLSUPER_NUM)
+	  {
+	     b->bc_main_type = _SLANG_BC_SUPER_0 + i;
+	     b = b1;
+	  }
+	else
+	  b += Bytecode_Length[b->bc_main_type];
+     }
+}
+#endif
+
+static void optimize_block (SLBlock_Type *b)
+{
+   combine_bytecodes (b);
+#if USE_SUPER_BYTECODES
+   fuse_super_bytecodes (b);
+#endif
+}
+
+#endif
+
+/*{{{ tail calls */
+
+/* A call to a S-Lang function that is followed by a return, or by the
+ * end of the body or of an if-else branch that ends the body, is in tail
+ * position.  Such a call is not made from within inner_interp: the
+ * caller returns, and its execute_slang_fun runs the callee in the same
+ * frame, so that recursion in tail position runs in constant stack.
+ * Calls in functions with an ERROR_BLOCK or EXIT_BLOCK are left alone,
+ * since those blocks must see what happens in the call, and so are calls
+ * in functions that take references to their local variables, since
+ * those go away with the frame.
+ */
+
+/* Whether the function returns once b is reached.  is_tail says whether
+ * the end of the block that b is in returns.  Line numbers from
+ * _debug_info do not count.
+ */
+static int returns_at (SLBlock_Type *b, int is_tail)
+{
+   while (b->bc_main_type == _SLANG_BC_LINE_NUM)
+     b++;
+   return ((b->bc_main_type == _SLANG_BC_RETURN)
+	   || (is_tail && (b->bc_main_type == 0)));
+}
+
+static void mark_tail_calls (SLBlock_Type *b, int is_tail)
+{
+   SLBlock_Type *call, *next;
+   int tail;
+
+   init_bytecode_info ();
+
+   while (b->bc_main_type != 0)
+     {
+	next = b + Bytecode_Length[b->bc_main_type];
+	call = NULL;
+
+	switch (b->bc_main_type)
+	  {
+	   case _SLANG_BC_BLOCK:
+	     if (b->b.blk == NULL)
+	       break;
+	     switch (b->bc_sub_type)
+	       {
+		case 0:
+		  /* The first branch of an if-else */
+		  tail = ((next->bc_main_type == _SLANG_BC_BLOCK)
+			  && ((next->bc_sub_type == _SLANG_BCST_ELSE)
+			      || (next->bc_sub_type == _SLANG_BCST_NOTELSE))
+			  && returns_at (next + 1, is_tail));
+		  break;
+
+		case _SLANG_BCST_IF:
+		case _SLANG_BCST_IFNOT:
+		case _SLANG_BCST_ELSE:
+		case _SLANG_BCST_NOTELSE:
+		  tail = returns_at (next, is_tail);
+		  break;
+
+		default:
+		  tail = 0;
+	       }
+	     mark_tail_calls (b->b.blk, tail);
+	     break;
+
+	   case _SLANG_BC_FUNCTION:
+	   case _SLANG_BC_PFUNCTION:
+	     call = b;
+	     break;
+
+	   case _SLANG_BC_CALL_DIRECT_SLFUN:
+	     call = b + 1;
 	     break;
 	  }
+
+	if ((call != NULL) && returns_at (next, is_tail))
+	  call->bc_sub_type = _SLANG_BCST_TAIL_CALL;
+
+	b = next;
      }
 }
 
-#endif
-
+/*}}}*/
 
 /* name will be NULL if the object is to simply terminate the function
  * definition.  See SLang_restart.
@@ -4116,6 +5332,8 @@ static int lang_define_function (char *name, unsigned char type, unsigned long h
 #if USE_COMBINED_BYTECODES
 	     optimize_block (h->body);
 #endif
+	     if (No_Tail_Calls == 0)
+	       mark_tail_calls (h->body, 1);
 
 	     if (-1 == add_slang_function (name, type, hash,
 					   Function_Args_Number,
@@ -4210,7 +5428,8 @@ static int lang_begin_block (void)
    return push_block_context (COMPILE_BLOCK_TYPE_BLOCK);
 }
 
-static int lang_check_space (void)
+/* Make room for num more byte-codes */
+static int lang_check_space_n (unsigned int num)
 {
    unsigned int n;
    SLBlock_Type *p;
@@ -4222,10 +5441,10 @@ static int lang_check_space (void)
      }
 
    /* Allow 1 extra for terminator */
-   if (Compile_ByteCode_Ptr + 1 < This_Compile_Block_Max)
+   if (Compile_ByteCode_Ptr + num < This_Compile_Block_Max)
      return 0;
 
-   n = (unsigned int) (This_Compile_Block_Max - p);
+   n = (unsigned int) (Compile_ByteCode_Ptr - p) + num;
 
    /* enlarge the space by 2 objects */
    n += 2;
@@ -4241,6 +5460,11 @@ static int lang_check_space (void)
    return 0;
 }
 
+static int lang_check_space (void)
+{
+   return lang_check_space_n (1);
+}
+
 /* returns positive number if name is a function or negative number if it
  is a variable.  If it is intrinsic, it returns magnitude of 1, else 2 */
 int SLang_is_defined(char *name)
@@ -4390,7 +5614,9 @@ void SLang_restart (int localv)
    if (localv)
      {
 	Next_Function_Num_Args = SLang_Num_Function_Args = 0;
-	Local_Variable_Frame = Local_Variable_Stack;
+	Local_Stack_Chunk = 0;
+	Local_Variable_Frame = Local_Stack_Chunks[0].objs;
+	Local_Variable_Max = Local_Stack_Chunks[0].objs + Local_Stack_Chunks[0].len;
 	Recursion_Depth = 0;
 	Frame_Pointer = _SLStack_Pointer;
 	Frame_Pointer_Depth = 0;
@@ -4404,6 +5630,286 @@ void SLang_restart (int localv)
      }
 }
 
+#if _SLANG_OPTIMIZE_FOR_SPEED
+/*{{{ constant folding */
+
+/* Binary operations on literals and intrinsic constants are done as
+ * they are compiled, and so are if-else statements on a literal
+ * condition: the branch that cannot run is dropped and the other one
+ * takes the place of the statement.  This only happens in functions
+ * and blocks, since at top-level lang_try_now has already run the
+ * operands.  Byte-compiled files get the same treatment when they are
+ * loaded.
+ */
+
+/* The value of b if it is a literal or constant that can be folded */
+static int get_constant_bytecode (SLBlock_Type *b, SLang_Object_Type *obj)
+{
+   if (b < This_Compile_Block)
+     return -1;
+
+   switch (b->bc_main_type)
+     {
+      case _SLANG_BC_LITERAL_INT:
+	if (b->bc_sub_type != SLANG_INT_TYPE)
+	  return -1;
+	obj->v.int_val = (int) b->b.l_blk;
+	obj->data_type = SLANG_INT_TYPE;
+	return 0;
+
+      case _SLANG_BC_ICONST:
+	obj->v.int_val = b->b.iconst_blk->i;
+	obj->data_type = SLANG_INT_TYPE;
+	return 0;
+
+#if SLANG_HAS_FLOAT
+      case _SLANG_BC_LITERAL_DBL:
+	if (b->bc_sub_type != SLANG_DOUBLE_TYPE)
+	  return -1;
+	obj->v.double_val = *b->b.double_blk;
+	obj->data_type = SLANG_DOUBLE_TYPE;
+	return 0;
+
+      case _SLANG_BC_DCONST:
+	obj->v.double_val = b->b.dconst_blk->d;
+	obj->data_type = SLANG_DOUBLE_TYPE;
+	return 0;
+#endif
+
+      case _SLANG_BC_LITERAL_STR:
+	obj->v.s_val = b->b.s_blk;
+	obj->data_type = SLANG_STRING_TYPE;
+	return 0;
+     }
+   return -1;
+}
+
+static void free_constant_bytecode (SLBlock_Type *b)
+{
+   SLang_Class_Type *cl;
+
+   if ((b->bc_main_type == _SLANG_BC_LITERAL_DBL)
+       || (b->bc_main_type == _SLANG_BC_LITERAL_STR))
+     {
+	cl = _SLclass_get_class (b->bc_sub_type);
+	(*cl->cl_byte_code_destroy) (b->bc_sub_type, (VOID_STAR) &b->b.ptr_blk);
+     }
+}
+
+/* If the two byte-codes before this binary operation are constants,
+ * replace them by the result.  Anything that fails, like a division by
+ * zero, is left for run-time to report.
+ */
+static int fold_constant_binary (int op)
+{
+   SLang_Object_Type a, b, c;
+   SLBlock_Type *bc;
+#if SLANG_HAS_FLOAT
+   double *d = NULL;
+#endif
+
+   if (SLang_Error
+       || (This_Compile_Block_Type == COMPILE_BLOCK_TYPE_TOP_LEVEL)
+       || (-1 == get_constant_bytecode (Compile_ByteCode_Ptr - 2, &a))
+       || (-1 == get_constant_bytecode (Compile_ByteCode_Ptr - 1, &b)))
+     return -1;
+
+   if ((a.data_type == SLANG_STRING_TYPE) || (b.data_type == SLANG_STRING_TYPE))
+     {
+	if ((a.data_type != b.data_type) || (op != SLANG_PLUS))
+	  return -1;
+	if (NULL == (c.v.s_val = SLang_concat_slstrings (a.v.s_val, b.v.s_val)))
+	  return -1;
+	c.data_type = SLANG_STRING_TYPE;
+     }
+   else
+     {
+	if (0 != _SLarith_bin_op (&a, &b, op))
+	  {
+	     SLang_Error = 0;
+	     return -1;
+	  }
+	if (-1 == SLang_pop (&c))
+	  return -1;
+     }
+
+   switch (c.data_type)
+     {
+      case SLANG_INT_TYPE:
+      case SLANG_CHAR_TYPE:
+      case SLANG_STRING_TYPE:
+	break;
+#if SLANG_HAS_FLOAT
+      case SLANG_DOUBLE_TYPE:
+	if (NULL == (d = (double *) SLmalloc (sizeof (double))))
+	  return -1;
+	*d = c.v.double_val;
+	break;
+#endif
+      default:
+	SLang_free_object (&c);
+	return -1;
+     }
+
+   bc = Compile_ByteCode_Ptr - 2;
+   free_constant_bytecode (bc);
+   free_constant_bytecode (bc + 1);
+
+   bc->bc_sub_type = c.data_type;
+   switch (c.data_type)
+     {
+      case SLANG_INT_TYPE:
+	bc->bc_main_type = _SLANG_BC_LITERAL_INT;
+	bc->b.l_blk = c.v.int_val;
+	break;
+      case SLANG_CHAR_TYPE:
+	/* as a CHAR_TOKEN would be compiled */
+	bc->bc_main_type = _SLANG_BC_LITERAL;
+	bc->b.l_blk = c.v.char_val;
+	break;
+#if SLANG_HAS_FLOAT
+      case SLANG_DOUBLE_TYPE:
+	bc->bc_main_type = _SLANG_BC_LITERAL_DBL;
+	bc->b.double_blk = d;
+	break;
+#endif
+      case SLANG_STRING_TYPE:
+	bc->bc_main_type = _SLANG_BC_LITERAL_STR;
+	bc->b.s_blk = c.v.s_val;
+	break;
+     }
+
+   Compile_ByteCode_Ptr = bc;
+   lang_try_now ();
+   return 0;
+}
+
+/* Whether the byte-codes of blk can run in the enclosing block instead
+ * of a block of their own.
+ */
+static int is_inlinable_branch (SLBlock_Type *blk)
+{
+   for (; blk->bc_main_type != 0; blk++)
+     {
+	if ((blk->bc_main_type == _SLANG_BC_X_ERROR)
+	    || ((blk->bc_main_type == _SLANG_BC_BLOCK)
+		&& (blk->bc_sub_type == _SLANG_BCST_ERROR_BLOCK)))
+	  return 0;
+     }
+   return 1;
+}
+
+/* Put the byte-codes of blk where Compile_ByteCode_Ptr is */
+static int inline_constant_branch (SLBlock_Type *blk)
+{
+   SLBlock_Type *b;
+   unsigned int n;
+
+   for (b = blk; b->bc_main_type != 0; b++)
+     ;
+   n = (unsigned int) (b - blk);
+   if (-1 == lang_check_space_n (n + 1))
+     {
+	if (lang_free_branch (blk))
+	  SLfree ((char *) blk);
+	return -1;
+     }
+
+   memcpy ((char *) Compile_ByteCode_Ptr, (char *) blk, n * sizeof (SLBlock_Type));
+   for (b = Compile_ByteCode_Ptr; n; n--, b++)
+     {
+	/* The end of blk is not the end any more */
+	if (b->bc_main_type == _SLANG_BC_INTRINSIC_STOP)
+	  b->bc_main_type = _SLANG_BC_INTRINSIC;
+	else if (b->bc_main_type == _SLANG_BC_CALL_DIRECT_INTRSTOP)
+	  b->bc_main_type = _SLANG_BC_CALL_DIRECT_INTRINSIC;
+     }
+   Compile_ByteCode_Ptr = b;
+
+   /* The byte-codes belong to this block now, so only blk itself goes */
+   if ((blk != SLShort_Blocks)
+       && (blk != SLShort_Blocks + 2)
+       && (blk != SLShort_Blocks + 4))
+     SLfree ((char *) blk);
+   return 0;
+}
+
+/* Compile_ByteCode_Ptr is at the last block of an if, !if, else or
+ * !else.  If the condition is constant, replace the whole statement by
+ * the branch it takes, if any.
+ */
+static int fold_constant_branch (void)
+{
+   SLBlock_Type *last, *first, *b, *live, *live_blk;
+   SLang_Object_Type obj;
+
+   if (This_Compile_Block_Type == COMPILE_BLOCK_TYPE_TOP_LEVEL)
+     return -1;
+
+   last = first = Compile_ByteCode_Ptr;
+   switch (last->bc_sub_type)
+     {
+      case _SLANG_BCST_IF:
+      case _SLANG_BCST_IFNOT:
+	break;
+
+      case _SLANG_BCST_ELSE:
+      case _SLANG_BCST_NOTELSE:
+	first = last - 1;
+	if ((first < This_Compile_Block)
+	    || (first->bc_main_type != _SLANG_BC_BLOCK)
+	    || (first->bc_sub_type != 0))
+	  return -1;
+	break;
+
+      default:
+	return -1;
+     }
+
+   if ((-1 == get_constant_bytecode (first - 1, &obj))
+       || (obj.data_type != SLANG_INT_TYPE))
+     return -1;
+
+   switch (last->bc_sub_type)
+     {
+      case _SLANG_BCST_IF:
+	live = obj.v.int_val ? last : NULL;
+	break;
+      case _SLANG_BCST_IFNOT:
+	live = obj.v.int_val ? NULL : last;
+	break;
+      case _SLANG_BCST_ELSE:
+	live = obj.v.int_val ? first : last;
+	break;
+      default:			       /* _SLANG_BCST_NOTELSE */
+	live = obj.v.int_val ? last : first;
+	break;
+     }
+
+   live_blk = NULL;
+   if (live != NULL)
+     {
+	live_blk = live->b.blk;
+	if (0 == is_inlinable_branch (live_blk))
+	  return -1;
+     }
+
+   for (b = first; b <= last; b++)
+     {
+	if ((b != live) && lang_free_branch (b->b.blk))
+	  SLfree ((char *) b->b.blk);
+     }
+
+   /* The condition owns nothing */
+   Compile_ByteCode_Ptr = first - 1;
+   if (live_blk != NULL)
+     (void) inline_constant_branch (live_blk);
+   return 0;
+}
+
+/*}}}*/
+#endif				       /* _SLANG_OPTIMIZE_FOR_SPEED */
+
 static void compile_directive (unsigned char sub_type)
 {
    /* This function is called only from compile_directive_mode which is
@@ -4414,6 +5920,10 @@ static void compile_directive (unsigned char sub_type)
    Compile_ByteCode_Ptr--;
    Compile_ByteCode_Ptr->bc_sub_type = sub_type;
 
+#if _SLANG_OPTIMIZE_FOR_SPEED
+   if (0 == fold_constant_branch ())
+     return;
+#endif
    lang_try_now ();
 }
 
@@ -4429,9 +5939,14 @@ static void compile_unary (int op, unsigned char mt)
 
 static void compile_binary (int op)
 {
+#if _SLANG_OPTIMIZE_FOR_SPEED
+   if (0 == fold_constant_binary (op))
+     return;
+#endif
    Compile_ByteCode_Ptr->bc_main_type = _SLANG_BC_BINARY;
    Compile_ByteCode_Ptr->b.i_blk = op;
    Compile_ByteCode_Ptr->bc_sub_type = 0;
+   Compile_ByteCode_Ptr->bc_cache = 0;
 
    lang_try_now ();
 }
@@ -4565,6 +6080,7 @@ static void compile_hashed_identifier (char *name, unsigned long hash, _SLang_To
 
    name_type = entry->name_type;
    Compile_ByteCode_Ptr->bc_main_type = name_type;
+   Compile_ByteCode_Ptr->bc_sub_type = 0;
 
    if (name_type == SLANG_LVARIABLE)   /* == _SLANG_BC_LVARIABLE */
      Compile_ByteCode_Ptr->b.i_blk = ((SLang_Local_Var_Type *) entry)->local_var_number;
@@ -4845,6 +6361,7 @@ compile_struct_assign (_SLang_Token_Type *t)
 {
    Compile_ByteCode_Ptr->bc_sub_type = _SLANG_BCST_ASSIGN + (t->type - _STRUCT_ASSIGN_TOKEN);
    Compile_ByteCode_Ptr->bc_main_type = _SLANG_BC_SET_STRUCT_LVALUE;
+   Compile_ByteCode_Ptr->bc_cache = 0;
    Compile_ByteCode_Ptr->b.s_blk = _SLstring_dup_hashed_string (t->v.s_val, t->hash);
    lang_try_now ();
 }
@@ -4861,6 +6378,7 @@ compile_array_assign (_SLang_Token_Type *t)
 static void compile_dot(_SLang_Token_Type *t)
 {
    Compile_ByteCode_Ptr->bc_main_type = _SLANG_BC_FIELD;
+   Compile_ByteCode_Ptr->bc_cache = 0;
    Compile_ByteCode_Ptr->b.s_blk = _SLstring_dup_hashed_string(t->v.s_val, t->hash);
    lang_try_now ();
 }
@@ -4881,6 +6399,7 @@ static void compile_ref (char *name, unsigned long hash)
    if (main_type == SLANG_LVARIABLE)
      {
 	main_type = _SLANG_BC_LOBJPTR;
+	No_Tail_Calls = 1;
 	Compile_ByteCode_Ptr->b.i_blk = ((SLang_Local_Var_Type *)entry)->local_var_number;
      }
    else
@@ -5045,6 +6564,7 @@ static void compile_directive_mode (_SLang_Token_Type *t)
 	     break;
 	  }
 	bc_sub_type = _SLANG_BCST_EXIT_BLOCK;
+	No_Tail_Calls = 1;
 	break;
 
       case ERRBLK_TOKEN:
@@ -5055,6 +6575,7 @@ static void compile_directive_mode (_SLang_Token_Type *t)
 	  }
 	if (0 == check_error_block ())
 	  bc_sub_type = _SLANG_BCST_ERROR_BLOCK;
+	No_Tail_Calls = 1;
 	break;
 
       case USRBLK0_TOKEN:
@@ -5708,34 +7229,45 @@ static int init_interpreter (void)
      return -1;
    if (-1 == _SLns_set_namespace_name (ns, "Global"))
      return -1;
-   Global_NameSpace = ns;
+   Global_NameSpace = Intrinsic_NameSpace = ns;
 
-   _SLRun_Stack = (SLang_Object_Type *) SLcalloc (SLANG_MAX_STACK_LEN,
+   _SLRun_Stack = (SLang_Object_Type *) SLcalloc (SLANG_INITIAL_STACK_LEN,
 						  sizeof (SLang_Object_Type));
    if (_SLRun_Stack == NULL)
      return -1;
 
+   Run_Stack_Len = SLANG_INITIAL_STACK_LEN;
    _SLStack_Pointer = _SLRun_Stack;
-   _SLStack_Pointer_Max = _SLRun_Stack + SLANG_MAX_STACK_LEN;
+   _SLStack_Pointer_Max = _SLRun_Stack + SLANG_INITIAL_STACK_LEN;
 
    SLShort_Blocks[SHORT_BLOCK_RETURN_INDX].bc_main_type = _SLANG_BC_RETURN;
    SLShort_Blocks[SHORT_BLOCK_BREAK_INDX].bc_main_type = _SLANG_BC_BREAK;
    SLShort_Blocks[SHORT_BLOCK_CONTINUE_INDX].bc_main_type = _SLANG_BC_CONTINUE;
 
-   Num_Args_Stack = (int *) SLmalloc (sizeof (int) * SLANG_MAX_RECURSIVE_DEPTH);
+   Num_Args_Stack = (int *) SLmalloc (sizeof (int) * SLANG_INITIAL_RECURSIVE_DEPTH);
    if (Num_Args_Stack == NULL)
      {
 	SLfree ((char *) _SLRun_Stack);
 	return -1;
      }
    Recursion_Depth = 0;
-   Frame_Pointer_Stack = (unsigned int *) SLmalloc (sizeof (unsigned int) * SLANG_MAX_RECURSIVE_DEPTH);
+   Frame_Pointer_Stack = (unsigned int *) SLmalloc (sizeof (unsigned int) * SLANG_INITIAL_RECURSIVE_DEPTH);
    if (Frame_Pointer_Stack == NULL)
      {
 	SLfree ((char *) _SLRun_Stack);
 	SLfree ((char *)Num_Args_Stack);
 	return -1;
      }
+   Function_Name_Stack = (char **) SLmalloc (sizeof (char *) * SLANG_INITIAL_RECURSIVE_DEPTH);
+   if (Function_Name_Stack == NULL)
+     {
+	SLfree ((char *) _SLRun_Stack);
+	SLfree ((char *)Num_Args_Stack);
+	SLfree ((char *)Frame_Pointer_Stack);
+	return -1;
+     }
+   Recursion_Stack_Len = SLANG_INITIAL_RECURSIVE_DEPTH;
+   Frame_Pointer_Stack_Len = SLANG_INITIAL_RECURSIVE_DEPTH;
    Frame_Pointer_Depth = 0;
    Frame_Pointer = _SLRun_Stack;
 
@@ -5743,6 +7275,282 @@ static int init_interpreter (void)
    return 0;
 }
 
+/*{{{ interpreter contexts */
+
+/* A context is a set of the stacks above, an error state, a string table
+ * and a list of namespaces with a Global namespace of its own.  The one
+ * in use lives in the static variables; the others are kept here.
+ * Contexts are switched at top level only, when the stacks hold no
+ * frames and nothing is being compiled.
+ */
+struct _SLang_Context_Type
+{
+   SLang_Object_Type *run_stack;
+   SLang_Object_Type *stack_pointer;
+   unsigned int run_stack_len;
+   SLang_Object_Type *frame_pointer;
+   int *num_args_stack;
+   char **function_name_stack;
+   unsigned int recursion_stack_len;
+   unsigned int *frame_pointer_stack;
+   unsigned int frame_pointer_stack_len;
+   Local_Stack_Chunk_Type local_stack_chunks[MAX_LOCAL_STACK_CHUNKS];
+   unsigned int local_stack_size;
+   int stacks_have_grown;
+   int error;
+   _SLstring_Table_Type *strings;      /* NULL for the default table */
+   SLang_NameSpace_Type *namespaces;
+   SLang_NameSpace_Type *global_namespace;
+   SLang_NameSpace_Type *static_namespace;
+};
+
+static SLang_Context_Type Default_Context;
+static SLang_Context_Type *Current_Context = &Default_Context;
+
+static void save_context (SLang_Context_Type *c)
+{
+   c->run_stack = _SLRun_Stack;
+   c->stack_pointer = _SLStack_Pointer;
+   c->run_stack_len = Run_Stack_Len;
+   c->frame_pointer = Frame_Pointer;
+   c->num_args_stack = Num_Args_Stack;
+   c->function_name_stack = Function_Name_Stack;
+   c->recursion_stack_len = Recursion_Stack_Len;
+   c->frame_pointer_stack = Frame_Pointer_Stack;
+   c->frame_pointer_stack_len = Frame_Pointer_Stack_Len;
+   memcpy ((char *) c->local_stack_chunks, (char *) Local_Stack_Chunks, sizeof (Local_Stack_Chunks));
+   c->local_stack_size = Local_Stack_Size;
+   c->stacks_have_grown = Stacks_Have_Grown;
+   c->error = SLang_Error;
+   c->global_namespace = Global_NameSpace;
+   c->static_namespace = This_Static_NameSpace;
+   c->namespaces = _SLns_switch_namespace_list (NULL);
+   (void) _SLstring_switch_table (NULL);
+}
+
+static void restore_context (SLang_Context_Type *c)
+{
+   _SLRun_Stack = c->run_stack;
+   _SLStack_Pointer = c->stack_pointer;
+   _SLStack_Pointer_Max = c->run_stack + c->run_stack_len;
+   Run_Stack_Len = c->run_stack_len;
+   Frame_Pointer = c->frame_pointer;
+   Num_Args_Stack = c->num_args_stack;
+   Function_Name_Stack = c->function_name_stack;
+   Recursion_Stack_Len = c->recursion_stack_len;
+   Frame_Pointer_Stack = c->frame_pointer_stack;
+   Frame_Pointer_Stack_Len = c->frame_pointer_stack_len;
+   memcpy ((char *) Local_Stack_Chunks, (char *) c->local_stack_chunks, sizeof (Local_Stack_Chunks));
+   Local_Stack_Size = c->local_stack_size;
+   Local_Variable_Frame = Local_Stack_Chunks[0].objs;
+   Local_Variable_Max = Local_Stack_Chunks[0].objs + Local_Stack_Chunks[0].len;
+   Stacks_Have_Grown = c->stacks_have_grown;
+   SLang_Error = c->error;
+   (void) _SLstring_switch_table (c->strings);
+   (void) _SLns_switch_namespace_list (c->namespaces);
+   Global_NameSpace = c->global_namespace;
+   This_Static_NameSpace = c->static_namespace;
+}
+
+static void free_context_stacks (SLang_Context_Type *c)
+{
+   SLang_Object_Type *obj;
+   unsigned int k;
+
+   if (c->run_stack != NULL)
+     {
+	for (obj = c->run_stack; obj < c->stack_pointer; obj++)
+	  SLang_free_object (obj);
+	SLfree ((char *) c->run_stack);
+     }
+   SLfree ((char *) c->num_args_stack);
+   SLfree ((char *) c->function_name_stack);
+   SLfree ((char *) c->frame_pointer_stack);
+   for (k = 0; k < MAX_LOCAL_STACK_CHUNKS; k++)
+     SLfree ((char *) c->local_stack_chunks[k].objs);
+}
+
+/* Free the variables and functions of the namespaces in the current
+ * list, and the namespaces themselves.  Intrinsics that the application
+ * added to them are not freed since their tables may be static.
+ */
+static void free_namespaces (void)
+{
+   SLang_NameSpace_Type *ns, *next;
+   SLang_Name_Type *t, *tnext, **table;
+   unsigned int i;
+
+   ns = _SLns_switch_namespace_list (NULL);
+   while (ns != NULL)
+     {
+	next = ns->next;
+	table = ns->table;
+	for (i = 0; i < ns->table_size; i++)
+	  {
+	     for (t = table[i]; t != NULL; t = tnext)
+	       {
+		  _SLang_Function_Type *f;
+
+		  tnext = t->next;
+		  switch (t->name_type)
+		    {
+		     case SLANG_GVARIABLE:
+		     case SLANG_PVARIABLE:
+		       SLang_free_object (&((SLang_Global_Var_Type *) t)->obj);
+		       break;
+
+		     case SLANG_FUNCTION:
+		     case SLANG_PFUNCTION:
+		       f = (_SLang_Function_Type *) t;
+		       if (f->v.header != NULL)
+			 {
+			    if (f->nlocals == AUTOLOAD_NUM_LOCALS)
+			      SLang_free_slstring ((char *) f->v.autoload_filename);
+			    else
+			      free_function_header (f->v.header);
+			 }
+#if _SLANG_HAS_DEBUG_CODE
+		       SLang_free_slstring (f->file);
+#endif
+		       break;
+
+		     default:
+		       continue;
+		    }
+		  SLang_free_slstring (t->name);
+		  SLfree ((char *) t);
+	       }
+	  }
+	SLfree ((char *) table);
+	SLang_free_slstring (ns->name);
+	SLang_free_slstring (ns->namespace_name);
+	SLfree ((char *) ns);
+	ns = next;
+     }
+}
+
+SLang_Context_Type *SLang_create_context (void)
+{
+   SLang_Context_Type *c;
+   SLang_NameSpace_Type *ns, *save_ns;
+   _SLstring_Table_Type *save_strings;
+
+   if (-1 == init_interpreter ())
+     return NULL;
+
+   c = (SLang_Context_Type *) SLcalloc (1, sizeof (SLang_Context_Type));
+   if (c == NULL)
+     return NULL;
+
+   c->run_stack_len = SLANG_INITIAL_STACK_LEN;
+   c->recursion_stack_len = SLANG_INITIAL_RECURSIVE_DEPTH;
+   c->frame_pointer_stack_len = SLANG_INITIAL_RECURSIVE_DEPTH;
+   c->local_stack_size = SLANG_INITIAL_LOCAL_STACK;
+   c->local_stack_chunks[0].len = SLANG_INITIAL_LOCAL_STACK;
+
+   if ((NULL == (c->run_stack = (SLang_Object_Type *) SLcalloc (SLANG_INITIAL_STACK_LEN, sizeof (SLang_Object_Type))))
+       || (NULL == (c->num_args_stack = (int *) SLmalloc (sizeof (int) * SLANG_INITIAL_RECURSIVE_DEPTH)))
+       || (NULL == (c->function_name_stack = (char **) SLmalloc (sizeof (char *) * SLANG_INITIAL_RECURSIVE_DEPTH)))
+       || (NULL == (c->frame_pointer_stack = (unsigned int *) SLmalloc (sizeof (unsigned int) * SLANG_INITIAL_RECURSIVE_DEPTH)))
+       || (NULL == (c->local_stack_chunks[0].objs = (SLang_Object_Type *) SLmalloc (sizeof (SLang_Object_Type) * SLANG_INITIAL_LOCAL_STACK)))
+       || (NULL == (c->strings = _SLstring_new_table ())))
+     {
+	free_context_stacks (c);
+	SLfree ((char *) c);
+	return NULL;
+     }
+   c->stack_pointer = c->frame_pointer = c->run_stack;
+
+   /* The Global namespace of the context is made in its own string table
+    * and namespace list.
+    */
+   save_strings = _SLstring_switch_table (c->strings);
+   save_ns = _SLns_switch_namespace_list (NULL);
+   if ((NULL == (ns = _SLns_allocate_namespace ("***GLOBAL***", SLGLOBALS_HASH_TABLE_SIZE)))
+       || (-1 == _SLns_set_namespace_name (ns, "Global")))
+     {
+	free_namespaces ();
+	(void) _SLns_switch_namespace_list (save_ns);
+	(void) _SLstring_switch_table (save_strings);
+	_SLstring_free_table (c->strings);
+	free_context_stacks (c);
+	SLfree ((char *) c);
+	return NULL;
+     }
+   c->namespaces = _SLns_switch_namespace_list (save_ns);
+   (void) _SLstring_switch_table (save_strings);
+   c->global_namespace = ns;
+   return c;
+}
+
+static int context_switch_ok (void)
+{
+   if ((Recursion_Depth != 0) || (Frame_Pointer_Depth != 0)
+       || (Local_Stack_Chunk != 0) || (Compile_Context_Stack != NULL))
+     {
+	SLang_verror (SL_APPLICATION_ERROR, "Contexts may only be switched at top level");
+	return 0;
+     }
+   return 1;
+}
+
+/* Make c the context that the interpreter runs in, or the default one if
+ * c is NULL.  The context that was in use is returned, or NULL upon error.
+ */
+SLang_Context_Type *SLang_switch_context (SLang_Context_Type *c)
+{
+   SLang_Context_Type *old;
+
+   if (c == NULL)
+     c = &Default_Context;
+
+   old = Current_Context;
+   if (c == old)
+     return old;
+
+   if ((0 == context_switch_ok ())
+       || (-1 == init_interpreter ()))
+     return NULL;
+
+   save_context (old);
+   restore_context (c);
+   Current_Context = c;
+   return old;
+}
+
+void SLang_free_context (SLang_Context_Type *c)
+{
+   SLang_Context_Type *old;
+
+   if ((c == NULL) || (c == &Default_Context))
+     return;
+
+   if (c == Current_Context)
+     {
+	SLang_verror (SL_APPLICATION_ERROR, "The context in use may not be freed");
+	return;
+     }
+
+   if (0 == context_switch_ok ())
+     return;
+
+   /* The objects of the context are freed in the context itself, so that
+    * their strings come out of its table.
+    */
+   old = Current_Context;
+   save_context (old);
+   restore_context (c);
+   free_context_stacks (c);
+   free_namespaces ();
+   save_context (c);
+   restore_context (old);
+
+   _SLstring_free_table (c->strings);
+   SLfree ((char *) c);
+}
+
+/*}}}*/
+
 static int add_generic_table (SLang_NameSpace_Type *ns,
 			      SLang_Name_Type *table, char *pp_name,
 			      unsigned int entry_len)
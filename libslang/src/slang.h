@@ -340,6 +340,48 @@ extern int (*SLang_Auto_Declare_Var_Hook) (char *);
 
 extern int SLang_generate_debug_info (int);
 
+/* The run-time, function call and local variable stacks grow as needed,
+ * and give back what they took when the outermost function returns.
+ * These are the limits at which they overflow.  The default recursion
+ * depth suits a C stack of a few megabytes; raise it only when the
+ * interpreter runs on a larger one.
+ */
+extern unsigned int SLang_Max_Stack_Len;
+extern unsigned int SLang_Max_Recursion_Depth;
+extern unsigned int SLang_Max_Local_Stack;
+
+/* Each context has its own run-time, function call and local variable
+ * stacks, its own SLang_Error, string table and namespaces.  The
+ * intrinsics of the default context are seen by all of them.  Data
+ * types and the compiler are shared, so contexts used by different
+ * threads must not run at the same time.  Switch contexts at top level
+ * only, never from an intrinsic function.  SLang_switch_context (NULL)
+ * gets back to the default context.
+ */
+typedef struct _SLang_Context_Type SLang_Context_Type;
+extern SLang_Context_Type *SLang_create_context (void);
+extern SLang_Context_Type *SLang_switch_context (SLang_Context_Type *);
+extern void SLang_free_context (SLang_Context_Type *);
+
+/* Count how often each byte-code sequence runs, for util/mksuper.
+ * The previous setting is returned.
+ */
+extern int SLang_collect_bytecode_stats (int);
+extern int SLang_write_bytecode_stats (char *);
+
+/* The profiler.  SLANG_PROFILE_CALLS times every call of a S-Lang
+ * function; SLANG_PROFILE_SAMPLES looks at the call stack every
+ * SLang_Profile_Interval microseconds of CPU time (Unix only).
+ * SLang_set_profile returns the previous flags, or -1 upon error.
+ */
+#define SLANG_PROFILE_CALLS	0x1
+#define SLANG_PROFILE_SAMPLES	0x2
+extern int SLang_Profile_Interval;
+extern int SLang_set_profile (int);
+extern void SLang_reset_profile (void);
+extern int SLang_write_profile (char *);
+extern int SLang_write_profile_stacks (char *);
+
 
 #if defined(ultrix) && !defined(__GNUC__)
 # ifndef NO_PROTOTYPES
@@ -819,7 +861,7 @@ extern int SLang_init_import (void);
    /* takes a file of S-Lang code and ``byte-compiles'' it for faster
     * loading.  The new filename is equivalent to the old except that a `c' is
     * appended to the name.  (e.g., init.sl --> init.slc).  The second
-    * specified the method; currently, it is not used.
+    * specifies the method: 0 for a binary image, 1 for the older text form.
     */
 
    extern int SLang_autoload(char *, char *);
@@ -1265,8 +1307,11 @@ extern int SLang_RL_EOF_Char;
 extern SLang_Read_Line_Type * SLang_rline_save_line (SLang_RLine_Info_Type *);
 extern int SLang_init_readline (SLang_RLine_Info_Type *);
 extern int SLang_read_line (SLang_RLine_Info_Type *);
+extern int SLang_rline_start (SLang_RLine_Info_Type *);
+extern int SLang_rline_key (SLang_RLine_Info_Type *);
 extern int SLang_rline_insert (char *);
 extern void SLrline_redraw (SLang_RLine_Info_Type *);
+extern void SLrline_update (SLang_RLine_Info_Type *);
 extern int SLang_Rline_Quit;
 
 /*}}}*/
@@ -1274,6 +1319,7 @@ extern int SLang_Rline_Quit;
 /*{{{ Low Level Screen Output Interface */
 
 extern unsigned long SLtt_Num_Chars_Output;
+extern void (*SLtt_Output_Hook) (char *, unsigned int);
 extern int SLtt_Baud_Rate;
 
 typedef unsigned long SLtt_Char_Type;
@@ -1454,9 +1500,17 @@ extern void SLsmg_write_color_chars (SLsmg_Char_Type *, unsigned int);
 extern unsigned int SLsmg_read_raw (SLsmg_Char_Type *, unsigned int);
 extern unsigned int SLsmg_write_raw (SLsmg_Char_Type *, unsigned int);
 extern void SLsmg_set_color_in_region (int, int, int, unsigned int, unsigned int);
+extern void SLsmg_scroll_region (int, int, unsigned int, unsigned int, int);
+extern void SLsmg_paint_region (int, int, unsigned int, unsigned int, SLsmg_Char_Type *, unsigned int, unsigned int);
 extern int SLsmg_Display_Eight_Bit;
 extern int SLsmg_Tab_Width;
 
+/* Called by SLsmg_refresh for every row that may have changed, with the
+ * new contents of the row, before anything is sent to the terminal.  At
+ * the end of the refresh it is called once more with row -1.
+ */
+extern void (*SLsmg_Refresh_Hook) (int, SLsmg_Char_Type *, unsigned int);
+
 #define SLSMG_NEWLINE_IGNORED	0      /* default */
 #define SLSMG_NEWLINE_MOVES	1      /* moves to next line, column 0 */
 #define SLSMG_NEWLINE_SCROLLS	2      /* moves but scrolls at bottom of screen */
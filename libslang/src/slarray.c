@@ -17,9 +17,17 @@ typedef struct
    int first_index;
    int last_index;
    int delta;
+   /* Non-zero for a range written as [a:b].  When such a range is used
+    * as an index, negative ends count from the end of the array.  Ranges
+    * computed from other ranges behave like the values they stand for.
+    */
+   int is_rubber;
 }
 SLarray_Range_Array_Type;
 
+/* Ranges are operated on this many values at a time */
+#define RANGE_BLOCK_SIZE	256
+
 /* Use SLang_pop_array when a linear array is required. */
 static int pop_array (SLang_Array_Type **at_ptr, int convert_scalar)
 {
@@ -89,6 +97,73 @@ static VOID_STAR linear_get_data_addr (SLang_Array_Type *at, int *dims)
    return (VOID_STAR) ((char *)at->data + (ofs * at->sizeof_type));
 }
 
+static VOID_STAR range_get_data_addr (SLang_Array_Type *at, int *dims)
+{
+   static int value;
+   SLarray_Range_Array_Type *r;
+   int d;
+
+   d = *dims;
+   r = (SLarray_Range_Array_Type *)at->data;
+
+   if (d < 0)
+     d += at->dims[0];
+
+   value = r->first_index + d * r->delta;
+   return (VOID_STAR) &value;
+}
+
+/* Create the range of the n values first, first + delta, ... */
+static SLang_Array_Type *create_range_array (int first, int delta, unsigned int n)
+{
+   SLarray_Range_Array_Type *r;
+   SLang_Array_Type *at;
+   int dims;
+
+   r = (SLarray_Range_Array_Type *) SLmalloc (sizeof (SLarray_Range_Array_Type));
+   if (r == NULL)
+     return NULL;
+
+   r->first_index = first;
+   r->last_index = first + ((int) n - 1) * delta;
+   r->delta = delta;
+   r->is_rubber = 0;
+
+   dims = (int) n;
+   if (NULL == (at = SLang_create_array (SLANG_INT_TYPE, 0, (VOID_STAR) r, &dims, 1)))
+     {
+	SLfree ((char *) r);
+	return NULL;
+     }
+
+   at->index_fun = range_get_data_addr;
+   at->flags |= SLARR_DATA_VALUE_IS_RANGE;
+   return at;
+}
+
+/* Return the address of the n elements of the linear array at that start
+ * at element i.  The values of a range are computed into buf, which has
+ * room for RANGE_BLOCK_SIZE of them.
+ */
+static VOID_STAR get_block_data (SLang_Array_Type *at, unsigned int i, unsigned int n, int *buf)
+{
+   SLarray_Range_Array_Type *r;
+   int x, *buf_max;
+
+   if (0 == (at->flags & SLARR_DATA_VALUE_IS_RANGE))
+     return (VOID_STAR) ((char *) at->data + i * at->sizeof_type);
+
+   r = (SLarray_Range_Array_Type *) at->data;
+   x = r->first_index + (int) i * r->delta;
+   buf_max = buf + n;
+   while (buf < buf_max)
+     {
+	*buf++ = x;
+	x += r->delta;
+     }
+   return (VOID_STAR) (buf_max - n);
+}
+
 static VOID_STAR get_data_addr (SLang_Array_Type *at, int *dims)
 {
    VOID_STAR data;
@@ -574,7 +649,8 @@ pop_indices (SLang_Array_Type *at_to_index,
 		  if (num_indices == 1)
 		    {
 		       if ((at_to_index->num_dims > 1)
-			   || (0 == (at->flags & SLARR_DATA_VALUE_IS_RANGE)))
+			   || (0 == (at->flags & SLARR_DATA_VALUE_IS_RANGE))
+			   || (0 == ((SLarray_Range_Array_Type *) at->data)->is_rubber))
 			 *is_index_array = 1;
 		    }
 	       }
@@ -593,7 +669,7 @@ pop_indices (SLang_Array_Type *at_to_index,
    return -1;
 }
 
-/* Here ind_at is a linear 1-d array of indices */
+/* Here ind_at is a 1-d array of indices, either linear or a range */
 static int
 check_index_array_ranges (SLang_Array_Type *at, SLang_Array_Type *ind_at)
 {
@@ -601,6 +677,23 @@ check_index_array_ranges (SLang_Array_Type *at, SLang_Array_Type *ind_at)
    unsigned int num_elements;
 
    num_elements = at->num_elements;
+
+   if (ind_at->flags & SLARR_DATA_VALUE_IS_RANGE)
+     {
+	SLarray_Range_Array_Type *r = (SLarray_Range_Array_Type *) ind_at->data;
+
+	/* The values lie between the first and the last */
+	if ((ind_at->num_elements != 0)
+	    && (((unsigned int) r->first_index >= num_elements)
+		|| ((unsigned int) (r->first_index + ((int) ind_at->num_elements - 1) * r->delta) >= num_elements)))
+	  {
+	     SLang_verror (SL_INVALID_PARM,
+			   "index-array is out of range");
+	     return -1;
+	  }
+	return 0;
+     }
+
    indices = (int *) ind_at->data;
    indices_max = indices + ind_at->num_elements;
 
@@ -686,46 +779,70 @@ aget_from_index_array (SLang_Array_Type *at,
 {
    SLang_Array_Type *new_at;
    int *indices, *indices_max;
-   unsigned char *new_data, *src_data;
-   unsigned int sizeof_type;
+   unsigned char *new_data, *src_data, *src;
+   unsigned int sizeof_type, i, n, num;
    int is_ptr;
-   
-   if (-1 == coerse_array_to_linear (at))
-     return -1;
-
-   if (-1 == coerse_array_to_linear (ind_at))
-     return -1;
+   int index_buf [RANGE_BLOCK_SIZE];
 
+   /* Neither a range nor a range index array is expanded.  A range
+    * indexed by a range is another range.
+    */
    if (-1 == check_index_array_ranges (at, ind_at))
      return -1;
 
+   num = ind_at->num_elements;
+   if ((at->flags & SLARR_DATA_VALUE_IS_RANGE)
+       && (ind_at->flags & SLARR_DATA_VALUE_IS_RANGE))
+     {
+	SLarray_Range_Array_Type *r = (SLarray_Range_Array_Type *) at->data;
+	SLarray_Range_Array_Type *ri = (SLarray_Range_Array_Type *) ind_at->data;
+
+	if (num > 1)
+	  {
+	     new_at = create_range_array (r->first_index + ri->first_index * r->delta,
+					  r->delta * ri->delta, num);
+	     if (new_at == NULL)
+	       return -1;
+	     return SLang_push_array (new_at, 1);
+	  }
+     }
+
    if (NULL == (new_at = SLang_create_array (at->data_type, 0, NULL, ind_at->dims, 1)))
      return -1;
 
-   /* Since the index array is linear, I can address it directly */
-   indices = (int *) ind_at->data;
-   indices_max = indices + ind_at->num_elements;
-
-   src_data = (unsigned char *) at->data;
+   if (at->flags & SLARR_DATA_VALUE_IS_RANGE)
+     src_data = NULL;
+   else
+     src_data = (unsigned char *) at->data;
    new_data = (unsigned char *) new_at->data;
    sizeof_type = new_at->sizeof_type;
    is_ptr = (new_at->flags & SLARR_DATA_VALUE_IS_POINTER);
 
-   while (indices < indices_max)
+   for (i = 0; i < num; i += n)
      {
-	unsigned int offset;
+	n = num - i;
+	if (n > RANGE_BLOCK_SIZE) n = RANGE_BLOCK_SIZE;
+	indices = (int *) get_block_data (ind_at, i, n, index_buf);
+	indices_max = indices + n;
 
-	offset = sizeof_type * (unsigned int)*indices;
-	if (-1 == transfer_n_elements (at, (VOID_STAR) new_data,
-				       (VOID_STAR) (src_data + offset),
-				       sizeof_type, 1, is_ptr))
+	while (indices < indices_max)
 	  {
-	     SLang_free_array (new_at);
-	     return -1;
-	  }
+	     if (src_data == NULL)
+	       src = (unsigned char *) range_get_data_addr (at, indices);
+	     else
+	       src = src_data + sizeof_type * (unsigned int)*indices;
 
-	new_data += sizeof_type;
-	indices++;
+	     if (-1 == transfer_n_elements (at, (VOID_STAR) new_data,
+					    (VOID_STAR) src,
+					    sizeof_type, 1, is_ptr))
+	       {
+		  SLang_free_array (new_at);
+		  return -1;
+	       }
+
+	     new_data += sizeof_type;
+	     indices++;
+	  }
      }
 
    return SLang_push_array (new_at, 1);
@@ -779,7 +896,29 @@ convert_nasty_index_objs (SLang_Array_Type *at,
 	     is_dim_array[i] = 1;
 	     ind_at = obj->v.array_val;
 
-	     if (ind_at->flags & SLARR_DATA_VALUE_IS_RANGE)
+	     if ((ind_at->flags & SLARR_DATA_VALUE_IS_RANGE)
+		 && (0 == ((SLarray_Range_Array_Type *) ind_at->data)->is_rubber))
+	       {
+		  SLarray_Range_Array_Type *r;
+
+		  /* Like an index array with the values of the range */
+		  if (0 == (max_dims[i] = ind_at->num_elements))
+		    {
+		       total_num_elements = 0;
+		       break;
+		    }
+
+		  r = (SLarray_Range_Array_Type *) ind_at->data;
+		  range_buf[i] = min_index = r->first_index;
+		  range_delta_buf[i] = r->delta;
+		  max_index = r->first_index + (max_dims[i] - 1) * r->delta;
+		  if (max_index < min_index)
+		    {
+		       min_index = max_index;
+		       max_index = r->first_index;
+		    }
+	       }
+	     else if (ind_at->flags & SLARR_DATA_VALUE_IS_RANGE)
 	       {
 		  SLarray_Range_Array_Type *r;
 		  int delta;
@@ -938,6 +1077,22 @@ aget_from_indices (SLang_Array_Type *at,
 				       is_dim_array))
      return -1;
 
+   /* A slice of a range is a range */
+   if ((at->flags & SLARR_DATA_VALUE_IS_RANGE)
+       && (num_indices == 1) && (range_delta_buf[0] != 0)
+       && (num_elements > 1)
+       && (range_buf[0] >= 0)
+       && (range_buf[0] + ((int) num_elements - 1) * range_delta_buf[0] >= 0))
+     {
+	SLarray_Range_Array_Type *r = (SLarray_Range_Array_Type *) at->data;
+
+	new_at = create_range_array (r->first_index + range_buf[0] * r->delta,
+				     r->delta * range_delta_buf[0], num_elements);
+	if (new_at == NULL)
+	  return -1;
+	return SLang_push_array (new_at, 1);
+     }
+
    is_ptr = (at->flags & SLARR_DATA_VALUE_IS_POINTER);
    sizeof_type = at->sizeof_type;
 
@@ -1411,20 +1566,18 @@ static int
 aput_from_index_array (SLang_Array_Type *at, SLang_Array_Type *ind_at)
 {
    int *indices, *indices_max;
-   unsigned int sizeof_type;
+   unsigned int sizeof_type, i, n, num;
    char *data_to_put, *dest_data;
    unsigned int data_increment;
    int is_ptr;
    SLang_Array_Type *bt;
    SLang_Class_Type *cl;
    int ret;
+   int index_buf [RANGE_BLOCK_SIZE];
 
    if (-1 == coerse_array_to_linear (at))
      return -1;
 
-   if (-1 == coerse_array_to_linear (ind_at))
-     return -1;
-
    if (-1 == check_index_array_ranges (at, ind_at))
      return -1;
 
@@ -1439,27 +1592,32 @@ aput_from_index_array (SLang_Array_Type *at, SLang_Array_Type *ind_at)
 				    &bt, &data_to_put, &data_increment))
      return -1;
 
-   /* Since the index array is linear, I can address it directly */
-   indices = (int *) ind_at->data;
-   indices_max = indices + ind_at->num_elements;
-
    is_ptr = (at->flags & SLARR_DATA_VALUE_IS_POINTER);
    dest_data = (char *) at->data;
+   num = ind_at->num_elements;
 
    ret = -1;
-   while (indices < indices_max)
+   for (i = 0; i < num; i += n)
      {
-	unsigned int offset;
+	n = num - i;
+	if (n > RANGE_BLOCK_SIZE) n = RANGE_BLOCK_SIZE;
+	indices = (int *) get_block_data (ind_at, i, n, index_buf);
+	indices_max = indices + n;
 
-	offset = sizeof_type * (unsigned int)*indices;
+	while (indices < indices_max)
+	  {
+	     unsigned int offset;
 
-	if (-1 == transfer_n_elements (at, (VOID_STAR) (dest_data + offset),
-				       (VOID_STAR) data_to_put, sizeof_type, 1,
-				       is_ptr))
-	  goto return_error;
+	     offset = sizeof_type * (unsigned int)*indices;
 
-	indices++;
-	data_to_put += data_increment;
+	     if (-1 == transfer_n_elements (at, (VOID_STAR) (dest_data + offset),
+					    (VOID_STAR) data_to_put, sizeof_type, 1,
+					    is_ptr))
+	       goto return_error;
+
+	     indices++;
+	     data_to_put += data_increment;
+	  }
      }
 
    ret = 0;
@@ -1836,22 +1994,6 @@ static void array_info (void)
    SLang_free_array (at);
 }
 
-static VOID_STAR range_get_data_addr (SLang_Array_Type *at, int *dims)
-{
-   static int value;
-   SLarray_Range_Array_Type *r;
-   int d;
-
-   d = *dims;
-   r = (SLarray_Range_Array_Type *)at->data;
-
-   if (d < 0)
-     d += at->dims[0];
-
-   value = r->first_index + d * r->delta;
-   return (VOID_STAR) &value;
-}
-
 static SLang_Array_Type *inline_implicit_int_array (int *xminptr, int *xmaxptr, int *dxptr)
 {
    int delta;
@@ -1874,6 +2016,7 @@ static SLang_Array_Type *inline_implicit_int_array (int *xminptr, int *xmaxptr,
 
    SLMEMSET((char *) data, 0, sizeof (SLarray_Range_Array_Type));
    data->delta = delta;
+   data->is_rubber = 1;
    dims = 0;
 
    if (xminptr != NULL)
@@ -2310,6 +2453,97 @@ static int array_binary_op_result (int op, unsigned char a, unsigned char b,
    return 1;
 }
 
+/* Add an integer to a range, subtract one from it or multiply it by one.
+ * The result is another range.  This returns 0 if that is not what the
+ * operation does.
+ */
+static int range_int_binary_op (int op, SLang_Array_Type *at, int k, int k_is_first,
+				SLang_Array_Type **ct)
+{
+   SLarray_Range_Array_Type *r;
+   int first, delta;
+
+   r = (SLarray_Range_Array_Type *) at->data;
+   first = r->first_index;
+   delta = r->delta;
+
+   switch (op)
+     {
+      case SLANG_PLUS:
+	first += k;
+	break;
+
+      case SLANG_MINUS:
+	if (k_is_first)
+	  {
+	     first = k - first;
+	     delta = -delta;
+	  }
+	else first -= k;
+	break;
+
+      case SLANG_TIMES:
+	first *= k;
+	delta *= k;
+	if (delta == 0)
+	  return 0;
+	break;
+
+      default:
+	return 0;
+     }
+
+   if (NULL == (*ct = create_range_array (first, delta, at->num_elements)))
+     return -1;
+   return 1;
+}
+
+/* Apply binary_fun to the arrays at and bt, either of which may be a
+ * range, or to the scalar ap or bp in place of one that is NULL.  The
+ * values of a range are produced a block at a time.
+ */
+static int range_binary_op (int (*binary_fun) (int,
+					       unsigned char, VOID_STAR, unsigned int,
+					       unsigned char, VOID_STAR, unsigned int,
+					       VOID_STAR),
+			    int op,
+			    SLang_Array_Type *at, unsigned char a_type, VOID_STAR ap, unsigned int na,
+			    SLang_Array_Type *bt, unsigned char b_type, VOID_STAR bp, unsigned int nb,
+			    SLang_Array_Type *ct)
+{
+   int a_buf [RANGE_BLOCK_SIZE], b_buf [RANGE_BLOCK_SIZE];
+   unsigned int i, n, num;
+   int ret;
+
+   if (na == 1)
+     {
+	if (at != NULL) ap = get_block_data (at, 0, 1, a_buf);
+	at = NULL;
+     }
+   if (nb == 1)
+     {
+	if (bt != NULL) bp = get_block_data (bt, 0, 1, b_buf);
+	bt = NULL;
+     }
+
+   num = ct->num_elements;
+   for (i = 0; i < num; i += n)
+     {
+	n = num - i;
+	if (n > RANGE_BLOCK_SIZE) n = RANGE_BLOCK_SIZE;
+
+	if (at != NULL) ap = get_block_data (at, i, n, a_buf);
+	if (bt != NULL) bp = get_block_data (bt, i, n, b_buf);
+
+	ret = (*binary_fun) (op, a_type, ap, (at != NULL) ? n : 1,
+			     b_type, bp, (bt != NULL) ? n : 1,
+			     (VOID_STAR) ((char *) ct->data + i * ct->sizeof_type));
+	if (ret != 1)
+	  return ret;
+     }
+   return 1;
+}
+
 static int array_binary_op (int op,
 			    unsigned char a_type, VOID_STAR ap, unsigned int na,
 			    unsigned char b_type, VOID_STAR bp, unsigned int nb,
@@ -2322,7 +2556,7 @@ static int array_binary_op (int op,
 		      unsigned char, VOID_STAR, unsigned int,
 		      VOID_STAR);
    SLang_Class_Type *a_cl, *b_cl, *c_cl;
-   int no_init;
+   int no_init, ret;
 
    if (a_type == SLANG_ARRAY_TYPE)
      {
@@ -2332,9 +2566,8 @@ static int array_binary_op (int op,
 	     return -1;
 	  }
 
+	/* A range is left as it is; see range_binary_op */
 	at = *(SLang_Array_Type **) ap;
-	if (-1 == coerse_array_to_linear (at))
-	  return -1;
 	ap = at->data;
 	a_type = at->data_type;
 	na = at->num_elements;
@@ -2353,8 +2586,6 @@ static int array_binary_op (int op,
 	  }
 
 	bt = *(SLang_Array_Type **) bp;
-	if (-1 == coerse_array_to_linear (bt))
-	  return -1;
 	bp = bt->data;
 	b_type = bt->data_type;
 	nb = bt->num_elements;
@@ -2384,6 +2615,21 @@ static int array_binary_op (int op,
 	  }
      }
 
+   if ((at != NULL) && (at->flags & SLARR_DATA_VALUE_IS_RANGE)
+       && (bt == NULL) && (b_type == SLANG_INT_TYPE) && (nb == 1))
+     {
+	int ret = range_int_binary_op (op, at, *(int *) bp, 0, (SLang_Array_Type **) cp);
+	if (ret != 0)
+	  return ret;
+     }
+   if ((bt != NULL) && (bt->flags & SLARR_DATA_VALUE_IS_RANGE)
+       && (at == NULL) && (a_type == SLANG_INT_TYPE) && (na == 1))
+     {
+	int ret = range_int_binary_op (op, bt, *(int *) ap, 1, (SLang_Array_Type **) cp);
+	if (ret != 0)
+	  return ret;
+     }
+
    a_cl = _SLclass_get_class (a_type);
    b_cl = _SLclass_get_class (b_type);
 
@@ -2405,14 +2651,16 @@ static int array_binary_op (int op,
      {
 	if ((at != NULL) 
 	    && (at->num_refs == 1)
-	    && (at->data_type == c_cl->cl_data_type))
+	    && (at->data_type == c_cl->cl_data_type)
+	    && (0 == (at->flags & SLARR_DATA_VALUE_IS_RANGE)))
 	  {
 	     ct = at;
 	     ct->num_refs = 2;
 	  }
 	else if ((bt != NULL) 
 	    && (bt->num_refs == 1)
-	    && (bt->data_type == c_cl->cl_data_type))
+	    && (bt->data_type == c_cl->cl_data_type)
+	    && (0 == (bt->flags & SLARR_DATA_VALUE_IS_RANGE)))
 	  {
 	     ct = bt;
 	     ct->num_refs = 2;
@@ -2429,8 +2677,15 @@ static int array_binary_op (int op,
      }
 
 
-   if ((na == 0) || (nb == 0)	       /* allow empty arrays */
-       || (1 == (*binary_fun) (op, a_type, ap, na, b_type, bp, nb, ct->data)))
+   if ((na == 0) || (nb == 0))	       /* allow empty arrays */
+     ret = 1;
+   else if (((at != NULL) && (at->flags & SLARR_DATA_VALUE_IS_RANGE))
+	    || ((bt != NULL) && (bt->flags & SLARR_DATA_VALUE_IS_RANGE)))
+     ret = range_binary_op (binary_fun, op, at, a_type, ap, na, bt, b_type, bp, nb, ct);
+   else
+     ret = (*binary_fun) (op, a_type, ap, na, b_type, bp, nb, ct->data);
+
+   if (ret == 1)
      {
 	*(SLang_Array_Type **) cp = ct;
 	return 1;
@@ -2876,6 +3131,8 @@ do_array_math_op (int op, int unary_type,
    SLang_Array_Type *bt;
    SLang_Class_Type *b_cl;
    int no_init;
+   int buf [RANGE_BLOCK_SIZE];
+   unsigned int i, n;
 
    if (na != 1)
      {
@@ -2883,14 +3140,18 @@ do_array_math_op (int op, int unary_type,
 	return NULL;
      }
 
+   if ((at->flags & SLARR_DATA_VALUE_IS_RANGE)
+       && (unary_type == _SLANG_BC_UNARY) && (op == SLANG_CHS))
+     {
+	SLarray_Range_Array_Type *r = (SLarray_Range_Array_Type *) at->data;
+	return create_range_array (-r->first_index, -r->delta, at->num_elements);
+     }
+
    a_type = at->data_type;
    if (NULL == (f = _SLclass_get_unary_fun (op, at->cl, &b_cl, unary_type)))
      return NULL;
    b_type = b_cl->cl_data_type;
 
-   if (-1 == coerse_array_to_linear (at))
-     return NULL;
-
    no_init = ((b_cl->cl_class_type == SLANG_CLASS_TYPE_SCALAR)
 	      || (b_cl->cl_class_type == SLANG_CLASS_TYPE_VECTOR));
 
@@ -2903,7 +3164,8 @@ do_array_math_op (int op, int unary_type,
     */
    if (no_init
        && (at->num_refs == 1)
-       && (at->data_type == b_cl->cl_data_type))
+       && (at->data_type == b_cl->cl_data_type)
+       && (0 == (at->flags & SLARR_DATA_VALUE_IS_RANGE)))
      {
 	bt = at;
 	bt->num_refs = 2;
@@ -2913,10 +3175,26 @@ do_array_math_op (int op, int unary_type,
      if (NULL == (bt = SLang_create_array1 (b_type, 0, NULL, at->dims, at->num_dims, no_init)))
        return NULL;
 
-   if (1 != (*f)(op, a_type, at->data, at->num_elements, bt->data))
+   if (0 == (at->flags & SLARR_DATA_VALUE_IS_RANGE))
      {
-	SLang_free_array (bt);
-	return NULL;
+	if (1 != (*f)(op, a_type, at->data, at->num_elements, bt->data))
+	  {
+	     SLang_free_array (bt);
+	     return NULL;
+	  }
+	return bt;
+     }
+
+   for (i = 0; i < at->num_elements; i += n)
+     {
+	n = at->num_elements - i;
+	if (n > RANGE_BLOCK_SIZE) n = RANGE_BLOCK_SIZE;
+	if (1 != (*f)(op, a_type, get_block_data (at, i, n, buf), n,
+		      (VOID_STAR) ((char *) bt->data + i * bt->sizeof_type)))
+	  {
+	     SLang_free_array (bt);
+	     return NULL;
+	  }
      }
    return bt;
 }
@@ -3013,9 +3291,6 @@ _SLarray_typecast (unsigned char a_type, VOID_STAR ap, unsigned int na,
    if (NULL == (t = _SLclass_get_typecast (a_type, b_type, is_implicit)))
      return -1;
 
-   if (-1 == coerse_array_to_linear (at))
-     return -1;
-
    b_cl = _SLclass_get_class (b_type);
 
    no_init = ((b_cl->cl_class_type == SLANG_CLASS_TYPE_SCALAR)
@@ -3024,7 +3299,26 @@ _SLarray_typecast (unsigned char a_type, VOID_STAR ap, unsigned int na,
    if (NULL == (bt = SLang_create_array1 (b_type, 0, NULL, at->dims, at->num_dims, no_init)))
      return -1;
 
-   if (1 == (*t) (a_type, at->data, at->num_elements, b_type, bt->data))
+   if (at->flags & SLARR_DATA_VALUE_IS_RANGE)
+     {
+	int buf [RANGE_BLOCK_SIZE];
+	unsigned int i, n;
+
+	for (i = 0; i < at->num_elements; i += n)
+	  {
+	     n = at->num_elements - i;
+	     if (n > RANGE_BLOCK_SIZE) n = RANGE_BLOCK_SIZE;
+	     if (1 != (*t) (a_type, get_block_data (at, i, n, buf), n, b_type,
+			    (VOID_STAR) ((char *) bt->data + i * bt->sizeof_type)))
+	       break;
+	  }
+	if (i >= at->num_elements)
+	  {
+	     *(SLang_Array_Type **) bp = bt;
+	     return 1;
+	  }
+     }
+   else if (1 == (*t) (a_type, at->data, at->num_elements, b_type, bt->data))
      {
 	*(SLang_Array_Type **) bp = bt;
 	return 1;
@@ -246,6 +246,9 @@ static unsigned char *Output_Bufferp = Output_Buffer;
 
 unsigned long SLtt_Num_Chars_Output;
 
+/* sees everything that is written to the terminal, e.g. to record it */
+void (*SLtt_Output_Hook) (char *, unsigned int);
+
 int _SLusleep (unsigned long usecs)
 {
 #if !defined(VMS) || (__VMS_VER >= 70000000)
@@ -265,6 +268,8 @@ int SLtt_flush_output (void)
    int n = (int) (Output_Bufferp - Output_Buffer);
 
    SLtt_Num_Chars_Output += n;
+   if ((SLtt_Output_Hook != NULL) && (n > 0))
+     (*SLtt_Output_Hook) ((char *) Output_Buffer, (unsigned int) n);
 
    total = 0;
    while (n > 0)
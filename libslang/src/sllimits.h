@@ -15,25 +15,41 @@
 # define SLASSOC_HASH_TABLE_SIZE 	2909
 #endif
 
-/* slang.c: maximum size of run time stack */
+/* slang.c: The stacks below start at the INITIAL size and grow as needed.
+ * The MAX sizes are the defaults of SLang_Max_Stack_Len,
+ * SLang_Max_Recursion_Depth and SLang_Max_Local_Stack.  The run-time and
+ * local variable stacks live on the heap and may grow large.  Each call
+ * also takes C stack, so the recursion depth is kept small enough that
+ * runaway recursion is caught before it overflows a typical C or thread
+ * stack; an application that runs the interpreter on a larger stack may
+ * raise it.
+ */
+
+/* slang.c: size of run time stack */
 #ifdef __MSDOS_16BIT__
+# define SLANG_INITIAL_STACK_LEN	500
 # define SLANG_MAX_STACK_LEN		500
 #else
-# define SLANG_MAX_STACK_LEN		2500
+# define SLANG_INITIAL_STACK_LEN	1024
+# define SLANG_MAX_STACK_LEN		1048576
 #endif
 
 /* slang.c: This sets the size on the depth of function calls */
 #ifdef __MSDOS_16BIT__
+# define SLANG_INITIAL_RECURSIVE_DEPTH	50
 # define SLANG_MAX_RECURSIVE_DEPTH	50
 #else
+# define SLANG_INITIAL_RECURSIVE_DEPTH	256
 # define SLANG_MAX_RECURSIVE_DEPTH	2500
 #endif
 
 /* slang.c: Size of the stack used for local variables */
 #ifdef __MSDOS_16BIT__
+# define SLANG_INITIAL_LOCAL_STACK	200
 # define SLANG_MAX_LOCAL_STACK		200
 #else
-# define SLANG_MAX_LOCAL_STACK		4096
+# define SLANG_INITIAL_LOCAL_STACK	1024
+# define SLANG_MAX_LOCAL_STACK		1048576
 #endif
 
 /* slang.c: The size of the hash table used for local and global objects.
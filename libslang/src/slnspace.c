@@ -292,3 +292,15 @@ SLang_Array_Type *_SLns_list_namespaces (void)
      }
    return at;
 }
+
+/* Each interpreter context has a list of namespaces of its own.  This
+ * makes list the one in use and returns the list that was.
+ */
+SLang_NameSpace_Type *_SLns_switch_namespace_list (SLang_NameSpace_Type *list)
+{
+   SLang_NameSpace_Type *old;
+
+   old = Namespace_Tables;
+   Namespace_Tables = list;
+   return old;
+}
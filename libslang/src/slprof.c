@@ -0,0 +1,574 @@
+/* A profiler for S-Lang functions */
+/* Copyright (c) 2003 John E. Davis
+ * This file is part of the S-Lang library.
+ *
+ * You may distribute under the terms of either the GNU General Public
+ * License or the Perl Artistic License.
+ */
+
+/* Both kinds of profiling add to one call tree with a node for every
+ * call path seen.  SLANG_PROFILE_CALLS counts the calls of each path
+ * and times them: a node's exclusive time is its inclusive time less
+ * that of its children.  SLANG_PROFILE_SAMPLES has SIGPROF copy the
+ * function names of the call stack into a ring buffer; the samples
+ * are added to the tree on the next function call, or before the
+ * profile is written, so that the handler never allocates anything.
+ *
+ * SLang_write_profile sums the nodes by function.  A function's
+ * inclusive figures only come from the nodes that are not below
+ * another call of the same function, so recursion is not counted
+ * twice.  SLang_write_profile_stacks writes a path per line in the
+ * "collapsed" form that flamegraph.pl reads.
+ */
+
+#include "slinclud.h"
+
+#include <signal.h>
+#include <time.h>
+
+#include "slang.h"
+#include "_slang.h"
+
+#ifdef REAL_UNIX_SYSTEM
+# include <sys/time.h>
+#endif
+
+#if defined(REAL_UNIX_SYSTEM) && defined(SIGPROF) && defined(ITIMER_PROF)
+# define PROF_CAN_SAMPLE	1
+#else
+# define PROF_CAN_SAMPLE	0
+#endif
+
+int _SLang_Profile = 0;
+int SLang_Profile_Interval = 1000;     /* microseconds */
+
+typedef struct
+{
+   char *name;			       /* slstring, NULL for the root */
+   unsigned int parent;
+   unsigned int child;		       /* 0 if none */
+   unsigned int next;
+   unsigned long calls;
+   unsigned long samples;
+   double incl;			       /* microseconds */
+   double excl;
+}
+Prof_Node_Type;
+
+typedef struct
+{
+   unsigned int node;
+   double start;
+   double child_time;
+}
+Prof_Frame_Type;
+
+static Prof_Node_Type *Prof_Nodes;
+static unsigned int Num_Prof_Nodes;
+static unsigned int Max_Prof_Nodes;
+
+static Prof_Frame_Type *Prof_Stack;
+static unsigned int Prof_Depth;
+static unsigned int Prof_Stack_Len;
+/* Changed by SLang_reset_profile so that calls running at the time do
+ * not pop the frames of calls made after it.
+ */
+static unsigned long Prof_Generation = 1;
+
+static unsigned long Total_Samples;
+static unsigned long Outside_Samples;
+
+static double prof_time (void)
+{
+#ifdef REAL_UNIX_SYSTEM
+   struct timeval tv;
+
+   (void) gettimeofday (&tv, NULL);
+   return 1e6 * (double) tv.tv_sec + (double) tv.tv_usec;
+#else
+   return (1e6 / (double) CLOCKS_PER_SEC) * (double) clock ();
+#endif
+}
+
+static int init_profile (void)
+{
+   if (Prof_Nodes != NULL)
+     return 0;
+
+   Prof_Stack = (Prof_Frame_Type *) SLmalloc (64 * sizeof (Prof_Frame_Type));
+   if (Prof_Stack == NULL)
+     return -1;
+   Prof_Stack_Len = 64;
+   Prof_Nodes = (Prof_Node_Type *) SLcalloc (256, sizeof (Prof_Node_Type));
+   if (Prof_Nodes == NULL)
+     {
+	SLfree ((char *) Prof_Stack);
+	Prof_Stack = NULL;
+	return -1;
+     }
+   Max_Prof_Nodes = 256;
+   Num_Prof_Nodes = 1;		       /* the root */
+   return 0;
+}
+
+/* The node for name below parent, made if need be; 0 upon failure */
+static unsigned int find_node (unsigned int parent, char *name)
+{
+   Prof_Node_Type *n;
+   unsigned int i;
+
+   for (i = Prof_Nodes[parent].child; i != 0; i = Prof_Nodes[i].next)
+     {
+	n = Prof_Nodes + i;
+	if ((n->name == name) || (0 == strcmp (n->name, name)))
+	  return i;
+     }
+
+   if (Num_Prof_Nodes == Max_Prof_Nodes)
+     {
+	n = (Prof_Node_Type *) SLrealloc ((char *) Prof_Nodes, 2 * Max_Prof_Nodes * sizeof (Prof_Node_Type));
+	if (n == NULL)
+	  return 0;
+	Prof_Nodes = n;
+	Max_Prof_Nodes *= 2;
+     }
+   i = Num_Prof_Nodes;
+   n = Prof_Nodes + i;
+   memset ((char *) n, 0, sizeof (Prof_Node_Type));
+   if (NULL == (n->name = SLang_create_slstring (name)))
+     return 0;
+   n->parent = parent;
+   n->next = Prof_Nodes[parent].child;
+   Prof_Nodes[parent].child = i;
+   Num_Prof_Nodes++;
+   return i;
+}
+
+/*{{{ Sampling */
+
+#if PROF_CAN_SAMPLE
+/* A sample is its depth followed by that many names */
+typedef union
+{
+   char *name;
+   unsigned int depth;
+}
+Sample_Slot_Type;
+
+# define SAMPLE_RING_SIZE	0x10000	       /* power of 2 */
+static Sample_Slot_Type *Sample_Ring;
+/* The handler only moves Sample_Head and the code that takes the
+ * samples out only moves Sample_Tail, so neither needs a lock.
+ */
+static volatile unsigned int Sample_Head;
+static volatile unsigned int Sample_Tail;
+static volatile unsigned long Dropped_Samples;
+static SLSig_Fun_Type *Old_SIGPROF_Handler;
+
+static void sigprof_handler (int sig)
+{
+   char **names;
+   unsigned int depth, i, head, n;
+
+   (void) sig;
+   names = _SLang_function_name_stack (&depth);
+   head = Sample_Head;
+   if (SAMPLE_RING_SIZE - (head - Sample_Tail) < depth + 1)
+     {
+	Dropped_Samples++;
+	return;
+     }
+   n = 0;
+   for (i = 0; i < depth; i++)
+     {
+	if (names[i] == NULL)
+	  continue;
+	n++;
+	Sample_Ring[(head + n) & (SAMPLE_RING_SIZE - 1)].name = names[i];
+     }
+   Sample_Ring[head & (SAMPLE_RING_SIZE - 1)].depth = n;
+   Sample_Head = head + n + 1;
+}
+
+static void add_samples (void)
+{
+   unsigned int tail, head, depth, node;
+
+   head = Sample_Head;
+   tail = Sample_Tail;
+   while (tail != head)
+     {
+	depth = Sample_Ring[tail & (SAMPLE_RING_SIZE - 1)].depth;
+	tail++;
+	Total_Samples++;
+	if (depth == 0)
+	  Outside_Samples++;
+	node = 0;
+	while (depth--)
+	  {
+	     node = find_node (node, Sample_Ring[tail & (SAMPLE_RING_SIZE - 1)].name);
+	     tail++;
+	     if (node == 0)
+	       {
+		  tail += depth;
+		  break;
+	       }
+	  }
+	if (node != 0)
+	  Prof_Nodes[node].samples++;
+     }
+   Sample_Tail = tail;
+}
+
+static int set_prof_timer (int usecs)
+{
+   struct itimerval it;
+
+   it.it_interval.tv_sec = usecs / 1000000;
+   it.it_interval.tv_usec = usecs % 1000000;
+   it.it_value = it.it_interval;
+   return setitimer (ITIMER_PROF, &it, NULL);
+}
+
+static int start_sampling (void)
+{
+   if (Sample_Ring == NULL)
+     {
+	Sample_Ring = (Sample_Slot_Type *) SLmalloc (SAMPLE_RING_SIZE * sizeof (Sample_Slot_Type));
+	if (Sample_Ring == NULL)
+	  return -1;
+     }
+   if (SLang_Profile_Interval <= 0)
+     SLang_Profile_Interval = 1000;
+
+   Old_SIGPROF_Handler = SLsignal (SIGPROF, sigprof_handler);
+   if (-1 == set_prof_timer (SLang_Profile_Interval))
+     {
+	(void) SLsignal (SIGPROF, Old_SIGPROF_Handler);
+	SLang_verror (SL_INTRINSIC_ERROR, "Unable to start the profiling timer");
+	return -1;
+     }
+   return 0;
+}
+
+static void stop_sampling (void)
+{
+   (void) set_prof_timer (0);
+   (void) SLsignal (SIGPROF, Old_SIGPROF_Handler);
+   add_samples ();
+}
+#endif				       /* PROF_CAN_SAMPLE */
+
+static void take_samples (void)
+{
+#if PROF_CAN_SAMPLE
+   if (Sample_Head != Sample_Tail)
+     add_samples ();
+#endif
+}
+
+/*}}}*/
+
+/*{{{ Call timing */
+
+/* Called by execute_slang_fun when _SLang_Profile is set.  The token
+ * returned is to be passed to _SLprof_exit, 0 if there is nothing to do.
+ */
+unsigned long _SLprof_enter (char *name)
+{
+   Prof_Frame_Type *f;
+   unsigned int node;
+
+   /* A name in the ring could go away if its function were redefined,
+    * so they are looked at as soon as can be.
+    */
+   take_samples ();
+
+   if (0 == (_SLang_Profile & SLANG_PROFILE_CALLS))
+     return 0;
+
+   if (Prof_Depth == Prof_Stack_Len)
+     {
+	f = (Prof_Frame_Type *) SLrealloc ((char *) Prof_Stack, 2 * Prof_Stack_Len * sizeof (Prof_Frame_Type));
+	if (f == NULL)
+	  return 0;
+	Prof_Stack = f;
+	Prof_Stack_Len *= 2;
+     }
+
+   node = find_node (Prof_Depth ? Prof_Stack[Prof_Depth - 1].node : 0, name);
+   if (node == 0)
+     return 0;
+
+   Prof_Nodes[node].calls++;
+   f = Prof_Stack + Prof_Depth;
+   Prof_Depth++;
+   f->node = node;
+   f->child_time = 0.0;
+   f->start = prof_time ();
+   return (Prof_Generation << 16) | Prof_Depth;
+}
+
+void _SLprof_exit (unsigned long token)
+{
+   Prof_Frame_Type *f;
+   Prof_Node_Type *n;
+   double dt;
+
+   if (token != ((Prof_Generation << 16) | Prof_Depth))
+     return;
+
+   Prof_Depth--;
+   f = Prof_Stack + Prof_Depth;
+   dt = prof_time () - f->start;
+   n = Prof_Nodes + f->node;
+   n->incl += dt;
+   n->excl += dt - f->child_time;
+   if (Prof_Depth)
+     Prof_Stack[Prof_Depth - 1].child_time += dt;
+}
+
+/*}}}*/
+
+int SLang_set_profile (int flags)
+{
+   int old = _SLang_Profile;
+
+   flags &= (SLANG_PROFILE_CALLS | SLANG_PROFILE_SAMPLES);
+#if !PROF_CAN_SAMPLE
+   if (flags & SLANG_PROFILE_SAMPLES)
+     {
+	SLang_verror (SL_NOT_IMPLEMENTED, "Sampling profiler not supported on this system");
+	return -1;
+     }
+#endif
+   if (-1 == init_profile ())
+     return -1;
+
+#if PROF_CAN_SAMPLE
+   if ((flags & SLANG_PROFILE_SAMPLES) && (0 == (old & SLANG_PROFILE_SAMPLES)))
+     {
+	if (-1 == start_sampling ())
+	  return -1;
+     }
+   else if ((old & SLANG_PROFILE_SAMPLES) && (0 == (flags & SLANG_PROFILE_SAMPLES)))
+     stop_sampling ();
+#endif
+   _SLang_Profile = flags;
+   return old;
+}
+
+void SLang_reset_profile (void)
+{
+   unsigned int i;
+
+   if (Prof_Nodes == NULL)
+     return;
+
+   take_samples ();
+   for (i = 1; i < Num_Prof_Nodes; i++)
+     SLang_free_slstring (Prof_Nodes[i].name);
+   memset ((char *) Prof_Nodes, 0, sizeof (Prof_Node_Type));
+   Num_Prof_Nodes = 1;
+   Prof_Depth = 0;
+   Prof_Generation = (Prof_Generation + 1) & 0x7FFF;
+   if (Prof_Generation == 0)
+     Prof_Generation = 1;
+   Total_Samples = Outside_Samples = 0;
+#if PROF_CAN_SAMPLE
+   Dropped_Samples = 0;
+#endif
+}
+
+/*{{{ Output */
+
+typedef struct
+{
+   char *name;
+   unsigned long calls;
+   unsigned long incl_samples;
+   unsigned long excl_samples;
+   double incl;
+   double excl;
+}
+Prof_Function_Type;
+
+static int compare_node_names (unsigned int *a, unsigned int *b)
+{
+   char *na = Prof_Nodes[*a].name, *nb = Prof_Nodes[*b].name;
+
+   if (na == nb) return 0;
+   return strcmp (na, nb);
+}
+
+static int compare_functions (Prof_Function_Type *a, Prof_Function_Type *b)
+{
+   if (a->excl != b->excl)
+     return (a->excl < b->excl) ? 1 : -1;
+   if (a->excl_samples != b->excl_samples)
+     return (a->excl_samples < b->excl_samples) ? 1 : -1;
+   return strcmp (a->name, b->name);
+}
+
+/* Whether the function of node i is also called above it */
+static int is_recursive_node (unsigned int i)
+{
+   char *name = Prof_Nodes[i].name;
+
+   while (0 != (i = Prof_Nodes[i].parent))
+     {
+	if (0 == strcmp (Prof_Nodes[i].name, name))
+	  return 1;
+     }
+   return 0;
+}
+
+static FILE *open_profile_file (char *file)
+{
+   FILE *fp;
+
+   if (Prof_Nodes == NULL)
+     {
+	SLang_verror (SL_INTRINSIC_ERROR, "No profile has been taken");
+	return NULL;
+     }
+   take_samples ();
+   if (NULL == (fp = fopen (file, "w")))
+     SLang_verror (SL_OBJ_NOPEN, "Unable to open %s", file);
+   return fp;
+}
+
+/* A line per function, those that took the most time first.  Times are
+ * in milliseconds.
+ */
+int SLang_write_profile (char *file)
+{
+   unsigned long *subtree;
+   unsigned int *order;
+   Prof_Function_Type *funs, *f;
+   unsigned int i, j, n, num_funs;
+   unsigned long dropped = 0;
+   FILE *fp;
+
+   if (NULL == (fp = open_profile_file (file)))
+     return -1;
+
+   n = Num_Prof_Nodes;
+   subtree = (unsigned long *) SLcalloc (n, sizeof (unsigned long));
+   order = (unsigned int *) SLmalloc (n * sizeof (unsigned int));
+   funs = (Prof_Function_Type *) SLcalloc (n, sizeof (Prof_Function_Type));
+   if ((subtree == NULL) || (order == NULL) || (funs == NULL))
+     {
+	SLfree ((char *) subtree);
+	SLfree ((char *) order);
+	SLfree ((char *) funs);
+	fclose (fp);
+	return -1;
+     }
+
+   /* A node comes after its parent, so a backwards pass sums subtrees */
+   for (i = n; i-- > 1;)
+     {
+	subtree[i] += Prof_Nodes[i].samples;
+	subtree[Prof_Nodes[i].parent] += subtree[i];
+     }
+
+   for (i = 1; i < n; i++)
+     order[i - 1] = i;
+   qsort ((char *) order, n - 1, sizeof (unsigned int),
+	  (int (*)(const void *, const void *)) compare_node_names);
+
+   num_funs = 0;
+   f = NULL;
+   for (j = 0; j + 1 < n; j++)
+     {
+	Prof_Node_Type *node;
+
+	i = order[j];
+	node = Prof_Nodes + i;
+	if ((f == NULL) || strcmp (f->name, node->name))
+	  {
+	     f = funs + num_funs++;
+	     f->name = node->name;
+	  }
+	f->calls += node->calls;
+	f->excl += node->excl;
+	f->excl_samples += node->samples;
+	if (0 == is_recursive_node (i))
+	  {
+	     f->incl += node->incl;
+	     f->incl_samples += subtree[i];
+	  }
+     }
+   qsort ((char *) funs, num_funs, sizeof (Prof_Function_Type),
+	  (int (*)(const void *, const void *)) compare_functions);
+
+#if PROF_CAN_SAMPLE
+   dropped = Dropped_Samples;
+#endif
+   fprintf (fp, "# S-Lang profile: %lu samples, %lu outside S-Lang, %lu dropped\n",
+	    Total_Samples, Outside_Samples, dropped);
+   fprintf (fp, "#%9s %12s %12s %10s %10s  %s\n",
+	    "calls", "incl-ms", "excl-ms", "incl-smp", "excl-smp", "function");
+   for (i = 0; i < num_funs; i++)
+     {
+	f = funs + i;
+	fprintf (fp, "%10lu %12.3f %12.3f %10lu %10lu  %s\n",
+		 f->calls, f->incl / 1000.0, f->excl / 1000.0,
+		 f->incl_samples, f->excl_samples, f->name);
+     }
+
+   SLfree ((char *) subtree);
+   SLfree ((char *) order);
+   SLfree ((char *) funs);
+   if (EOF == fclose (fp))
+     return -1;
+   return 0;
+}
+
+/* "main;f;g 12": the number of samples taken in g when called from f
+ * from main, or its exclusive microseconds if no samples were taken.
+ */
+int SLang_write_profile_stacks (char *file)
+{
+   unsigned int *path;
+   unsigned int i, depth;
+   unsigned long count;
+   FILE *fp;
+
+   if (NULL == (fp = open_profile_file (file)))
+     return -1;
+
+   if (NULL == (path = (unsigned int *) SLmalloc (Num_Prof_Nodes * sizeof (unsigned int))))
+     {
+	fclose (fp);
+	return -1;
+     }
+
+   for (i = 1; i < Num_Prof_Nodes; i++)
+     {
+	Prof_Node_Type *n = Prof_Nodes + i;
+	unsigned int j;
+
+	if (Total_Samples)
+	  count = n->samples;
+	else
+	  count = (unsigned long) (n->excl + 0.5);
+	if (count == 0)
+	  continue;
+
+	depth = 0;
+	for (j = i; j != 0; j = Prof_Nodes[j].parent)
+	  path[depth++] = j;
+	while (depth--)
+	  fprintf (fp, "%s%c", Prof_Nodes[path[depth]].name, depth ? ';' : ' ');
+	fprintf (fp, "%lu\n", count);
+     }
+
+   SLfree ((char *) path);
+   if (EOF == fclose (fp))
+     return -1;
+   return 0;
+}
+
+/*}}}*/
@@ -301,6 +301,23 @@ static void really_update (SLang_RLine_Info_Type *rli, int new_curs_position)
 	     chb = *b++; chp = *p++;
 	     if (chb == chp) continue;
 
+	     if (rli->old_upd_len == rli->new_upd_len)
+	       {
+		  /* same length: only what lies between the first and the
+		   * last difference has to go out */
+		  unsigned char *q = rli->new_upd + rli->new_upd_len;
+		  unsigned char *bq = rli->old_upd + rli->old_upd_len;
+
+		  while ((q > p) && (*(q - 1) == *(bq - 1)))
+		    {
+		       q--; bq--;
+		    }
+		  position_cursor ((int) (p - 1 - rli->new_upd));
+		  p--;
+		  while (p < q) putc((char) *p++, stdout);
+		  rli->curs_pos = (int) (q - rli->new_upd);
+		  break;
+	       }
 	     if (rli->old_upd_len <= rli->new_upd_len)
 	       {
 		  /* easy one */
@@ -447,6 +464,12 @@ static void RLupdate (SLang_RLine_Info_Type *rli)
    really_update (rli, want_cursor_pos);
 }
 
+/* Bring the display up to date after rli was changed from outside */
+void SLrline_update (SLang_RLine_Info_Type *rli)
+{
+   RLupdate (rli);
+}
+
 void SLrline_redraw (SLang_RLine_Info_Type *rli)
 {
    unsigned char *p = rli->new_upd;
@@ -540,10 +563,12 @@ static void blink_match (SLang_RLine_Info_Type *rli)
      }
 }
 
-int SLang_read_line (SLang_RLine_Info_Type *rli)
+/* Set up rli for editing and draw the prompt.  Keys are then fed to the
+ * editor one at a time with SLang_rline_key.
+ */
+int SLang_rline_start (SLang_RLine_Info_Type *rli)
 {
    unsigned char *p, *pmax;
-   SLang_Key_Type *key;
 
    SLang_Rline_Quit = 0;
    This_RLI = rli;
@@ -568,43 +593,62 @@ int SLang_read_line (SLang_RLine_Info_Type *rli)
      putc ('\r', stdout);
 
    RLupdate (rli);
+   return 0;
+}
 
-   while (1)
-     {
-	key = SLang_do_key (RL_Keymap, (int (*)(void)) rli->getkey);
+/* Read one key with rli->getkey and act on it.  Returns -2 while the line
+ * is still being edited, otherwise what SLang_read_line returns.
+ */
+int SLang_rline_key (SLang_RLine_Info_Type *rli)
+{
+   SLang_Key_Type *key;
 
-	if ((key == NULL) || (key->f.f == NULL))
-	  rl_beep ();
-	else
+   This_RLI = rli;
+   SLang_Rline_Quit = 0;
+   key = SLang_do_key (RL_Keymap, (int (*)(void)) rli->getkey);
+
+   if ((key == NULL) || (key->f.f == NULL))
+     rl_beep ();
+   else
+     {
+	if ((SLang_Last_Key_Char == SLang_RL_EOF_Char)
+	    && (*key->str == 2)
+	    && (This_RLI->len == 0))
+	  rl_eof_insert ();
+	else if (key->type == SLKEY_F_INTRINSIC)
 	  {
-	     if ((SLang_Last_Key_Char == SLang_RL_EOF_Char)
-		 && (*key->str == 2)
-		 && (This_RLI->len == 0))
-	       rl_eof_insert ();
-	     else if (key->type == SLKEY_F_INTRINSIC)
-	       {
-		  if ((key->f.f)())
-		    RLupdate (rli);
+	     if ((key->f.f)())
+	       RLupdate (rli);
 
-		  if ((rli->flags & SL_RLINE_BLINK_MATCH)
-		      && (rli->input_pending != NULL))
-		    blink_match (rli);
-	       }
+	     if ((rli->flags & SL_RLINE_BLINK_MATCH)
+		 && (rli->input_pending != NULL))
+	       blink_match (rli);
+	  }
 
-	     if (SLang_Rline_Quit)
+	if (SLang_Rline_Quit)
+	  {
+	     This_RLI->buf[This_RLI->len] = 0;
+	     if (SLang_Error == SL_USER_BREAK)
 	       {
-		  This_RLI->buf[This_RLI->len] = 0;
-		  if (SLang_Error == SL_USER_BREAK)
-		    {
-		       SLang_Error = 0;
-		       return -1;
-		    }
-		  return This_RLI->len;
+		  SLang_Error = 0;
+		  return -1;
 	       }
+	     return This_RLI->len;
 	  }
-	if (key != NULL)
-	  This_RLI->last_fun = key->f.f;
      }
+   if (key != NULL)
+     This_RLI->last_fun = key->f.f;
+   return -2;
+}
+
+int SLang_read_line (SLang_RLine_Info_Type *rli)
+{
+   int ret;
+
+   SLang_rline_start (rli);
+   while (-2 == (ret = SLang_rline_key (rli)))
+     ;
+   return ret;
 }
 
 static int rl_abort (void)
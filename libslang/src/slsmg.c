@@ -50,6 +50,7 @@ static int Bce_Color_Offset;
 
 int SLsmg_Newline_Behavior = 0;
 int SLsmg_Backspace_Moves = 0;
+void (*SLsmg_Refresh_Hook) (int, SLsmg_Char_Type *, unsigned int);
 /* Backward compatibility. Not used. */
 /* int SLsmg_Newline_Moves; */
 
@@ -80,19 +81,107 @@ static int *tt_Use_Blink_For_ACS = &SLtt_Use_Blink_For_ACS;
 
 static int Smg_Inited;
 
-static void blank_line (SLsmg_Char_Type *p, int n, unsigned char ch)
+/* Row kernels.  These work on whole runs of cells of a row and are
+ * vectorized where the compiler tells us that it is possible, the
+ * scalar loops handle the tails and everything else.
+ */
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# define SMG_SSE2_KERNELS 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define SMG_NEON_KERNELS 1
+#endif
+
+/* Set n cells to cell, returns non-zero if any cell changed */
+static int fill_cells (SLsmg_Char_Type *p, unsigned int n, SLsmg_Char_Type cell)
+{
+   SLsmg_Char_Type *pmax = p + n;
+   int changed = 0;
+
+#if SMG_SSE2_KERNELS
+   __m128i v = _mm_set1_epi16 ((short) cell);
+   __m128i all = _mm_set1_epi16 (-1);
+
+   while (p + 8 <= pmax)
+     {
+	__m128i old = _mm_loadu_si128 ((__m128i *) p);
+	all = _mm_and_si128 (all, _mm_cmpeq_epi16 (old, v));
+	_mm_storeu_si128 ((__m128i *) p, v);
+	p += 8;
+     }
+   changed = (_mm_movemask_epi8 (all) != 0xFFFF);
+#elif SMG_NEON_KERNELS
+   uint16x8_t v = vdupq_n_u16 (cell);
+   uint16x8_t all = vdupq_n_u16 (0xFFFF);
+
+   while (p + 8 <= pmax)
+     {
+	all = vandq_u16 (all, vceqq_u16 (vld1q_u16 (p), v));
+	vst1q_u16 (p, v);
+	p += 8;
+     }
+# ifdef __aarch64__
+   changed = (vminvq_u16 (all) != 0xFFFF);
+# else
+     {
+	/* No across-vector minimum on 32-bit ARM; fold pairwise instead */
+	uint16x4_t min = vpmin_u16 (vget_low_u16 (all), vget_high_u16 (all));
+	min = vpmin_u16 (min, min);
+	min = vpmin_u16 (min, min);
+	changed = (vget_lane_u16 (min, 0) != 0xFFFF);
+     }
+# endif
+#endif
+
+   while (p < pmax)
+     {
+	changed |= (*p != cell);
+	*p++ = cell;
+     }
+   return changed;
+}
+
+/* *p = (*p & char_mask) | color for n cells */
+static void recolor_cells (SLsmg_Char_Type *p, unsigned int n,
+			   SLsmg_Char_Type char_mask, SLsmg_Char_Type color)
 {
-   register SLsmg_Char_Type *pmax = p + n;
-   register SLsmg_Char_Type color_ch;
+   SLsmg_Char_Type *pmax = p + n;
 
-   color_ch = SLSMG_BUILD_CHAR(ch,This_Color);
+#if SMG_SSE2_KERNELS
+   __m128i m = _mm_set1_epi16 ((short) char_mask);
+   __m128i c = _mm_set1_epi16 ((short) color);
+
+   while (p + 8 <= pmax)
+     {
+	__m128i x = _mm_loadu_si128 ((__m128i *) p);
+	_mm_storeu_si128 ((__m128i *) p, _mm_or_si128 (_mm_and_si128 (x, m), c));
+	p += 8;
+     }
+#elif SMG_NEON_KERNELS
+   uint16x8_t m = vdupq_n_u16 (char_mask);
+   uint16x8_t c = vdupq_n_u16 (color);
+
+   while (p + 8 <= pmax)
+     {
+	vst1q_u16 (p, vorrq_u16 (vandq_u16 (vld1q_u16 (p), m), c));
+	p += 8;
+     }
+#endif
 
    while (p < pmax)
      {
-	*p++ = color_ch;
+	*p = (*p & char_mask) | color;
+	p++;
      }
 }
 
+static void blank_line (SLsmg_Char_Type *p, int n, unsigned char ch)
+{
+   if (n <= 0) return;
+   (void) fill_cells (p, (unsigned int) n, SLSMG_BUILD_CHAR(ch,This_Color));
+}
+
 static void clear_region (int row, int n, unsigned char ch)
 {
    int i;
@@ -850,6 +939,15 @@ void SLsmg_refresh (void)
 #endif
      }
 
+   if (SLsmg_Refresh_Hook != NULL)
+     {
+	for (i = 0; i < Screen_Rows; i++)
+	  {
+	     if (SL_Screen[i].flags == 0) continue;
+	     (*SLsmg_Refresh_Hook) (i, SL_Screen[i].neew, (unsigned int) Screen_Cols);
+	  }
+     }
+
 #ifndef IBMPC_SYSTEM
    for (i = 0; i < Screen_Rows; i++)
      {
@@ -903,6 +1001,9 @@ void SLsmg_refresh (void)
    (*tt_flush_output) ();
    Cls_Flag = 0;
    Screen_Trashed = 0;
+
+   if (SLsmg_Refresh_Hook != NULL)
+     (*SLsmg_Refresh_Hook) (-1, NULL, 0);
 }
 
 static int compute_clip (int row, int n, int box_start, int box_end,
@@ -1334,6 +1435,8 @@ void SLsmg_fill_region (int r, int c, unsigned int dr, unsigned int dc, unsigned
    static unsigned char hbuf[16];
    int count;
    int dcmax, rmax;
+   int cmin, cmax, rmin, row;
+   SLsmg_Char_Type cell;
 
    if (Smg_Inited == 0) return;
 
@@ -1346,6 +1449,34 @@ void SLsmg_fill_region (int r, int c, unsigned int dr, unsigned int dc, unsigned
 
    if (dc > (unsigned int) dcmax) dc = (unsigned int) dcmax;
 
+   /* A character that occupies exactly one cell is stored directly
+    * into the rows, anything else has to go through write_nchars.
+    */
+   if (((ch >= ' ') && (ch < 127))
+       || (ch >= (unsigned char) SLsmg_Display_Eight_Bit))
+     {
+#ifndef IBMPC_SYSTEM
+	if ((This_Color & ALT_CHAR_FLAG)
+	    && ((tt_Use_Blink_For_ACS == NULL) || (*tt_Use_Blink_For_ACS == 0)))
+	  ch = Alt_Char_Set [ch & 0x7F];
+#endif
+	cell = SLSMG_BUILD_CHAR(ch, This_Color);
+
+	if (compute_clip (c, (int) dc, Start_Col, Start_Col + Screen_Cols, &cmin, &cmax)
+	    && compute_clip (r, (int) dr, Start_Row, Start_Row + Screen_Rows, &rmin, &rmax))
+	  {
+	     for (row = rmin - Start_Row; row < rmax - Start_Row; row++)
+	       {
+		  if (fill_cells (SL_Screen[row].neew + (cmin - Start_Col),
+				  (unsigned int) (cmax - cmin), cell))
+		    SL_Screen[row].flags |= TOUCHED;
+	       }
+	  }
+	This_Row = r;
+	This_Col = c + (int) dc;
+	return;
+     }
+
    rmax = This_Row + dr;
    if (rmax > Screen_Rows) rmax = Screen_Rows;
 
@@ -1503,21 +1634,144 @@ SLsmg_set_color_in_region (int color, int r, int c, unsigned int dr, unsigned in
      char_mask = 0x80FF;
 #endif
 
+   if (c >= cmax) return;
+
    while (r < rmax)
      {
-	SLsmg_Char_Type *s, *smax;
-
 	SL_Screen[r].flags |= TOUCHED;
-	s = SL_Screen[r].neew;
-	smax = s + cmax;
-	s += c;
+	recolor_cells (SL_Screen[r].neew + c, (unsigned int) (cmax - c),
+		       char_mask, (SLsmg_Char_Type) color);
+	r++;
+     }
+}
 
-	while (s < smax)
+/* Tile the region with a pattern of pw x ph cells.  The pattern rows
+ * are laid out one after the other and are anchored at the upper left
+ * corner of the region.  Each screen row is built by copying the
+ * pattern row once and then doubling what has been copied so far.
+ */
+void SLsmg_paint_region (int r, int c, unsigned int dr, unsigned int dc,
+			 SLsmg_Char_Type *pat, unsigned int pw, unsigned int ph)
+{
+   int rmin, rmax, cmin, cmax, row;
+   unsigned int n, done, chunk, off;
+   SLsmg_Char_Type *s, *p;
+
+   if ((Smg_Inited == 0) || (pat == NULL) || (pw == 0) || (ph == 0))
+     return;
+
+   if ((0 == compute_clip (c, (int) dc, Start_Col, Start_Col + Screen_Cols, &cmin, &cmax))
+       || (0 == compute_clip (r, (int) dr, Start_Row, Start_Row + Screen_Rows, &rmin, &rmax)))
+     return;
+
+   n = (unsigned int) (cmax - cmin);
+   for (row = rmin; row < rmax; row++)
+     {
+	p = pat + ((unsigned int) (row - r) % ph) * pw;
+	s = SL_Screen[row - Start_Row].neew + (cmin - Start_Col);
+
+	off = (unsigned int) (cmin - c) % pw;
+	done = pw - off;
+	if (done > n) done = n;
+	SLMEMCPY ((char *) s, (char *) (p + off), done * sizeof (SLsmg_Char_Type));
+	if (done < n)
 	  {
-	     *s = (*s & char_mask) | color;
-	     s++;
+	     chunk = (n - done < pw) ? n - done : pw;
+	     SLMEMCPY ((char *) (s + done), (char *) p, chunk * sizeof (SLsmg_Char_Type));
+	     done += chunk;
+	  }
+	/* s[off'..] is now periodic with period pw, keep doubling */
+	while (done < n)
+	  {
+	     unsigned int period = done - (done % pw);
+
+	     chunk = (period > n - done) ? n - done : period;
+	     SLMEMCPY ((char *) (s + done), (char *) (s + (done - period)),
+		       chunk * sizeof (SLsmg_Char_Type));
+	     done += chunk;
+	  }
+#if REQUIRES_NON_BCE_SUPPORT
+	if (Bce_Color_Offset)
+	  {
+	     SLsmg_Char_Type *smax = s + n;
+	     while (s < smax)
+	       {
+		  int color = SLSMG_EXTRACT_COLOR(*s);
+		  if (color & 0x80)
+		    color = ((color & 0x7F) + Bce_Color_Offset) | 0x80;
+		  else
+		    color = ((color & 0x7F) + Bce_Color_Offset) & 0x7F;
+		  *s = SLSMG_BUILD_CHAR(SLSMG_EXTRACT_CHAR(*s), color);
+		  s++;
+	       }
+	  }
+#endif
+	SL_Screen[row - Start_Row].flags |= TOUCHED;
+     }
+}
+
+/* Move the contents of a region up by n rows (down if n is negative).
+ * The rows that are uncovered keep their old contents and are expected
+ * to be redrawn by the caller.  When the region spans the whole width
+ * the lines are simply rotated, and SLsmg_refresh will then find the
+ * scroll via the line hashes and let the terminal do it.
+ */
+void SLsmg_scroll_region (int r, int c, unsigned int dr, unsigned int dc, int n)
+{
+   int cmax, rmax, i, nabs;
+   SLsmg_Char_Type *tmp[SLTT_MAX_SCREEN_ROWS];
+
+   if (Smg_Inited == 0) return;
+
+   c -= Start_Col;
+   r -= Start_Row;
+
+   cmax = c + (int) dc;
+   rmax = r + (int) dr;
+
+   if (cmax > Screen_Cols) cmax = Screen_Cols;
+   if (rmax > Screen_Rows) rmax = Screen_Rows;
+
+   if (c < 0) c = 0;
+   if (r < 0) r = 0;
+
+   nabs = (n < 0) ? -n : n;
+   if ((n == 0) || (nabs >= rmax - r) || (c >= cmax))
+     return;
+
+   if ((c == 0) && (cmax == Screen_Cols))
+     {
+	int nrows = rmax - r;
+
+	for (i = 0; i < nrows; i++)
+	  tmp[i] = SL_Screen[r + i].neew;
+	for (i = 0; i < nrows; i++)
+	  {
+	     SL_Screen[r + i].neew = tmp[(i + n + nrows) % nrows];
+	     SL_Screen[r + i].flags |= TOUCHED;
+	  }
+	return;
+     }
+
+   if (n > 0)
+     {
+	for (i = r; i < rmax - n; i++)
+	  {
+	     SLMEMCPY ((char *) (SL_Screen[i].neew + c),
+		       (char *) (SL_Screen[i + n].neew + c),
+		       (cmax - c) * sizeof (SLsmg_Char_Type));
+	     SL_Screen[i].flags |= TOUCHED;
+	  }
+     }
+   else
+     {
+	for (i = rmax - 1; i >= r + nabs; i--)
+	  {
+	     SLMEMCPY ((char *) (SL_Screen[i].neew + c),
+		       (char *) (SL_Screen[i - nabs].neew + c),
+		       (cmax - c) * sizeof (SLsmg_Char_Type));
+	     SL_Screen[i].flags |= TOUCHED;
 	  }
-	r++;
      }
 }
 
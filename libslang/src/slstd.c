@@ -612,6 +612,16 @@ static void lang_print_stack (void)
    (void) _SLang_dump_stack ();
 }
 
+static int bytecode_stats_intrin (int *on)
+{
+   return SLang_collect_bytecode_stats (*on);
+}
+
+static int profile_intrin (int *flags)
+{
+   return SLang_set_profile (*flags);
+}
+
 static SLang_Intrin_Fun_Type SLang_Basic_Table [] = /*{{{*/
 {
    MAKE_INTRINSIC_1("__is_initialized", _SLang_is_ref_initialized, SLANG_INT_TYPE, SLANG_REF_TYPE),
@@ -638,6 +648,12 @@ static SLang_Intrin_Fun_Type SLang_Basic_Table [] = /*{{{*/
    MAKE_INTRINSIC_0("_apropos",  intrin_apropos, SLANG_VOID_TYPE),
    MAKE_INTRINSIC_0("_get_namespaces", intrin_get_namespaces, SLANG_VOID_TYPE),
    MAKE_INTRINSIC_S("_trace_function",  _SLang_trace_fun, SLANG_VOID_TYPE),
+   MAKE_INTRINSIC_I("_bytecode_stats", bytecode_stats_intrin, SLANG_INT_TYPE),
+   MAKE_INTRINSIC_S("_write_bytecode_stats", SLang_write_bytecode_stats, SLANG_INT_TYPE),
+   MAKE_INTRINSIC_I("_profile", profile_intrin, SLANG_INT_TYPE),
+   MAKE_INTRINSIC_0("_profile_reset", SLang_reset_profile, SLANG_VOID_TYPE),
+   MAKE_INTRINSIC_S("_write_profile", SLang_write_profile, SLANG_INT_TYPE),
+   MAKE_INTRINSIC_S("_write_profile_stacks", SLang_write_profile_stacks, SLANG_INT_TYPE),
 #if SLANG_HAS_FLOAT
    MAKE_INTRINSIC_S("atof", _SLang_atof, SLANG_DOUBLE_TYPE),
    MAKE_INTRINSIC_0("double", intrin_double, SLANG_VOID_TYPE),
@@ -685,6 +701,7 @@ static SLang_Intrin_Var_Type Intrin_Vars[] =
    MAKE_VARIABLE("_auto_declare", &_SLang_Auto_Declare_Globals, SLANG_INT_TYPE, 0),
    MAKE_VARIABLE("_traceback", &SLang_Traceback, SLANG_INT_TYPE, 0),
    MAKE_VARIABLE("_slangtrace", &_SLang_Trace, SLANG_INT_TYPE, 0),
+   MAKE_VARIABLE("_profile_interval", &SLang_Profile_Interval, SLANG_INT_TYPE, 0),
    MAKE_VARIABLE("_slang_version", &SLang_Version, SLANG_INT_TYPE, 1),
    MAKE_VARIABLE("_slang_version_string", &SLang_Version_String, SLANG_STRING_TYPE, 1),
    MAKE_VARIABLE("_NARGS", &SLang_Num_Function_Args, SLANG_INT_TYPE, 1),
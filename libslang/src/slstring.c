@@ -17,7 +17,6 @@ typedef struct _SLstring_Type
 }
 SLstring_Type;
 
-static SLstring_Type *String_Hash_Table [SLSTRING_HASH_TABLE_SIZE];
 static char Single_Char_Strings [256 * 2];
 
 #if _SLANG_OPTIMIZE_FOR_SPEED
@@ -32,10 +31,27 @@ typedef struct
    unsigned int len;
 }
 Cached_String_Type;
-static Cached_String_Type Cached_Strings [NUM_CACHED_STRINGS];
+#endif
+
+/* Each interpreter context interns its strings in a table of its own.
+ * The single and zero character strings are shared by all of them.
+ */
+struct _SLstring_Table_Type
+{
+   SLstring_Type *hash_table [SLSTRING_HASH_TABLE_SIZE];
+#if _SLANG_OPTIMIZE_FOR_SPEED
+   Cached_String_Type cached_strings [NUM_CACHED_STRINGS];
+#endif
+   struct _SLstring_Table_Type *next;
+};
 
+static _SLstring_Table_Type Default_String_Table;
+static _SLstring_Table_Type *String_Table = &Default_String_Table;
+#define String_Hash_Table (String_Table->hash_table)
+
+#if _SLANG_OPTIMIZE_FOR_SPEED
 #define GET_CACHED_STRING(s) \
-   (Cached_Strings + (unsigned int)(((unsigned long) (s)) % NUM_CACHED_STRINGS))
+   (String_Table->cached_strings + (unsigned int)(((unsigned long) (s)) % NUM_CACHED_STRINGS))
 
 _INLINE_
 static void cache_string (SLstring_Type *sls, unsigned int len, unsigned long hash)
@@ -158,6 +174,29 @@ static SLstring_Type *find_slstring (char *s, unsigned long hash)
    return sls;
 }
 
+/* A string that is not in the table of the current context may belong
+ * to another one, e.g., the name of an intrinsic function.  Look for it
+ * there and make that table current.  The table that was current is
+ * returned, or NULL if the string was not found.
+ */
+static _SLstring_Table_Type *find_foreign_slstring (char *s, unsigned long hash, SLstring_Type **slsp)
+{
+   _SLstring_Table_Type *t, *save;
+
+   save = String_Table;
+   for (t = &Default_String_Table; t != NULL; t = t->next)
+     {
+	if (t == save)
+	  continue;
+
+	String_Table = t;
+	if (NULL != (*slsp = find_slstring (s, hash)))
+	  return save;
+     }
+   String_Table = save;
+   return NULL;
+}
+
 _INLINE_
 static SLstring_Type *allocate_sls (unsigned int len)
 {
@@ -337,8 +376,16 @@ char *_SLstring_dup_slstring (char *s)
    sls = find_slstring (s, hash);
    if (sls == NULL)
      {
-	SLang_Error = SL_INTERNAL_ERROR;
-	return NULL;
+	_SLstring_Table_Type *save;
+
+	if (NULL == (save = find_foreign_slstring (s, hash, &sls)))
+	  {
+	     SLang_Error = SL_INTERNAL_ERROR;
+	     return NULL;
+	  }
+	String_Table = save;
+	sls->ref_count++;
+	return s;
      }
    
    sls->ref_count++;
@@ -387,7 +434,16 @@ static void free_long_string (char *s, unsigned int len, unsigned long hash)
 
    if (NULL == (sls = find_slstring (s, hash)))
      {
-	SLang_doerror ("Application internal error: invalid attempt to free string");
+	_SLstring_Table_Type *save;
+
+	if (NULL == (save = find_foreign_slstring (s, hash, &sls)))
+	  {
+	     SLang_doerror ("Application internal error: invalid attempt to free string");
+	     return;
+	  }
+	if (--sls->ref_count == 0)
+	  free_sls_string (sls, s, len, hash);
+	String_Table = save;
 	return;
      }
 
@@ -546,3 +602,74 @@ char *SLang_concat_slstrings (char *a, char *b)
    return _SLcreate_via_alloced_slstring (c, len);
 }
 
+
+_SLstring_Table_Type *_SLstring_new_table (void)
+{
+   _SLstring_Table_Type *t;
+
+   t = (_SLstring_Table_Type *) SLcalloc (1, sizeof (_SLstring_Table_Type));
+   if (t == NULL)
+     return NULL;
+
+   t->next = Default_String_Table.next;
+   Default_String_Table.next = t;
+   return t;
+}
+
+/* Make t the table that strings are interned in, or the default table if
+ * t is NULL.  The table that was in use is returned.
+ */
+_SLstring_Table_Type *_SLstring_switch_table (_SLstring_Table_Type *t)
+{
+   _SLstring_Table_Type *old;
+
+   if (t == NULL)
+     t = &Default_String_Table;
+
+   old = String_Table;
+   String_Table = t;
+   return old;
+}
+
+/* Strings that are still in use when a table is freed, e.g., the names of
+ * data types that were defined in its context, are moved to the default
+ * table.
+ */
+void _SLstring_free_table (_SLstring_Table_Type *t)
+{
+   _SLstring_Table_Type *prev;
+   SLstring_Type *sls, *next;
+   unsigned long hash;
+   unsigned int i;
+
+   if ((t == NULL) || (t == &Default_String_Table))
+     return;
+
+   prev = &Default_String_Table;
+   while (prev->next != t)
+     {
+	if (prev->next == NULL)
+	  return;
+	prev = prev->next;
+     }
+   prev->next = t->next;
+
+   if (String_Table == t)
+     String_Table = &Default_String_Table;
+
+   for (i = 0; i < SLSTRING_HASH_TABLE_SIZE; i++)
+     {
+	sls = t->hash_table[i];
+	while (sls != NULL)
+	  {
+	     next = sls->next;
+	     hash = _SLstring_hash ((unsigned char *) sls->bytes,
+				   (unsigned char *) sls->bytes + strlen (sls->bytes));
+	     hash = hash % SLSTRING_HASH_TABLE_SIZE;
+	     sls->next = Default_String_Table.hash_table[(unsigned int) hash];
+	     Default_String_Table.hash_table[(unsigned int) hash] = sls;
+	     sls = next;
+	  }
+     }
+   SLfree ((char *) t);
+}
@@ -144,6 +144,18 @@ static _SLstruct_Field_Type *find_field (_SLang_Struct_Type *s, char *name)
 	f++;
      }
 
+   /* A struct of a type defined in another interpreter context has its
+    * field names in the string table of that context.
+    */
+   f = s->fields;
+   while (f < fmax)
+     {
+	if (0 == strcmp (name, f->name))
+	  return f;
+
+	f++;
+     }
+
    return NULL;
 }
 
@@ -545,6 +557,78 @@ static int struct_sget (unsigned char type, char *name)
    return ret;
 }
 
+/* The interpreter's FIELD and SET_STRUCT_LVALUE byte-codes come here
+ * with a cache of the index at which their field was last found.
+ * Structs of one definition or typedef have their fields in the same
+ * order, and field names are slstrings, so a pointer compare at that
+ * index tells whether the guess is right.  A miss scans the fields as
+ * before and updates the cache.  Classes with other sget/sput methods
+ * are passed on to them.
+ */
+static _SLstruct_Field_Type *
+  pop_cached_field (_SLang_Struct_Type *s, char *name, unsigned short *cache)
+{
+   _SLstruct_Field_Type *f;
+   unsigned int i = *cache;
+
+   if ((i < s->nfields) && (s->fields[i].name == name))
+     return s->fields + i;
+
+   if (NULL != (f = pop_field (s, name, find_field)))
+     *cache = (unsigned short) (f - s->fields);
+   return f;
+}
+
+int _SLstruct_sget_cached (SLang_Class_Type *cl, unsigned char type, char *name,
+			   unsigned short *cache)
+{
+   _SLang_Struct_Type *s;
+   _SLstruct_Field_Type *f;
+   int ret;
+
+   if (cl->cl_sget != struct_sget)
+     return (*cl->cl_sget) (type, name);
+
+   if (-1 == _SLang_pop_struct (&s))
+     return -1;
+
+   if (NULL == (f = pop_cached_field (s, name, cache)))
+     {
+	_SLstruct_delete_struct (s);
+	return -1;
+     }
+
+   ret = _SLpush_slang_obj (&f->obj);
+   _SLstruct_delete_struct (s);
+   return ret;
+}
+
+int _SLstruct_sput_cached (SLang_Class_Type *cl, unsigned char type, char *name,
+			   unsigned short *cache)
+{
+   _SLang_Struct_Type *s;
+   _SLstruct_Field_Type *f;
+   SLang_Object_Type obj;
+
+   if (cl->cl_sput != struct_sput)
+     return (*cl->cl_sput) (type, name);
+
+   if (-1 == _SLang_pop_struct (&s))
+     return -1;
+
+   if ((NULL == (f = pop_cached_field (s, name, cache)))
+       || (-1 == SLang_pop (&obj)))
+     {
+	_SLstruct_delete_struct (s);
+	return -1;
+     }
+
+   SLang_free_object (&f->obj);
+   f->obj = obj;
+   _SLstruct_delete_struct (s);
+   return 0;
+}
+
 static int struct_typecast
   (unsigned char a_type, VOID_STAR ap, unsigned int na,
    unsigned char b_type, VOID_STAR bp)
@@ -9,6 +9,13 @@
 #include "slang.h"
 #include "_slang.h"
 
+#ifdef REAL_UNIX_SYSTEM
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <time.h>
+#endif
+
 #define MAX_TOKEN_LEN 254
 #define MAX_FILE_LINE_LEN 256
 
@@ -1074,6 +1081,480 @@ int SLang_load_file_verbose (int v)
    return v1;
 }
 
+/*{{{ binary byte-compiled images */
+
+/* By default, SLang_byte_compile_file saves the tokens that the parser
+ * hands to the compiler as a binary image:
+ *
+ *    "\177SLC"
+ *    format version, SLANG_VERSION, length and hash of the source,
+ *      modification time of the source, number of strings, number of
+ *      bytes of tokens, hash of the rest
+ *    the strings: each one is a length, its bytes, and a 0 byte
+ *    the tokens: a type byte followed by the value of an integer token
+ *      or the index of the string of an identifier, literal, etc.
+ *
+ * All numbers are varints, 7 bits per byte with the low bits first.  An
+ * identifier or literal is in the string table only once however often it
+ * is used.  Loading maps the file, computes the hash of each string once,
+ * and passes the tokens straight to the compiler.  The tokenizer, escape
+ * processing, and number parsing are skipped.  The hash of the source is
+ * that of its contents, so an image whose source has been edited since is
+ * ignored and the source is loaded instead.  Reading the whole source for
+ * that on every load would cost about what the tokenizer saves, so a source
+ * that still has the length and modification time recorded in the image is
+ * taken to be unchanged without it.  A source modified in the second the
+ * image was written is recorded with a time of 0, which never matches.
+ * The hash of the strings and tokens catches images that have been damaged
+ * in a way that would still decode.
+ */
+#define IMAGE_MAGIC		"\177SLC"
+#define IMAGE_MAGIC_LEN		4
+#define IMAGE_FORMAT_VERSION	3
+
+#define IMAGE_OPERAND_NONE	0
+#define IMAGE_OPERAND_INTEGER	1
+#define IMAGE_OPERAND_STRING	2
+
+/* 32 bit FNV-1a */
+#define IMAGE_HASH_INIT		2166136261UL
+static unsigned long image_hash (unsigned char *s, unsigned char *smax,
+				 unsigned long h)
+{
+   while (s < smax)
+     {
+	h ^= *s++;
+	h = (h * 16777619UL) & 0xFFFFFFFFUL;
+     }
+   return h;
+}
+
+static int hash_source_file (char *file, unsigned long *lenp, unsigned long *hashp)
+{
+   FILE *fp;
+   unsigned char buf [4096];
+   unsigned long len, hash;
+   unsigned int n;
+
+   if (NULL == (fp = fopen (file, "rb")))
+     return -1;
+
+   len = 0;
+   hash = IMAGE_HASH_INIT;
+   while (0 != (n = fread (buf, 1, sizeof (buf), fp)))
+     {
+	hash = image_hash (buf, buf + n, hash);
+	len += n;
+     }
+   fclose (fp);
+
+   *lenp = len;
+   *hashp = hash;
+   return 0;
+}
+
+/* The modification time to record for file, 0 if it cannot be trusted */
+static unsigned long image_source_mtime (char *file)
+{
+#ifdef REAL_UNIX_SYSTEM
+   struct stat st;
+
+   if ((-1 == stat (file, &st))
+       || (st.st_mtime >= time (NULL)))
+     return 0;
+   return (unsigned long) st.st_mtime;
+#else
+   (void) file;
+   return 0;
+#endif
+}
+
+static int image_token_operand (unsigned char type)
+{
+   switch (type)
+     {
+      case LINE_NUM_TOKEN:
+      case CHAR_TOKEN:
+      case UCHAR_TOKEN:
+      case SHORT_TOKEN:
+      case USHORT_TOKEN:
+      case INT_TOKEN:
+      case UINT_TOKEN:
+      case LONG_TOKEN:
+      case ULONG_TOKEN:
+	return IMAGE_OPERAND_INTEGER;
+
+      case COMPLEX_TOKEN:
+      case FLOAT_TOKEN:
+      case DOUBLE_TOKEN:
+      case STRING_TOKEN:
+      case _BSTRING_TOKEN:
+      case TMP_TOKEN:
+      case DEFINE_TOKEN:
+      case DEFINE_STATIC_TOKEN:
+      case DEFINE_PRIVATE_TOKEN:
+      case DEFINE_PUBLIC_TOKEN:
+      case DOT_TOKEN:
+      case IDENT_TOKEN:
+      case _REF_TOKEN:
+      case _DEREF_ASSIGN_TOKEN:
+      case _SCALAR_ASSIGN_TOKEN:
+      case _SCALAR_PLUSEQS_TOKEN:
+      case _SCALAR_MINUSEQS_TOKEN:
+      case _SCALAR_TIMESEQS_TOKEN:
+      case _SCALAR_DIVEQS_TOKEN:
+      case _SCALAR_BOREQS_TOKEN:
+      case _SCALAR_BANDEQS_TOKEN:
+      case _SCALAR_PLUSPLUS_TOKEN:
+      case _SCALAR_POST_PLUSPLUS_TOKEN:
+      case _SCALAR_MINUSMINUS_TOKEN:
+      case _SCALAR_POST_MINUSMINUS_TOKEN:
+      case _STRUCT_ASSIGN_TOKEN:
+      case _STRUCT_PLUSEQS_TOKEN:
+      case _STRUCT_MINUSEQS_TOKEN:
+      case _STRUCT_TIMESEQS_TOKEN:
+      case _STRUCT_DIVEQS_TOKEN:
+      case _STRUCT_BOREQS_TOKEN:
+      case _STRUCT_BANDEQS_TOKEN:
+      case _STRUCT_POST_MINUSMINUS_TOKEN:
+      case _STRUCT_MINUSMINUS_TOKEN:
+      case _STRUCT_POST_PLUSPLUS_TOKEN:
+      case _STRUCT_PLUSPLUS_TOKEN:
+	return IMAGE_OPERAND_STRING;
+     }
+   return IMAGE_OPERAND_NONE;
+}
+
+typedef struct
+{
+   char *str;
+   unsigned int len;
+   unsigned long hash;
+   int next;			       /* hash chain, used when writing */
+}
+Image_String_Type;
+
+typedef struct
+{
+   unsigned char *data;		       /* the whole file */
+   unsigned long size;
+   int is_mmapped;
+
+   unsigned long format_version;
+   unsigned long slang_version;
+   unsigned long source_len;
+   unsigned long source_hash;
+   unsigned long source_mtime;
+
+   Image_String_Type *strings;
+   unsigned long num_strings;
+   unsigned char *tokens, *tokens_max;
+   int started;
+}
+Image_Type;
+
+static int image_get_varint (unsigned char **pp, unsigned char *pmax,
+			     unsigned long *vp)
+{
+   unsigned char *p;
+   unsigned long v;
+   unsigned int shift;
+
+   p = *pp;
+   v = 0;
+   shift = 0;
+   while ((p < pmax) && (shift < 8 * sizeof (unsigned long)))
+     {
+	unsigned char ch = *p++;
+
+	v |= (unsigned long) (ch & 0x7F) << shift;
+	if (0 == (ch & 0x80))
+	  {
+	     *pp = p;
+	     *vp = v;
+	     return 0;
+	  }
+	shift += 7;
+     }
+   return -1;
+}
+
+static void close_image (Image_Type *img)
+{
+   if (img == NULL)
+     return;
+
+   SLfree ((char *) img->strings);
+#ifdef REAL_UNIX_SYSTEM
+   if (img->is_mmapped)
+     (void) munmap ((char *) img->data, img->size);
+   else
+#endif
+     SLfree ((char *) img->data);
+   SLfree ((char *) img);
+}
+
+/* Read the header and set up the string table */
+static int link_image (Image_Type *img)
+{
+   unsigned char *p, *pmax;
+   unsigned long i, tokens_len, hash;
+
+   p = img->data + IMAGE_MAGIC_LEN;
+   pmax = img->data + img->size;
+
+   if ((-1 == image_get_varint (&p, pmax, &img->format_version))
+       || (-1 == image_get_varint (&p, pmax, &img->slang_version))
+       || (-1 == image_get_varint (&p, pmax, &img->source_len))
+       || (-1 == image_get_varint (&p, pmax, &img->source_hash)))
+     return -1;
+
+   if ((img->format_version != IMAGE_FORMAT_VERSION)
+       || (img->slang_version != SLANG_VERSION))
+     return 0;			       /* not ours to read */
+
+   if ((-1 == image_get_varint (&p, pmax, &img->source_mtime))
+       || (-1 == image_get_varint (&p, pmax, &img->num_strings))
+       || (-1 == image_get_varint (&p, pmax, &tokens_len))
+       || (-1 == image_get_varint (&p, pmax, &hash))
+       || (img->num_strings > (unsigned long) (pmax - p))
+       || (hash != image_hash (p, pmax, IMAGE_HASH_INIT)))
+     return -1;
+
+   if (img->num_strings
+       && (NULL == (img->strings = (Image_String_Type *) SLmalloc (img->num_strings * sizeof (Image_String_Type)))))
+     return -1;
+
+   for (i = 0; i < img->num_strings; i++)
+     {
+	Image_String_Type *s = img->strings + i;
+	unsigned long len;
+
+	if ((-1 == image_get_varint (&p, pmax, &len))
+	    || (len >= (unsigned long) (pmax - p))
+	    || (p[len] != 0))
+	  return -1;
+
+	s->str = (char *) p;
+	s->len = (unsigned int) len;
+	s->hash = _SLstring_hash (p, p + len);
+	p += len + 1;
+     }
+
+   if (tokens_len != (unsigned long) (pmax - p))
+     return -1;
+   img->tokens = p;
+   img->tokens_max = pmax;
+   return 0;
+}
+
+/* Returns 1 if file is a binary image, 0 if it is not, or -1 upon error */
+static int open_image (char *file, Image_Type **imgp)
+{
+   FILE *fp;
+   char magic [IMAGE_MAGIC_LEN];
+   Image_Type *img;
+   long size;
+
+   *imgp = NULL;
+   if (NULL == (fp = fopen (file, "rb")))
+     return 0;
+
+   if ((IMAGE_MAGIC_LEN != fread (magic, 1, IMAGE_MAGIC_LEN, fp))
+       || (0 != memcmp (magic, IMAGE_MAGIC, IMAGE_MAGIC_LEN))
+       || (-1 == fseek (fp, 0, SEEK_END))
+       || (-1 == (size = ftell (fp))))
+     {
+	fclose (fp);
+	return 0;
+     }
+
+   if (NULL == (img = (Image_Type *) SLmalloc (sizeof (Image_Type))))
+     {
+	fclose (fp);
+	return -1;
+     }
+   memset ((char *) img, 0, sizeof (Image_Type));
+   img->size = (unsigned long) size;
+
+#ifdef REAL_UNIX_SYSTEM
+   img->data = (unsigned char *) mmap (NULL, img->size, PROT_READ, MAP_PRIVATE, fileno (fp), 0);
+   if (img->data == (unsigned char *) MAP_FAILED)
+     img->data = NULL;
+   else
+     img->is_mmapped = 1;
+#endif
+   if (img->data == NULL)
+     {
+	if ((NULL == (img->data = (unsigned char *) SLmalloc (img->size + 1)))
+	    || (-1 == fseek (fp, 0, SEEK_SET))
+	    || (img->size != fread (img->data, 1, img->size, fp)))
+	  {
+	     if (img->data != NULL)
+	       SLang_verror (SL_OBJ_NOPEN, "Error reading %s", file);
+	     fclose (fp);
+	     close_image (img);
+	     return -1;
+	  }
+     }
+   fclose (fp);
+
+   if (-1 == link_image (img))
+     {
+	SLang_verror (SL_OBJ_NOPEN, "Byte compiled file %s appears corrupt", file);
+	close_image (img);
+	return -1;
+     }
+
+   *imgp = img;
+   return 1;
+}
+
+/* Returns 1 if source is what img was made from, 0 if it is not, or -1
+ * if it cannot be read.
+ */
+static int image_source_is_current (Image_Type *img, char *source)
+{
+   unsigned long len, hash;
+#ifdef REAL_UNIX_SYSTEM
+   struct stat st;
+
+   if (-1 == stat (source, &st))
+     return -1;
+   if ((unsigned long) st.st_size != img->source_len)
+     return 0;
+   if ((img->source_mtime != 0)
+       && ((unsigned long) st.st_mtime == img->source_mtime))
+     return 1;
+#endif
+   if (-1 == hash_source_file (source, &len, &hash))
+     return -1;
+   return ((len == img->source_len) && (hash == img->source_hash));
+}
+
+/* If *filep is an image, open it unless it was made from a different
+ * version of its source, file without the trailing 'c', in which case
+ * *filep becomes the source.  An image whose source cannot be found is
+ * assumed to be current.
+ */
+static int open_current_image (char **filep, Image_Type **imgp)
+{
+   Image_Type *img;
+   char *file, *source;
+   unsigned int len;
+   int ret, current = 0;
+
+   file = *filep;
+   if (1 != (ret = open_image (file, imgp)))
+     return ret;
+   img = *imgp;
+
+   len = strlen (file);
+   if ((len < 2) || (file[len - 1] != 'c')
+       || (NULL == (source = SLang_create_nslstring (file, len - 1))))
+     source = NULL;
+   else if ((img->tokens != NULL)
+	    && (-1 == (current = image_source_is_current (img, source))))
+     {
+	SLang_free_slstring (source);
+	source = NULL;
+     }
+
+   if (source == NULL)
+     {
+	if (img->tokens != NULL)
+	  return 1;
+	SLang_verror (SL_OBJ_NOPEN, "%s was byte-compiled by another version of S-Lang", file);
+	close_image (img);
+	*imgp = NULL;
+	return -1;
+     }
+
+   if ((img->tokens != NULL) && current)
+     {
+	SLang_free_slstring (source);
+	return 1;
+     }
+
+   if (Load_File_Verbose)
+     SLang_vmessage ("%s is out of date", file);
+   close_image (img);
+   *imgp = NULL;
+   SLang_free_slstring (file);
+   *filep = source;
+   return 0;
+}
+
+/* The parser sees a byte-compiled file, and _SLcompile_byte_compiled
+ * takes over from there.
+ */
+static char Image_Start_Line[] = ".#";
+static char *read_from_image (SLang_Load_Type *x)
+{
+   Image_Type *img = (Image_Type *) x->client_data;
+
+   if (img->started)
+     return NULL;
+   img->started = 1;
+   return Image_Start_Line;
+}
+
+static void compile_image (Image_Type *img)
+{
+   _SLang_Token_Type tok;
+   unsigned char *p, *pmax;
+   unsigned char type;
+   unsigned long v;
+
+   memset ((char *) &tok, 0, sizeof (_SLang_Token_Type));
+
+   p = img->tokens;
+   pmax = img->tokens_max;
+   while ((p < pmax) && (SLang_Error == 0))
+     {
+	type = *p++;
+	switch (image_token_operand (type))
+	  {
+	   case IMAGE_OPERAND_INTEGER:
+	     if (-1 == image_get_varint (&p, pmax, &v))
+	       goto corrupt;
+	     /* zig-zag encoded */
+	     if (v & 1)
+	       tok.v.long_val = (long) ~(v >> 1);
+	     else
+	       tok.v.long_val = (long) (v >> 1);
+	     break;
+
+	   case IMAGE_OPERAND_STRING:
+	     if ((-1 == image_get_varint (&p, pmax, &v))
+		 || (v >= img->num_strings))
+	       goto corrupt;
+	     tok.v.s_val = img->strings[v].str;
+	     if (type == _BSTRING_TOKEN)
+	       tok.hash = img->strings[v].len;
+	     else
+	       tok.hash = img->strings[v].hash;
+	     break;
+
+	   default:
+	     /* These are written as _BSTRING_TOKEN */
+	     if (type == BSTRING_TOKEN)
+	       goto corrupt;
+	     tok.v.long_val = 0;
+	     break;
+	  }
+	tok.type = type;
+
+	(*_SLcompile_ptr) (&tok);
+     }
+   return;
+
+   corrupt:
+   SLang_doerror ("Byte compiled file appears corrupt");
+}
+
+/*}}}*/
+
 /* Note that file could be freed from Slang during run of this routine
  * so get it and store it !! (e.g., autoloading)
  */
@@ -1088,6 +1569,7 @@ int SLns_load_file (char *f, char *ns_name)
 {
    File_Client_Data_Type client_data;
    SLang_Load_Type *x;
+   Image_Type *image;
    char *name, *buf;
    FILE *fp;
 
@@ -1105,24 +1587,42 @@ int SLns_load_file (char *f, char *ns_name)
    if (name == NULL)
      return -1;
 
+   image = NULL;
+   if ((f != NULL) && (-1 == open_current_image (&name, &image)))
+     {
+	SLang_free_slstring (name);
+	return -1;
+     }
+
    if (NULL == (x = SLns_allocate_load_type (name, ns_name)))
      {
+	close_image (image);
 	SLang_free_slstring (name);
 	return -1;
      }
 
    buf = NULL;
+   fp = NULL;
 
    if (f != NULL)
      {
-	fp = fopen (name, "r");
+	if (image == NULL)
+	  fp = fopen (name, "r");
 	if (Load_File_Verbose)
 	  SLang_vmessage ("Loading %s", name);
      }
    else
      fp = stdin;
 
-   if (fp == NULL)
+   if (image != NULL)
+     {
+	x->client_data = (VOID_STAR) image;
+	x->read = read_from_image;
+
+	(void) SLang_load_object (x);
+	close_image (image);
+     }
+   else if (fp == NULL)
      SLang_verror (SL_OBJ_NOPEN, "Unable to open %s", name);
    else if (NULL != (buf = SLmalloc (MAX_FILE_LINE_LEN + 1)))
      {
@@ -1175,6 +1675,12 @@ void _SLcompile_byte_compiled (void)
    char *ebuf;
    unsigned int len;
 
+   if (LLT->read == read_from_image)
+     {
+	compile_image ((Image_Type *) LLT->client_data);
+	return;
+     }
+
    memset ((char *) &tok, 0, sizeof (_SLang_Token_Type));
 
    while (SLang_Error == 0)
@@ -1487,17 +1993,301 @@ static void byte_compile_token (_SLang_Token_Type *tok)
    (void) bytecomp_write_data ((char *)buf, len);
 }
 
+#define IMAGE_STRING_TABLE_SIZE	1021
+
+typedef struct
+{
+   Image_String_Type *strings;
+   unsigned int num_strings;
+   unsigned int max_strings;
+   int buckets [IMAGE_STRING_TABLE_SIZE];
+
+   unsigned char *tokens;
+   unsigned long num_token_bytes;
+   unsigned long max_token_bytes;
+}
+Image_Writer_Type;
+
+static Image_Writer_Type *Image_Writer;
+
+static unsigned int image_encode_varint (unsigned char *buf, unsigned long v)
+{
+   unsigned int n = 0;
+
+   while (v >= 0x80)
+     {
+	buf[n++] = (unsigned char) (v | 0x80);
+	v = v >> 7;
+     }
+   buf[n++] = (unsigned char) v;
+   return n;
+}
+
+static int image_put_bytes (Image_Writer_Type *w, unsigned char *bytes, unsigned int n)
+{
+   if (w->num_token_bytes + n > w->max_token_bytes)
+     {
+	unsigned long max = 2 * w->max_token_bytes + n + 1024;
+	unsigned char *tokens;
+
+	if (NULL == (tokens = (unsigned char *) SLrealloc ((char *) w->tokens, max)))
+	  return -1;
+	w->tokens = tokens;
+	w->max_token_bytes = max;
+     }
+   SLMEMCPY ((char *) w->tokens + w->num_token_bytes, (char *) bytes, n);
+   w->num_token_bytes += n;
+   return 0;
+}
+
+/* Returns the index of the string in the table, adding it if necessary */
+static int image_add_string (Image_Writer_Type *w, char *str, unsigned int len)
+{
+   Image_String_Type *s;
+   unsigned long hash;
+   int i;
+
+   hash = _SLstring_hash ((unsigned char *) str, (unsigned char *) str + len);
+   i = w->buckets [hash % IMAGE_STRING_TABLE_SIZE];
+   while (i != -1)
+     {
+	s = w->strings + i;
+	if ((s->hash == hash) && (s->len == len)
+	    && (0 == memcmp (s->str, str, len)))
+	  return i;
+	i = s->next;
+     }
+
+   if (w->num_strings == w->max_strings)
+     {
+	unsigned int max = 2 * w->max_strings + 256;
+
+	if (NULL == (s = (Image_String_Type *) SLrealloc ((char *) w->strings, max * sizeof (Image_String_Type))))
+	  return -1;
+	w->strings = s;
+	w->max_strings = max;
+     }
+
+   s = w->strings + w->num_strings;
+   if (NULL == (s->str = SLmalloc (len + 1)))
+     return -1;
+   SLMEMCPY (s->str, str, len);
+   s->str[len] = 0;
+   s->len = len;
+   s->hash = hash;
+   s->next = w->buckets [hash % IMAGE_STRING_TABLE_SIZE];
+   w->buckets [hash % IMAGE_STRING_TABLE_SIZE] = (int) w->num_strings;
+   return (int) w->num_strings++;
+}
+
+static void image_write_error (void)
+{
+   SLang_verror (SL_MALLOC_ERROR, "Not enough memory for the byte-compiled image");
+}
+
+/* Adds tok to the image.  Should it not fit, SLang_Error is set, which
+ * stops the load and keeps byte_compile_image from writing the file.
+ */
+static void image_compile_token (_SLang_Token_Type *tok)
+{
+   Image_Writer_Type *w = Image_Writer;
+   unsigned char buf [1 + 2 * sizeof (unsigned long)];
+   unsigned int n, len;
+   unsigned long v;
+   char *s;
+   int i;
+
+   if (SLang_Error) return;
+
+   buf[0] = (unsigned char) tok->type;
+   n = 1;
+
+   switch (tok->type)
+     {
+      case BSTRING_TOKEN:
+	if (NULL == (s = (char *) SLbstring_get_pointer (tok->v.b_val, &len)))
+	  {
+	     image_write_error ();
+	     return;
+	  }
+	buf[0] = _BSTRING_TOKEN;
+	break;
+
+      case _BSTRING_TOKEN:
+	s = tok->v.s_val;
+	len = (unsigned int) tok->hash;
+	break;
+
+      default:
+	s = tok->v.s_val;
+	len = 0;
+	if (image_token_operand (buf[0]) == IMAGE_OPERAND_STRING)
+	  len = strlen (s);
+     }
+
+   switch (image_token_operand (buf[0]))
+     {
+      case IMAGE_OPERAND_INTEGER:
+	/* zig-zag, so that small negative numbers are short too */
+	v = (unsigned long) tok->v.long_val;
+	if (tok->v.long_val < 0)
+	  v = ((~v) << 1) | 1;
+	else
+	  v = v << 1;
+	n += image_encode_varint (buf + n, v);
+	break;
+
+      case IMAGE_OPERAND_STRING:
+	if (-1 == (i = image_add_string (w, s, len)))
+	  {
+	     image_write_error ();
+	     return;
+	  }
+	n += image_encode_varint (buf + n, (unsigned long) i);
+	break;
+     }
+
+   if (-1 == image_put_bytes (w, buf, n))
+     image_write_error ();
+}
+
+static int image_write_varint (FILE *fp, unsigned long v)
+{
+   unsigned char buf [2 * sizeof (unsigned long)];
+   unsigned int n;
+
+   n = image_encode_varint (buf, v);
+   if (n != fwrite (buf, 1, n, fp))
+     return -1;
+   return 0;
+}
+
+static int write_image (FILE *fp, Image_Writer_Type *w,
+			unsigned long source_len, unsigned long source_hash,
+			unsigned long source_mtime)
+{
+   unsigned char buf [2 * sizeof (unsigned long)];
+   unsigned long hash;
+   unsigned int i;
+
+   /* The hash of what follows the header, byte for byte as written */
+   hash = IMAGE_HASH_INIT;
+   for (i = 0; i < w->num_strings; i++)
+     {
+	Image_String_Type *s = w->strings + i;
+
+	hash = image_hash (buf, buf + image_encode_varint (buf, s->len), hash);
+	hash = image_hash ((unsigned char *) s->str,
+			   (unsigned char *) s->str + s->len + 1, hash);
+     }
+   hash = image_hash (w->tokens, w->tokens + w->num_token_bytes, hash);
+
+   if ((IMAGE_MAGIC_LEN != fwrite (IMAGE_MAGIC, 1, IMAGE_MAGIC_LEN, fp))
+       || (-1 == image_write_varint (fp, IMAGE_FORMAT_VERSION))
+       || (-1 == image_write_varint (fp, SLANG_VERSION))
+       || (-1 == image_write_varint (fp, source_len))
+       || (-1 == image_write_varint (fp, source_hash))
+       || (-1 == image_write_varint (fp, source_mtime))
+       || (-1 == image_write_varint (fp, w->num_strings))
+       || (-1 == image_write_varint (fp, w->num_token_bytes))
+       || (-1 == image_write_varint (fp, hash)))
+     return -1;
+
+   for (i = 0; i < w->num_strings; i++)
+     {
+	Image_String_Type *s = w->strings + i;
+
+	if ((-1 == image_write_varint (fp, s->len))
+	    || (s->len + 1 != fwrite (s->str, 1, s->len + 1, fp)))
+	  return -1;
+     }
+
+   if (w->num_token_bytes
+       != fwrite (w->tokens, 1, w->num_token_bytes, fp))
+     return -1;
+   return 0;
+}
+
+static void free_image_writer (Image_Writer_Type *w)
+{
+   unsigned int i;
+
+   for (i = 0; i < w->num_strings; i++)
+     SLfree (w->strings[i].str);
+   SLfree ((char *) w->strings);
+   SLfree ((char *) w->tokens);
+   SLfree ((char *) w);
+}
+
+static int byte_compile_image (char *name, char *file)
+{
+   Image_Writer_Type *w;
+   unsigned long source_len, source_hash, source_mtime;
+   unsigned int i;
+   FILE *fp;
+
+   /* before the hash, so that an edit in between cannot go unnoticed */
+   source_mtime = image_source_mtime (name);
+   if (-1 == hash_source_file (name, &source_len, &source_hash))
+     {
+	SLang_verror (SL_OBJ_NOPEN, "%s: unable to open", name);
+	return -1;
+     }
+
+   if (NULL == (w = (Image_Writer_Type *) SLmalloc (sizeof (Image_Writer_Type))))
+     return -1;
+   memset ((char *) w, 0, sizeof (Image_Writer_Type));
+   for (i = 0; i < IMAGE_STRING_TABLE_SIZE; i++)
+     w->buckets[i] = -1;
+
+   Image_Writer = w;
+   _SLcompile_ptr = image_compile_token;
+   (void) SLang_load_file (name);
+   _SLcompile_ptr = _SLcompile;
+   Image_Writer = NULL;
+
+   if (SLang_Error == 0)
+     {
+	if (NULL == (fp = fopen (file, "wb")))
+	  SLang_verror (SL_OBJ_NOPEN, "%s: unable to open", file);
+	else
+	  {
+	     if (-1 == write_image (fp, w, source_len, source_hash, source_mtime))
+	       SLang_doerror ("Write Error");
+	     if ((EOF == fclose (fp)) && (SLang_Error == 0))
+	       SLang_doerror ("Write Error");
+	  }
+     }
+
+   free_image_writer (w);
+
+   if (SLang_Error)
+     return -1;
+   return 0;
+}
+
 int SLang_byte_compile_file (char *name, int method)
 {
    char file [1024];
 
-   (void) method;
    if (strlen (name) + 2 >= sizeof (file))
      {
 	SLang_verror (SL_INVALID_PARM, "Filename too long");
 	return -1;
      }
    sprintf (file, "%sc", name);
+
+   if (method == 0)
+     {
+	if (-1 == byte_compile_image (name, file))
+	  {
+	     SLang_verror (0, "Error processing %s", name);
+	     return -1;
+	  }
+	return 0;
+     }
+
+   /* Otherwise the tokens are written as text */
    if (NULL == (Byte_Compile_Fp = fopen (file, "w")))
      {
 	SLang_verror(SL_OBJ_NOPEN, "%s: unable to open", file);
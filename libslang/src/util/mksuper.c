@@ -0,0 +1,176 @@
+/* Generate slsuper.inc, the superinstructions of slang.c, from the
+ * byte-code statistics written by SLang_write_bytecode_stats.  The
+ * Makefile runs it on util/bcstats.txt, the statistics of bcstats.sl:
+ *
+ *    mksuper [-n max] util/bcstats.txt > slsuper.inc
+ *
+ * Each non-comment line of the statistics is a count followed by the
+ * names of two or three byte-codes that ran one after the other.  The
+ * sequences that save the most dispatches (count times the number of
+ * byte-codes fused away) become superinstructions, at most 16 of them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SUPER	16
+#define MAX_SEQUENCE	3
+#define MAX_NAME	32
+
+typedef struct
+{
+   unsigned long count;
+   unsigned long saved;
+   unsigned int num;
+   char names[MAX_SEQUENCE][MAX_NAME];
+}
+Sequence_Type;
+
+static Sequence_Type Sequences [MAX_SUPER];
+static unsigned int Num_Sequences;
+static unsigned int Max_Sequences = MAX_SUPER;
+
+static void add_sequence (Sequence_Type *s)
+{
+   unsigned int i;
+
+   /* Keep the table sorted by the dispatches saved */
+   i = Num_Sequences;
+   if (i == Max_Sequences)
+     {
+	if (s->saved <= Sequences[i - 1].saved)
+	  return;
+	i--;
+     }
+   else Num_Sequences++;
+
+   while ((i > 0) && (Sequences[i - 1].saved < s->saved))
+     {
+	Sequences[i] = Sequences[i - 1];
+	i--;
+     }
+   Sequences[i] = *s;
+}
+
+static int parse_line (char *line, Sequence_Type *s)
+{
+   char *p;
+
+   if ((*line == '#') || (*line == '\n') || (*line == 0))
+     return -1;
+
+   s->count = strtoul (line, &p, 10);
+   s->num = 0;
+   while (s->num < MAX_SEQUENCE)
+     {
+	unsigned int len;
+
+	while ((*p == ' ') || (*p == '\t'))
+	  p++;
+	len = strcspn (p, " \t\n");
+	if (len == 0)
+	  break;
+	if (len >= MAX_NAME)
+	  return -1;
+	strncpy (s->names[s->num], p, len);
+	s->names[s->num][len] = 0;
+	/* Superinstructions are not made of superinstructions */
+	if (0 == strncmp (s->names[s->num], "SUPER_", 6))
+	  return -1;
+	s->num++;
+	p += len;
+     }
+   if (s->num < 2)
+     return -1;
+   s->saved = s->count * (s->num - 1);
+   return 0;
+}
+
+/* Longer sequences first, so that a pair does not hide a triple that
+ * starts with it.
+ */
+static int compare_sequences (const void *a, const void *b)
+{
+   const Sequence_Type *sa = (const Sequence_Type *) a;
+   const Sequence_Type *sb = (const Sequence_Type *) b;
+
+   if (sa->num != sb->num)
+     return (int) sb->num - (int) sa->num;
+   if (sa->saved != sb->saved)
+     return (sa->saved < sb->saved) ? 1 : -1;
+   return 0;
+}
+
+static void write_inc (FILE *fp, int argc, char **argv)
+{
+   unsigned int i, j;
+
+   fputs ("/* Superinstructions for slang.c, generated by:\n *", fp);
+   for (i = 0; i < (unsigned int) argc; i++)
+     fprintf (fp, " %s", argv[i]);
+   fputs ("\n * Do not edit; see util/mksuper.c.\n */\n\n", fp);
+
+   fputs ("#ifdef SLSUPER_TABLE\n", fp);
+   fprintf (fp, "#define SLSUPER_NUM\t%u\n", Num_Sequences);
+   fputs ("static Super_Bytecode_Type Super_Bytecodes [SLSUPER_NUM + 1] =\n{\n", fp);
+   for (i = 0; i < Num_Sequences; i++)
+     {
+	fprintf (fp, "   {%u, {", Sequences[i].num);
+	for (j = 0; j < Sequences[i].num; j++)
+	  fprintf (fp, "%s_SLANG_BC_%s", j ? ", " : "", Sequences[i].names[j]);
+	fputs ("}},\n", fp);
+     }
+   fputs ("   {0, {0}}\n};\n#endif\n\n", fp);
+
+   fputs ("#ifdef SLSUPER_TARGETS\n", fp);
+   for (i = 0; i < Num_Sequences; i++)
+     fprintf (fp, "\tBC_TARGET(_SLANG_BC_SUPER_%u),\n", i);
+   fputs ("#endif\n\n", fp);
+
+   fputs ("#ifdef SLSUPER_CASES\n", fp);
+   for (i = 0; i < Num_Sequences; i++)
+     {
+	fprintf (fp, "\t   BC_CASE(_SLANG_BC_SUPER_%u):\t       /* %lu runs */\n",
+		 i, Sequences[i].count);
+	for (j = 0; j < Sequences[i].num; j++)
+	  fprintf (fp, "\t     BC_DO_%s;\n\t     %s;\n", Sequences[i].names[j],
+		   (j + 1 < Sequences[i].num) ? "BC_FUSE" : "BC_NEXT");
+     }
+   fputs ("#endif\n", fp);
+}
+
+int main (int argc, char **argv)
+{
+   FILE *fp;
+   char line[256];
+   Sequence_Type s;
+   int i = 1;
+
+   if ((argc > 2) && (0 == strcmp (argv[1], "-n")))
+     {
+	Max_Sequences = (unsigned int) atoi (argv[2]);
+	if (Max_Sequences > MAX_SUPER)
+	  Max_Sequences = MAX_SUPER;
+	i = 3;
+     }
+   if (i + 1 != argc)
+     {
+	fprintf (stderr, "Usage: %s [-n max] stats-file > slsuper.inc\n", argv[0]);
+	return 1;
+     }
+   if (NULL == (fp = fopen (argv[i], "r")))
+     {
+	fprintf (stderr, "Unable to open %s\n", argv[i]);
+	return 1;
+     }
+   while (NULL != fgets (line, sizeof (line), fp))
+     {
+	if ((0 == parse_line (line, &s)) && (Max_Sequences > 0))
+	  add_sequence (&s);
+     }
+   fclose (fp);
+
+   qsort ((char *) Sequences, Num_Sequences, sizeof (Sequence_Type), compare_sequences);
+   write_inc (stdout, argc, argv);
+   return 0;
+}
@@ -116,6 +116,44 @@ signal(Sig, Fun) ->
     p_cmd(P,?SIGNAL, [{int, Sig}], void).
 
 
+%% instead of getkey/0: every key typed is sent to the calling
+%% process as {slang_key, Key}, with keypad decoding if Mode is kp.
+%% Needs init_tty/3 first, returns -1 otherwise
+key_events(off) ->
+    P = gp(),
+    p_cmd(P, ?KEY_EVENTS, [{int, 0}], int);
+key_events(raw) ->
+    P = gp(),
+    p_cmd(P, ?KEY_EVENTS, [{int, 1}], int);
+key_events(kp) ->
+    P = gp(),
+    p_cmd(P, ?KEY_EVENTS, [{int, 2}], int).
+
+%% after every refresh that changed anything the calling process gets
+%% {slang_damage, Binary}, see slang_mirror
+mirror(Bool) ->
+    P = gp(),
+    p_cmd(P, ?MIRROR, [{int, bool_to_int(Bool)}], int).
+
+%% record everything sent to the terminal into File as an asciicast
+%% v2 session.  A keyframe, a full redraw of the screen, is recorded
+%% at the start and then every KeyframeMs ms at a refresh, only at the
+%% start if KeyframeMs is 0 and never if it is -1
+cast_start(File, KeyframeMs) ->
+    P = gp(),
+    p_cmd(P, ?CAST_START, [{int, KeyframeMs}, {string, File}], int).
+
+%% returns the number of output chunks lost because the disk was slow
+cast_stop() ->
+    P = gp(),
+    p_cmd(P, ?CAST_STOP, [], int).
+
+%% number of bytes the tty still has to send to the terminal
+tt_outq() ->
+    P = gp(),
+    p_cmd(P, ?TT_OUTQ, [], int).
+
+
 %%% screen management
 
 
@@ -279,6 +317,336 @@ smg_set_color_in_region (Color, R, C, Dr, Dc) ->
     p_cmd(P, ?SMG_SET_COLOR_IN_REGION, [{int, Color}, {int, R}, {int, C},
 				       {int, Dr}, {int, Dc}], void).
 
+%% move the contents of a region N rows up (down if N < 0), the
+%% uncovered rows must be redrawn by the caller
+smg_scroll_region (R, C, Dr, Dc, N) ->
+    P = gp(),
+    p_cmd(P, ?SMG_SCROLL_REGION, [{int, R}, {int, C},
+				 {int, Dr}, {int, Dc}, {int, N}], void).
+
+
+
+
+
+%% tile a region with Pattern, a list of rows of cells where a cell is
+%% either Char bor (Color bsl 8) or {Char, Color}
+smg_paint_region (R, C, Dr, Dc, Pattern = [Row0 | _]) ->
+    P = gp(),
+    Pw = length(Row0),
+    Cells = lists:map(fun({Ch, Color}) -> ?int16((Color bsl 8) bor Ch);
+			 (Cell) -> ?int16(Cell)
+		      end, lists:append(Pattern)),
+    p_cmd(P, ?SMG_PAINT_REGION, [{int, R}, {int, C}, {int, Dr}, {int, Dc},
+				{int, Pw}, {int, length(Pattern)},
+				{bytes, Cells}], void).
+
+
+%%% the whole virtual screen in one go:
+%%% {Gen, {Rows, Cols}, {CurRow, CurCol}, [{Row, Cells}]}
+%%% Cells is a binary of 16 bit big endian SLsmg_Char_Type, color in
+%%% the high byte.  smg_snapshot(Gen) only returns the rows changed
+%%% since the snapshot that returned Gen.
+
+smg_snapshot() ->
+    smg_snapshot(-1).
+
+smg_snapshot(Since) ->
+    P = gp(),
+    Bin = list_to_binary(p_cmd(P, ?SMG_SNAPSHOT, [{int, Since}], string)),
+    <<Gen:32, Rows:16, Cols:16, CurRow:16, CurCol:16, _N:16, Data/binary>> = Bin,
+    RowLen = Cols * 2,
+    {Gen, {Rows, Cols}, {CurRow, CurCol},
+     [{Row, Cells} || <<Row:16, Cells:RowLen/binary>> <= Data]}.
+
+%% the characters of a row of snapshot cells
+snapshot_text(Cells) ->
+    [Ch || <<_Color:8, Ch:8>> <= Cells].
+
+%% [{Char, Color}], the alt charset flag stays in Color
+snapshot_cells(Cells) ->
+    [{Ch, Color} || <<Color:8, Ch:8>> <= Cells].
+
+
+
+%%% the driver side pager, the file is mmap'ed and only the visible
+%%% window is ever rendered, so Erlang only sends navigation commands
+
+pager_open(File) ->
+    P = gp(),
+    p_cmd(P, ?PAGER_OPEN, [{string, File}], int).
+
+pager_close() ->
+    P = gp(),
+    p_cmd(P, ?PAGER_CLOSE, [], void).
+
+pager_window(R, C, Nr, Nc) ->
+    P = gp(),
+    p_cmd(P, ?PAGER_WINDOW, [{int, R}, {int, C}, {int, Nr}, {int, Nc}], void).
+
+pager_scroll(N) ->
+    pager_move(?PAGER_LINES, N).
+
+pager_page(N) ->
+    pager_move(?PAGER_PAGES, N).
+
+pager_goto(Line) ->
+    pager_move(?PAGER_GOTO, Line).
+
+pager_top() ->
+    pager_move(?PAGER_TOP, 0).
+
+pager_bottom() ->
+    pager_move(?PAGER_BOTTOM, 0).
+
+pager_hscroll(N) ->
+    pager_move(?PAGER_COLUMNS, N).
+
+pager_move(How, N) ->
+    P = gp(),
+    p_cmd(P, ?PAGER_MOVE, [{int, How}, {int, N}], void).
+
+%% in follow mode the driver redraws the window itself when the file grows
+pager_follow(Bool) ->
+    P = gp(),
+    p_cmd(P, ?PAGER_FOLLOW, [{int, bool_to_int(Bool)}], void).
+
+pager_render() ->
+    P = gp(),
+    p_cmd(P, ?PAGER_RENDER, [], void).
+
+%% line numbers are -1 while the driver is still indexing the file
+pager_info() ->
+    P = gp(),
+    [Top, Lines, SizeHi, SizeLo, Follow] =
+	p_cmd(P, ?PAGER_INFO, [], int_list),
+    [{top_line, Top}, {lines, Lines},
+     {size, (SizeHi bsl 32) bor (SizeLo band 16#ffffffff)},
+     {follow, Follow == 1}].
+
+
+
+
+%%% latency statistics kept by the driver for every opcode,
+%%% times are in nanoseconds from the monotonic clock
+
+stats() ->
+    P = gp(),
+    case p_cmd(P, ?STATS_GET, [], string) of
+	[255, 255, 255, 255] ->			% no memory for the reply
+	    {error, enomem};
+	Reply ->
+	    decode_stats(list_to_binary(Reply))
+    end.
+
+stats_reset() ->
+    P = gp(),
+    p_cmd(P, ?STATS_RESET, [], void).
+
+%% with trace on the calling process gets a {slang_trace, Op, Ns}
+%% message for every command the driver executes
+stats_trace(Bool) ->
+    P = gp(),
+    p_cmd(P, ?STATS_TRACE, [{int, bool_to_int(Bool)}], void).
+
+
+decode_stats(<<Op:8, Count:64, Total:64, Min:64, Max:64, N:16,
+	       Rest/binary>>) ->
+    HLen = N * 6,
+    <<H:HLen/binary, Tail/binary>> = Rest,
+    Hist = [{bucket_low(B), C} || <<B:16, C:32>> <= H],
+    [{Op, [{count, Count}, {total, Total}, {min, Min}, {max, Max},
+	   {p50, percentile(Hist, Count * 0.50)},
+	   {p90, percentile(Hist, Count * 0.90)},
+	   {p99, percentile(Hist, Count * 0.99)},
+	   {p999, percentile(Hist, Count * 0.999)},
+	   {histogram, Hist}]} | decode_stats(Tail)];
+decode_stats(<<>>) ->
+    [].
+
+%% lowest value that falls into histogram bucket B, there are
+%% 16 buckets per power of two
+bucket_low(B) when B < 16 ->
+    B;
+bucket_low(B) ->
+    E = (B bsr 4) + 3,
+    (16 + (B band 15)) bsl (E - 4).
+
+percentile([{Low, C} | Tail], Rank) when C >= Rank; Tail == [] ->
+    Low;
+percentile([{_, C} | Tail], Rank) ->
+    percentile(Tail, Rank - C);
+percentile([], _) ->
+    0.
+
+
+
+
+%%% record every command the driver gets into File, the recording
+%%% is played back with priv/slang_replay
+
+cmdlog_start(File) ->
+    P = gp(),
+    p_cmd(P, ?CMDLOG_START, [{string, File}], int).
+
+cmdlog_stop() ->
+    P = gp(),
+    p_cmd(P, ?CMDLOG_STOP, [], void).
+
+
+
+
+%%% animations kept up to date by the driver, without a message per
+%%% frame.  Id is any integer chosen by the caller, adding an Id that
+%%% exists replaces it.  They are drawn in the refreshes Erlang does
+%%% anyway when they can, otherwise the driver refreshes by itself.
+
+%% cycle through the characters of Glyphs every PeriodMs ms
+anim_spinner(Id, R, C, Color, PeriodMs, Glyphs) ->
+    anim_add(?ANIM_SPINNER, Id, R, C, 1, Color, 0, PeriodMs, 0, Glyphs).
+
+%% a bar Width wide, Percent of it in FillColor with the percentage in
+%% the middle, a block moving back and forth if Percent < 0
+anim_progress(Id, R, C, Width, Color, FillColor, Percent) ->
+    anim_add(?ANIM_PROGRESS, Id, R, C, Width, Color, FillColor, 100,
+	     Percent, "").
+
+%% the local time through strftime(3) Format, Width wide
+anim_clock(Id, R, C, Width, Color, Format) ->
+    anim_add(?ANIM_CLOCK, Id, R, C, Width, Color, 0, 1000, 0, Format).
+
+anim_add(Kind, Id, R, C, Width, Color, Color2, PeriodMs, Value, Text) ->
+    P = gp(),
+    p_cmd(P, ?ANIM_ADD, [{int, Kind}, {int, Id}, {int, R}, {int, C},
+			 {int, Width}, {int, Color}, {int, Color2},
+			 {int, PeriodMs}, {int, Value}, {string, Text}], int).
+
+%% new percentage for a progress bar
+anim_set(Id, Value) ->
+    P = gp(),
+    p_cmd(P, ?ANIM_SET, [{int, Id}, {int, Value}], int).
+
+anim_delete(Id) ->
+    P = gp(),
+    p_cmd(P, ?ANIM_DELETE, [{int, Id}], void).
+
+anim_delete_all() ->
+    anim_delete(-1).
+
+
+
+
+%%% color objects the driver allocates on demand.  Fg and Bg are
+%%% default, a palette index 0..255, {R, G, B} or one of the 16 ANSI
+%%% color names; Attrs is a list of bold, underline, blink and reverse.
+%%% RGB colors are mapped to what the terminal can show.  An object
+%%% stays valid until about 64 other colors have been asked for while
+%%% it was not on the screen.
+
+%% the color object for Fg on Bg, to pass to smg_set_color/1 and co
+color(Fg, Bg, Attrs) ->
+    P = gp(),
+    p_cmd(P, ?COLOR_GET, [{int, color_spec(Fg)}, {int, color_spec(Bg)},
+			 {int, color_attrs(Attrs, 0)}], int).
+
+%% draw in Fg on Bg from here on, without waiting for a reply
+smg_set_color(Fg, Bg, Attrs) ->
+    P = gp(),
+    p_cmd(P, ?COLOR_SET, [{int, color_spec(Fg)}, {int, color_spec(Bg)},
+			 {int, color_attrs(Attrs, 0)}], void).
+
+color_spec(default) -> -1;
+color_spec(C) when is_integer(C), C >= 0, C =< 255 -> C;
+color_spec({R, G, B}) -> ?COLOR_RGB bor (R bsl 16) bor (G bsl 8) bor B;
+color_spec(black) -> 0;
+color_spec(red) -> 1;
+color_spec(green) -> 2;
+color_spec(brown) -> 3;
+color_spec(yellow) -> 3;
+color_spec(blue) -> 4;
+color_spec(magenta) -> 5;
+color_spec(cyan) -> 6;
+color_spec(lightgray) -> 7;
+color_spec(gray) -> 8;
+color_spec(brightred) -> 9;
+color_spec(brightgreen) -> 10;
+color_spec(brightyellow) -> 11;
+color_spec(brightblue) -> 12;
+color_spec(brightmagenta) -> 13;
+color_spec(brightcyan) -> 14;
+color_spec(white) -> 15.
+
+color_attrs([bold | T], A) -> color_attrs(T, A bor 1);
+color_attrs([underline | T], A) -> color_attrs(T, A bor 2);
+color_attrs([blink | T], A) -> color_attrs(T, A bor 4);
+color_attrs([reverse | T], A) -> color_attrs(T, A bor 8);
+color_attrs([], A) -> A.
+
+
+
+
+%%% a line editor run by the driver: keys are handled there as they
+%%% arrive and only the finished line comes back, as a message to the
+%%% process that started it.  Up and down recall earlier lines that
+%%% start with what is left of the cursor, Ctrl-R searches them.  Tab
+%%% completes the word left of the cursor.
+
+%% edit a line on row R from column C on, Width cells wide.  Sends
+%% {slang_line, Binary}, {slang_line, eof} or {slang_line, abort}
+read_line(R, C, Width, Color, Prompt) ->
+    P = gp(),
+    p_cmd(P, ?RLINE_START, [{int, R}, {int, C}, {int, Width}, {int, Color},
+			   {string, Prompt}], int).
+
+read_line_stop() ->
+    P = gp(),
+    p_cmd(P, ?RLINE_STOP, [], void).
+
+%% keep the history of read_line/5 in File, at most Max lines of it,
+%% returns the number of lines read back from it or -1
+history_open(File, Max) ->
+    P = gp(),
+    p_cmd(P, ?HIST_OPEN, [{int, Max}, {string, File}], int).
+
+%% lines entered from now on are only kept in memory
+history_close() ->
+    P = gp(),
+    p_cmd(P, ?HIST_CLOSE, [], void).
+
+history_add(Line) ->
+    P = gp(),
+    p_cmd(P, ?HIST_ADD, [{string, Line}], void).
+
+%% words for Tab to complete: Source 0 for the first word of the
+%% line, 1..3 for the words after it.  Replaces what Source had,
+%% returns the number of distinct words
+completion_load(Source, Words) ->
+    P = gp(),
+    Bin = list_to_binary([[W, 0] || W <- Words]),
+    p_cmd(P, ?COMPL_LOAD, [{int, Source}, {int, size(Bin)}, {bytes, Bin}], int).
+
+%% with true, a Tab that nothing loaded fits sends
+%% {slang_complete, Gen, Source, Prefix}, to be answered with
+%% completion_reply/2
+completion_callback(Bool) ->
+    P = gp(),
+    p_cmd(P, ?COMPL_CALLBACK, [{int, bool_to_int(Bool)}], void).
+
+%% ignored if a key was typed since Gen was asked
+completion_reply(Gen, Words) ->
+    P = gp(),
+    Bin = list_to_binary([[W, 0] || W <- Words]),
+    p_cmd(P, ?COMPL_REPLY, [{int, Gen}, {int, size(Bin)}, {bytes, Bin}], void).
+
+%% read_line/5 and wait for the line
+get_line(R, C, Width, Color, Prompt) ->
+    case read_line(R, C, Width, Color, Prompt) of
+	0 ->
+	    receive
+		{slang_line, Line} -> Line
+	    end;
+	Err ->
+	    {error, Err}
+    end.
 
 
 
@@ -286,6 +654,10 @@ smg_set_color_in_region (Color, R, C, Dr, Dc) ->
 %%%%%%% auxilliary functions %%%%%%%%%%%%%%%%%
 
 
+bool_to_int(true) -> 1;
+bool_to_int(false) -> 0.
+
+
 encode_var(baud_rate) ->         1;
 encode_var(read_fd) ->           2;
 encode_var(abort_char) ->        3;
@@ -351,6 +723,10 @@ expect([X1,X2, X3, X4], int) ->
     ?i32(X1,X2, X3, X4);
 expect([X1,X2, X3, X4, Y1, Y2, Y3, Y4], int_int) ->
     {?i32(X1,X2, X3, X4), ?i32(Y1, Y2, Y3, Y4)};
+expect([X1,X2, X3, X4 | Tail], int_list) ->
+    [?i32(X1,X2, X3, X4) | expect(Tail, int_list)];
+expect([], int_list) ->
+    [];
 
 expect(List, string) ->
     List.
@@ -374,6 +750,8 @@ mk_args([{string, Str} |Tail]) when is_list(Str) ->
     [Str, 0 | mk_args(Tail)];
 mk_args([{string, Str} |Tail]) when is_atom(Str) ->
     [atom_to_list(Str), 0 | mk_args(Tail)];
+mk_args([{bytes, Bytes} |Tail]) ->
+    [Bytes | mk_args(Tail)];
 mk_args([{smg_char_type, Str} |Tail]) when is_list(Str) ->
     Len = 2 * length(Str),
     List = [?int32(Len) | lists:map(fun(I) -> ?int16(I) end, Str)] ,
@@ -1,7 +1,7 @@
 %%%----------------------------------------------------------------------
 %%% File    : slang_lib.erl
 %%% Author  : Claes Wikstrom <klacke@kaja.hemma.net>
-%%% Purpose : 
+%%% Purpose :
 %%% Created :  4 Dec 2000 by Claes Wikstrom <klacke@kaja.hemma.net>
 %%%----------------------------------------------------------------------
 
@@ -13,3 +13,236 @@
 
 
 %% higher level functions for slang
+
+
+
+%%% A virtualized table. Only the visible rows are ever fetched from
+%%% the row source and a row is only redrawn when what is on the
+%%% screen differs from what should be there.  Scrolling moves the
+%%% rows already on the screen with slang:smg_scroll_region/5, so
+%%% SLsmg_refresh finds the scroll and lets the terminal do it.
+%%%
+%%% Columns is a list of {Title, Width} or {Title, Width, left | right}
+%%% Source is either
+%%%   {ets, Tab}       where Tab holds {Index, Cells}, Index in 0..Size-1
+%%%   {callback, Fun}  where Fun(size) -> Size and
+%%%                    Fun({rows, From, N}) -> [Cells] (at most N)
+%%% and Cells is a list of strings, one per column.
+%%%
+%%% All table_ functions return the new table, the caller does the
+%%% slang:smg_refresh/0.
+
+-record(table, {row, col, nrows, ncols,
+		columns,
+		source,
+		size = 0,
+		top = 0,
+		cursor = 0,
+		color = 0,
+		cursor_color = 1,
+		header_color = 0,
+		drawn}).     % element I is what body row I shows
+
+
+table_new(R, C, Nr, Nc, Columns, Source) ->
+    table_new(R, C, Nr, Nc, Columns, Source, []).
+
+table_new(R, C, Nr, Nc, Columns, Source, Opts) when Nr > 1 ->
+    T = #table{row = R, col = C, nrows = Nr - 1, ncols = Nc,
+	       columns = [norm_column(Col) || Col <- Columns],
+	       source = Source,
+	       color = opt(color, Opts, 0),
+	       cursor_color = opt(cursor_color, Opts, 1),
+	       header_color = opt(header_color, Opts, 0),
+	       drawn = erlang:make_tuple(Nr - 1, undefined)},
+    draw_header(T),
+    T#table{size = source_size(Source)}.
+
+
+%% check every visible row against the source
+table_render(T0) ->
+    T = clamp(T0#table{size = source_size(T0#table.source)}),
+    Rows = fetch(T#table.source, T#table.top, T#table.nrows),
+    draw_rows(T, 1, T#table.top, Rows).
+
+
+%% only the rows in Indices have changed in the source
+table_changed(T, Indices) ->
+    lists:foldl(
+      fun(Idx, Tab) when Idx >= Tab#table.top,
+			 Idx < Tab#table.top + Tab#table.nrows ->
+	      I = Idx - Tab#table.top + 1,
+	      case fetch(Tab#table.source, Idx, 1) of
+		  [Cells] ->
+		      draw_row(Tab, I, {Idx, Cells, Idx == Tab#table.cursor});
+		  [] ->
+		      draw_row(Tab, I, blank)
+	      end;
+	 (_, Tab) ->
+	      Tab
+      end, T, lists:usort(Indices)).
+
+
+table_scroll(T, N) ->
+    Top = max_top(T, T#table.top + N),
+    scroll_to(T, Top).
+
+
+table_goto(T, Idx) ->
+    Cursor = max_cursor(T, Idx),
+    move_cursor(T, Cursor).
+
+
+table_move_cursor(T, N) ->
+    move_cursor(T, max_cursor(T, T#table.cursor + N)).
+
+
+table_cursor(T) ->
+    T#table.cursor.
+
+table_top(T) ->
+    T#table.top.
+
+table_size(T) ->
+    T#table.size.
+
+
+
+move_cursor(T, Cursor) ->
+    Top = if
+	      Cursor < T#table.top ->
+		  Cursor;
+	      Cursor >= T#table.top + T#table.nrows ->
+		  Cursor - T#table.nrows + 1;
+	      true ->
+		  T#table.top
+	  end,
+    scroll_to(T#table{cursor = Cursor}, Top).
+
+
+scroll_to(T, Top) when Top == T#table.top ->
+    table_render(T);
+scroll_to(T, Top) when abs(Top - T#table.top) >= T#table.nrows ->
+    table_render(T#table{top = Top});
+scroll_to(T, Top) ->
+    D = Top - T#table.top,
+    slang:smg_scroll_region(T#table.row + 1, T#table.col,
+			    T#table.nrows, T#table.ncols, D),
+    Drawn = tuple_to_list(T#table.drawn),
+    Blank = lists:duplicate(abs(D), undefined),
+    Shifted = if
+		  D > 0 ->
+		      lists:nthtail(D, Drawn) ++ Blank;
+		  true ->
+		      Blank ++ lists:sublist(Drawn, T#table.nrows + D)
+	      end,
+    table_render(T#table{top = Top, drawn = list_to_tuple(Shifted)}).
+
+
+clamp(T) ->
+    Cursor = max_cursor(T, T#table.cursor),
+    T#table{cursor = Cursor, top = max_top(T, T#table.top)}.
+
+max_top(T, Top) ->
+    lists:max([0, lists:min([Top, T#table.size - T#table.nrows])]).
+
+max_cursor(T, Idx) ->
+    lists:max([0, lists:min([Idx, T#table.size - 1])]).
+
+
+
+draw_rows(T, I, Idx, [Cells | Tail]) when I =< T#table.nrows ->
+    T2 = draw_row(T, I, {Idx, Cells, Idx == T#table.cursor}),
+    draw_rows(T2, I + 1, Idx + 1, Tail);
+draw_rows(T, I, Idx, []) when I =< T#table.nrows ->
+    T2 = draw_row(T, I, blank),
+    draw_rows(T2, I + 1, Idx + 1, []);
+draw_rows(T, _, _, _) ->
+    T.
+
+draw_row(T, I, What) ->
+    case element(I, T#table.drawn) of
+	What ->
+	    T;
+	_ ->
+	    write_row(T, I, What),
+	    T#table{drawn = setelement(I, T#table.drawn, What)}
+    end.
+
+
+write_row(T, I, blank) ->
+    slang:smg_set_color(T#table.color),
+    slang:smg_gotorc(T#table.row + I, T#table.col),
+    slang:smg_write_nstring("", T#table.ncols);
+write_row(T, I, {_Idx, Cells, Hilite}) ->
+    slang:smg_set_color(if
+			    Hilite -> T#table.cursor_color;
+			    true -> T#table.color
+			end),
+    slang:smg_gotorc(T#table.row + I, T#table.col),
+    slang:smg_write_nstring(format_row(T#table.columns, Cells),
+			    T#table.ncols),
+    slang:smg_set_color(T#table.color).
+
+
+draw_header(T) ->
+    slang:smg_set_color(T#table.header_color),
+    slang:smg_gotorc(T#table.row, T#table.col),
+    slang:smg_write_nstring(
+      format_row(T#table.columns,
+		 [Title || {Title, _, _} <- T#table.columns]),
+      T#table.ncols),
+    slang:smg_set_color(T#table.color).
+
+
+format_row([{_, W, Align} | Cols], [Cell | Cells]) ->
+    [pad(to_str(Cell), W, Align), $\s | format_row(Cols, Cells)];
+format_row([{_, W, _} | Cols], []) ->
+    [lists:duplicate(W, $\s), $\s | format_row(Cols, [])];
+format_row([], _) ->
+    [].
+
+pad(S, W, left) ->
+    string:left(S, W);
+pad(S, W, right) ->
+    string:right(S, W).
+
+to_str(S) when is_list(S) -> lists:flatten(S);
+to_str(A) when is_atom(A) -> atom_to_list(A);
+to_str(I) when is_integer(I) -> integer_to_list(I);
+to_str(X) -> lists:flatten(io_lib:format("~p", [X])).
+
+
+norm_column({Title, W}) ->
+    {to_str(Title), W, left};
+norm_column({Title, W, Align}) ->
+    {to_str(Title), W, Align}.
+
+
+opt(Key, Opts, Default) ->
+    case lists:keysearch(Key, 1, Opts) of
+	{value, {_, Val}} -> Val;
+	false -> Default
+    end.
+
+
+
+source_size({ets, Tab}) ->
+    ets:info(Tab, size);
+source_size({callback, Fun}) ->
+    Fun(size).
+
+fetch({ets, Tab}, From, N) ->
+    fetch_ets(Tab, From, From + N);
+fetch({callback, Fun}, From, N) ->
+    Fun({rows, From, N}).
+
+fetch_ets(Tab, I, Max) when I < Max ->
+    case ets:lookup(Tab, I) of
+	[{I, Cells}] ->
+	    [Cells | fetch_ets(Tab, I + 1, Max)];
+	[] ->
+	    []
+    end;
+fetch_ets(_, _, _) ->
+    [].
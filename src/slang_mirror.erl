@@ -0,0 +1,147 @@
+%%%----------------------------------------------------------------------
+%%% File    : slang_mirror.erl
+%%% Purpose : watch the screen of a slang_server, possibly on another node
+%%%----------------------------------------------------------------------
+
+-module(slang_mirror).
+
+-compile(export_all).
+
+
+%%% The driver sends a damage record after every refresh that changed
+%%% anything: the changed span of every changed row, run length
+%%% encoded, so what goes over the wire is about the size of the
+%%% change.  slang_server hands them to its mirrors after an initial
+%%% slang:smg_snapshot/0.
+%%%
+%%% view/1 shows the mirrored screen on the local tty, the rest keeps
+%%% a copy of the screen in a #mirror{} without drawing anything.
+
+-record(mirror, {rows, cols,
+		 cursor = {0, 0},
+		 seq = 0,
+		 lines}).              % tuple of binaries, 2 bytes per cell
+
+
+
+%% show the screen of the slang_server on Node until q is typed
+view(Node) ->
+    Server = {slang_server, Node},
+    slang:init_tty(7, 0, 1),
+    slang:smg_init_smg(),
+    slang:key_events(raw),
+    Ref = erlang:monitor(process, Server),
+    draw_snapshot(slang_server:mirror(Server)),
+    slang:smg_refresh(),
+    view_loop(Server, Ref),
+    catch slang_server:unmirror(Server),
+    slang:key_events(off),
+    slang:smg_reset_smg(),
+    slang:reset_tty().
+
+view_loop(Server, Ref) ->
+    receive
+	{slang_damage, Bin} ->
+	    draw_damage(Bin),
+	    slang:smg_refresh(),
+	    view_loop(Server, Ref);
+	{slang_key, $q} ->
+	    ok;
+	{slang_key, _} ->
+	    view_loop(Server, Ref);
+	{'DOWN', Ref, _, _, _} ->
+	    ok
+    end.
+
+
+draw_snapshot({_Gen, _Size, {CR, CC}, Lines}) ->
+    Width = slang:getvar(screen_cols),
+    lists:foreach(fun({Row, Cells}) ->
+			  draw_row(Row, 0, Cells, Width)
+		  end, Lines),
+    slang:smg_gotorc(CR, CC).
+
+draw_damage(Bin) ->
+    {_Seq, _Size, {CR, CC}, Spans} = decode(Bin),
+    Width = slang:getvar(screen_cols),
+    lists:foreach(fun({Row, Col, Cells}) ->
+			  draw_row(Row, Col, Cells, Width)
+		  end, Spans),
+    slang:smg_gotorc(CR, CC).
+
+%% the driver ignores a pattern wider than the screen, so a row of a
+%% wider screen is cut at the edge of ours
+draw_row(_Row, Col, _Cells, Width) when Col >= Width ->
+    ok;
+draw_row(Row, Col, Cells, Width) ->
+    N = lists:min([size(Cells) div 2, Width - Col]),
+    slang:smg_paint_region(Row, Col, 1, N,
+			   [cell_list(binary:part(Cells, 0, N * 2))]).
+
+cell_list(Cells) ->
+    [C || <<C:16>> <= Cells].
+
+
+
+%%% a screen kept in memory
+
+new(Rows, Cols) ->
+    Blank = list_to_binary(lists:duplicate(Cols, <<0:8, $\s:8>>)),
+    #mirror{rows = Rows, cols = Cols,
+	    lines = erlang:make_tuple(Rows, Blank)}.
+
+from_snapshot({_Gen, {Rows, Cols}, Cursor, Lines}) ->
+    M = new(Rows, Cols),
+    M#mirror{cursor = Cursor,
+	     lines = lists:foldl(fun({Row, Cells}, T) ->
+					 setelement(Row + 1, T, Cells)
+				 end, M#mirror.lines, Lines)}.
+
+apply_damage(Bin, M0) ->
+    {Seq, {Rows, Cols}, Cursor, Spans} = decode(Bin),
+    M = if
+	    Rows == M0#mirror.rows, Cols == M0#mirror.cols -> M0;
+	    true -> new(Rows, Cols)       % the record redraws everything
+	end,
+    Lines = lists:foldl(fun({Row, Col, Cells}, T) ->
+				Old = element(Row + 1, T),
+				Skip = Col * 2,
+				Len = size(Cells),
+				<<Pre:Skip/binary, _:Len/binary, Post/binary>> = Old,
+				setelement(Row + 1, T,
+					   <<Pre/binary, Cells/binary, Post/binary>>)
+			end, M#mirror.lines, Spans),
+    M#mirror{seq = Seq, cursor = Cursor, lines = Lines}.
+
+%% the screen as a list of strings
+text(M) ->
+    [slang:snapshot_text(L) || L <- tuple_to_list(M#mirror.lines)].
+
+%% the screen as lists of {Char, Color}
+cells(M) ->
+    [slang:snapshot_cells(L) || L <- tuple_to_list(M#mirror.lines)].
+
+cursor(M) ->
+    M#mirror.cursor.
+
+
+
+%% {Seq, {Rows, Cols}, {CurRow, CurCol}, [{Row, Col, Cells}]}
+%% with Cells as in slang:smg_snapshot/1, see c_src/sl_mirror.c
+decode(<<Seq:32, Rows:16, Cols:16, CR:16, CC:16, _N:16, Spans/binary>>) ->
+    {Seq, {Rows, Cols}, {CR, CC}, decode_spans(Spans)}.
+
+decode_spans(<<Row:16, Col:16, Len:16, Runs/binary>>) ->
+    {Cells, Rest} = decode_runs(Len, Runs, []),
+    [{Row, Col, Cells} | decode_spans(Rest)];
+decode_spans(<<>>) ->
+    [].
+
+decode_runs(0, Rest, Acc) ->
+    {list_to_binary(lists:reverse(Acc)), Rest};
+decode_runs(Len, <<1:1, N:15, Cell:2/binary, Rest/binary>>, Acc) ->
+    decode_runs(Len - N, Rest, [binary:copy(Cell, N) | Acc]);
+decode_runs(Len, <<0:1, N:15, Rest0/binary>>, Acc) ->
+    Size = N * 2,
+    <<Cells:Size/binary, Rest/binary>> = Rest0,
+    decode_runs(Len - N, Rest, [Cells | Acc]).
@@ -0,0 +1,406 @@
+%%%----------------------------------------------------------------------
+%%% File    : slang_server.erl
+%%% Purpose : owner of the slang port, shared by many processes
+%%%----------------------------------------------------------------------
+
+-module(slang_server).
+
+-behaviour(gen_server).
+
+-export([start_link/0, start_link/1,
+	 draw/1, batch/1, call/2,
+	 subscribe/0, subscribe/1, unsubscribe/0,
+	 mirror/1, mirror/2, unmirror/1,
+	 info/0]).
+
+-export([init/1, handle_call/3, handle_cast/2, handle_info/2,
+	 terminate/2, code_change/3]).
+
+
+%%% The slang functions keep the port in the process dictionary, so
+%%% only the process that opened it can use it.  This server is that
+%%% process; others send it batches of slang calls, a batch is a list
+%%% of {Fun, Args} run as apply(slang, Fun, Args) in the server.
+%%%
+%%% Every client has its own queue of at most max_queue batches and
+%%% the queues are served round robin, so one busy renderer can only
+%%% hold up the others by one batch.  draw/1 returns as soon as the
+%%% batch is queued, and blocks while the caller's queue is full.
+%%%
+%%% Before each batch the server asks the driver how much output the
+%%% tty still has to send (slang:tt_outq/0).  Above high_water it
+%%% stops drawing until the terminal has caught up to low_water, the
+%%% same way a slow ssh link would otherwise just fill up.
+%%%
+%%% Keys are not read with getkey/0 but come from the driver as
+%%% messages, and are forwarded to the subscribed processes ahead of
+%%% any queued drawing, as are the lines and completion requests of
+%%% slang:read_line/5 run through call/2.  Batches must not call
+%%% getkey/0 or kp_getkey/0 while anyone is subscribed.
+%%%
+%%% Mirrors, usually slang_mirror viewers on other nodes, get a
+%%% snapshot of the screen and then a {slang_damage, Binary} for
+%%% every refresh that changed something.
+
+-define(PAUSE, 10).                      % ms between tt_outq polls
+
+-record(state, {port,
+		max_queue,
+		high_water,
+		low_water,
+		queues,                  % dict Pid -> queue of {From | none, Batch}
+		ring,                    % queue of Pids with queued batches
+		blocked,                 % dict Pid -> {From, {From | none, Batch}}
+		monitors,                % dict Pid -> Ref
+		subscribers = [],
+		mirrors = [],
+		key_mode = kp,
+		draining = false,
+		paused = false}).
+
+
+
+start_link() ->
+    start_link([]).
+
+%% Opts: {max_queue, Batches}, {high_water, Bytes}, {low_water, Bytes}
+start_link(Opts) ->
+    gen_server:start_link({local, ?MODULE}, ?MODULE, Opts, []).
+
+
+%% queue a batch, returns ok when it is queued
+draw(Batch) ->
+    gen_server:call(?MODULE, {draw, Batch}, infinity).
+
+%% run a batch after the caller's queued ones, returns the results
+batch(Batch) ->
+    gen_server:call(?MODULE, {batch, Batch}, infinity).
+
+call(Fun, Args) ->
+    [Res] = batch([{Fun, Args}]),
+    Res.
+
+%% get every key as {slang_key, Key}, Mode is kp or raw as for
+%% slang:key_events/1, the first subscriber decides
+subscribe() ->
+    subscribe(kp).
+
+subscribe(Mode) when Mode == kp; Mode == raw ->
+    gen_server:call(?MODULE, {subscribe, Mode}).
+
+unsubscribe() ->
+    gen_server:call(?MODULE, unsubscribe).
+
+%% Pid starts getting damage records, returns the slang:smg_snapshot/0
+%% they apply to.  Server is slang_server or {slang_server, Node}
+mirror(Server) ->
+    mirror(Server, self()).
+
+mirror(Server, Pid) ->
+    gen_server:call(Server, {mirror, Pid}).
+
+unmirror(Server) ->
+    gen_server:call(Server, {unmirror, self()}).
+
+info() ->
+    gen_server:call(?MODULE, info).
+
+
+
+init(Opts) ->
+    process_flag(trap_exit, true),
+    High = opt(high_water, Opts, 16384),
+    {ok, #state{port = slang:gp(),
+		max_queue = opt(max_queue, Opts, 16),
+		high_water = High,
+		low_water = opt(low_water, Opts, High div 4),
+		queues = dict:new(),
+		ring = queue:new(),
+		blocked = dict:new(),
+		monitors = dict:new()}}.
+
+
+handle_call({draw, Batch}, {Pid, _} = From, S) ->
+    case full(Pid, S) of
+	false ->
+	    {reply, ok, schedule(enqueue(Pid, {none, Batch}, S))};
+	true ->
+	    {noreply, block(Pid, From, {none, Batch}, S)}
+    end;
+
+handle_call({batch, Batch}, {Pid, _} = From, S) ->
+    case full(Pid, S) of
+	false ->
+	    {noreply, schedule(enqueue(Pid, {From, Batch}, S))};
+	true ->
+	    {noreply, block(Pid, From, {From, Batch}, S)}
+    end;
+
+handle_call({subscribe, Mode}, {Pid, _}, S) ->
+    case lists:member(Pid, S#state.subscribers) of
+	true ->
+	    {reply, ok, S};
+	false when S#state.subscribers == [] ->
+	    case slang:key_events(Mode) of
+		0 ->
+		    {reply, ok, add_subscriber(Pid, S#state{key_mode = Mode})};
+		_ ->
+		    {reply, {error, no_tty}, S}
+	    end;
+	false ->
+	    {reply, ok, add_subscriber(Pid, S)}
+    end;
+
+handle_call(unsubscribe, {Pid, _}, S) ->
+    {reply, ok, del_subscriber(Pid, S)};
+
+handle_call({mirror, Pid}, _From, S0) ->
+    %% older records must not reach Pid after its snapshot
+    S = forward_damage(S0),
+    case lists:member(Pid, S#state.mirrors) of
+	true ->
+	    ok;
+	false when S#state.mirrors == [] ->
+	    slang:mirror(true);
+	false ->
+	    ok
+    end,
+    S2 = monitor_client(Pid, S),
+    {reply, slang:smg_snapshot(),
+     S2#state{mirrors = [Pid | lists:delete(Pid, S2#state.mirrors)]}};
+
+handle_call({unmirror, Pid}, _From, S) ->
+    {reply, ok, del_mirror(Pid, S)};
+
+handle_call(info, _From, S) ->
+    Queued = dict:fold(fun(_, Q, N) -> N + queue:len(Q) end,
+		       0, S#state.queues),
+    {reply, [{clients, queue:len(S#state.ring)},
+	     {queued, Queued},
+	     {blocked, dict:size(S#state.blocked)},
+	     {subscribers, length(S#state.subscribers)},
+	     {mirrors, length(S#state.mirrors)},
+	     {paused, S#state.paused},
+	     {tt_outq, slang:tt_outq()}], S}.
+
+
+handle_cast(_Msg, S) ->
+    {noreply, S}.
+
+
+handle_info(drain, S0) ->
+    S = forward_keys(S0#state{draining = false}),
+    case queue:is_empty(S#state.ring) of
+	true ->
+	    {noreply, S#state{paused = false}};
+	false ->
+	    Limit = if
+			S#state.paused -> S#state.low_water;
+			true -> S#state.high_water
+		    end,
+	    case slang:tt_outq() of
+		Outq when Outq > Limit ->
+		    erlang:send_after(?PAUSE, self(), drain),
+		    {noreply, S#state{draining = true, paused = true}};
+		_ ->
+		    {noreply, schedule(run_next(S#state{paused = false}))}
+	    end
+    end;
+
+handle_info({slang_key, Key}, S) ->
+    send_key(Key, S),
+    {noreply, S};
+
+handle_info({slang_line, Line}, S) ->
+    lists:foreach(fun(Pid) -> Pid ! {slang_line, Line} end,
+		  S#state.subscribers),
+    {noreply, S};
+
+handle_info({slang_complete, _Gen, _Source, _Prefix} = Msg, S) ->
+    lists:foreach(fun(Pid) -> Pid ! Msg end, S#state.subscribers),
+    {noreply, S};
+
+handle_info({slang_damage, Bin}, S) ->
+    send_damage(Bin, S),
+    {noreply, S};
+
+handle_info({'DOWN', _Ref, process, Pid, _}, S) ->
+    {noreply, drop_client(Pid, S)};
+
+handle_info({'EXIT', Port, Reason}, S) when Port == S#state.port ->
+    {stop, Reason, S};
+
+handle_info(_Info, S) ->
+    {noreply, S}.
+
+
+terminate(_Reason, S) ->
+    case S#state.subscribers of
+	[] -> ok;
+	_ -> catch slang:key_events(off)
+    end,
+    ok.
+
+
+code_change(_OldVsn, S, _Extra) ->
+    {ok, S}.
+
+
+
+%% keys that arrived while we were busy go out before more drawing
+forward_keys(S) ->
+    receive
+	{slang_key, Key} ->
+	    send_key(Key, S),
+	    forward_keys(S)
+    after 0 ->
+	    S
+    end.
+
+send_key(Key, S) ->
+    lists:foreach(fun(Pid) -> Pid ! {slang_key, Key} end,
+		  S#state.subscribers).
+
+
+forward_damage(S) ->
+    receive
+	{slang_damage, Bin} ->
+	    send_damage(Bin, S),
+	    forward_damage(S)
+    after 0 ->
+	    S
+    end.
+
+send_damage(Bin, S) ->
+    lists:foreach(fun(Pid) -> Pid ! {slang_damage, Bin} end,
+		  S#state.mirrors).
+
+
+schedule(S) when S#state.draining == false ->
+    case queue:is_empty(S#state.ring) of
+	true ->
+	    S;
+	false ->
+	    self() ! drain,
+	    S#state{draining = true}
+    end;
+schedule(S) ->
+    S.
+
+
+full(Pid, S) ->
+    dict:is_key(Pid, S#state.blocked) orelse
+	case dict:find(Pid, S#state.queues) of
+	    {ok, Q} -> queue:len(Q) >= S#state.max_queue;
+	    error -> false
+	end.
+
+enqueue(Pid, Item, S0) ->
+    S = monitor_client(Pid, S0),
+    case dict:find(Pid, S#state.queues) of
+	{ok, Q} ->
+	    S#state{queues = dict:store(Pid, queue:in(Item, Q), S#state.queues)};
+	error ->
+	    S#state{queues = dict:store(Pid, queue:in(Item, queue:new()),
+					S#state.queues),
+		    ring = queue:in(Pid, S#state.ring)}
+    end.
+
+block(Pid, From, Item, S) ->
+    S#state{blocked = dict:store(Pid, {From, Item}, S#state.blocked)}.
+
+
+%% run the first batch of the next client in the ring
+run_next(S) ->
+    {{value, Pid}, Ring} = queue:out(S#state.ring),
+    {{value, {From, Batch}}, Q} = queue:out(dict:fetch(Pid, S#state.queues)),
+    S2 = case queue:is_empty(Q) of
+	     true ->
+		 S#state{queues = dict:erase(Pid, S#state.queues),
+			 ring = Ring};
+	     false ->
+		 S#state{queues = dict:store(Pid, Q, S#state.queues),
+			 ring = queue:in(Pid, Ring)}
+	 end,
+    Res = run(Batch, From),
+    case From of
+	none -> ok;
+	_ -> gen_server:reply(From, Res)
+    end,
+    unblock(Pid, S2).
+
+run(Batch, From) ->
+    [run1(Fun, Args, From) || {Fun, Args} <- Batch].
+
+run1(Fun, Args, From) ->
+    case catch apply(slang, Fun, Args) of
+	{'EXIT', Reason} when From == none ->
+	    error_logger:format("slang_server: ~p~p failed: ~p~n",
+				[Fun, Args, Reason]),
+	    {error, Reason};
+	{'EXIT', Reason} ->
+	    {error, Reason};
+	Res ->
+	    Res
+    end.
+
+%% there is room in Pid's queue again
+unblock(Pid, S) ->
+    case dict:find(Pid, S#state.blocked) of
+	{ok, {From, Item}} ->
+	    S2 = enqueue(Pid, Item,
+			 S#state{blocked = dict:erase(Pid, S#state.blocked)}),
+	    case Item of
+		{none, _} -> gen_server:reply(From, ok);
+		_ -> ok
+	    end,
+	    S2;
+	error ->
+	    S
+    end.
+
+
+monitor_client(Pid, S) ->
+    case dict:is_key(Pid, S#state.monitors) of
+	true ->
+	    S;
+	false ->
+	    Ref = erlang:monitor(process, Pid),
+	    S#state{monitors = dict:store(Pid, Ref, S#state.monitors)}
+    end.
+
+add_subscriber(Pid, S) ->
+    S2 = monitor_client(Pid, S),
+    S2#state{subscribers = [Pid | S2#state.subscribers]}.
+
+del_subscriber(Pid, S) ->
+    case lists:delete(Pid, S#state.subscribers) of
+	[] when S#state.subscribers /= [] ->
+	    slang:key_events(off),
+	    S#state{subscribers = []};
+	Subs ->
+	    S#state{subscribers = Subs}
+    end.
+
+del_mirror(Pid, S) ->
+    case lists:delete(Pid, S#state.mirrors) of
+	[] when S#state.mirrors /= [] ->
+	    slang:mirror(false),
+	    S#state{mirrors = []};
+	Mirrors ->
+	    S#state{mirrors = Mirrors}
+    end.
+
+drop_client(Pid, S0) ->
+    S = del_mirror(Pid, del_subscriber(Pid, S0)),
+    S#state{queues = dict:erase(Pid, S#state.queues),
+	    ring = queue:filter(fun(P) -> P /= Pid end, S#state.ring),
+	    blocked = dict:erase(Pid, S#state.blocked),
+	    monitors = dict:erase(Pid, S#state.monitors)}.
+
+
+opt(Key, Opts, Default) ->
+    case lists:keysearch(Key, 1, Opts) of
+	{value, {_, Val}} -> Val;
+	false -> Default
+    end.
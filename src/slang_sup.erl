@@ -0,0 +1,26 @@
+%%%----------------------------------------------------------------------
+%%% File    : slang_sup.erl
+%%% Purpose : supervisor for slang_server
+%%%----------------------------------------------------------------------
+
+-module(slang_sup).
+
+-behaviour(supervisor).
+
+-export([start_link/0, start_link/1]).
+-export([init/1]).
+
+
+%% to be put in an application's own supervision tree, starting it
+%% takes over the tty
+start_link() ->
+    start_link([]).
+
+start_link(ServerOpts) ->
+    supervisor:start_link({local, ?MODULE}, ?MODULE, ServerOpts).
+
+
+init(ServerOpts) ->
+    Server = {slang_server, {slang_server, start_link, [ServerOpts]},
+	      permanent, 5000, worker, [slang_server]},
+    {ok, {{one_for_one, 3, 10}, [Server]}}.
@@ -0,0 +1,113 @@
+%%%----------------------------------------------------------------------
+%%% File    : slang_lib_tests.erl
+%%% Purpose : the virtualized table of slang_lib
+%%%----------------------------------------------------------------------
+
+-module(slang_lib_tests).
+
+-include_lib("eunit/include/eunit.hrl").
+
+
+%% The table draws through the slang port, which does nothing here as
+%% the screen is never initialized; what is tested is what it fetches
+%% from its source and where the cursor and the top row end up.
+
+%% a source of Size rows that tells the test what is fetched
+source(Size) ->
+    Self = self(),
+    {callback, fun(size) ->
+		       Size;
+		  ({rows, From, N}) ->
+		       Self ! {fetched, From, N},
+		       [[integer_to_list(I)]
+			|| I <- lists:seq(From, lists:min([From + N, Size]) - 1)]
+	       end}.
+
+fetched() ->
+    receive
+	{fetched, From, N} -> [{From, N} | fetched()]
+    after 0 ->
+	    []
+    end.
+
+%% 5 body rows under the header
+table(Source) ->
+    slang_lib:table_new(0, 0, 6, 20, [{"n", 5}], Source).
+
+at(T) ->
+    {slang_lib:table_top(T), slang_lib:table_cursor(T)}.
+
+
+
+format_row_test() ->
+    Cols = [{"a", 3, left}, {"b", 4, right}],
+    ?assertEqual("x     12 ", lists:flatten(slang_lib:format_row(Cols, ["x", 12]))),
+    ?assertEqual("y        ", lists:flatten(slang_lib:format_row(Cols, [y]))),
+    %% too long: cut at the right of left aligned columns and at the
+    %% left of right aligned ones
+    ?assertEqual("abc nger ",
+		 lists:flatten(slang_lib:format_row(Cols, ["abcd", "longer"]))).
+
+new_test() ->
+    T = table(source(100)),
+    ?assertEqual(100, slang_lib:table_size(T)),
+    ?assertEqual({0, 0}, at(T)),
+    ?assertEqual([], fetched()).
+
+%% the cursor drags the window along, at either end
+cursor_test() ->
+    T0 = slang_lib:table_render(table(source(100))),
+    T1 = slang_lib:table_move_cursor(T0, 7),
+    ?assertEqual({3, 7}, at(T1)),
+    T2 = slang_lib:table_move_cursor(T1, -5),
+    ?assertEqual({2, 2}, at(T2)),
+    T3 = slang_lib:table_goto(T2, 1000),
+    ?assertEqual({95, 99}, at(T3)),
+    T4 = slang_lib:table_goto(T3, -5),
+    ?assertEqual({0, 0}, at(T4)).
+
+%% scrolling leaves the cursor where it is
+scroll_test() ->
+    T0 = slang_lib:table_render(table(source(100))),
+    T1 = slang_lib:table_scroll(T0, 3),
+    ?assertEqual({3, 0}, at(T1)),
+    T2 = slang_lib:table_scroll(T1, 1000),
+    ?assertEqual({95, 0}, at(T2)),
+    T3 = slang_lib:table_scroll(T2, -1000),
+    ?assertEqual({0, 0}, at(T3)).
+
+%% only the visible rows are ever fetched
+fetch_test() ->
+    T0 = slang_lib:table_render(table(source(1000000))),
+    T1 = slang_lib:table_scroll(T0, 2),
+    T2 = slang_lib:table_goto(T1, 500000),
+    _ = slang_lib:table_scroll(T2, -1),
+    ?assertEqual([{0, 5}, {2, 5}, {499996, 5}, {499995, 5}], fetched()).
+
+%% a table shorter than the window
+short_test() ->
+    T0 = slang_lib:table_render(table(source(3))),
+    ?assertEqual([{0, 5}], fetched()),
+    T1 = slang_lib:table_goto(T0, 10),
+    ?assertEqual({0, 2}, at(T1)),
+    T2 = slang_lib:table_scroll(T1, 1),
+    ?assertEqual({0, 2}, at(T2)).
+
+%% rows that change out of view are not fetched, the others once
+changed_test() ->
+    T0 = slang_lib:table_render(table(source(100))),
+    [{0, 5}] = fetched(),
+    _ = slang_lib:table_changed(T0, [3, 50, 3, 1]),
+    ?assertEqual([{1, 1}, {3, 1}], fetched()).
+
+%% the source shrinking under the cursor pulls it back
+shrink_test() ->
+    Tab = ets:new(rows, [set]),
+    ets:insert(Tab, [{I, [integer_to_list(I)]} || I <- lists:seq(0, 9)]),
+    T0 = slang_lib:table_goto(table({ets, Tab}), 9),
+    ?assertEqual({5, 9}, at(T0)),
+    lists:foreach(fun(I) -> ets:delete(Tab, I) end, lists:seq(5, 9)),
+    T1 = slang_lib:table_render(T0),
+    ?assertEqual(5, slang_lib:table_size(T1)),
+    ?assertEqual({0, 4}, at(T1)),
+    ets:delete(Tab).
@@ -0,0 +1,123 @@
+%%%----------------------------------------------------------------------
+%%% File    : slang_mirror_tests.erl
+%%% Purpose : damage records against the snapshots they stand for
+%%%----------------------------------------------------------------------
+
+-module(slang_mirror_tests).
+
+-include_lib("eunit/include/eunit.hrl").
+
+
+%% a row of snapshot cells, all in one color
+cells(Str, Color) ->
+    list_to_binary([<<Color:8, Ch:8>> || Ch <- Str]).
+
+cells(Str) ->
+    cells(Str, 0).
+
+%% a damage record as c_src/sl_mirror.c builds it, Spans are
+%% {Row, Col, Runs} with Runs {lit, Cells} or {rep, N, Cell}
+damage(Seq, {Rows, Cols}, {CR, CC}, Spans) ->
+    list_to_binary([<<Seq:32, Rows:16, Cols:16, CR:16, CC:16,
+		     (length(Spans)):16>>,
+		    [span(S) || S <- Spans]]).
+
+span({Row, Col, Runs}) ->
+    Len = lists:sum([run_len(R) || R <- Runs]),
+    [<<Row:16, Col:16, Len:16>>, [run(R) || R <- Runs]].
+
+run_len({lit, Cells}) -> size(Cells) div 2;
+run_len({rep, N, _}) -> N.
+
+run({lit, Cells}) -> <<0:1, (size(Cells) div 2):15, Cells/binary>>;
+run({rep, N, Cell}) -> <<1:1, N:15, Cell/binary>>.
+
+snapshot(Cursor, Rows) ->
+    Cols = length(hd(Rows)),
+    {1, {length(Rows), Cols}, Cursor,
+     [{R, cells(Str)} || {R, Str} <- lists:zip(lists:seq(0, length(Rows) - 1),
+					       Rows)]}.
+
+
+
+decode_test() ->
+    Bin = damage(7, {3, 5}, {1, 2},
+		 [{0, 1, [{lit, cells("ab")}, {rep, 1, cells("c", 3)}]},
+		  {2, 0, [{rep, 5, cells("-")}]}]),
+    ?assertEqual({7, {3, 5}, {1, 2},
+		  [{0, 1, <<0, $a, 0, $b, 3, $c>>},
+		   {2, 0, cells("-----")}]},
+		 slang_mirror:decode(Bin)).
+
+decode_empty_test() ->
+    ?assertEqual({1, {2, 4}, {0, 0}, []},
+		 slang_mirror:decode(damage(1, {2, 4}, {0, 0}, []))).
+
+from_snapshot_test() ->
+    M = slang_mirror:from_snapshot(snapshot({1, 3}, ["hello", "world"])),
+    ?assertEqual(["hello", "world"], slang_mirror:text(M)),
+    ?assertEqual({1, 3}, slang_mirror:cursor(M)).
+
+%% rows a snapshot leaves out are blank
+from_partial_snapshot_test() ->
+    M = slang_mirror:from_snapshot({4, {3, 3}, {0, 0}, [{1, cells("abc")}]}),
+    ?assertEqual(["   ", "abc", "   "], slang_mirror:text(M)).
+
+%% a damage record on top of a snapshot ends up where the next
+%% snapshot of the screen would be
+apply_damage_test() ->
+    M0 = slang_mirror:from_snapshot(snapshot({0, 0}, ["hello",
+							"world",
+							"     "])),
+    Bin = damage(1, {3, 5}, {2, 4},
+		 [{0, 1, [{lit, cells("ab")}, {rep, 1, cells("c", 3)}]},
+		  {2, 0, [{rep, 3, cells("-", 2)}, {lit, cells("->")}]}]),
+    M = slang_mirror:apply_damage(Bin, M0),
+    Want = slang_mirror:from_snapshot(
+	     {2, {3, 5}, {2, 4},
+	      [{0, <<0, $h, 0, $a, 0, $b, 3, $c, 0, $o>>},
+	       {1, cells("world")},
+	       {2, <<(cells("---", 2))/binary, (cells("->"))/binary>>}]}),
+    ?assertEqual(slang_mirror:text(Want), slang_mirror:text(M)),
+    ?assertEqual(slang_mirror:cells(Want), slang_mirror:cells(M)),
+    ?assertEqual({2, 4}, slang_mirror:cursor(M)).
+
+%% spans at both ends of a row
+apply_damage_edges_test() ->
+    M0 = slang_mirror:from_snapshot(snapshot({0, 0}, ["abcdef"])),
+    Bin = damage(1, {1, 6}, {0, 6},
+		 [{0, 0, [{lit, cells("X")}]}, {0, 5, [{lit, cells("Y")}]}]),
+    M = slang_mirror:apply_damage(Bin, M0),
+    ?assertEqual(["XbcdeY"], slang_mirror:text(M)).
+
+%% later records win, and rows they do not touch keep what the
+%% earlier ones put there
+apply_damage_sequence_test() ->
+    M0 = slang_mirror:new(2, 4),
+    M1 = slang_mirror:apply_damage(
+	   damage(1, {2, 4}, {0, 4}, [{0, 0, [{lit, cells("abcd")}]},
+				      {1, 0, [{rep, 4, cells("=")}]}]), M0),
+    M2 = slang_mirror:apply_damage(
+	   damage(2, {2, 4}, {0, 2}, [{0, 1, [{rep, 2, cells("x", 1)}]}]), M1),
+    ?assertEqual(["axxd", "===="], slang_mirror:text(M2)),
+    ?assertEqual([[{$a, 0}, {$x, 1}, {$x, 1}, {$d, 0}],
+		  [{$=, 0}, {$=, 0}, {$=, 0}, {$=, 0}]],
+		 slang_mirror:cells(M2)),
+    ?assertEqual({0, 2}, slang_mirror:cursor(M2)).
+
+%% after a resize the driver sends the whole screen again, what the
+%% mirror had before is gone
+apply_damage_resize_test() ->
+    M0 = slang_mirror:from_snapshot(snapshot({0, 0}, ["hello", "world"])),
+    Bin = damage(3, {3, 3}, {2, 0}, [{1, 0, [{lit, cells("xyz")}]}]),
+    M = slang_mirror:apply_damage(Bin, M0),
+    ?assertEqual(["   ", "xyz", "   "], slang_mirror:text(M)),
+    ?assertEqual({2, 0}, slang_mirror:cursor(M)).
+
+%% the alternate character set flag is part of the color
+apply_damage_alt_charset_test() ->
+    M0 = slang_mirror:new(1, 3),
+    Bin = damage(1, {1, 3}, {0, 0}, [{0, 0, [{rep, 3, <<16#80, $q>>}]}]),
+    M = slang_mirror:apply_damage(Bin, M0),
+    ?assertEqual([[{$q, 16#80}, {$q, 16#80}, {$q, 16#80}]],
+		 slang_mirror:cells(M)).
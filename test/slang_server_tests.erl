@@ -0,0 +1,148 @@
+%%%----------------------------------------------------------------------
+%%% File    : slang_server_tests.erl
+%%% Purpose : batches, queueing and backpressure of slang_server
+%%%----------------------------------------------------------------------
+
+-module(slang_server_tests).
+
+-include_lib("eunit/include/eunit.hrl").
+
+
+%% Nothing here needs a tty: the batches only call slang functions
+%% that do not draw, and without one slang:tt_outq/0 is always 0, so
+%% a high_water of -1 keeps the server paused for good.
+
+with_server(Opts, Fun) ->
+    {ok, Pid} = slang_server:start_link(Opts),
+    unlink(Pid),
+    try
+	Fun()
+    after
+	stop(Pid)
+    end.
+
+stop(Pid) ->
+    Ref = erlang:monitor(process, Pid),
+    exit(Pid, shutdown),
+    receive
+	{'DOWN', Ref, _, _, _} -> ok
+    end.
+
+info(Key) ->
+    proplists:get_value(Key, slang_server:info()).
+
+%% the server sees a client go down some time after we do
+info_after_down(Key, Want) ->
+    info_after_down(Key, Want, 100).
+
+info_after_down(Key, _Want, 0) ->
+    info(Key);
+info_after_down(Key, Want, N) ->
+    case info(Key) of
+	Want ->
+	    Want;
+	_ ->
+	    timer:sleep(10),
+	    info_after_down(Key, Want, N - 1)
+    end.
+
+%% a process that queues N draws, telling the test after each one
+drawer(N) ->
+    Self = self(),
+    spawn(fun() ->
+		  lists:foreach(fun(I) ->
+					ok = slang_server:draw([{tt_outq, []}]),
+					Self ! {drawn, self(), I}
+				end, lists:seq(1, N)),
+		  receive stop -> ok end
+	  end).
+
+drawn(Pid, I) ->
+    receive
+	{drawn, Pid, I} -> ok
+    after 1000 ->
+	    timeout
+    end.
+
+kill(Pid) ->
+    Ref = erlang:monitor(process, Pid),
+    exit(Pid, kill),
+    receive
+	{'DOWN', Ref, _, _, _} -> ok
+    end.
+
+
+
+batch_test() ->
+    with_server([], fun() ->
+	    [Text, Outq, Error] =
+		slang_server:batch([{snapshot_text, [<<0, $a, 0, $b>>]},
+				    {tt_outq, []},
+				    {snapshot_text, [not_cells]}]),
+	    ?assertEqual("ab", Text),
+	    ?assertEqual(0, Outq),
+	    ?assertMatch({error, _}, Error),
+	    ?assertEqual("c", slang_server:call(snapshot_text, [<<0, $c>>]))
+    end).
+
+%% draw/1 returns before the batch has run, a batch/1 after it
+%% finds the caller's queue empty
+draw_test() ->
+    with_server([], fun() ->
+	    ok = slang_server:draw([{tt_outq, []}]),
+	    ok = slang_server:draw([{tt_outq, []}]),
+	    ?assertEqual([0], slang_server:batch([{tt_outq, []}])),
+	    ?assertEqual(0, info(queued)),
+	    ?assertEqual(0, info(clients)),
+	    ?assertEqual(false, info(paused))
+    end).
+
+%% above high_water nothing runs, draws queue up to max_queue and
+%% then block the caller
+backpressure_test() ->
+    with_server([{max_queue, 2}, {high_water, -1}, {low_water, -1}], fun() ->
+	    D = drawer(3),
+	    ?assertEqual(ok, drawn(D, 1)),
+	    ?assertEqual(ok, drawn(D, 2)),
+	    ?assertEqual(timeout, drawn(D, 3)),
+	    ?assertEqual(2, info(queued)),
+	    ?assertEqual(1, info(blocked)),
+	    ?assertEqual(1, info(clients)),
+	    ?assertEqual(true, info(paused)),
+	    kill(D)
+    end).
+
+%% every client has a queue of its own, one that is full does not
+%% block the others
+queue_per_client_test() ->
+    with_server([{max_queue, 1}, {high_water, -1}, {low_water, -1}], fun() ->
+	    D1 = drawer(2),
+	    ?assertEqual(ok, drawn(D1, 1)),
+	    ?assertEqual(timeout, drawn(D1, 2)),
+	    D2 = drawer(1),
+	    ?assertEqual(ok, drawn(D2, 1)),
+	    ?assertEqual(2, info(clients)),
+	    ?assertEqual(2, info(queued)),
+	    ?assertEqual(1, info(blocked)),
+	    kill(D1),
+	    kill(D2)
+    end).
+
+%% what a client that goes away had queued or blocked is dropped
+client_down_test() ->
+    with_server([{max_queue, 1}, {high_water, -1}, {low_water, -1}], fun() ->
+	    D = drawer(2),
+	    ?assertEqual(ok, drawn(D, 1)),
+	    ?assertEqual(timeout, drawn(D, 2)),
+	    kill(D),
+	    ?assertEqual(0, info_after_down(clients, 0)),
+	    ?assertEqual(0, info(queued)),
+	    ?assertEqual(0, info(blocked))
+    end).
+
+%% key events need the tty set up
+subscribe_no_tty_test() ->
+    with_server([], fun() ->
+	    ?assertEqual({error, no_tty}, slang_server:subscribe()),
+	    ?assertEqual(0, info(subscribers))
+    end).
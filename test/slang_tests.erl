@@ -0,0 +1,149 @@
+%%%----------------------------------------------------------------------
+%%% File    : slang_tests.erl
+%%% Purpose : driver features that work without a tty
+%%%----------------------------------------------------------------------
+
+-module(slang_tests).
+
+-include_lib("eunit/include/eunit.hrl").
+-include("../src/slang_int.hrl").
+
+
+%% The port is opened by the first slang call of the test process and
+%% the driver state is shared by all its tests, so they only look at
+%% what they did themselves.  Nothing here initializes the screen.
+
+%% the driver's {Tag, Op, ...} message
+receive_op(Tag, Op) ->
+    receive
+	{Tag, Op, _} = Msg ->
+	    Msg
+    after 1000 ->
+	    timeout
+    end.
+
+
+
+%%% latency statistics
+
+stats_test() ->
+    slang:stats_reset(),
+    slang:smg_gotorc(1, 2),
+    slang:smg_gotorc(3, 4),
+    slang:smg_gotorc(5, 6),
+    Stats = slang:stats(),
+    Gotorc = proplists:get_value(?SMG_GOTORC, Stats),
+    ?assertEqual(3, proplists:get_value(count, Gotorc)),
+    Min = proplists:get_value(min, Gotorc),
+    Max = proplists:get_value(max, Gotorc),
+    ?assert(Min =< Max),
+    ?assert(Max =< proplists:get_value(total, Gotorc)),
+    Hist = proplists:get_value(histogram, Gotorc),
+    ?assertEqual(3, lists:sum([C || {_, C} <- Hist])),
+    %% buckets are named by their lowest value
+    {Lowest, _} = hd(Hist),
+    {Highest, _} = lists:last(Hist),
+    ?assert(Lowest =< Min),
+    ?assert(Highest =< Max),
+    ?assertEqual(1, proplists:get_value(
+		      count, proplists:get_value(?STATS_RESET, Stats))).
+
+stats_reset_test() ->
+    slang:smg_gotorc(0, 0),
+    slang:stats_reset(),
+    ?assertEqual(undefined, proplists:get_value(?SMG_GOTORC, slang:stats())).
+
+stats_trace_test() ->
+    slang:stats_trace(true),
+    slang:smg_gotorc(0, 0),
+    slang:stats_trace(false),
+    ?assertMatch({slang_trace, ?SMG_GOTORC, Ns} when is_integer(Ns),
+		 receive_op(slang_trace, ?SMG_GOTORC)).
+
+%% two samples, 10 and 20 ns, in buckets 10 and 20
+decode_stats_test() ->
+    Bin = <<?SMG_GOTORC:8, 2:64, 30:64, 10:64, 20:64, 2:16,
+	   10:16, 1:32, 20:16, 1:32>>,
+    [{Op, S}] = slang:decode_stats(Bin),
+    ?assertEqual(?SMG_GOTORC, Op),
+    ?assertEqual([{10, 1}, {20, 1}], proplists:get_value(histogram, S)),
+    ?assertEqual(10, proplists:get_value(p50, S)),
+    ?assertEqual(20, proplists:get_value(p90, S)),
+    ?assertEqual(20, proplists:get_value(p999, S)).
+
+%% 16 buckets for every power of two
+bucket_low_test() ->
+    ?assertEqual(15, slang:bucket_low(15)),
+    ?assertEqual(16, slang:bucket_low(16)),
+    ?assertEqual(31, slang:bucket_low(31)),
+    ?assertEqual(32, slang:bucket_low(32)),
+    ?assertEqual(34, slang:bucket_low(33)),
+    ?assertEqual(100, slang:bucket_low(57)).
+
+
+
+%%% command stream recording
+
+cmdlog_test() ->
+    File = "slang_tests.rec",
+    ?assertEqual(0, slang:cmdlog_start(File)),
+    slang:smg_gotorc(1, 2),
+    slang:cmdlog_stop(),
+    %% any reply will do, the driver has done the stop before it
+    _ = slang:tt_outq(),
+    {ok, Bin} = file:read_file(File),
+    file:delete(File),
+    <<"SLREC", 1, _Rows:16, _Cols:16, Cmds/binary>> = Bin,
+    %% the start is not in it, the stop is
+    ?assertEqual([[?SMG_GOTORC, 0, 0, 0, 1, 0, 0, 0, 2], [?CMDLOG_STOP]],
+		 [C || C <- commands(Cmds), C /= [255]]).
+
+cmdlog_bad_file_test() ->
+    ?assertEqual(-1, slang:cmdlog_start("/nonexistent/slang_tests.rec")).
+
+%% { Delta Len Bytes }*, Delta and Len LEB128
+commands(<<>>) ->
+    [];
+commands(Bin) ->
+    {_Delta, R1} = varint(Bin),
+    {Len, R2} = varint(R1),
+    <<Cmd:Len/binary, Rest/binary>> = R2,
+    [binary_to_list(Cmd) | commands(Rest)].
+
+varint(<<1:1, N:7, Rest/binary>>) ->
+    {V, R} = varint(Rest),
+    {(V bsl 7) bor N, R};
+varint(<<0:1, N:7, Rest/binary>>) ->
+    {N, Rest}.
+
+
+
+%%% color objects allocated on demand
+
+color_test() ->
+    A = slang:color(red, default, []),
+    B = slang:color(blue, default, [bold]),
+    ?assert((A >= 64) and (A =< 127)),
+    ?assert((B >= 64) and (B =< 127)),
+    ?assertNotEqual(A, B),
+    ?assertEqual(A, slang:color(red, default, [])),
+    ?assertEqual(A, slang:color(1, default, [])),
+    ?assertNotEqual(A, slang:color(red, default, [bold])),
+    ?assertNotEqual(A, slang:color(red, black, [])).
+
+%% with every object taken the least recently used one goes, here
+%% none of them is on the screen
+color_reuse_test() ->
+    Objs = [slang:color(white, {1, 2, I}, []) || I <- lists:seq(1, 64)],
+    ?assertEqual(lists:seq(64, 127), lists:usort(Objs)),
+    [First, Second | _] = Objs,
+    ?assertEqual(First, slang:color(white, {1, 2, 1}, [])),
+    ?assertEqual(Second, slang:color(white, {1, 2, 65}, [])),
+    ?assertEqual(First, slang:color(white, {1, 2, 1}, [])).
+
+color_spec_test() ->
+    ?assertEqual(-1, slang:color_spec(default)),
+    ?assertEqual(12, slang:color_spec(brightblue)),
+    ?assertEqual(200, slang:color_spec(200)),
+    ?assertEqual(?COLOR_RGB bor 16#ff8000, slang:color_spec({255, 128, 0})),
+    ?assertEqual(1 bor 8, slang:color_attrs([bold, reverse], 0)).